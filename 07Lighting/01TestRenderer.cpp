@@ -54,10 +54,10 @@ int main(int argc, char const *argv[])
     renderer.setModelRotation(torusIdx, glm::vec3(0.0f, 0.0f, 1.0f), 1.0f);
     renderer.setTexture(torusIdx, "BrickTexture.jpg");
 
-    // imported model
-    std::shared_ptr<Utils::Model> spImportedModel(new Utils::ImportedModel("TestModel.obj"));
-    auto importIdx = renderer.addModel(spImportedModel, Utils::Renderer::PureColorLineStrip);
-    renderer.setModelRotation(importIdx, glm::vec3(0.0f, 1.0f, 0.0f), -0.5f);
+    // imported model, parsed on a worker thread and drawn once loaded
+    auto importHandle = renderer.addModelAsync([]() { return std::make_shared<Utils::ImportedModel>("TestModel.obj"); },
+                                               Utils::Renderer::PureColorLineStrip);
+    renderer.setModelRotation(importHandle.index(), glm::vec3(0.0f, 1.0f, 0.0f), -0.5f);
 
     // draw user-defined axises, override renderer axises
     std::shared_ptr<Utils::Model> spAxis(new Axises(100.0f));
@@ -0,0 +1,218 @@
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <format>
+#include <filesystem>
+#include <thread>
+#include <ImportedModel.h>
+#include <MappedFile.h>
+#include <MeshCache.h>
+
+// OBJ loading throughput: the memory mapped from_chars parser of ImportedModel against the old istringstream loader,
+// the scaling of the parallel chunked parsing with thread count, the gain of the deduplicated indexed output,
+// and loading from the binary mesh cache instead of parsing.
+// usage: 01ObjLoading [model.obj] [repeat]
+// without a model file, a synthetic grid model of about 100MB is generated to the temporary directory.
+
+struct LegacyArrays
+{
+    std::vector<float> vertices;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+};
+
+// the loader of ImportedModel before the memory mapped parser, kept here as the baseline
+LegacyArrays legacyLoad(const char* filePath)
+{
+    LegacyArrays res;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::ifstream fin(filePath);
+    std::string line;
+    float x, y, z;
+    std::vector<int> vertIndices, tcIndices, normalIndices;
+    while (!fin.eof())
+    {
+        std::getline(fin, line);
+        if (line.compare(0, 2, "v ") == 0)
+        {
+            std::istringstream iss(line.erase(0, 1));
+            iss >> x >> y >> z;
+            vertices.push_back(glm::vec3(x, y, z));
+        }
+        else if (line.compare(0, 2, "vt") == 0)
+        {
+            std::istringstream iss(line.erase(0, 2));
+            iss >> x >> y;
+            texCoords.push_back(glm::vec2(x, y));
+        }
+        else if (line.compare(0, 2, "vn") == 0)
+        {
+            std::istringstream iss(line.erase(0, 2));
+            iss >> x >> y >> z;
+            normals.push_back(glm::vec3(x, y, z));
+        }
+        else if (line.compare(0, 2, "f ") == 0)
+        {
+            std::string oneVertex, v, t, n;
+            std::istringstream iss(line.erase(0, 2));
+            for (int i = 0; i < 3; ++i)
+            {
+                std::getline(iss, oneVertex, ' ');
+                std::istringstream oneVertexIss(oneVertex);
+                std::getline(oneVertexIss, v, '/');
+                std::getline(oneVertexIss, t, '/');
+                std::getline(oneVertexIss, n, '/');
+                vertIndices.push_back(std::stoi(v) - 1);
+                tcIndices.push_back(std::stoi(t) - 1);
+                normalIndices.push_back(std::stoi(n) - 1);
+            }
+        }
+    }
+    for (auto idx : vertIndices)
+    {
+        res.vertices.insert(res.vertices.end(), { vertices[idx].x, vertices[idx].y, vertices[idx].z });
+    }
+    for (auto idx : tcIndices)
+    {
+        res.texCoords.insert(res.texCoords.end(), { texCoords[idx].s, texCoords[idx].t });
+    }
+    for (auto idx : normalIndices)
+    {
+        res.normals.insert(res.normals.end(), { normals[idx].x, normals[idx].y, normals[idx].z });
+    }
+    return res;
+}
+
+// a prec*prec grid of quads on a unit sphere, two triangles per quad
+void generateModel(const std::string& filePath, int prec)
+{
+    std::ofstream fout(filePath);
+    fout << "# synthetic benchmark model\n";
+    for (int i = 0; i <= prec; i++)
+    {
+        for (int j = 0; j <= prec; j++)
+        {
+            float theta = glm::pi<float>() * i / prec;
+            float phi = 2.0f * glm::pi<float>() * j / prec;
+            float x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = std::sin(theta) * std::sin(phi);
+            fout << std::format("v {:.6f} {:.6f} {:.6f}\n", x, y, z);
+            fout << std::format("vt {:.6f} {:.6f}\n", float(j) / prec, float(i) / prec);
+            fout << std::format("vn {:.4f} {:.4f} {:.4f}\n", x, y, z);
+        }
+    }
+    for (int i = 0; i < prec; i++)
+    {
+        for (int j = 0; j < prec; j++)
+        {
+            int a = i * (prec + 1) + j + 1, b = a + 1, c = a + prec + 1, d = c + 1;
+            fout << std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", a, c, b);
+            fout << std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", b, c, d);
+        }
+    }
+}
+
+template<typename Func>
+double measureSeconds(int repeat, Func&& func)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeat; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::string filePath;
+    if (argc > 1)
+    {
+        filePath = argv[1];
+    }
+    else
+    {
+        filePath = (std::filesystem::temp_directory_path() / "LearnOpenGL_benchmark.obj").string();
+        std::cout << std::format("Generating {} ...\n", filePath);
+        generateModel(filePath, 800);
+    }
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 3;
+    double sizeInMB = double(std::filesystem::file_size(filePath)) / (1024.0 * 1024.0);
+
+    LegacyArrays legacy;
+    double legacySeconds = measureSeconds(repeat, [&]() { legacy = legacyLoad(filePath.c_str()); });
+    std::vector<float> vertices, texCoords, normals;
+    std::vector<int> indices;
+    Utils::IndexingStatistics stats;
+    double mappedSeconds = measureSeconds(repeat, [&]()
+    {
+        Utils::ImportedModel model(filePath.c_str(), 1, false);
+        vertices = model.getVerticesArray();
+        texCoords = model.getTexCoordsArray();
+        normals = model.getNormalsArray();
+        indices = model.getIndices();
+        stats = model.getIndexingStatistics();
+    });
+
+    bool identical = legacy.vertices == vertices && legacy.texCoords == texCoords && legacy.normals == normals;
+    std::cout << std::format("file size          : {:.1f} MB\n", sizeInMB);
+    std::cout << std::format("istringstream      : {:.3f} s, {:.1f} MB/s\n", legacySeconds, sizeInMB / legacySeconds);
+    std::cout << std::format("mapped from_chars  : {:.3f} s, {:.1f} MB/s\n", mappedSeconds, sizeInMB / mappedSeconds);
+    std::cout << std::format("speed up           : {:.2f}x\n", legacySeconds / mappedSeconds);
+    std::cout << std::format("identical results  : {}\n", identical ? "yes" : "NO");
+    std::cout << std::format("unique vertices    : {} of {} face corners\n", stats.uniqueVertices, stats.corners);
+    std::cout << std::format("vertex data        : {:.1f} MB indexed, {:.1f} MB de-indexed, {:.1f}% saved\n",
+                             stats.indexedBytes / (1024.0 * 1024.0), stats.flatBytes / (1024.0 * 1024.0),
+                             stats.flatBytes == 0 ? 0.0 : 100.0 - 100.0 * double(stats.indexedBytes) / double(stats.flatBytes));
+    std::cout << std::format("post-transform hit : {:.1f}% with {} entries FIFO cache, ACMR {:.3f}\n",
+                             stats.cacheHitRate * 100.0f, Utils::ImportedModel::postTransformCacheSize, stats.acmr);
+
+    // parallel parsing, must be byte-identical to the single threaded result
+    std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 2; threads <= maxThreads; threads *= 2)
+    {
+        bool sameAsSingle = true;
+        double seconds = measureSeconds(repeat, [&]()
+        {
+            Utils::ImportedModel model(filePath.c_str(), threads, false);
+            sameAsSingle = model.getVerticesArray() == vertices && model.getTexCoordsArray() == texCoords && model.getNormalsArray() == normals
+                           && model.getIndices() == indices;
+        });
+        identical = identical && sameAsSingle;
+        std::cout << std::format("{: >3} threads        : {:.3f} s, {:.1f} MB/s, {:.2f}x of single thread, identical: {}\n",
+                                 threads, seconds, sizeInMB / seconds, mappedSeconds / seconds, sameAsSingle ? "yes" : "NO");
+    }
+
+    // the first load writes the cache, the later ones map it
+    std::filesystem::remove(filePath + ".meshcache");
+    double cacheWriteSeconds = measureSeconds(1, [&]() { Utils::ImportedModel model(filePath.c_str()); });
+    double cacheSeconds = measureSeconds(repeat, [&]() { Utils::ImportedModel model(filePath.c_str()); });
+    Utils::ImportedModel cached(filePath.c_str());
+    auto cachedIndices = cached.getIndicesView();
+    bool fromCache = cached.isLoadedFromCache();
+    bool sameAsParsed = std::equal(cachedIndices.begin(), cachedIndices.end(), indices.begin(), indices.end())
+                        && cached.getVerticesArray() == vertices && cached.getTexCoordsArray() == texCoords && cached.getNormalsArray() == normals;
+    double hashSeconds = measureSeconds(repeat, [&]()
+    {
+        Utils::MappedFile file(filePath.c_str());
+        volatile std::uint64_t hash = Utils::MeshCache::hashBytes(file.data(), file.size());
+        (void)hash;
+    });
+    identical = identical && sameAsParsed && fromCache;
+    std::cout << std::format("parse + write cache: {:.3f} s, {:.1f} MB cache file\n", cacheWriteSeconds,
+                             double(std::filesystem::file_size(filePath + ".meshcache")) / (1024.0 * 1024.0));
+    std::cout << std::format("mapped mesh cache  : {:.3f} s (source hashing {:.3f} s), {:.2f}x of parsing, identical: {}\n",
+                             cacheSeconds, hashSeconds, mappedSeconds / cacheSeconds, sameAsParsed && fromCache ? "yes" : "NO");
+    return identical ? 0 : 1;
+}
\ No newline at end of file
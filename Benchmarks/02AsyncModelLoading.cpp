@@ -0,0 +1,99 @@
+#include <glad/gl.h> // glad2!
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <format>
+#include <filesystem>
+#include <memory>
+#include <Renderer.h>
+#include <ImportedModel.h>
+
+// startup cost of adding many imported models: Renderer::addModel parses and uploads on the render thread,
+// Renderer::addModelAsync only blocks the render thread for the GL uploads.
+// usage: 02AsyncModelLoading [model count] [model.obj]
+// without a model file, a synthetic sphere model is generated to the temporary directory.
+// the mesh cache is not used, every model is parsed, as on the first launch.
+
+void generateModel(const std::string& filePath, int prec)
+{
+    std::ofstream fout(filePath);
+    for (int i = 0; i <= prec; i++)
+    {
+        for (int j = 0; j <= prec; j++)
+        {
+            float theta = glm::pi<float>() * i / prec;
+            float phi = 2.0f * glm::pi<float>() * j / prec;
+            float x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = std::sin(theta) * std::sin(phi);
+            fout << std::format("v {:.6f} {:.6f} {:.6f}\nvt {:.6f} {:.6f}\nvn {:.4f} {:.4f} {:.4f}\n", x, y, z, float(j) / prec, float(i) / prec, x, y, z);
+        }
+    }
+    for (int i = 0; i < prec; i++)
+    {
+        for (int j = 0; j < prec; j++)
+        {
+            int a = i * (prec + 1) + j + 1, b = a + 1, c = a + prec + 1, d = c + 1;
+            fout << std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", a, c, b);
+            fout << std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", b, c, d);
+        }
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char const *argv[])
+{
+    int modelCount = argc > 1 ? std::stoi(argv[1]) : 24;
+    std::string filePath;
+    if (argc > 2)
+    {
+        filePath = argv[2];
+    }
+    else
+    {
+        filePath = (std::filesystem::temp_directory_path() / "LearnOpenGL_async_benchmark.obj").string();
+        generateModel(filePath, 300);
+    }
+
+    Utils::Renderer renderer("02AsyncModelLoading", 640, 480);
+    auto loader = [&]() { return std::make_shared<Utils::ImportedModel>(filePath.c_str(), 1, false); };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < modelCount; i++)
+    {
+        renderer.addModel(loader(), Utils::Renderer::PureColorTriangles);
+    }
+    glFinish();
+    double syncSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Utils::AsyncModelHandle> handles;
+    for (int i = 0; i < modelCount; i++)
+    {
+        handles.push_back(renderer.addModelAsync(loader, Utils::Renderer::PureColorTriangles));
+    }
+    double asyncBlockedSeconds = secondsSince(start);
+    renderer.finishAsyncModels();
+    glFinish();
+    double asyncSeconds = secondsSince(start);
+
+    int uploaded = 0;
+    for (const auto& handle : handles)
+    {
+        uploaded += handle.isUploaded() ? 1 : 0;
+    }
+    std::cout << std::format("models                       : {} x {}\n", modelCount, filePath);
+    std::cout << std::format("addModel, render thread busy : {:.3f} s\n", syncSeconds);
+    std::cout << std::format("addModelAsync, calls return  : {:.3f} s\n", asyncBlockedSeconds);
+    std::cout << std::format("addModelAsync, all uploaded  : {:.3f} s, {:.2f}x, {} of {} models uploaded\n",
+                             asyncSeconds, syncSeconds / asyncSeconds, uploaded, modelCount);
+    return uploaded == modelCount ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <glm/glm.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <span>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <format>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <Model.h>
+#include <Sphere.h>
+#include <Torus.h>
+#include <Plane.h>
+#include <ImportedModel.h>
+
+// allocations made to read the data of a model for upload: the std::vector getters against the std::span views.
+// usage: 03ModelAccessors [model.obj] [repeat]
+
+// count every allocation of the program
+std::atomic<std::size_t> g_allocationCount = 0;
+std::atomic<std::size_t> g_allocatedBytes = 0;
+
+void* operator new(std::size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+struct Measurement
+{
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    double seconds = 1e30;
+    std::size_t checksum = 0;
+};
+
+// best time of repeat runs, allocations of one run
+Measurement measure(int repeat, const std::function<std::size_t()>& func)
+{
+    Measurement res;
+    for (int i = 0; i < repeat; i++)
+    {
+        std::size_t allocations = g_allocationCount.load(), bytes = g_allocatedBytes.load();
+        auto start = std::chrono::steady_clock::now();
+        res.checksum = func();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        res.seconds = std::min(res.seconds, elapsed.count());
+        res.allocations = g_allocationCount.load() - allocations;
+        res.bytes = g_allocatedBytes.load() - bytes;
+    }
+    return res;
+}
+
+// what Renderer::addModel reads from an indexed model, the byte count stands for the upload
+std::size_t readWithVectors(Utils::Model& model)
+{
+    std::size_t bytes = model.getIndices().size() * sizeof(int) + model.getVertices().size() * sizeof(glm::vec3);
+    if (model.supplyTexCoords())
+    {
+        bytes += model.getTexCoords().size() * sizeof(glm::vec2);
+    }
+    if (model.supplyNormals())
+    {
+        bytes += model.getNormals().size() * sizeof(glm::vec3);
+    }
+    if (model.supplyTangents())
+    {
+        bytes += model.getSTangents().size() * sizeof(glm::vec3) + model.getTTangents().size() * sizeof(glm::vec3);
+    }
+    return bytes;
+}
+
+std::size_t readWithViews(Utils::Model& model)
+{
+    std::size_t bytes = model.getIndicesView().size_bytes() + model.getVerticesView().size_bytes();
+    if (model.supplyTexCoords())
+    {
+        bytes += model.getTexCoordsView().size_bytes();
+    }
+    if (model.supplyNormals())
+    {
+        bytes += model.getNormalsView().size_bytes();
+    }
+    if (model.supplyTangents())
+    {
+        bytes += model.getSTangentsView().size_bytes() + model.getTTangentsView().size_bytes();
+    }
+    return bytes;
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 10;
+    std::vector<std::pair<std::string, std::shared_ptr<Utils::Model>>> models = {
+        { "Sphere(48)", std::make_shared<Utils::Sphere>(48) },
+        { "Sphere(1024)", std::make_shared<Utils::Sphere>(1024) },
+        { "Torus(1, 3, 48)", std::make_shared<Utils::Torus>(1.0f, 3.0f, 48) },
+        { "Plane(0)", std::make_shared<Utils::Plane>(0.0f) },
+    };
+    if (argc > 1)
+    {
+        models.emplace_back(argv[1], std::make_shared<Utils::ImportedModel>(argv[1]));
+    }
+
+    bool consistent = true;
+    std::cout << std::format("{:<20}{:>14}{:>14}{:>12}{:>14}{:>14}{:>12}\n", "model", "vector allocs", "vector MB", "vector ms", "span allocs", "span MB", "span ms");
+    for (auto& [name, spModel] : models)
+    {
+        Utils::Model& model = *spModel;
+        Measurement vectors = measure(repeat, [&]() { return readWithVectors(model); });
+        Measurement views = measure(repeat, [&]() { return readWithViews(model); });
+        consistent = consistent && vectors.checksum == views.checksum;
+        std::cout << std::format("{:<20}{:>14}{:>14.2f}{:>12.3f}{:>14}{:>14.2f}{:>12.3f}\n", name,
+                                 vectors.allocations, vectors.bytes / (1024.0 * 1024.0), vectors.seconds * 1000.0,
+                                 views.allocations, views.bytes / (1024.0 * 1024.0), views.seconds * 1000.0);
+    }
+    std::cout << std::format("same data size through both APIs: {}\n", consistent ? "yes" : "NO");
+    return consistent ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <glm/glm.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <span>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <algorithm>
+#include <Model.h>
+#include <Sphere.h>
+#include <Torus.h>
+#include <Plane.h>
+#include <ImportedModel.h>
+#include <VertexQuantization.h>
+
+// vertex memory of the quantized upload of Renderer::addModel (quantize = true) against 32 bits floats and indices,
+// with the largest errors of the encodings and the time to encode.
+// usage: 04VertexQuantization [model.obj] [repeat]
+
+struct QuantizationResult
+{
+    std::size_t vertexCount = 0;
+    std::size_t floatBytes = 0;       // vertex buffers of the float upload
+    std::size_t quantizedBytes = 0;   // vertex buffers of the quantized upload
+    std::size_t floatIndexBytes = 0;
+    std::size_t quantizedIndexBytes = 0;
+    bool shortIndices = false;
+    float maxDirectionError = 0.0f;   // degrees
+    float maxTexCoordError = 0.0f;
+    double seconds = 1e30;
+};
+
+std::span<const float> floatsOf(std::span<const glm::vec3> vectors)
+{
+    return std::span<const float>(reinterpret_cast<const float*>(vectors.data()), vectors.size() * 3);
+}
+
+std::span<const float> floatsOf(std::span<const glm::vec2> vectors)
+{
+    return std::span<const float>(reinterpret_cast<const float*>(vectors.data()), vectors.size() * 2);
+}
+
+// angle between the direction and its decoded encoding
+float directionError(glm::vec3 direction, std::int16_t x, std::int16_t y)
+{
+    if (glm::length(direction) == 0.0f)
+    {
+        return 0.0f;
+    }
+    glm::vec3 decoded = Utils::octDecode({ x, y });
+    glm::vec3 c = glm::cross(glm::normalize(direction), decoded);
+    // asin of the cross product is accurate for small angles where acos of the dot product is not
+    return glm::degrees(std::asin(std::min(1.0f, glm::length(c))));
+}
+
+// the same encodings as the quantization of the Renderer
+QuantizationResult quantize(Utils::Model& model, int repeat)
+{
+    QuantizationResult res;
+    auto indices = model.getIndicesView();
+    auto vertices = model.getVerticesView();
+    auto texCoords = model.getTexCoordsView();
+    std::vector<std::span<const glm::vec3>> directions;
+    if (model.supplyNormals())
+    {
+        directions.push_back(model.getNormalsView());
+    }
+    if (model.supplyTangents())
+    {
+        directions.push_back(model.getSTangentsView());
+        directions.push_back(model.getTTangentsView());
+    }
+    res.vertexCount = vertices.size();
+    res.shortIndices = vertices.size() <= Utils::maxShortIndexVertexCount;
+    res.floatBytes = vertices.size_bytes() + texCoords.size_bytes();
+    res.floatIndexBytes = indices.size_bytes();
+    for (auto view : directions)
+    {
+        res.floatBytes += view.size_bytes();
+    }
+
+    for (int i = 0; i < repeat; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::size_t quantizedBytes = vertices.size_bytes();
+        auto halfTexCoords = Utils::quantizeHalfFloats(floatsOf(texCoords));
+        quantizedBytes += halfTexCoords.size() * sizeof(std::uint16_t);
+        std::vector<std::vector<std::int16_t>> encodedDirections;
+        for (auto view : directions)
+        {
+            encodedDirections.push_back(Utils::quantizeDirections(floatsOf(view)));
+            quantizedBytes += encodedDirections.back().size() * sizeof(std::int16_t);
+        }
+        std::size_t quantizedIndexBytes = indices.size_bytes();
+        if (res.shortIndices)
+        {
+            quantizedIndexBytes = Utils::narrowIndices(indices).size() * sizeof(std::uint16_t);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        res.seconds = std::min(res.seconds, elapsed.count());
+        res.quantizedBytes = quantizedBytes;
+        res.quantizedIndexBytes = quantizedIndexBytes;
+
+        if (i == 0)
+        {
+            for (std::size_t j = 0; j < texCoords.size(); j++)
+            {
+                glm::vec2 decoded(Utils::halfToFloat(halfTexCoords[j * 2]), Utils::halfToFloat(halfTexCoords[j * 2 + 1]));
+                glm::vec2 error = glm::abs(decoded - texCoords[j]);
+                res.maxTexCoordError = std::max({ res.maxTexCoordError, error.x, error.y });
+            }
+            for (std::size_t k = 0; k < directions.size(); k++)
+            {
+                for (std::size_t j = 0; j < directions[k].size(); j++)
+                {
+                    float error = directionError(directions[k][j], encodedDirections[k][j * 2], encodedDirections[k][j * 2 + 1]);
+                    res.maxDirectionError = std::max(res.maxDirectionError, error);
+                }
+            }
+        }
+    }
+    return res;
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 10;
+    std::vector<std::pair<std::string, std::shared_ptr<Utils::Model>>> models = {
+        { "Sphere(48)", std::make_shared<Utils::Sphere>(48) },
+        { "Sphere(1024)", std::make_shared<Utils::Sphere>(1024) },
+        { "Torus(1, 3, 48)", std::make_shared<Utils::Torus>(1.0f, 3.0f, 48) },
+        { "Plane(0)", std::make_shared<Utils::Plane>(0.0f) },
+    };
+    if (argc > 1)
+    {
+        models.emplace_back(argv[1], std::make_shared<Utils::ImportedModel>(argv[1]));
+    }
+
+    std::size_t totalFloatBytes = 0, totalQuantizedBytes = 0, totalFloatIndexBytes = 0, totalQuantizedIndexBytes = 0;
+    std::cout << std::format("{:<20}{:>10}{:>10}{:>10}{:>12}{:>10}{:>8}{:>14}{:>12}{:>10}\n",
+                             "model", "vertices", "float B/v", "quant B/v", "vertex cut", "indices", "index cut", "dir err deg", "uv err", "ms");
+    for (auto& [name, spModel] : models)
+    {
+        QuantizationResult res = quantize(*spModel, repeat);
+        totalFloatBytes += res.floatBytes;
+        totalQuantizedBytes += res.quantizedBytes;
+        totalFloatIndexBytes += res.floatIndexBytes;
+        totalQuantizedIndexBytes += res.quantizedIndexBytes;
+        std::cout << std::format("{:<20}{:>10}{:>10}{:>10}{:>11.2f}x{:>10}{:>7.2f}x{:>14.5f}{:>12.6f}{:>10.3f}\n", name, res.vertexCount,
+                                 res.floatBytes / res.vertexCount, res.quantizedBytes / res.vertexCount,
+                                 double(res.floatBytes) / double(res.quantizedBytes), res.shortIndices ? "16 bits" : "32 bits",
+                                 double(res.floatIndexBytes) / double(res.quantizedIndexBytes),
+                                 res.maxDirectionError, res.maxTexCoordError, res.seconds * 1000.0);
+    }
+    std::cout << std::format("all models: vertex buffers {:.2f} MB as floats, {:.2f} MB quantized, {:.2f}x smaller\n",
+                             totalFloatBytes / (1024.0 * 1024.0), totalQuantizedBytes / (1024.0 * 1024.0), double(totalFloatBytes) / double(totalQuantizedBytes));
+    std::cout << std::format("            index buffers {:.2f} MB as 32 bits, {:.2f} MB quantized, {:.2f}x smaller\n",
+                             totalFloatIndexBytes / (1024.0 * 1024.0), totalQuantizedIndexBytes / (1024.0 * 1024.0),
+                             double(totalFloatIndexBytes) / double(totalQuantizedIndexBytes));
+    return 0;
+}
\ No newline at end of file
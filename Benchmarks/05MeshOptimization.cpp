@@ -0,0 +1,91 @@
+#include <glm/glm.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <span>
+#include <array>
+#include <format>
+#include <memory>
+#include <algorithm>
+#include <Model.h>
+#include <Sphere.h>
+#include <Torus.h>
+#include <Plane.h>
+#include <ImportedModel.h>
+#include <MeshOptimizer.h>
+
+// post-transform cache efficiency of the generated index order against the optimized order of Renderer::addModel (OptimizeMesh),
+// ACMR (transformed vertices per triangle) and ATVR (transformed vertices per vertex) for FIFO caches of several sizes.
+// usage: 05MeshOptimization [model.obj] [repeat]
+
+// the triangles of the mesh by vertex position, each rotated to start at its smallest corner, sorted
+std::vector<std::array<int, 3>> canonicalTriangles(std::span<const int> indices, std::span<const int> vertexIds)
+{
+    std::vector<std::array<int, 3>> res;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<int, 3> t = { vertexIds[indices[i]], vertexIds[indices[i + 1]], vertexIds[indices[i + 2]] };
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        res.push_back(t);
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 3;
+    std::vector<std::pair<std::string, std::shared_ptr<Utils::Model>>> models = {
+        { "Sphere(48)", std::make_shared<Utils::Sphere>(48) },
+        { "Sphere(512)", std::make_shared<Utils::Sphere>(512) },
+        { "Torus(1, 3, 48)", std::make_shared<Utils::Torus>(1.0f, 3.0f, 48) },
+        { "Plane(0)", std::make_shared<Utils::Plane>(0.0f) },
+    };
+    if (argc > 1)
+    {
+        models.emplace_back(argv[1], std::make_shared<Utils::ImportedModel>(argv[1]));
+    }
+    const std::size_t cacheSizes[] = { Utils::optimizerCacheSize, Utils::ImportedModel::postTransformCacheSize };
+
+    bool valid = true;
+    std::cout << std::format("{:<20}{:>10}{:>7}{:>13}{:>12}{:>13}{:>12}{:>10}\n", "model", "triangles", "cache",
+                             "ACMR before", "ACMR after", "ATVR before", "ATVR after", "ms");
+    for (auto& [name, spModel] : models)
+    {
+        auto indices = spModel->getIndicesView();
+        auto vertices = spModel->getVerticesView();
+        Utils::OptimizedMesh mesh;
+        double seconds = 1e30;
+        for (int i = 0; i < repeat; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            mesh = Utils::optimizeMesh(indices, vertices);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds = std::min(seconds, elapsed.count());
+        }
+
+        // the same triangles with the same winding, vertices identified by their old index
+        std::vector<int> oldIds(vertices.size()), newIds(mesh.vertexCount);
+        for (std::size_t v = 0; v < vertices.size(); v++)
+        {
+            oldIds[v] = int(v);
+            if (mesh.remap[v] >= 0)
+            {
+                newIds[mesh.remap[v]] = int(v);
+            }
+        }
+        bool sameTriangles = canonicalTriangles(indices, oldIds) == canonicalTriangles(mesh.indices, newIds);
+        valid = valid && sameTriangles;
+
+        for (std::size_t cacheSize : cacheSizes)
+        {
+            Utils::VertexCacheStatistics before = Utils::analyzeVertexCache(indices, vertices.size(), cacheSize);
+            Utils::VertexCacheStatistics after = Utils::analyzeVertexCache(mesh.indices, mesh.vertexCount, cacheSize);
+            std::cout << std::format("{:<20}{:>10}{:>7}{:>13.3f}{:>12.3f}{:>13.3f}{:>12.3f}{:>10.2f}{}\n", name, before.triangles, cacheSize,
+                                     before.acmr, after.acmr, before.atvr, after.atvr, seconds * 1000.0, sameTriangles ? "" : "  TRIANGLES DIFFER");
+        }
+    }
+    std::cout << std::format("same triangles after optimization: {}\n", valid ? "yes" : "NO");
+    return valid ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <format>
+#include <memory>
+#include <algorithm>
+#include <Model.h>
+#include <Sphere.h>
+#include <Torus.h>
+#include <ImportedModel.h>
+#include <MeshSimplifier.h>
+
+// levels of detail of Renderer::addModel (GenerateLods): triangles and error of every level, the time to build the chain,
+// and the triangles drawn for a row of copies of the model at growing distance with the level selection of Renderer::display.
+// usage: 06LodGeneration [model.obj] [repeat]
+
+// same rule as Renderer::selectModelLods, for a 1080 pixels high viewport with 60 degrees vertical field of view
+std::size_t selectLod(const std::vector<Utils::MeshLod>& lods, float distance, float pixelError)
+{
+    float pixelsPerUnit = 1.0f / std::tan(glm::pi<float>() / 6.0f) * 1080.0f * 0.5f;
+    std::size_t lod = 0;
+    while (distance > 0.0f && lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit / distance <= pixelError)
+    {
+        lod++;
+    }
+    return lod;
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 3;
+    std::vector<std::pair<std::string, std::shared_ptr<Utils::Model>>> models = {
+        { "Sphere(256)", std::make_shared<Utils::Sphere>(256) },
+        { "Torus(1, 3, 256)", std::make_shared<Utils::Torus>(1.0f, 3.0f, 256) },
+    };
+    if (argc > 1)
+    {
+        models.emplace_back(argv[1], std::make_shared<Utils::ImportedModel>(argv[1]));
+    }
+
+    for (auto& [name, spModel] : models)
+    {
+        auto indices = spModel->getIndicesView();
+        auto vertices = spModel->getVerticesView();
+        std::vector<Utils::MeshLod> lods;
+        double seconds = 1e30;
+        for (int i = 0; i < repeat; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Utils::buildLodChain(indices, vertices, lods);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds = std::min(seconds, elapsed.count());
+        }
+        float radius = 0.0f;
+        for (auto& v : vertices)
+        {
+            radius = std::max(radius, glm::length(v));
+        }
+
+        std::cout << std::format("{}: {} vertices, bounding radius {:.3f}, chain built in {:.3f} s\n", name, vertices.size(), radius, seconds);
+        for (std::size_t i = 0; i < lods.size(); i++)
+        {
+            std::cout << std::format("    level {}: {:>9} triangles, error {:.6f} ({:.4f}% of the radius)\n", i, lods[i].indexCount / 3,
+                                     lods[i].error, radius > 0.0f ? 100.0f * lods[i].error / radius : 0.0f);
+        }
+
+        // 100 copies from 2 to 200 radii away from the eye
+        std::size_t fullTriangles = 0, lodTriangles = 0;
+        for (int i = 1; i <= 100; i++)
+        {
+            float distance = radius * 2.0f * float(i) - radius;
+            fullTriangles += lods[0].indexCount / 3;
+            lodTriangles += lods[selectLod(lods, distance, 1.0f)].indexCount / 3;
+        }
+        std::cout << std::format("    100 copies at 2 to 200 radii: {} triangles at full detail, {} with 1 pixel error levels, {:.2f}x fewer\n",
+                                 fullTriangles, lodTriangles, double(fullTriangles) / double(std::max<std::size_t>(lodTriangles, 1)));
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <span>
+#include <format>
+#include <memory>
+#include <algorithm>
+#include <Model.h>
+#include <Sphere.h>
+#include <Torus.h>
+#include <ImportedModel.h>
+#include <MeshOptimizer.h>
+#include <Meshlets.h>
+#include <Frustum.h>
+
+// meshlets of Renderer::addModel (OptimizeMesh | BuildMeshlets) and the CPU culling pass of Renderer::display:
+// meshlet sizes, build time, and for several viewpoints the triangles left after frustum and normal cone culling, the draw ranges
+// and the culling time. every culled meshlet is checked: no triangle of a back facing meshlet may face the eye.
+// usage: 07MeshletCulling [model.obj] [repeat]
+
+struct Viewpoint
+{
+    std::string name;
+    glm::vec3 eye;
+    glm::vec3 target;
+};
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 2 ? std::stoi(argv[2]) : 100;
+    std::vector<std::pair<std::string, std::shared_ptr<Utils::Model>>> models = {
+        { "Sphere(256)", std::make_shared<Utils::Sphere>(256) },
+        { "Torus(1, 3, 256)", std::make_shared<Utils::Torus>(1.0f, 3.0f, 256) },
+    };
+    if (argc > 1)
+    {
+        models.emplace_back(argv[1], std::make_shared<Utils::ImportedModel>(argv[1]));
+    }
+
+    bool valid = true;
+    for (auto& [name, spModel] : models)
+    {
+        Utils::OptimizedMesh mesh = Utils::optimizeMesh(spModel->getIndicesView(), spModel->getVerticesView());
+        std::vector<glm::vec3> vertices = Utils::remapVertices(spModel->getVerticesView(), mesh.remap, mesh.vertexCount);
+        std::vector<Utils::Meshlet> meshlets;
+        std::vector<int> indices;
+        double seconds = 1e30;
+        for (int i = 0; i < std::min(repeat, 3); i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            indices = Utils::buildMeshlets(mesh.indices, vertices, meshlets);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds = std::min(seconds, elapsed.count());
+        }
+
+        glm::vec3 minCorner = vertices.front(), maxCorner = minCorner;
+        std::size_t meshletVertices = 0, cones = 0;
+        for (const auto& v : vertices)
+        {
+            minCorner = glm::min(minCorner, v);
+            maxCorner = glm::max(maxCorner, v);
+        }
+        for (const auto& meshlet : meshlets)
+        {
+            meshletVertices += meshlet.vertexCount;
+            cones += meshlet.coneCutoff < 1.0f;
+        }
+        glm::vec3 center = (minCorner + maxCorner) * 0.5f;
+        float radius = glm::length(maxCorner - minCorner) * 0.5f;
+        std::size_t triangles = indices.size() / 3;
+        std::cout << std::format("{}: {} triangles, {} meshlets, {:.1f} vertices and {:.1f} triangles per meshlet, {:.1f}% with a normal cone, "
+                                 "built in {:.3f} s\n", name, triangles, meshlets.size(), double(meshletVertices) / double(meshlets.size()),
+                                 double(triangles) / double(meshlets.size()), 100.0 * double(cones) / double(meshlets.size()), seconds);
+
+        std::vector<Viewpoint> viewpoints = {
+            { "whole model, front", center + glm::vec3(0.0f, 0.0f, 3.0f * radius), center },
+            { "whole model, above", center + glm::vec3(0.0f, 3.0f * radius, 0.1f * radius), center },
+            { "whole model, diagonal", center + glm::vec3(1.7f, 1.7f, 1.7f) * radius, center },
+            { "close up", center + glm::vec3(0.0f, 0.0f, 1.5f * radius), center + glm::vec3(0.5f * radius, 0.0f, 0.0f) },
+            { "looking away", center + glm::vec3(0.0f, 0.0f, 3.0f * radius), center + glm::vec3(0.0f, 0.0f, 6.0f * radius) },
+        };
+        glm::mat4 pMat = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.01f * radius, 100.0f * radius);
+        std::cout << std::format("    {:<24}{:>10}{:>10}{:>11}{:>9}{:>10}{:>12}\n", "view", "visible", "outside", "backface",
+                                 "ranges", "tris %", "cull us");
+        for (const auto& view : viewpoints)
+        {
+            Utils::Frustum frustum(pMat * glm::lookAt(view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f)));
+            std::vector<Utils::IndexRange> ranges;
+            Utils::MeshletCullingStatistics stats;
+            double cullSeconds = 1e30;
+            for (int i = 0; i < repeat; i++)
+            {
+                stats = Utils::MeshletCullingStatistics{};
+                auto start = std::chrono::steady_clock::now();
+                Utils::cullMeshlets(meshlets, frustum, view.eye, true, ranges, &stats);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                cullSeconds = std::min(cullSeconds, elapsed.count());
+            }
+
+            // the cone test is conservative: every triangle of a back facing meshlet faces away from the eye
+            std::size_t wronglyCulled = 0;
+            for (const auto& meshlet : meshlets)
+            {
+                Utils::MeshletCullingStatistics single;
+                if (Utils::isMeshletVisible(meshlet, frustum, view.eye, true, &single) || single.backFacing == 0)
+                {
+                    continue;
+                }
+                for (std::size_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+                {
+                    glm::vec3 p0 = vertices[indices[i]], p1 = vertices[indices[i + 1]], p2 = vertices[indices[i + 2]];
+                    glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                    if (glm::dot(view.eye - p0, n) > 1e-4f * glm::length(n) * radius)
+                    {
+                        wronglyCulled++;
+                    }
+                }
+            }
+            valid = valid && wronglyCulled == 0;
+            std::cout << std::format("    {:<24}{:>10}{:>10}{:>11}{:>9}{:>10.1f}{:>12.1f}{}\n", view.name, stats.meshlets - stats.outsideFrustum - stats.backFacing,
+                                     stats.outsideFrustum, stats.backFacing, stats.ranges, 100.0 * double(stats.visibleTriangles) / double(triangles),
+                                     cullSeconds * 1e6, wronglyCulled ? std::format("  {} FRONT FACING TRIANGLES CULLED", wronglyCulled) : "");
+        }
+    }
+    std::cout << std::format("normal cone culling conservative: {}\n", valid ? "yes" : "NO");
+    return valid ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include <glad/gl.h> // glad2!
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <array>
+#include <format>
+#include <functional>
+#include <Renderer.h>
+#include <Shader.h>
+
+// per-frame cost of the uniform updates of Renderer::display for a lit model: 5 lights of each kind, material, matrices.
+// glGetUniformLocation with concatenated names for every set (before), Shader::set* by name from the reflected table,
+// and typed Uniform handles looked up once (what display uses for the model-specific uniforms, the lights are in a uniform block now).
+// usage: 08UniformUpdates [model count] [frames]
+
+const char* vertexShader = R"glsl(
+#version 430
+#define LIGHT_SIZE 5
+struct DirectionalLight { vec4 ambient; vec4 diffuse; vec4 specular; vec3 direction; };
+struct PointLight { vec4 ambient; vec4 diffuse; vec4 specular; vec3 location; float constant; float linear; float quadratic; };
+struct SpotLight { vec4 ambient; vec4 diffuse; vec4 specular; vec3 location; vec3 direction; float cutOffAngle; float strengthFactorExponent; };
+struct Material { vec4 ambient; vec4 diffuse; vec4 specular; float shininess; };
+layout (location = 0) in vec3 position;
+uniform mat4 mvMatrix;
+uniform mat4 projMatrix;
+uniform mat4 normMatrix;
+uniform vec4 globalAmbient;
+uniform uint directionalLightsSize;
+uniform uint pointLightsSize;
+uniform uint spotLightsSize;
+uniform DirectionalLight directionalLights[LIGHT_SIZE];
+uniform PointLight pointLights[LIGHT_SIZE];
+uniform SpotLight spotLights[LIGHT_SIZE];
+uniform Material material;
+uniform float materialWeight;
+uniform float textureWeight;
+out vec4 varyingColor;
+void main()
+{
+    // use every uniform, so that all of them are active
+    vec4 c = globalAmbient + (material.ambient + material.diffuse + material.specular) * material.shininess * materialWeight * textureWeight;
+    for (uint i = 0; i < directionalLightsSize; i++)
+    {
+        c += directionalLights[i].ambient + directionalLights[i].diffuse + directionalLights[i].specular + vec4(directionalLights[i].direction, 0.0);
+    }
+    for (uint i = 0; i < pointLightsSize; i++)
+    {
+        c += pointLights[i].ambient + pointLights[i].diffuse + pointLights[i].specular + vec4(pointLights[i].location, 0.0) *
+             (pointLights[i].constant + pointLights[i].linear + pointLights[i].quadratic);
+    }
+    for (uint i = 0; i < spotLightsSize; i++)
+    {
+        c += spotLights[i].ambient + spotLights[i].diffuse + spotLights[i].specular + vec4(spotLights[i].location + spotLights[i].direction, 0.0) *
+             (spotLights[i].cutOffAngle + spotLights[i].strengthFactorExponent);
+    }
+    varyingColor = c * (normMatrix * vec4(position, 0.0)).x;
+    gl_Position = projMatrix * mvMatrix * vec4(position, 1.0);
+}
+)glsl";
+
+const char* fragmentShader = R"glsl(
+#version 430
+in vec4 varyingColor;
+out vec4 color;
+void main()
+{
+    color = varyingColor;
+}
+)glsl";
+
+constexpr std::size_t lightSize = 5;
+// matrices, global ambient and light counts, the lights, material and weights
+constexpr std::size_t uniformsPerModel = 7 + lightSize * (4 + 7 + 7) + 6;
+
+struct Light
+{
+    glm::vec4 ambient = glm::vec4(0.1f);
+    glm::vec4 diffuse = glm::vec4(0.5f);
+    glm::vec4 specular = glm::vec4(0.9f);
+    glm::vec3 location = glm::vec3(1.0f, 2.0f, 3.0f);
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    float constant = 1.0f, linear = 0.1f, quadratic = 0.01f;
+    float cutOffAngle = 0.5f, exponent = 2.0f;
+};
+
+struct DirectionalLightUniforms { Utils::Uniform<glm::vec4> ambient, diffuse, specular; Utils::Uniform<glm::vec3> direction; };
+struct PointLightUniforms
+{
+    Utils::Uniform<glm::vec4> ambient, diffuse, specular;
+    Utils::Uniform<glm::vec3> location;
+    Utils::Uniform<float> constant, linear, quadratic;
+};
+struct SpotLightUniforms
+{
+    Utils::Uniform<glm::vec4> ambient, diffuse, specular;
+    Utils::Uniform<glm::vec3> location, direction;
+    Utils::Uniform<float> cutOffAngle, exponent;
+};
+
+// glGetUniformLocation for every set, as Shader::set* did before the uniform table
+void updateByLocationQuery(GLuint program, const Light& light, const glm::mat4& mv, const glm::mat4& proj)
+{
+    auto location = [&](const std::string& name) { return glGetUniformLocation(program, name.c_str()); };
+    glUniformMatrix4fv(location("mvMatrix"), 1, GL_FALSE, glm::value_ptr(mv));
+    glUniformMatrix4fv(location("projMatrix"), 1, GL_FALSE, glm::value_ptr(proj));
+    glUniformMatrix4fv(location("normMatrix"), 1, GL_FALSE, glm::value_ptr(mv));
+    glUniform4fv(location("globalAmbient"), 1, glm::value_ptr(light.ambient));
+    glUniform1ui(location("directionalLightsSize"), GLuint(lightSize));
+    for (std::size_t j = 0; j < lightSize; j++)
+    {
+        std::string str = "directionalLights[" + std::to_string(j) + "]";
+        glUniform4fv(location(str + ".ambient"), 1, glm::value_ptr(light.ambient));
+        glUniform4fv(location(str + ".diffuse"), 1, glm::value_ptr(light.diffuse));
+        glUniform4fv(location(str + ".specular"), 1, glm::value_ptr(light.specular));
+        glUniform3fv(location(str + ".direction"), 1, glm::value_ptr(light.direction));
+    }
+    glUniform1ui(location("pointLightsSize"), GLuint(lightSize));
+    for (std::size_t j = 0; j < lightSize; j++)
+    {
+        std::string str = "pointLights[" + std::to_string(j) + "]";
+        glUniform4fv(location(str + ".ambient"), 1, glm::value_ptr(light.ambient));
+        glUniform4fv(location(str + ".diffuse"), 1, glm::value_ptr(light.diffuse));
+        glUniform4fv(location(str + ".specular"), 1, glm::value_ptr(light.specular));
+        glUniform3fv(location(str + ".location"), 1, glm::value_ptr(light.location));
+        glUniform1f(location(str + ".constant"), light.constant);
+        glUniform1f(location(str + ".linear"), light.linear);
+        glUniform1f(location(str + ".quadratic"), light.quadratic);
+    }
+    glUniform1ui(location("spotLightsSize"), GLuint(lightSize));
+    for (std::size_t j = 0; j < lightSize; j++)
+    {
+        std::string str = "spotLights[" + std::to_string(j) + "]";
+        glUniform4fv(location(str + ".ambient"), 1, glm::value_ptr(light.ambient));
+        glUniform4fv(location(str + ".diffuse"), 1, glm::value_ptr(light.diffuse));
+        glUniform4fv(location(str + ".specular"), 1, glm::value_ptr(light.specular));
+        glUniform3fv(location(str + ".location"), 1, glm::value_ptr(light.location));
+        glUniform3fv(location(str + ".direction"), 1, glm::value_ptr(light.direction));
+        glUniform1f(location(str + ".cutOffAngle"), light.cutOffAngle);
+        glUniform1f(location(str + ".strengthFactorExponent"), light.exponent);
+    }
+    glUniform1f(location("materialWeight"), 0.5f);
+    glUniform1f(location("textureWeight"), 0.5f);
+    glUniform4fv(location("material.ambient"), 1, glm::value_ptr(light.ambient));
+    glUniform4fv(location("material.diffuse"), 1, glm::value_ptr(light.diffuse));
+    glUniform4fv(location("material.specular"), 1, glm::value_ptr(light.specular));
+    glUniform1f(location("material.shininess"), 32.0f);
+}
+
+// Shader::set* by name, the names are still built, the locations come from the reflected table
+void updateByName(const Utils::Shader& shader, const Light& light, const glm::mat4& mv, const glm::mat4& proj)
+{
+    shader.setMat4("mvMatrix", mv);
+    shader.setMat4("projMatrix", proj);
+    shader.setMat4("normMatrix", mv);
+    shader.setVec4("globalAmbient", light.ambient);
+    shader.setUint("directionalLightsSize", GLuint(lightSize));
+    for (std::size_t j = 0; j < lightSize; j++)
+    {
+        std::string str = "directionalLights[" + std::to_string(j) + "]";
+        shader.setVec4(str + ".ambient", light.ambient);
+        shader.setVec4(str + ".diffuse", light.diffuse);
+        shader.setVec4(str + ".specular", light.specular);
+        shader.setVec3(str + ".direction", light.direction);
+    }
+    shader.setUint("pointLightsSize", GLuint(lightSize));
+    for (std::size_t j = 0; j < lightSize; j++)
+    {
+        std::string str = "pointLights[" + std::to_string(j) + "]";
+        shader.setVec4(str + ".ambient", light.ambient);
+        shader.setVec4(str + ".diffuse", light.diffuse);
+        shader.setVec4(str + ".specular", light.specular);
+        shader.setVec3(str + ".location", light.location);
+        shader.setFloat(str + ".constant", light.constant);
+        shader.setFloat(str + ".linear", light.linear);
+        shader.setFloat(str + ".quadratic", light.quadratic);
+    }
+    shader.setUint("spotLightsSize", GLuint(lightSize));
+    for (std::size_t j = 0; j < lightSize; j++)
+    {
+        std::string str = "spotLights[" + std::to_string(j) + "]";
+        shader.setVec4(str + ".ambient", light.ambient);
+        shader.setVec4(str + ".diffuse", light.diffuse);
+        shader.setVec4(str + ".specular", light.specular);
+        shader.setVec3(str + ".location", light.location);
+        shader.setVec3(str + ".direction", light.direction);
+        shader.setFloat(str + ".cutOffAngle", light.cutOffAngle);
+        shader.setFloat(str + ".strengthFactorExponent", light.exponent);
+    }
+    shader.setFloat("materialWeight", 0.5f);
+    shader.setFloat("textureWeight", 0.5f);
+    shader.setVec4("material.ambient", light.ambient);
+    shader.setVec4("material.diffuse", light.diffuse);
+    shader.setVec4("material.specular", light.specular);
+    shader.setFloat("material.shininess", 32.0f);
+}
+
+struct Handles
+{
+    Utils::Uniform<glm::mat4> mvMatrix, projMatrix, normMatrix;
+    Utils::Uniform<glm::vec4> globalAmbient;
+    Utils::Uniform<GLuint> directionalLightsSize, pointLightsSize, spotLightsSize;
+    std::array<DirectionalLightUniforms, lightSize> directionalLights;
+    std::array<PointLightUniforms, lightSize> pointLights;
+    std::array<SpotLightUniforms, lightSize> spotLights;
+    Utils::Uniform<float> materialWeight, textureWeight, materialShininess;
+    Utils::Uniform<glm::vec4> materialAmbient, materialDiffuse, materialSpecular;
+
+    explicit Handles(const Utils::Shader& shader)
+    {
+        mvMatrix = shader.getUniform<glm::mat4>("mvMatrix");
+        projMatrix = shader.getUniform<glm::mat4>("projMatrix");
+        normMatrix = shader.getUniform<glm::mat4>("normMatrix");
+        globalAmbient = shader.getUniform<glm::vec4>("globalAmbient");
+        directionalLightsSize = shader.getUniform<GLuint>("directionalLightsSize");
+        pointLightsSize = shader.getUniform<GLuint>("pointLightsSize");
+        spotLightsSize = shader.getUniform<GLuint>("spotLightsSize");
+        for (std::size_t j = 0; j < lightSize; j++)
+        {
+            std::string str = std::format("directionalLights[{}]", j);
+            directionalLights[j] = { shader.getUniform<glm::vec4>(str + ".ambient"), shader.getUniform<glm::vec4>(str + ".diffuse"),
+                                     shader.getUniform<glm::vec4>(str + ".specular"), shader.getUniform<glm::vec3>(str + ".direction") };
+            str = std::format("pointLights[{}]", j);
+            pointLights[j] = { shader.getUniform<glm::vec4>(str + ".ambient"), shader.getUniform<glm::vec4>(str + ".diffuse"),
+                               shader.getUniform<glm::vec4>(str + ".specular"), shader.getUniform<glm::vec3>(str + ".location"),
+                               shader.getUniform<float>(str + ".constant"), shader.getUniform<float>(str + ".linear"),
+                               shader.getUniform<float>(str + ".quadratic") };
+            str = std::format("spotLights[{}]", j);
+            spotLights[j] = { shader.getUniform<glm::vec4>(str + ".ambient"), shader.getUniform<glm::vec4>(str + ".diffuse"),
+                              shader.getUniform<glm::vec4>(str + ".specular"), shader.getUniform<glm::vec3>(str + ".location"),
+                              shader.getUniform<glm::vec3>(str + ".direction"), shader.getUniform<float>(str + ".cutOffAngle"),
+                              shader.getUniform<float>(str + ".strengthFactorExponent") };
+        }
+        materialWeight = shader.getUniform<float>("materialWeight");
+        textureWeight = shader.getUniform<float>("textureWeight");
+        materialAmbient = shader.getUniform<glm::vec4>("material.ambient");
+        materialDiffuse = shader.getUniform<glm::vec4>("material.diffuse");
+        materialSpecular = shader.getUniform<glm::vec4>("material.specular");
+        materialShininess = shader.getUniform<float>("material.shininess");
+    }
+};
+
+// typed handles, no string is built or hashed
+void updateByHandle(const Utils::Shader& shader, const Handles& h, const Light& light, const glm::mat4& mv, const glm::mat4& proj)
+{
+    shader.set(h.mvMatrix, mv);
+    shader.set(h.projMatrix, proj);
+    shader.set(h.normMatrix, mv);
+    shader.set(h.globalAmbient, light.ambient);
+    shader.set(h.directionalLightsSize, GLuint(lightSize));
+    for (const auto& u : h.directionalLights)
+    {
+        shader.set(u.ambient, light.ambient);
+        shader.set(u.diffuse, light.diffuse);
+        shader.set(u.specular, light.specular);
+        shader.set(u.direction, light.direction);
+    }
+    shader.set(h.pointLightsSize, GLuint(lightSize));
+    for (const auto& u : h.pointLights)
+    {
+        shader.set(u.ambient, light.ambient);
+        shader.set(u.diffuse, light.diffuse);
+        shader.set(u.specular, light.specular);
+        shader.set(u.location, light.location);
+        shader.set(u.constant, light.constant);
+        shader.set(u.linear, light.linear);
+        shader.set(u.quadratic, light.quadratic);
+    }
+    shader.set(h.spotLightsSize, GLuint(lightSize));
+    for (const auto& u : h.spotLights)
+    {
+        shader.set(u.ambient, light.ambient);
+        shader.set(u.diffuse, light.diffuse);
+        shader.set(u.specular, light.specular);
+        shader.set(u.location, light.location);
+        shader.set(u.direction, light.direction);
+        shader.set(u.cutOffAngle, light.cutOffAngle);
+        shader.set(u.exponent, light.exponent);
+    }
+    shader.set(h.materialWeight, 0.5f);
+    shader.set(h.textureWeight, 0.5f);
+    shader.set(h.materialAmbient, light.ambient);
+    shader.set(h.materialDiffuse, light.diffuse);
+    shader.set(h.materialSpecular, light.specular);
+    shader.set(h.materialShininess, 32.0f);
+}
+
+int main(int argc, char const *argv[])
+{
+    int modelCount = argc > 1 ? std::stoi(argv[1]) : 1000;
+    int frames = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    // the renderer only provides the context
+    Utils::Renderer renderer("08UniformUpdates", 640, 480);
+    Utils::Shader shader(vertexShader, fragmentShader);
+    shader.use();
+    Handles handles(shader);
+    Light light;
+    glm::mat4 proj = glm::perspective(1.0f, 1.5f, 0.1f, 1000.0f);
+
+    // best frame of every variant
+    auto measure = [&](const std::function<void(const glm::mat4&)>& update)
+    {
+        double best = 1e30;
+        for (int f = 0; f < frames; f++)
+        {
+            glFinish();
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < modelCount; i++)
+            {
+                update(glm::translate(glm::mat4(1.0f), glm::vec3(float(i), 0.0f, float(f))));
+            }
+            glFinish();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    };
+    double queried = measure([&](const glm::mat4& mv) { updateByLocationQuery(shader.getShaderId(), light, mv, proj); });
+    double named = measure([&](const glm::mat4& mv) { updateByName(shader, light, mv, proj); });
+    double handled = measure([&](const glm::mat4& mv) { updateByHandle(shader, handles, light, mv, proj); });
+
+    std::cout << std::format("active uniform names       : {}\n", shader.getUniformCount());
+    std::cout << std::format("models per frame           : {}, {} uniforms each\n", modelCount, uniformsPerModel);
+    std::cout << std::format("glGetUniformLocation       : {:8.3f} ms per frame\n", queried * 1000.0);
+    std::cout << std::format("Shader::set* by name       : {:8.3f} ms per frame, {:.2f}x\n", named * 1000.0, queried / named);
+    std::cout << std::format("Shader::set with handles   : {:8.3f} ms per frame, {:.2f}x\n", handled * 1000.0, queried / handled);
+    return 0;
+}
\ No newline at end of file
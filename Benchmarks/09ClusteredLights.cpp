@@ -0,0 +1,121 @@
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <format>
+#include <algorithm>
+#include <LightClusters.h>
+
+// light assignment of the clustered forward shading of Renderer::display on the CPU, for a growing number of lights:
+// assignment time, light and cluster pairs, and the lights a fragment shades with clusters compared to all lights.
+// random points in the view frustum check that the cluster of every point lists every light that reaches the point.
+// usage: 09ClusteredLights [repeat]
+
+struct Scene
+{
+    std::vector<Utils::LightVolume> pointLights;
+    std::vector<Utils::LightVolume> spotLights;
+};
+
+// lights in view space spread in front of the eye, one spot light for every 8 point lights
+Scene makeScene(std::size_t pointCount, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> x(-60.0f, 60.0f), y(-30.0f, 30.0f), z(-200.0f, -2.0f), unit(-1.0f, 1.0f);
+    Scene scene;
+    // attenuation 1 / (1 + 0.7d + 1.8d^2), the range of a small lamp
+    float range = Utils::attenuationRange(1.0f, 0.7f, 1.8f);
+    for (std::size_t i = 0; i < pointCount; i++)
+    {
+        scene.pointLights.push_back(Utils::LightVolume{ glm::vec3(x(rng), y(rng), z(rng)), range });
+    }
+    for (std::size_t i = 0; i < pointCount / 8; i++)
+    {
+        // spot lights do not fade, their cone bounds them
+        glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), -1.0f, unit(rng)));
+        scene.spotLights.push_back(Utils::LightVolume{ glm::vec3(x(rng), 30.0f, z(rng)), Utils::infiniteLightRange, direction, 0.3f });
+    }
+    return scene;
+}
+
+bool reaches(const Utils::LightVolume& light, glm::vec3 p, bool spot)
+{
+    glm::vec3 v = p - light.position;
+    float distance = glm::length(v);
+    if (distance > light.range)
+    {
+        return false;
+    }
+    return !spot || distance == 0.0f || glm::dot(v / distance, light.direction) > std::cos(light.cutOffAngle);
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 1 ? std::stoi(argv[1]) : 20;
+    const int width = 1920, height = 1080;
+    glm::mat4 proj = glm::perspective(glm::pi<float>() / 3.0f, float(width) / float(height), 0.1f, 1000.0f);
+    Utils::LightClusterGrid grid;
+    auto start = std::chrono::steady_clock::now();
+    grid.update(proj, width, height);
+    std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - start;
+    glm::uvec3 size = grid.getSize();
+    std::cout << std::format("{}x{}x{} clusters for {}x{} pixels, bounds built in {:.3f} ms\n", size.x, size.y, size.z, width, height,
+                             buildTime.count() * 1000.0);
+    std::cout << std::format("{:>8}{:>8}{:>12}{:>12}{:>12}{:>14}{:>14}{:>10}\n", "points", "spots", "assign us", "pairs", "max/cluster",
+                             "all lights", "per sample", "missed");
+
+    std::mt19937 rng(7);
+    bool valid = true;
+    for (std::size_t pointCount : { 16, 64, 256, 1024, 4096 })
+    {
+        Scene scene = makeScene(pointCount, rng);
+        double seconds = 1e30;
+        for (int i = 0; i < repeat; i++)
+        {
+            start = std::chrono::steady_clock::now();
+            grid.assignLights(scene.pointLights, scene.spotLights);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds = std::min(seconds, elapsed.count());
+        }
+        const auto& stats = grid.getStatistics();
+        const auto& clusters = grid.getClusters();
+        const auto& indices = grid.getLightIndices();
+
+        // points uniform on the screen with a depth uniform in the logarithm, like the slices
+        std::uniform_real_distribution<float> px(0.0f, float(width)), py(0.0f, float(height)), logDepth(std::log(0.1f), std::log(1000.0f));
+        glm::mat4 inverse = glm::inverse(proj);
+        std::size_t samples = 20000, shaded = 0, missed = 0;
+        for (std::size_t s = 0; s < samples; s++)
+        {
+            glm::vec2 fragCoord(px(rng), py(rng));
+            float depth = std::exp(logDepth(rng));
+            // the view space point on the ray through the pixel at that depth
+            glm::vec4 ray = inverse * glm::vec4(fragCoord.x / float(width) * 2.0f - 1.0f, fragCoord.y / float(height) * 2.0f - 1.0f, 1.0f, 1.0f);
+            glm::vec3 direction = glm::vec3(ray) / ray.w;
+            glm::vec3 p = direction * (depth / -direction.z);
+
+            const glm::uvec4& cluster = clusters[grid.getClusterIndex(fragCoord, depth)];
+            shaded += cluster.y + cluster.z;
+            auto listed = [&](std::uint32_t light, std::uint32_t first, std::uint32_t count)
+            {
+                return std::find(indices.begin() + first, indices.begin() + first + count, light) != indices.begin() + first + count;
+            };
+            for (std::uint32_t i = 0; i < scene.pointLights.size(); i++)
+            {
+                missed += reaches(scene.pointLights[i], p, false) && !listed(i, cluster.x, cluster.y);
+            }
+            for (std::uint32_t i = 0; i < scene.spotLights.size(); i++)
+            {
+                missed += reaches(scene.spotLights[i], p, true) && !listed(i, cluster.x + cluster.y, cluster.z);
+            }
+        }
+        valid = valid && missed == 0;
+        std::cout << std::format("{:>8}{:>8}{:>12.1f}{:>12}{:>12}{:>14}{:>14.2f}{:>10}\n", stats.pointLights, stats.spotLights, seconds * 1e6,
+                                 stats.lightIndices, stats.maxClusterLights, stats.pointLights + stats.spotLights,
+                                 double(shaded) / double(samples), missed);
+    }
+    std::cout << std::format("clusters list every light that reaches them: {}\n", valid ? "yes" : "NO");
+    return valid ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include <glad/gl.h> // glad2!
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <format>
+#include <algorithm>
+#include <Renderer.h>
+#include <ProgramBinaryCache.h>
+
+// startup cost of the programs the Renderer constructor builds (the permutations of the lighting programs are built later in display):
+// cold with an empty program binary cache (compiled from source, binaries stored), warm with the binaries of the cold start (loaded).
+// the time of a bare window and context is subtracted. drivers may cache compiled shaders themselves,
+// e.g. Mesa: run with MESA_SHADER_CACHE_DISABLE=true to compare with compilation from source without any cache.
+// usage: 10ProgramBinaryCache [runs] [cache directory]
+
+// seconds to create a window with a context, as the Renderer constructor does before it builds the programs
+double contextStartup()
+{
+    auto start = std::chrono::steady_clock::now();
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* pWindow = glfwCreateWindow(640, 480, "10ProgramBinaryCache", NULL, NULL);
+    glfwMakeContextCurrent(pWindow);
+    gladLoadGL(glfwGetProcAddress);
+    glFinish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    glfwDestroyWindow(pWindow);
+    glfwTerminate();
+    return seconds;
+}
+
+int main(int argc, char const *argv[])
+{
+    int runs = argc > 1 ? std::stoi(argv[1]) : 5;
+    Utils::ProgramBinaryCache& cache = Utils::ProgramBinaryCache::globalCache();
+    if (argc > 2)
+    {
+        cache.setDirectory(argv[2]);
+    }
+
+    double context = 1e30, cold = 1e30, warm = 1e30;
+    Utils::ProgramCacheStatistics coldStats, warmStats;
+    std::string driver;
+    bool enabled = false;
+    // best of every kind of start, a renderer per start
+    auto startup = [&](bool bCold, Utils::ProgramCacheStatistics& stats)
+    {
+        if (bCold)
+        {
+            cache.clear();
+        }
+        Utils::ProgramCacheStatistics before = cache.getStatistics();
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        {
+            Utils::Renderer renderer("10ProgramBinaryCache", 640, 480);
+            renderer.finishShaderPrograms();
+            glFinish();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            enabled = cache.isEnabled();
+            driver = std::format("{} / {}", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        }
+        const Utils::ProgramCacheStatistics& after = cache.getStatistics();
+        stats = Utils::ProgramCacheStatistics{ after.hits - before.hits, after.misses - before.misses, after.rejected - before.rejected,
+                                               after.stored - before.stored };
+        return seconds;
+    };
+    for (int i = 0; i < runs; i++)
+    {
+        context = std::min(context, contextStartup());
+        cold = std::min(cold, startup(true, coldStats));
+        warm = std::min(warm, startup(false, warmStats));
+    }
+
+    std::cout << std::format("driver                 : {}\n", driver);
+    std::cout << std::format("cache directory        : {}{}\n", cache.getDirectory().string(), enabled ? "" : " (disabled, no program binary formats)");
+    std::cout << std::format("window and context     : {:8.2f} ms\n", context * 1000.0);
+    std::cout << std::format("cold start (compile)   : {:8.2f} ms, programs {:8.2f} ms, {} compiled, {} stored\n", cold * 1000.0,
+                             std::max(cold - context, 0.0) * 1000.0, coldStats.misses, coldStats.stored);
+    std::cout << std::format("warm start (binaries)  : {:8.2f} ms, programs {:8.2f} ms, {} loaded, {} rejected, {:.2f}x\n", warm * 1000.0,
+                             std::max(warm - context, 0.0) * 1000.0, warmStats.hits, warmStats.rejected,
+                             std::max(cold - context, 0.0) / std::max(warm - context, 1e-9));
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <glad/gl.h> // glad2!
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <format>
+#include <memory>
+#include <Renderer.h>
+#include <Sphere.h>
+#include <Torus.h>
+
+// soak test of model removal: a scene of live models where every frame removes some models, adds as many new ones
+// and replaces the meshes of others, in random sizes. the geometry buffers and the GL objects waiting for their fence
+// must stay flat once the scene is warmed up, the freed slots and buffer ranges are reused.
+// usage: 11ModelStreaming [frames] [live models] [models swapped per frame]
+
+std::shared_ptr<Utils::Model> randomModel(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> precision(8, 64);
+    if (rng() % 2 == 0)
+    {
+        return std::make_shared<Utils::Sphere>(precision(rng));
+    }
+    return std::make_shared<Utils::Torus>(0.5f, 0.2f, precision(rng));
+}
+
+int main(int argc, char const *argv[])
+{
+    int frames = argc > 1 ? std::stoi(argv[1]) : 3000;
+    std::size_t liveCount = argc > 2 ? std::stoul(argv[2]) : 500;
+    std::size_t swapCount = argc > 3 ? std::stoul(argv[3]) : 20;
+
+    Utils::Renderer renderer("11ModelStreaming", 640, 480);
+    std::mt19937 rng(7);
+    std::vector<Utils::ModelHandle> models;
+    for (std::size_t i = 0; i < liveCount; i++)
+    {
+        models.push_back(renderer.addModel(randomModel(rng), Utils::Renderer::PureColorTriangles));
+    }
+
+    int frame = 0;
+    std::size_t warmCapacity = 0;
+    std::size_t staleRemoved = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::cout << "frame   models  slots  buffers  capacity KB  in use KB  peak KB  fragmentation  retired  deleted\n";
+    renderer.setDisplayCallback([&](GLFWwindow* pWindow, float)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (std::size_t i = 0; i < swapCount; i++)
+        {
+            std::size_t k = rng() % models.size();
+            if (rng() % 4 == 0)
+            {
+                renderer.replaceModel(models[k], randomModel(rng));
+                continue;
+            }
+            Utils::ModelHandle removed = models[k];
+            renderer.removeModel(removed);
+            models[k] = renderer.addModel(randomModel(rng), Utils::Renderer::PureColorTriangles);
+            // the slot is reused, the handle of the removed model must not refer to the new one
+            staleRemoved += renderer.isModelValid(removed) ? 0 : 1;
+        }
+
+        const Utils::ResourceStatistics& resources = renderer.getResourceStatistics();
+        const Utils::BufferAllocatorStatistics& buffers = renderer.getGeometryBufferStatistics();
+        if (frame == frames / 2)
+        {
+            warmCapacity = buffers.capacity;
+        }
+        if (frame % (frames / 10 > 0 ? frames / 10 : 1) == 0 || frame == frames - 1)
+        {
+            std::cout << std::format("{:5}  {:7}  {:5}  {:7}  {:11}  {:9}  {:7}  {:13.3f}  {:7}  {:7}\n", frame, resources.models,
+                                     resources.modelSlots, buffers.buffers, buffers.capacity / 1024, buffers.bytesInUse / 1024,
+                                     buffers.peakBytesInUse / 1024, buffers.fragmentation, resources.retiredObjects, resources.deletedObjects);
+        }
+        if (++frame == frames)
+        {
+            glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
+        }
+    });
+    renderer.run();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const Utils::ResourceStatistics& resources = renderer.getResourceStatistics();
+    const Utils::BufferAllocatorStatistics& buffers = renderer.getGeometryBufferStatistics();
+    bool flat = buffers.capacity == warmCapacity && resources.modelSlots == liveCount;
+    std::cout << std::format("{} frames in {:.2f} s, {} models swapped per frame, {} stale handles after removal\n",
+                             frames, seconds, swapCount, staleRemoved);
+    std::cout << std::format("geometry buffers {} the second half: {} KB at half time, {} KB at the end\n",
+                             flat ? "flat in" : "grew in", warmCapacity / 1024, buffers.capacity / 1024);
+    return flat ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <format>
+#include <algorithm>
+#include <BoundingVolumes.h>
+#include <Frustum.h>
+
+// the flat frustum test, the brute force of 13BoundingVolumeHierarchy: the bounds of all models as a structure of arrays tested 4 at a time
+// (BoundsArray::cull) against the same box and sphere tests one bounding volume at a time. the models are scattered boxes of random
+// sizes and rotations in a cube around the camera, the results of both must be the same.
+// usage: 12FrustumCulling [repeat]
+
+std::size_t cullOneByOne(const std::vector<Utils::BoundingVolume>& bounds, const Utils::Frustum& frustum, std::vector<std::uint8_t>& visible)
+{
+    std::size_t visibleCount = 0;
+    visible.resize(bounds.size());
+    for (std::size_t i = 0; i < bounds.size(); i++)
+    {
+        bool bOutside = false;
+        for (const auto& plane : frustum.getPlanes())
+        {
+            glm::vec3 normal(plane);
+            bOutside = bOutside || glm::dot(normal, bounds[i].boxCenter) + plane.w + glm::dot(glm::abs(normal), bounds[i].boxExtent) < 0.0f ||
+                       !frustum.intersectsSphere(bounds[i].sphereCenter, bounds[i].sphereRadius);
+        }
+        visible[i] = std::uint8_t(!bOutside);
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 1 ? std::stoi(argv[1]) : 100;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f), size(0.2f, 4.0f), angle(0.0f, 2.0f * glm::pi<float>());
+    glm::mat4 pMat = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.1f, 300.0f);
+    glm::mat4 vMat = glm::lookAt(glm::vec3(0.0f, 10.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, -1.0f));
+    Utils::Frustum frustum(pMat * vMat);
+
+    bool valid = true;
+    std::cout << std::format("{:>8}{:>10}{:>16}{:>16}{:>10}\n", "models", "visible", "one by one us", "soa us", "speedup");
+    for (std::size_t count : { 1000, 10000, 100000 })
+    {
+        std::vector<Utils::BoundingVolume> bounds(count);
+        Utils::BoundsArray array;
+        for (auto& volume : bounds)
+        {
+            Utils::BoundingVolume local;
+            local.boxExtent = glm::vec3(size(rng), size(rng), size(rng));
+            local.sphereRadius = glm::length(local.boxExtent);
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng)));
+            transform = glm::rotate(transform, angle(rng), glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+            volume = local.transformed(transform);
+            array.add(volume);
+        }
+
+        std::vector<std::uint8_t> expected, visible;
+        std::size_t visibleCount = 0;
+        double scalarSeconds = 1e30, soaSeconds = 1e30;
+        for (int i = 0; i < repeat; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            cullOneByOne(bounds, frustum, expected);
+            auto middle = std::chrono::steady_clock::now();
+            visibleCount = array.cull(frustum, visible);
+            auto end = std::chrono::steady_clock::now();
+            scalarSeconds = std::min(scalarSeconds, std::chrono::duration<double>(middle - start).count());
+            soaSeconds = std::min(soaSeconds, std::chrono::duration<double>(end - middle).count());
+        }
+        bool same = visible == expected;
+        valid = valid && same;
+        std::cout << std::format("{:>8}{:>10}{:>16.1f}{:>16.1f}{:>9.1f}x{}\n", count, visibleCount, scalarSeconds * 1e6, soaSeconds * 1e6,
+                                 scalarSeconds / soaSeconds, same ? "" : "  DIFFERENT RESULTS");
+    }
+    std::cout << std::format("same results: {}\n", valid ? "yes" : "NO");
+    return valid ? 0 : 1;
+}
\ No newline at end of file
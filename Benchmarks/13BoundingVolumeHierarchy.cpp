@@ -0,0 +1,190 @@
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <format>
+#include <limits>
+#include <algorithm>
+#include <BoundingVolumes.h>
+#include <BoundingVolumeHierarchy.h>
+#include <Frustum.h>
+
+// the model hierarchy of Renderer::display against brute force at 1k, 10k and 100k models: the frustum culling of the camera and
+// 15 shadow views (BoundingVolumeHierarchy::cull against BoundsArray::cull), the refit after a tenth of the models rotated, and
+// ray casts as for mouse picking against testing every box. the models are boxes of random sizes in clusters, like objects in rooms.
+// the culling and the nearest hits of both must be the same.
+// usage: 13BoundingVolumeHierarchy [repeat]
+
+template<typename F>
+double bestSeconds(int repeat, F&& f)
+{
+    double seconds = 1e30;
+    for (int i = 0; i < repeat; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return seconds;
+}
+
+// the nearest box the ray enters, by testing all of them
+Utils::BvhRayHit raycastAll(const std::vector<Utils::BoundingVolume>& bounds, glm::vec3 origin, glm::vec3 direction, float maxDistance)
+{
+    Utils::BvhRayHit hit;
+    float nearest = maxDistance;
+    for (std::size_t i = 0; i < bounds.size(); i++)
+    {
+        glm::vec3 t1 = (bounds[i].boxCenter - bounds[i].boxExtent - origin) / direction;
+        glm::vec3 t2 = (bounds[i].boxCenter + bounds[i].boxExtent - origin) / direction;
+        glm::vec3 tNear = glm::min(t1, t2), tFar = glm::max(t1, t2);
+        float entry = std::max({ tNear.x, tNear.y, tNear.z, 0.0f });
+        float exit = std::min({ tFar.x, tFar.y, tFar.z, nearest });
+        if (entry <= exit)
+        {
+            nearest = entry;
+            hit.object = std::uint32_t(i);
+            hit.distance = entry;
+        }
+    }
+    return hit;
+}
+
+int main(int argc, char const *argv[])
+{
+    int repeat = argc > 1 ? std::stoi(argv[1]) : 20;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), size(0.2f, 2.0f), angle(0.0f, 2.0f * glm::pi<float>());
+
+    // the camera and the views of 15 lights around the scene, as the shadow textures of the renderer
+    glm::mat4 cameraVP = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.1f, 150.0f) *
+                         glm::lookAt(glm::vec3(0.0f, 20.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    std::vector<Utils::Frustum> views = { Utils::Frustum(cameraVP) };
+    for (int i = 0; i < 15; i++)
+    {
+        glm::vec3 light(100.0f * unit(rng), 50.0f + 20.0f * unit(rng), 100.0f * unit(rng));
+        views.emplace_back(glm::perspective(glm::pi<float>() / 2.0f, 1.0f, 1.0f, 1000.0f) *
+                           glm::lookAt(light, glm::vec3(40.0f * unit(rng), 0.0f, 40.0f * unit(rng)), glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+
+    bool valid = true;
+    std::cout << std::format("{:>7}{:>9}{:>10}{:>10}{:>12}{:>12}{:>11}{:>12}{:>10}{:>12}{:>12}{:>6}\n", "models", "build ms", "nodes", "cost",
+                             "16 views us", "brute us", "refit us", "cost refit", "visible", "100 rays us", "brute us", "hits");
+    for (std::size_t count : { 1000, 10000, 100000 })
+    {
+        // clusters of boxes scattered over a square of 400 units
+        std::vector<Utils::BoundingVolume> bounds(count);
+        std::vector<glm::mat4> transforms(count);
+        std::vector<Utils::BoundingVolume> local(count);
+        glm::vec3 cluster(0.0f);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (i % 64 == 0)
+            {
+                cluster = glm::vec3(200.0f * unit(rng), 0.0f, 200.0f * unit(rng));
+            }
+            local[i].boxExtent = glm::vec3(size(rng), size(rng), size(rng));
+            local[i].sphereRadius = glm::length(local[i].boxExtent);
+            transforms[i] = glm::translate(glm::mat4(1.0f), cluster + glm::vec3(10.0f * unit(rng), 2.0f * unit(rng), 10.0f * unit(rng)));
+            bounds[i] = local[i].transformed(transforms[i]);
+        }
+
+        Utils::BoundingVolumeHierarchy hierarchy;
+        double buildSeconds = bestSeconds(std::min(repeat, 5), [&] { hierarchy.build(bounds); });
+        float buildCost = hierarchy.getCost();
+        Utils::BoundsArray array;
+        for (const auto& volume : bounds)
+        {
+            array.add(volume);
+        }
+
+        // a tenth of the models rotate about their own axis, refitted every frame
+        float time = 0.0f;
+        double refitSeconds = bestSeconds(repeat, [&]
+        {
+            time += 0.1f;
+            for (std::size_t i = 0; i < count; i += 10)
+            {
+                glm::mat4 rotation = glm::rotate(transforms[i], time, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+                bounds[i] = local[i].transformed(rotation);
+                hierarchy.update(std::uint32_t(i), bounds[i]);
+            }
+            hierarchy.refit();
+        });
+        array.clear();
+        for (const auto& volume : bounds)
+        {
+            array.add(volume);
+        }
+
+        std::vector<std::uint8_t> visible, expected;
+        std::size_t visibleCount = 0;
+        double cullSeconds = bestSeconds(repeat, [&]
+        {
+            visibleCount = 0;
+            for (const auto& frustum : views)
+            {
+                visibleCount += hierarchy.cull(frustum, visible);
+            }
+        });
+        double bruteCullSeconds = bestSeconds(repeat, [&]
+        {
+            for (const auto& frustum : views)
+            {
+                array.cull(frustum, expected);
+            }
+        });
+        bool same = true;
+        for (const auto& frustum : views)
+        {
+            hierarchy.cull(frustum, visible);
+            array.cull(frustum, expected);
+            same = same && visible == expected;
+        }
+
+        // rays from the camera through random points of the screen
+        glm::mat4 inverseVP = glm::inverse(cameraVP);
+        std::vector<std::pair<glm::vec3, glm::vec3>> rays;
+        for (int i = 0; i < 100; i++)
+        {
+            glm::vec2 screen(unit(rng), unit(rng));
+            glm::vec4 nearPoint = inverseVP * glm::vec4(screen, -1.0f, 1.0f);
+            glm::vec4 farPoint = inverseVP * glm::vec4(screen, 1.0f, 1.0f);
+            glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+            rays.emplace_back(origin, glm::vec3(farPoint) / farPoint.w - origin);
+        }
+        std::vector<Utils::BvhRayHit> hits(rays.size()), bruteHits(rays.size());
+        double raySeconds = bestSeconds(repeat, [&]
+        {
+            for (std::size_t i = 0; i < rays.size(); i++)
+            {
+                hits[i] = hierarchy.raycast(rays[i].first, rays[i].second, 1.0f);
+            }
+        });
+        double bruteRaySeconds = bestSeconds(std::min(repeat, 5), [&]
+        {
+            for (std::size_t i = 0; i < rays.size(); i++)
+            {
+                bruteHits[i] = raycastAll(bounds, rays[i].first, rays[i].second, 1.0f);
+            }
+        });
+        std::size_t hitCount = 0;
+        for (std::size_t i = 0; i < rays.size(); i++)
+        {
+            // boxes entered at the same distance may be reported in another order
+            same = same && (hits[i].object == bruteHits[i].object || hits[i].distance == bruteHits[i].distance);
+            hitCount += hits[i].object != Utils::BoundingVolumeHierarchy::invalidObject ? 1 : 0;
+        }
+        valid = valid && same;
+
+        std::cout << std::format("{:>7}{:>9.2f}{:>10}{:>10.1f}{:>12.1f}{:>12.1f}{:>11.1f}{:>12.1f}{:>10}{:>12.1f}{:>12.1f}{:>6}{}\n", count,
+                                 buildSeconds * 1e3, hierarchy.getNodeCount(), buildCost, cullSeconds * 1e6, bruteCullSeconds * 1e6,
+                                 refitSeconds * 1e6, hierarchy.getCost(), visibleCount, raySeconds * 1e6, bruteRaySeconds * 1e6, hitCount,
+                                 same ? "" : "  DIFFERENT RESULTS");
+    }
+    std::cout << std::format("same results as brute force: {}\n", valid ? "yes" : "NO");
+    return valid ? 0 : 1;
+}
\ No newline at end of file
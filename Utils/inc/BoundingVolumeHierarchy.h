@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingVolumes.h"
+#include "Frustum.h"
+
+namespace Utils
+{
+
+struct BvhRayHit
+{
+    std::uint32_t object = 0xFFFFFFFF;  // BoundingVolumeHierarchy::invalidObject if nothing was hit
+    float distance = 0.0f;
+};
+
+// a bounding volume hierarchy over the boxes of objects, an object is the index of its bounds in the span the tree is built from.
+// the build is top-down by the surface area heuristic over binned centroids. objects that move are updated in place and the boxes
+// of their ancestors refitted: the tree stays valid but gets worse than a new build, rebuild when getCost() grew well above getBuildCost().
+class BoundingVolumeHierarchy
+{
+public:
+    static constexpr std::uint32_t invalidObject = 0xFFFFFFFF;
+
+    void build(std::span<const BoundingVolume> bounds);
+    // new bounds of an object, the tree is refitted by refit()
+    void update(std::uint32_t object, const BoundingVolume& bounds);
+    // the boxes of the nodes above the objects updated since the last refit
+    void refit();
+    // the same result as BoundsArray::cull: visible[i] is 0 if the box or the sphere of object i is completely outside of
+    // a plane of the frustum, 1 otherwise. subtrees outside of the frustum are skipped, subtrees inside are not tested further
+    std::size_t cull(const Frustum& frustum, std::vector<std::uint8_t>& visible) const;
+    // the nearest object whose box the ray enters within maxDistance, direction need not be normalized and distances are in its units.
+    // intersect tests the object itself once the ray enters its box at boxDistance: the distance of the hit, not less than boxDistance,
+    // or negative if the object is missed
+    BvhRayHit raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance,
+                      const std::function<float(std::uint32_t object, float boxDistance)>& intersect = nullptr) const;
+
+    std::size_t size() const;
+    std::size_t getNodeCount() const;
+    // expected cost of a query relative to testing the root box: the nodes weighted by their surface area, leaves by their object count
+    float getCost() const;
+    float getBuildCost() const;
+private:
+    // leftChild is 0 for a leaf, the right child follows the left one. the objects of every node are a range of m_Objects
+    struct Node
+    {
+        glm::vec3 minCorner;
+        std::uint32_t firstObject;
+        glm::vec3 maxCorner;
+        std::uint32_t objectCount;
+        std::uint32_t leftChild;
+        std::uint32_t parent;
+    };
+    // the box of a leaf from its objects, of an inner node from its children
+    void refitNode(std::uint32_t index);
+    float nodeCost(const Node& node) const;
+
+    // the objects in tree order and their bounds, the objects of a leaf are next to each other
+    std::vector<BoundingVolume> m_Bounds;
+    std::vector<std::uint32_t> m_Objects;
+    // the position of every object in tree order and its leaf
+    std::vector<std::uint32_t> m_ObjectSlots;
+    std::vector<std::uint32_t> m_ObjectLeaves;
+    std::vector<Node> m_Nodes;
+    // nodes whose box is refitted by the next refit, marked from the updated leaves up to the root
+    std::vector<std::uint8_t> m_Dirty;
+    std::vector<std::uint32_t> m_DirtyNodes;
+    // the sum of nodeCost over all nodes
+    float m_CostSum = 0.0f;
+    float m_BuildCost = 0.0f;
+};
+
+} // namespace Utils
\ No newline at end of file
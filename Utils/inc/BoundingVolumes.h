@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+namespace Utils
+{
+
+// an axis-aligned box and a sphere around an object, the frustum test uses both
+struct BoundingVolume
+{
+    glm::vec3 boxCenter = glm::vec3(0.0f);
+    glm::vec3 boxExtent = glm::vec3(0.0f);      // half the size of the box
+    glm::vec3 sphereCenter = glm::vec3(0.0f);
+    float sphereRadius = 0.0f;
+
+    // bounds of the object transformed by matrix: the box of the transformed box (Arvo), the sphere scaled by the largest axis scale
+    BoundingVolume transformed(const glm::mat4& matrix) const;
+    // grown by distance in every direction
+    BoundingVolume inflated(float distance) const;
+    // bounds of both
+    BoundingVolume merged(const BoundingVolume& other) const;
+};
+
+struct FrustumCullingPassStatistics
+{
+    std::size_t tested = 0;
+    std::size_t culled = 0;     // outside of the frustum
+    std::size_t drawn = 0;
+};
+
+struct FrustumCullingStatistics
+{
+    FrustumCullingPassStatistics camera;
+    std::vector<FrustumCullingPassStatistics> shadows;   // one per shadow texture drawn
+};
+
+// bounding volumes of many objects as a structure of arrays, one array per coordinate.
+// the frustum test reads 4 objects at a time with SSE2 (any x86-64), one by one on other processors.
+class BoundsArray
+{
+public:
+    void clear();
+    void add(const BoundingVolume& bounds);
+    std::size_t size() const;
+    // visible[i] is 0 if the box or the sphere of object i is completely outside of a plane of the frustum, 1 otherwise.
+    // returns the count of visible objects
+    std::size_t cull(const Frustum& frustum, std::vector<std::uint8_t>& visible) const;
+private:
+    std::vector<float> m_BoxCenterX, m_BoxCenterY, m_BoxCenterZ;
+    std::vector<float> m_BoxExtentX, m_BoxExtentY, m_BoxExtentZ;
+    std::vector<float> m_SphereCenterX, m_SphereCenterY, m_SphereCenterZ, m_SphereRadius;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace Utils
+{
+
+// offsets in a range of units (bytes, vertices, indices) handed out by a two-level segregated fit allocator (TLSF):
+// free blocks are listed by size class, a power of 2 split in 16 linear steps, and two levels of bitmaps find the first
+// list whose blocks all fit in constant time. a freed block is merged with its free neighbors. no GL calls.
+class RangeAllocator
+{
+public:
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    explicit RangeAllocator(std::size_t capacity = 0);
+    // offset of size units (0 is taken as 1) aligned to alignment, a power of 2, npos if no free block fits
+    std::size_t allocate(std::size_t size, std::size_t alignment = 1);
+    // the allocation at offset, as returned by allocate
+    void free(std::size_t offset);
+    std::size_t sizeOf(std::size_t offset) const;
+    // more units at the end, the capacity never shrinks
+    void grow(std::size_t capacity);
+    // offset of the allocation at the highest offset, npos if there is none
+    std::size_t lastAllocation() const;
+
+    std::size_t getCapacity() const;
+    std::size_t getUsed() const;
+    std::size_t getPeakUsed() const;
+    std::size_t getAllocationCount() const;
+    std::size_t getFreeBlockCount() const;
+    std::size_t getLargestFreeBlock() const;
+private:
+    static constexpr unsigned secondLevelBits = 4;
+    static constexpr std::size_t secondLevelCount = std::size_t(1) << secondLevelBits;
+    static constexpr std::size_t firstLevelCount = 64;
+    static constexpr std::uint32_t none = 0xFFFFFFFF;
+
+    // a free or allocated block, blocks are linked in the order of their offsets and free ones in the list of their size class
+    struct Block
+    {
+        std::size_t offset = 0;
+        std::size_t size = 0;
+        std::uint32_t prevPhysical = none;
+        std::uint32_t nextPhysical = none;
+        std::uint32_t prevFree = none;
+        std::uint32_t nextFree = none;
+        bool bFree = false;
+    };
+    std::vector<Block> m_Blocks;
+    std::vector<std::uint32_t> m_UnusedBlocks;  // records of merged blocks for reuse
+    std::uint64_t m_FirstLevelBitmap = 0;
+    std::array<std::uint32_t, firstLevelCount> m_SecondLevelBitmaps{};
+    std::array<std::array<std::uint32_t, secondLevelCount>, firstLevelCount> m_FreeLists;
+    std::unordered_map<std::size_t, std::uint32_t> m_Allocations;  // block by offset
+    std::uint32_t m_LastBlock = none;
+    std::size_t m_Capacity = 0;
+    std::size_t m_Used = 0;
+    std::size_t m_PeakUsed = 0;
+    std::size_t m_FreeBlockCount = 0;
+
+    // size class of a block size
+    static void mapping(std::size_t size, std::size_t& firstLevel, std::size_t& secondLevel);
+    std::uint32_t newBlock(std::size_t offset, std::size_t size);
+    void insertFree(std::uint32_t block);
+    void removeFree(std::uint32_t block);
+    // a free block of at least size, none if there is none
+    std::uint32_t findFree(std::size_t size) const;
+    // the block keeps size units, the rest becomes a new block after it that is returned, not listed as free
+    std::uint32_t split(std::uint32_t block, std::size_t size);
+    // next is merged into block and its record is released
+    void absorb(std::uint32_t block, std::uint32_t next);
+};
+
+// a range of one of the buffers of a BufferAllocator
+struct BufferAllocation
+{
+    GLuint buffer = 0;
+    std::size_t offset = 0;
+    std::size_t size = 0;
+};
+
+using BufferHandle = std::uint32_t;
+
+struct BufferAllocatorStatistics
+{
+    std::size_t buffers = 0;
+    std::size_t capacity = 0;           // bytes of all buffers
+    std::size_t bytesInUse = 0;
+    std::size_t peakBytesInUse = 0;
+    std::size_t allocations = 0;
+    std::size_t freeBlocks = 0;
+    std::size_t largestFreeBlock = 0;
+    // 1 - largest free block / free bytes: 0 if the free space is one block, close to 1 if it is scattered in small blocks
+    double fragmentation = 0.0;
+    std::size_t movedBytes = 0;         // copied by defragment, in total
+};
+
+// vertex, index and uniform data in a few large GL buffers, the ranges of each are managed by a RangeAllocator.
+// an allocation that fits in no buffer gets a new buffer of the page size (or its size if larger).
+// defragment moves allocations to lower free ranges of their buffer a few at a time, to be called once per frame:
+// the owner of a moved allocation must point its vertex arrays and draws to the new offset.
+// the buffers are deleted by release, which must be called while the context is current.
+class BufferAllocator
+{
+public:
+    static constexpr BufferHandle invalidHandle = 0xFFFFFFFF;
+
+    explicit BufferAllocator(std::size_t pageSize = 64 * 1024 * 1024);
+    // size bytes aligned to alignment, a power of 2, owner is any tag of the caller
+    BufferHandle allocate(std::size_t size, std::size_t alignment, std::uint64_t owner = 0);
+    void free(BufferHandle handle);
+    const BufferAllocation& get(BufferHandle handle) const;
+    std::uint64_t getOwner(BufferHandle handle) const;
+    // glBufferSubData to the start of the allocation
+    void upload(BufferHandle handle, const void* pData, std::size_t size);
+    // copy allocations from the end of their buffer to free ranges before them until byteBudget bytes are moved,
+    // delete buffers that became empty (except the first). returns the moved allocations, valid until the next call
+    const std::vector<BufferHandle>& defragment(std::size_t byteBudget);
+    // delete the buffers and drop all allocations
+    void release();
+    const BufferAllocatorStatistics& getStatistics() const;
+private:
+    struct Page
+    {
+        GLuint buffer = 0;
+        RangeAllocator ranges;
+        std::unordered_map<std::size_t, BufferHandle> handles;  // by offset
+    };
+    struct Entry
+    {
+        BufferAllocation allocation;
+        std::size_t alignment = 1;
+        Page* pPage = nullptr;
+        std::uint64_t owner = 0;
+    };
+    std::size_t m_PageSize;
+    std::vector<std::unique_ptr<Page>> m_Pages;
+    std::vector<Entry> m_Entries;
+    std::vector<BufferHandle> m_FreeHandles;
+    std::vector<BufferHandle> m_Moved;
+    BufferAllocatorStatistics m_Stats;
+
+    void updateStatistics();
+};
+
+} // namespace Utils
\ No newline at end of file
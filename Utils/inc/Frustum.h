@@ -0,0 +1,23 @@
+#pragma once
+#include <array>
+#include <glm/glm.hpp>
+
+namespace Utils
+{
+
+// the six planes of a view frustum, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane
+class Frustum
+{
+private:
+    std::array<glm::vec4, 6> m_Planes{}; // left, right, bottom, top, near, far, normalized
+public:
+    Frustum() = default;
+    // planes of the clip volume -w <= x, y, z <= w in the space that matrix transforms from (Gribb and Hartmann),
+    // the projection-view matrix gives world space planes, the model-view-projection matrix gives model space planes
+    explicit Frustum(const glm::mat4& matrix);
+    const std::array<glm::vec4, 6>& getPlanes() const { return m_Planes; }
+    // false only if the sphere is completely outside of one of the planes
+    bool intersectsSphere(glm::vec3 center, float radius) const;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstddef>
+#include <array>
+#include "Shader.h"
+
+namespace Utils
+{
+
+struct GLStateStatistics
+{
+    std::size_t issued = 0;     // calls passed to GL
+    std::size_t skipped = 0;    // calls that would have set the current value again
+};
+
+// shadow copy of the GL state the renderer sets per draw, a call that would not change it is not passed to GL.
+// the copy starts unknown, the first call of each state is always issued. GL calls that bypass the cache
+// (including deleting a bound object) make the copy stale, invalidate must be called after them.
+class GLStateCache
+{
+public:
+    // texture units whose GL_TEXTURE_2D and GL_TEXTURE_CUBE_MAP bindings are tracked, other bindings are always issued
+    static constexpr std::size_t trackedTextureUnits = 32;
+    static constexpr std::size_t trackedCapabilities = 5;
+
+    GLStateCache();
+    // forget the shadow copy
+    void invalidate();
+    void resetStatistics();
+    const GLStateStatistics& getStatistics() const;
+
+    // GL_CULL_FACE, GL_DEPTH_TEST, GL_BLEND, GL_STENCIL_TEST and GL_SCISSOR_TEST are tracked, other capabilities are always issued
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void cullFace(GLenum mode);
+    void frontFace(GLenum direction);
+    void depthFunc(GLenum func);
+    void useProgram(GLuint program);
+    // finishes a submitted program first, as Shader::use
+    void useProgram(const Shader& shader);
+    void activeTexture(GLenum unit);
+    // binds to the active texture unit
+    void bindTexture(GLenum target, GLuint texture);
+    void bindVertexArray(GLuint vao);
+    // GL_FRAMEBUFFER binds both the draw and the read frame buffer
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+private:
+    // neither a name nor an enum GL returns
+    static constexpr GLuint unknown = 0xFFFFFFFF;
+
+    std::array<GLuint, trackedCapabilities> m_Capabilities;
+    GLuint m_CullFace;
+    GLuint m_FrontFace;
+    GLuint m_DepthFunc;
+    GLuint m_Program;
+    GLuint m_ActiveTexture;
+    std::array<std::array<GLuint, 2>, trackedTextureUnits> m_Textures;  // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP of every unit
+    GLuint m_VertexArray;
+    GLuint m_DrawFramebuffer;
+    GLuint m_ReadFramebuffer;
+    GLStateStatistics m_Stats;
+
+    // true if value differs from current, which becomes value, counts the call either way
+    bool change(GLuint& current, GLuint value);
+    void setCapability(GLenum capability, bool enabled);
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Utils
+{
+
+// the slots of a table whose entries are removed and their slots reused. a handle is a slot index and the generation of the slot
+// when the entry was added, releasing a slot increments its generation so that the handles of the removed entry become stale.
+class HandleSlots
+{
+public:
+    static constexpr std::uint32_t invalidIndex = 0xFFFFFFFF;
+
+    // a released slot, the last released first, or a new slot at the end of the table
+    std::uint32_t acquire();
+    void release(std::uint32_t index);
+    // the slot is in use by the entry of this generation
+    bool isLive(std::uint32_t index, std::uint32_t generation) const;
+    std::uint32_t getGeneration(std::uint32_t index) const;
+    // slots in use and released, the size of the table
+    std::size_t getSize() const;
+    std::size_t getLiveCount() const;
+private:
+    std::vector<std::uint32_t> m_Generations;
+    std::vector<bool> m_Live;
+    std::vector<std::uint32_t> m_FreeSlots;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -3,25 +3,76 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include "Model.h"
+#include "MeshCache.h"
 
 namespace Utils
 {
 
+// result of the deduplication of the face corners of an imported model
+struct IndexingStatistics
+{
+    std::size_t corners = 0;            // face corners, i.e. vertex count of the de-indexed arrays
+    std::size_t uniqueVertices = 0;     // distinct (v, vt, vn) triples
+    std::size_t flatBytes = 0;          // size of the de-indexed arrays of glDrawArrays
+    std::size_t indexedBytes = 0;       // size of the vertex arrays plus indices of glDrawElements
+    float cacheHitRate = 0.0f;          // hit rate of a simulated FIFO post-transform cache
+    float acmr = 0.0f;                  // average cache miss ratio, transformed vertices per triangle
+};
+
+// a model loaded from a Wavefront OBJ file (triangles with v/vt/vn faces only).
+// the parsed mesh is written to a binary cache next to the file (filePath + ".meshcache") and mapped on later loads,
+// the cache is rebuilt whenever the content of the OBJ file changes.
 class ImportedModel : public Model
 {
 private:
-    std::vector<float> m_vertices;
-    std::vector<float> m_texCoords;
-    std::vector<float> m_normals;
+    // storage of a parsed model, released once the data is available from the mapped cache
+    std::vector<int> m_indices;
+    std::vector<glm::vec3> m_vertices;
+    std::vector<glm::vec2> m_texCoords;
+    std::vector<glm::vec3> m_normals;
+    std::vector<glm::vec3> m_sTangents;
+    std::vector<glm::vec3> m_tTangents;
+    MeshCache m_cache;
+    // views of either the vectors above or the cache
+    MeshData m_data;
 public: 
-    ImportedModel(const char* filePath);
+    // parse with parseThreads threads, 0 for all hardware threads, the result does not depend on the thread count
+    ImportedModel(const char* filePath, std::size_t parseThreads = 1, bool useMeshCache = true);
     // match with glDrawArrays
     virtual bool supplyVertices() override;
     virtual bool supplyTexCoords() override;
     virtual bool supplyNormals() override;
+    virtual bool supplyTangents() override;
     virtual std::vector<float> getVerticesArray() override;
     virtual std::vector<float> getTexCoordsArray() override;
     virtual std::vector<float> getNormalsArray() override;
+    virtual std::vector<float> getSTangentsArray() override;
+    virtual std::vector<float> getTTangentsArray() override;
+    // match with glDrawElements, every distinct (v, vt, vn) triple of the file is one vertex
+    virtual bool supplyIndices() override;
+    virtual std::vector<int> getIndices() override;
+    virtual std::vector<glm::vec3> getVertices() override;
+    virtual std::vector<glm::vec2> getTexCoords() override;
+    virtual std::vector<glm::vec3> getNormals() override;
+    virtual std::vector<glm::vec3> getSTangents() override;
+    virtual std::vector<glm::vec3> getTTangents() override;
+    virtual std::span<const int> getIndicesView() override;
+    virtual std::span<const glm::vec3> getVerticesView() override;
+    virtual std::span<const glm::vec2> getTexCoordsView() override;
+    virtual std::span<const glm::vec3> getNormalsView() override;
+    virtual std::span<const glm::vec3> getSTangentsView() override;
+    virtual std::span<const glm::vec3> getTTangentsView() override;
+
+    // whether the data is used in place from the mapped cache file
+    bool isLoadedFromCache() const;
+    // statistics of the indexed data against the de-indexed arrays
+    IndexingStatistics getIndexingStatistics() const;
+    // entries of the simulated post-transform cache
+    static constexpr std::size_t postTransformCacheSize = 32;
+private:
+    // parse the OBJ content to the vectors, return false on error
+    bool parse(const MappedFile& file, const char* filePath, std::size_t parseThreads);
+    void computeTangents();
 };
 
 
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <limits>
+#include <glm/glm.hpp>
+
+namespace Utils
+{
+
+// attenuation under which a point light is treated as not reaching a point, below one step of an 8 bits color channel
+constexpr float lightAttenuationThreshold = 1.0f / 512.0f;
+// range of lights that never fade out, finite so that it still works in GLSL
+constexpr float infiniteLightRange = std::numeric_limits<float>::max();
+
+// distance at which the attenuation 1 / (c + l*d + q*d*d) drops to threshold, infiniteLightRange if it never does
+float attenuationRange(float constant, float linear, float quadratic, float threshold = lightAttenuationThreshold);
+
+// the part of the view space a point or spot light reaches
+struct LightVolume
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    float range = infiniteLightRange;
+    // spot lights only: unit axis and half angle of the cone, a cone of at least pi/2 is not tested
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float cutOffAngle = 0.0f;
+};
+
+// axis aligned bounds of a cluster in view space, w unused, laid out for a std430 buffer
+struct ClusterBounds
+{
+    glm::vec4 minCorner = glm::vec4(0.0f);
+    glm::vec4 maxCorner = glm::vec4(0.0f);
+};
+
+struct LightClusterStatistics
+{
+    std::size_t clusters = 0;
+    std::size_t pointLights = 0;
+    std::size_t spotLights = 0;
+    std::size_t lightIndices = 0;       // light and cluster pairs
+    std::size_t occupiedClusters = 0;   // clusters with at least one light
+    std::size_t maxClusterLights = 0;
+};
+
+constexpr glm::uvec3 defaultLightClusterGridSize = glm::uvec3(16, 9, 24);
+
+// a grid of clusters over the view frustum for clustered forward shading (Olsson et al.):
+// size.x by size.y screen tiles, and size.z slices with exponentially growing depth between the near and far plane.
+// every cluster lists the point and spot lights whose volume intersects it, a fragment only shades the lights of its cluster.
+class LightClusterGrid
+{
+private:
+    glm::uvec3 m_Size;
+    glm::mat4 m_ProjMatrix = glm::mat4(0.0f);
+    glm::vec2 m_Viewport = glm::vec2(0.0f);
+    float m_Near = 0.0f;
+    float m_Far = 0.0f;
+    std::vector<ClusterBounds> m_Bounds;
+    // bounding spheres of the clusters and of the rows of clusters for the cone test, center and radius
+    std::vector<glm::vec4> m_Spheres;
+    std::vector<glm::vec4> m_RowSpheres;
+    // per cluster: first light index, point light count, spot light count, unused
+    std::vector<glm::uvec4> m_Clusters;
+    // point light indices, then spot light indices of every cluster
+    std::vector<std::uint32_t> m_LightIndices;
+    // clusters of every light before they are sorted by cluster
+    std::vector<std::uint32_t> m_Candidates;
+    std::vector<std::size_t> m_CandidateOffsets;
+    LightClusterStatistics m_Stats;
+
+    void addCandidates(const LightVolume& light, bool spot);
+public:
+    explicit LightClusterGrid(glm::uvec3 size = defaultLightClusterGridSize);
+
+    // rebuild the bounds of the clusters for a projection and a viewport in pixels, nothing to do if both did not change.
+    // return true if the bounds were rebuilt
+    bool update(const glm::mat4& projMatrix, int width, int height);
+    // lights in view space, replace the lights of all clusters
+    void assignLights(std::span<const LightVolume> pointLights, std::span<const LightVolume> spotLights);
+
+    glm::uvec3 getSize() const;
+    std::size_t getClusterCount() const;
+    // the slice of view depth d is floor(log(d) * depthScale + depthBias)
+    float getDepthScale() const;
+    float getDepthBias() const;
+    // size of a tile in pixels
+    glm::vec2 getTileSize() const;
+    // cluster of a fragment by its window coordinates (gl_FragCoord.xy) and view depth (-z in view space), clamped to the grid
+    std::size_t getClusterIndex(glm::vec2 fragCoord, float viewDepth) const;
+    const std::vector<ClusterBounds>& getBounds() const;
+    const std::vector<glm::uvec4>& getClusters() const;
+    const std::vector<std::uint32_t>& getLightIndices() const;
+    const LightClusterStatistics& getStatistics() const;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+namespace Utils
+{
+
+// read-only memory mapping of a whole file, the content is valid until the file is closed.
+class MappedFile
+{
+private:
+    const char* m_pData = nullptr;
+    std::size_t m_Size = 0;
+    bool m_bOpen = false;
+#ifdef _WIN32
+    void* m_hFile = nullptr;
+    void* m_hMapping = nullptr;
+#else
+    int m_Fd = -1;
+#endif
+public:
+    MappedFile() = default;
+    MappedFile(const char* filePath);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // map the whole file, return false if the file could not be opened or mapped
+    bool open(const char* filePath);
+    void close();
+    bool isOpen() const;
+    // an empty file is open but has no data
+    const char* data() const;
+    std::size_t size() const;
+private:
+    void moveFrom(MappedFile& other);
+};
+
+} // namespace Utils
\ No newline at end of file
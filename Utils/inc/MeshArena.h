@@ -0,0 +1,87 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstddef>
+#include "VertexLayout.h"
+#include "BufferAllocator.h"
+
+namespace Utils
+{
+
+// a draw of glMultiDrawElementsIndirect, the layout is defined by OpenGL
+struct DrawElementsIndirectCommand
+{
+    GLuint count = 0;
+    GLuint instanceCount = 1;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint baseInstance = 0;
+};
+
+// where a mesh is in its arena, its indices count from baseVertex
+struct MeshArenaRange
+{
+    GLint baseVertex = 0;
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+};
+
+struct MultiDrawStatistics
+{
+    std::size_t arenas = 0;             // vertex formats with an arena
+    std::size_t arenaModels = 0;        // models uploaded to the arenas
+    // of the last frame, shadow passes included
+    std::size_t multiDrawCalls = 0;     // glMultiDrawElementsIndirect calls
+    std::size_t multiDrawCommands = 0;  // draws of those calls
+    std::size_t singleDraws = 0;        // draw calls of a single model
+};
+
+// the meshes of one vertex format in a single interleaved vertex buffer and a single index buffer of one vertex array,
+// drawn one by one with glDrawElementsBaseVertex or together with glMultiDrawElementsIndirect.
+// the ranges of the meshes are managed by a RangeAllocator in vertices and in indices, the ranges of removed meshes are reused.
+// a full buffer is replaced by one of twice the size and the meshes are copied on the GPU.
+// the buffers are released with the context, as the other GL objects of the renderer.
+class MeshArena
+{
+public:
+    // location of the per instance draw index attribute, see setDrawIndexBuffer
+    static constexpr GLuint drawIndexLocation = 5;
+
+    // the attributes of layout interleaved, the index type is GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    MeshArena(const VertexLayout& layout, GLenum indexType);
+    // the interleaved layout of the attributes of layout, the same for layouts of the same attributes in any packing
+    static VertexLayout interleavedLayout(const VertexLayout& layout);
+    // a mesh of the layout and index type can be added
+    bool accepts(const VertexLayout& layout, GLenum indexType) const;
+    // vertices interleaved as getLayout, indices of the index type counting from the first of these vertices
+    MeshArenaRange add(const void* pVertices, std::size_t vertexCount, const void* pIndices, std::size_t indexCount);
+    // free the ranges of a mesh returned by add
+    void remove(const MeshArenaRange& range);
+    // unsigned int attribute of divisor 1 from buffer: with the values 0, 1, 2... it is the baseInstance of an indirect draw,
+    // the draw index of shaders without gl_DrawID
+    void setDrawIndexBuffer(GLuint buffer);
+
+    const VertexLayout& getLayout() const;
+    GLenum getIndexType() const;
+    GLuint getVao() const;
+    // in use
+    std::size_t getVertexCount() const;
+    std::size_t getIndexCount() const;
+    std::size_t getMeshCount() const;
+private:
+    VertexLayout m_Layout;
+    GLenum m_IndexType;
+    std::size_t m_IndexSize;
+    GLuint m_Vao = 0;
+    GLuint m_VertexBuffer = 0;
+    GLuint m_IndexBuffer = 0;
+    RangeAllocator m_Vertices;
+    RangeAllocator m_Indices;
+    std::size_t m_MeshCount = 0;
+
+    // a range of count elements, the buffer is replaced by a larger one with the same content if no free range fits
+    static std::size_t allocate(GLuint& buffer, RangeAllocator& ranges, std::size_t count, std::size_t initialCapacity, std::size_t elementSize);
+    // attach the buffers to the vertex array
+    void attachBuffers();
+};
+
+} // namespace Utils
\ No newline at end of file
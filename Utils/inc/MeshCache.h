@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <glm/glm.hpp>
+#include <MappedFile.h>
+
+namespace Utils
+{
+
+// views of the indexed mesh data of glDrawElements, the storage is owned by someone else
+struct MeshData
+{
+    std::span<const int> indices;
+    std::span<const glm::vec3> vertices;
+    std::span<const glm::vec2> texCoords;
+    std::span<const glm::vec3> normals;
+    std::span<const glm::vec3> sTangents;
+    std::span<const glm::vec3> tTangents;
+};
+
+// binary mesh container, a cache of a parsed model file that is mapped into memory and used in place.
+// layout: a fixed size header followed by the sections of indices, vertices, texCoords, normals, sTangents and tTangents.
+// every section starts at a multiple of sectionAlignment, so the mapped data can be used as arrays of its type directly.
+// the header records size and hash of the source file, a cache of another version of the source is rejected.
+// data is in native byte order, a cache written on a machine of different byte order is rejected too.
+class MeshCache
+{
+public:
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::size_t sectionAlignment = 64;
+
+    MeshCache() = default;
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+    MeshCache(MeshCache&&) = default;
+    MeshCache& operator=(MeshCache&&) = default;
+
+    // map a cache file, return false if it does not exist, is broken, or is not the cache of the given source
+    bool open(const char* filePath, std::uint64_t sourceSize, std::uint64_t sourceHash);
+    void close();
+    bool isOpen() const;
+    // views into the mapping, valid until the cache is closed
+    const MeshData& data() const;
+
+    // write data as a cache of the given source, return false on failure.
+    // the file is written to a temporary file and renamed, a concurrent reader never sees a partial file.
+    static bool write(const char* filePath, const MeshData& data, std::uint64_t sourceSize, std::uint64_t sourceHash);
+    // a fast non-cryptographic 64 bit hash to identify the content of source files
+    static std::uint64_t hashBytes(const char* pData, std::size_t size);
+private:
+    MappedFile m_File;
+    MeshData m_Data;
+};
+
+} // namespace Utils
\ No newline at end of file
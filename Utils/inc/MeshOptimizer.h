@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Utils
+{
+
+// efficiency of an index stream of triangles on a FIFO post-transform vertex cache
+struct VertexCacheStatistics
+{
+    std::size_t triangles = 0;
+    std::size_t vertices = 0;               // distinct vertices referenced by the indices
+    std::size_t transformedVertices = 0;    // cache misses, i.e. vertex shader invocations
+    float acmr = 0.0f;                      // average cache miss ratio, transformed vertices per triangle, 0.5 at best, 3 at worst
+    float atvr = 0.0f;                      // average transformed vertex ratio, transformed vertices per vertex, 1 at best
+};
+
+// a triangle order and vertex order optimized for the GPU
+struct OptimizedMesh
+{
+    std::vector<int> indices;   // indices of the remapped vertices
+    std::vector<int> remap;     // new index of every old vertex, -1 for vertices no triangle references
+    std::size_t vertexCount = 0;
+};
+
+// the cache the optimization aims at, smaller than the cache of most GPUs, so the order works well on the larger ones too
+constexpr std::size_t optimizerCacheSize = 16;
+// an overdraw cluster may have this much higher ACMR than the vertex cache order
+constexpr float defaultOverdrawThreshold = 1.05f;
+
+// replay the index stream through a FIFO cache of cacheSize entries, return the count of cache misses
+std::size_t simulateVertexCache(std::span<const int> indices, std::size_t vertexCount, std::size_t cacheSize);
+VertexCacheStatistics analyzeVertexCache(std::span<const int> indices, std::size_t vertexCount, std::size_t cacheSize);
+
+// reorder triangles for post-transform cache locality, Tipsify of Sander, Nehab and Barczak,
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007).
+// pClusters receives the first triangle of every cluster that starts after a dead end, where the order may be broken up.
+std::vector<int> optimizeVertexCache(std::span<const int> indices, std::size_t vertexCount, std::size_t cacheSize = optimizerCacheSize,
+                                     std::vector<std::size_t>* pClusters = nullptr);
+// reorder clusters of a vertex cache optimized index stream so that the outward facing ones go first,
+// they tend to occlude the rest of the mesh. threshold limits the ACMR loss of splitting into smaller clusters.
+std::vector<int> optimizeOverdraw(std::span<const int> indices, std::span<const glm::vec3> vertices, std::span<const std::size_t> clusters,
+                                  std::size_t cacheSize = optimizerCacheSize, float threshold = defaultOverdrawThreshold);
+// new vertex indices in order of first use, for vertex fetch locality. return the new vertex count.
+std::size_t buildVertexFetchRemap(std::span<const int> indices, std::size_t vertexCount, std::vector<int>& remap);
+// the vertex data of remap, vertexSize bytes per vertex
+std::vector<char> remapVertices(std::span<const char> vertices, std::size_t vertexSize, std::span<const int> remap, std::size_t newVertexCount);
+
+template<typename T>
+std::vector<T> remapVertices(std::span<const T> vertices, std::span<const int> remap, std::size_t newVertexCount)
+{
+    std::vector<T> res(newVertexCount);
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        if (remap[i] >= 0)
+        {
+            res[remap[i]] = vertices[i];
+        }
+    }
+    return res;
+}
+
+// vertex cache order, overdraw order, then vertex fetch order
+OptimizedMesh optimizeMesh(std::span<const int> indices, std::span<const glm::vec3> vertices, float overdrawThreshold = defaultOverdrawThreshold);
+
+} // namespace Utils
\ No newline at end of file
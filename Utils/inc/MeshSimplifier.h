@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Utils
+{
+
+// a level of detail of a mesh, a range of the indices of the whole chain
+struct MeshLod
+{
+    std::size_t firstIndex = 0;
+    std::size_t indexCount = 0;
+    float error = 0.0f;     // deviation from the full mesh in model units, 0 for the full mesh
+};
+
+// levels of a chain including the full mesh
+constexpr std::size_t defaultLodLevels = 4;
+// triangles of a level relative to the level before
+constexpr float defaultLodReduction = 0.5f;
+
+// simplify by collapsing edges onto one of their vertices in order of quadric error (Garland and Heckbert, 1997).
+// no vertex is created or moved, so the levels share the vertex data of the full mesh.
+// vertices of UV or normal seams (other vertices at the same position) and of non-manifold edges are kept,
+// vertices of open borders only collapse along the border, so seams and outlines survive.
+// stops at targetIndexCount or before a collapse of more than maxError (model units), pError receives the error of the result.
+std::vector<int> simplifyMesh(std::span<const int> indices, std::span<const glm::vec3> vertices, std::size_t targetIndexCount,
+                              float maxError, float* pError = nullptr);
+
+// the full mesh followed by levels of reduction times the triangles of the level before, each simplified from the full mesh.
+// return the indices of all levels one after another, lods receives their ranges. the chain ends early when a level does not get smaller.
+std::vector<int> buildLodChain(std::span<const int> indices, std::span<const glm::vec3> vertices, std::vector<MeshLod>& lods,
+                               std::size_t levelCount = defaultLodLevels, float reduction = defaultLodReduction);
+
+} // namespace Utils
\ No newline at end of file
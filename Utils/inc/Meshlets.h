@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+namespace Utils
+{
+
+// a cluster of nearby triangles of a mesh, a range of the indices, with the bounds its culling tests need
+struct Meshlet
+{
+    std::size_t firstIndex = 0;
+    std::size_t indexCount = 0;
+    std::size_t vertexCount = 0;    // distinct vertices
+    // bounding sphere
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    // normal cone: all triangles face away from an eye e with dot(normalize(coneApex - e), coneAxis) >= coneCutoff,
+    // coneCutoff is 1 when the normals spread too much for the test to ever pass
+    glm::vec3 coneApex = glm::vec3(0.0f);
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float coneCutoff = 1.0f;
+};
+
+// limits of a meshlet, the common choice for mesh shaders of NVIDIA and AMD hardware
+constexpr std::size_t maxMeshletVertices = 64;
+constexpr std::size_t maxMeshletTriangles = 124;
+
+// a range of indices to draw
+struct IndexRange
+{
+    std::size_t firstIndex = 0;
+    std::size_t indexCount = 0;
+};
+
+struct MeshletCullingStatistics
+{
+    std::size_t meshlets = 0;
+    std::size_t outsideFrustum = 0;
+    std::size_t backFacing = 0;
+    std::size_t visibleTriangles = 0;
+    std::size_t ranges = 0;         // draw ranges after merging adjacent visible meshlets
+
+    MeshletCullingStatistics& operator+=(const MeshletCullingStatistics& other);
+};
+
+// split the triangles of a mesh into meshlets of at most maxVertices vertices and maxTriangles triangles.
+// a meshlet grows from the first remaining triangle over the neighbouring triangles that add the fewest vertices and bend the least,
+// its triangles keep their relative order, so a vertex cache order of the input is kept inside meshlets.
+// return the indices ordered by meshlet, meshlets receives their ranges relative to the returned indices.
+std::vector<int> buildMeshlets(std::span<const int> indices, std::span<const glm::vec3> vertices, std::vector<Meshlet>& meshlets,
+                               std::size_t maxVertices = maxMeshletVertices, std::size_t maxTriangles = maxMeshletTriangles);
+
+// frustum and eye in the space of the vertices, the normal cone is tested only if backFaceCulling is set,
+// it assumes that back faces of counter-clockwise triangles are culled.
+bool isMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, glm::vec3 eye, bool backFaceCulling,
+                      MeshletCullingStatistics* pStats = nullptr);
+
+// ranges receives the index ranges of the visible meshlets, adjacent visible meshlets are merged into one range.
+// pStats accumulates, so that one statistics can sum up several meshes
+void cullMeshlets(std::span<const Meshlet> meshlets, const Frustum& frustum, glm::vec3 eye, bool backFaceCulling,
+                  std::vector<IndexRange>& ranges, MeshletCullingStatistics* pStats = nullptr);
+
+} // namespace Utils
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
+#include <span>
 #include <string>
 #include <exception>
 
@@ -39,6 +40,32 @@ public:
     virtual std::vector<glm::vec3> getNormals();
     virtual std::vector<glm::vec3> getSTangents();
     virtual std::vector<glm::vec3> getTTangents();
+    // views of the data of glDrawElements without copy, valid as long as the model is alive and unchanged.
+    // empty by default for models that do not keep their data in this form, use the getters above then.
+    virtual std::span<const int> getIndicesView();
+    virtual std::span<const glm::vec3> getVerticesView();
+    virtual std::span<const glm::vec2> getTexCoordsView();
+    virtual std::span<const glm::vec3> getNormalsView();
+    virtual std::span<const glm::vec3> getSTangentsView();
+    virtual std::span<const glm::vec3> getTTangentsView();
+protected:
+    // expand indexed data to the flat float array of glDrawArrays, in a single allocation
+    template<typename T>
+    static std::vector<float> deindex(std::span<const int> indices, std::span<const T> data)
+    {
+        constexpr std::size_t components = sizeof(T) / sizeof(float);
+        std::vector<float> res(indices.size() * components);
+        float* pDst = res.data();
+        for (auto idx : indices)
+        {
+            const float* pSrc = &data[idx][0];
+            for (std::size_t i = 0; i < components; i++)
+            {
+                *pDst++ = pSrc[i];
+            }
+        }
+        return res;
+    }
 };
 
 
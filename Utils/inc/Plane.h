@@ -37,6 +37,12 @@ public:
     virtual std::vector<glm::vec3> getNormals() override;
     virtual std::vector<glm::vec3> getSTangents() override;
     virtual std::vector<glm::vec3> getTTangents() override;
+    virtual std::span<const int> getIndicesView() override;
+    virtual std::span<const glm::vec3> getVerticesView() override;
+    virtual std::span<const glm::vec2> getTexCoordsView() override;
+    virtual std::span<const glm::vec3> getNormalsView() override;
+    virtual std::span<const glm::vec3> getSTangentsView() override;
+    virtual std::span<const glm::vec3> getTTangentsView() override;
 };
 
 
@@ -0,0 +1,68 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <span>
+#include <filesystem>
+
+namespace Utils
+{
+
+// source of one shader stage of a program
+struct ProgramStage
+{
+    GLenum type;
+    std::string_view source;
+};
+
+struct ProgramCacheStatistics
+{
+    std::size_t hits = 0;       // programs linked from a cached binary
+    std::size_t misses = 0;     // programs without a cached binary, compiled from source
+    std::size_t rejected = 0;   // cached binaries the driver did not accept, compiled from source and replaced
+    std::size_t stored = 0;     // binaries written
+};
+
+// linked program binaries on disk (glGetProgramBinary/glProgramBinary), one file per program in a cache directory.
+// a binary is keyed by a hash of the sources of all stages (permutation defines included, they are part of the sources)
+// and of the vendor, renderer and version strings of the driver, an update of the driver or of a shader source is a miss.
+// a missing, broken or rejected binary falls back to compilation from source, the caller does that and stores the result.
+// submitShaderProgram and the program creation functions of Utils.h built on it go through globalCache().
+class ProgramBinaryCache
+{
+public:
+    static constexpr std::uint32_t version = 1;
+
+    // disabled, load always misses and store does nothing
+    ProgramBinaryCache() = default;
+    explicit ProgramBinaryCache(std::filesystem::path directory);
+
+    // the directory is created when the first binary is stored, an empty path disables the cache
+    void setDirectory(std::filesystem::path directory);
+    const std::filesystem::path& getDirectory() const;
+    // enabled, and the current context supports at least one binary format
+    bool isEnabled() const;
+
+    // a linked program from the cached binary of the stages, 0 on a miss or a rejected binary. needs a current context
+    GLuint load(std::span<const ProgramStage> stages);
+    // write the binary of a program linked from the stages with GL_PROGRAM_BINARY_RETRIEVABLE_HINT, return false on failure
+    bool store(GLuint program, std::span<const ProgramStage> stages);
+    // remove all cached binaries of the directory
+    void clear();
+
+    const ProgramCacheStatistics& getStatistics() const;
+
+    // the cache of the program creation functions, in "LearnOpenGL-program-cache" of the temporary directory by default
+    static ProgramBinaryCache& globalCache();
+private:
+    std::filesystem::path m_Directory;
+    ProgramCacheStatistics m_Stats;
+
+    // key text of the stages and the driver, and its file
+    std::string makeKey(std::span<const ProgramStage> stages) const;
+    std::filesystem::path makePath(std::uint64_t keyHash) const;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+namespace Utils
+{
+
+// the textures a draw binds: color texture, normal map, height map, environment cube map, 0 for unused
+using RenderTextureSet = std::array<GLuint, 4>;
+
+// a draw of the queue, index is the caller's draw
+struct RenderItem
+{
+    std::uint64_t key = 0;
+    std::uint32_t index = 0;
+};
+
+struct RenderQueueStatistics
+{
+    std::size_t draws = 0;
+    // changes between consecutive draws in key order, the first draw counts as one of each
+    std::size_t programSwitches = 0;
+    std::size_t textureSwitches = 0;
+    // the same in the order the draws were added
+    std::size_t unsortedProgramSwitches = 0;
+    std::size_t unsortedTextureSwitches = 0;
+};
+
+// opaque draws of a frame sorted by a 64-bit key to minimize state changes, from the most to the least significant bits:
+// program (8 bits), texture set (14 bits), material (12 bits), depth (20 bits), vertex array (10 bits).
+// programs, texture sets, materials and vertex arrays are ranked in the order they are first added to the frame,
+// ranks beyond the width of their field share its largest value. draws of the same state are ordered front to back for early-Z.
+class RenderQueue
+{
+public:
+    // drop the draws and the ranks of the last frame
+    void clear();
+    // depth is the distance of the draw to the eye, negative is treated as 0. material is any identity, nullptr for none
+    void add(std::uint32_t index, GLuint program, const RenderTextureSet& textures, const void* material, GLuint vao, float depth);
+    // LSD radix sort by key, bytes that are equal in all keys are skipped
+    void sort();
+    // the draws, in key order after sort
+    const std::vector<RenderItem>& getItems() const;
+    // of the last sort
+    const RenderQueueStatistics& getStatistics() const;
+
+    static std::uint64_t makeKey(std::uint32_t programRank, std::uint32_t textureRank, std::uint32_t materialRank, float depth, std::uint32_t vaoRank);
+    static std::uint32_t getProgramRank(std::uint64_t key);
+    static std::uint32_t getTextureRank(std::uint64_t key);
+private:
+    std::vector<RenderItem> m_Items;
+    std::vector<RenderItem> m_Scratch;
+    std::unordered_map<GLuint, std::uint32_t> m_ProgramRanks;
+    std::map<RenderTextureSet, std::uint32_t> m_TextureRanks;
+    std::unordered_map<const void*, std::uint32_t> m_MaterialRanks;
+    std::unordered_map<GLuint, std::uint32_t> m_VaoRanks;
+    RenderQueueStatistics m_Stats;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -8,16 +8,98 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <array>
 #include <functional>
+#include <future>
+#include <atomic>
+#include <span>
+#include <deque>
 #include "Material.h"
 #include "Model.h"
 #include "Logger.h"
 #include "Light.h"
 #include "Shader.h"
+#include "VertexLayout.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "LightClusters.h"
+#include "ShaderPermutations.h"
+#include "GLStateCache.h"
+#include "RenderQueue.h"
+#include "MeshArena.h"
+#include "BufferAllocator.h"
+#include "BoundingVolumes.h"
+#include "BoundingVolumeHierarchy.h"
+#include "HandleSlots.h"
 
 namespace Utils
 {
 
+struct AsyncModelState;
+struct ModelUploadData;
+struct DrawParametersStd430;
+
+// generational handle of a model added to Renderer: the slot of a removed model is reused by a later model,
+// the handles of the removed model are stale and refer to no model. converts to the model index for the model setters.
+struct ModelHandle
+{
+    std::uint32_t index = HandleSlots::invalidIndex;
+    std::uint32_t generation = 0;
+
+    operator std::size_t() const { return index; }
+};
+
+// generational handle of a texture of the texture table of Renderer, see Renderer::addTexture
+struct TextureHandle
+{
+    std::uint32_t index = HandleSlots::invalidIndex;
+    std::uint32_t generation = 0;
+};
+
+// future-like handle of a model added by Renderer::addModelAsync
+class AsyncModelHandle
+{
+    friend class Renderer;
+private:
+    ModelHandle m_Model;
+    std::shared_ptr<AsyncModelState> m_spState;
+public:
+    AsyncModelHandle() = default;
+    AsyncModelHandle(ModelHandle model, std::shared_ptr<AsyncModelState> spState);
+    // model index for the model setters of Renderer, valid right away
+    std::size_t index() const;
+    // for Renderer::removeModel and Renderer::replaceModel
+    ModelHandle model() const;
+    bool valid() const;
+    // CPU side loading finished, successfully or not
+    bool isLoaded() const;
+    // GL buffers are created, the model is drawn from now on
+    bool isUploaded() const;
+    // block until CPU side loading finished
+    void wait() const;
+    // wait and return the model, rethrow the exception of the loader if any
+    std::shared_ptr<Model> get() const;
+};
+
+struct ResourceStatistics
+{
+    std::size_t models = 0;             // added and not removed
+    std::size_t modelSlots = 0;         // the size of the model table, slots of removed models included
+    std::size_t textures = 0;           // in the texture table
+    // removed models and textures whose GL objects and buffer ranges wait for the GPU to finish the frames that used them
+    std::size_t retiredFrames = 0;
+    std::size_t retiredObjects = 0;
+    std::size_t deletedObjects = 0;     // in total
+};
+
+// an instance of an instanced model, see Renderer::setModelInstances
+struct ModelInstance
+{
+    glm::mat4 transform = glm::mat4(1.0f);  // applied before the model matrix (the rotation of the model)
+    glm::vec4 color = glm::vec4(1.0f);      // for pure color styles, instead of the color of the model
+    std::uint32_t materialIndex = 0;        // for lighting styles, index of the materials of Renderer::setInstanceMaterials
+};
+
 class Renderer
 {
 public:
@@ -50,6 +132,21 @@ public:
         Sample64,           // sampling for near 64 texels
         Sample4Dithered     // sampling for near dithered 4 texels
     };
+    // optional processing of the model data before upload in addModel and addModelAsync, combine them with |
+    enum ModelProcessing
+    {
+        NoProcessing = 0,
+        QuantizeAttributes = 1,     // half float texCoords, octahedral snorm16 normals and tangents, 16 bits indices if the vertex count allows
+        OptimizeMesh = 2,           // reorder triangles for the post-transform cache and overdraw, and vertices for fetch locality
+        GenerateLods = 4,           // simplified levels of detail of indexed models, display draws one by the screen size of the model
+        BuildMeshlets = 8           // clusters of indexed models with bounds, display draws the clusters in the view frustum that face the eye
+    };
+    // where point and spot lights are assigned to the clusters of the view frustum every frame
+    enum LightCullingMode
+    {
+        CpuLightCulling = 0,    // LightClusterGrid on the CPU, the clusters are uploaded
+        GpuLightCulling         // a compute shader, the lights of a cluster that do not fit in the light index buffer are dropped
+    };
 private:
     struct ModelAttributes
     {
@@ -71,15 +168,38 @@ private:
         bool bRotate = false;
         glm::vec3 rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
         float rotationRate = 1.0; // means 1 second for 1 radian
+        // false while the model is loading asynchronously, it is not drawn until uploaded
+        bool bUploaded = false;
         // vao, one vao per model
         GLuint vao = 0;
-        // vbos
-        GLuint indicesVbo = 0;
-        GLuint verticesVbo = 0;
-        GLuint texCoordVbo = 0;
-        GLuint normalVbo = 0;
-        GLuint sTanVbo = 0;
-        GLuint tTanVbo = 0;
+        // layout of the vertex attributes in the vertex buffers
+        VertexLayout layout;
+        // index type of glDrawElements, GL_UNSIGNED_SHORT for quantized models of at most 65536 vertices
+        GLenum indexType = GL_UNSIGNED_INT;
+        // texCoords are half floats, normals and tangents are octahedral encoded, decoded by the built-in shaders
+        bool bQuantized = false;
+        // levels of detail in the indices from full to coarsest, empty without GenerateLods, and the one drawn this frame
+        std::vector<MeshLod> lods;
+        std::size_t currentLod = 0;
+        // meshlets of every level of detail in the indices, empty without BuildMeshlets,
+        // lodMeshlets[i] is the first meshlet of level i, the last entry is the meshlet count
+        std::vector<Meshlet> meshlets;
+        std::vector<std::size_t> lodMeshlets;
+        // ranges of the visible meshlets of this frame for glMultiDrawElements, valid if bMeshletsCulled
+        bool bMeshletsCulled = false;
+        std::vector<GLsizei> visibleCounts;
+        std::vector<const void*> visibleOffsets;
+        std::vector<GLint> visibleBaseVertices;
+        // bounding box and sphere of the vertices in model space
+        BoundingVolume bounds;
+        // ranges of the geometry buffers: the indices, and the vertices (interleaved packing, at location 0) or
+        // each attribute by location (separate buffers), invalid for data the model does not have
+        BufferHandle indexAllocation = BufferAllocator::invalidHandle;
+        std::array<BufferHandle, 5> vertexAllocations = { BufferAllocator::invalidHandle, BufferAllocator::invalidHandle,
+            BufferAllocator::invalidHandle, BufferAllocator::invalidHandle, BufferAllocator::invalidHandle };
+        // the indices of the model start at firstIndex of the index buffer of vao and count from baseVertex
+        GLuint firstIndex = 0;
+        GLint baseVertex = 0;
         // bump map
         bool generateBumpMap = false;
         // normal map
@@ -89,6 +209,18 @@ private:
         bool enableHeightMap = false;
         GLuint heightMap = 0;
         float heightFactor = 10.0f;
+        // instancing: the model is drawn instanceCount times with the transforms of the instance buffer, once without instancing if 0
+        GLuint instanceSsbo = 0;
+        GLsizei instanceCount = 0;
+        // the transforms of the instance buffer and the bounds of all instances in model space, for frustum culling
+        std::vector<glm::mat4> instanceTransforms;
+        BoundingVolume instanceBounds;
+        GLuint instanceMaterialSsbo = 0;
+        GLuint instanceMaterialsSize = 0;
+        // multi-draw indirect: the model is in the shared arena of its vertex format and has no ranges of the geometry buffers,
+        // vao is the one of the arena and firstIndex and baseVertex are those of the range
+        MeshArena* pArena = nullptr;
+        MeshArenaRange arenaRange;
     };
     // attributes that every window needs one copy
     // workaround for variables that need to be visited in call back function, they must be static, so save them in static hashtable for every window.
@@ -121,10 +253,83 @@ public:
     static int& getLastCursorPosY(GLFWwindow* w) { return s_WindowAttrs[w].m_LastCursorPosY; }
 private:
     // some max lihgts number constants, must be same as the number in the shader !
-    static constexpr std::size_t MAX_POINT_LIGHT_SIZE = 5;
+    // point and spot lights are not limited, only the first MAX_SHADOW_SIZE lights (directional, point, spot) cast shadows
     static constexpr std::size_t MAX_DIRECTIONAL_LIGHT_SIZE = 5;
-    static constexpr std::size_t MAX_SPOT_LIGHT_SIZE = 5;
-    static constexpr std::size_t MAX_SHADOW_SIZE = MAX_POINT_LIGHT_SIZE + MAX_DIRECTIONAL_LIGHT_SIZE + MAX_SPOT_LIGHT_SIZE; // 15
+    static constexpr std::size_t MAX_SHADOW_SIZE = 15;
+    // binding points of the uniform blocks of the lighting, shadow and environment map shaders, same as in the shaders !
+    // FrameBlock: view and projection matrices, PCF settings, light cluster grid. LightBlock: global ambient and directional lights in view space.
+    static constexpr GLuint FRAME_UNIFORM_BINDING = 0;
+    static constexpr GLuint LIGHT_UNIFORM_BINDING = 1;
+    // binding points of the shader storage blocks of the clustered lights, same as in the shaders !
+    static constexpr GLuint POINT_LIGHT_STORAGE_BINDING = 0;
+    static constexpr GLuint SPOT_LIGHT_STORAGE_BINDING = 1;
+    static constexpr GLuint CLUSTER_STORAGE_BINDING = 2;
+    static constexpr GLuint CLUSTER_LIGHT_INDEX_STORAGE_BINDING = 3;
+    static constexpr GLuint CLUSTER_BOUNDS_STORAGE_BINDING = 4;
+    static constexpr GLuint CLUSTER_COUNTER_STORAGE_BINDING = 5;
+    // binding points of the instance buffers of instanced models, same as in the shaders !
+    static constexpr GLuint INSTANCE_STORAGE_BINDING = 6;
+    static constexpr GLuint INSTANCE_MATERIAL_STORAGE_BINDING = 7;
+    // binding point of the draw parameters of the multi-draw programs, same as in the shaders !
+    static constexpr GLuint DRAW_PARAMETER_STORAGE_BINDING = 8;
+    // light indices per cluster on average that the buffer of GpuLightCulling has room for
+    static constexpr std::size_t GPU_CLUSTER_LIGHT_INDICES = 64;
+    // features of the variants of the lighting programs, the bit of a feature is the index of its #define in the feature names of the Renderer constructor
+    enum ShaderFeature : ShaderFeatureMask
+    {
+        FlatShadingFeature = 1 << 0,
+        BumpMapFeature = 1 << 1,
+        NormalMapFeature = 1 << 2,
+        HeightMapFeature = 1 << 3,
+        OctNormalsFeature = 1 << 4,
+        DirectionalLightsFeature = 1 << 5,
+        PointLightsFeature = 1 << 6,
+        SpotLightsFeature = 1 << 7,
+        InstancedFeature = 1 << 8,
+        MultiDrawFeature = 1 << 9
+    };
+    // handles of the uniforms that display sets for every model, looked up once per program,
+    // uniforms that a program does not have (or has in a uniform block) are invalid handles and setting them does nothing
+    struct ModelUniforms
+    {
+        Uniform<glm::mat4> mvMatrix, projMatrix, normMatrix;
+        Uniform<bool> octNormals;
+        Uniform<glm::vec4> inputColor;
+        // lighting and material
+        Uniform<GLfloat> materialWeight, textureWeight;
+        Uniform<glm::vec4> materialAmbient, materialDiffuse, materialSpecular;
+        Uniform<GLfloat> materialShininess;
+        // shadows
+        std::array<Uniform<glm::mat4>, MAX_SHADOW_SIZE> shadowMVPs;
+        // height map
+        Uniform<GLfloat> heightFactor;
+        // instanced variants
+        Uniform<GLuint> instanceMaterialsSize;
+        // multi-draw variants with gl_DrawID
+        Uniform<GLuint> firstDraw;
+
+        ModelUniforms() = default;
+        explicit ModelUniforms(const Shader& shader);
+    };
+    // a model drawn by the camera pass of display, in the order of the render queue
+    struct ModelDraw
+    {
+        std::size_t modelIndex = 0;
+        const Shader* pShader = nullptr;
+        const ModelUniforms* pUniforms = nullptr;
+        GLenum primitiveType = GL_TRIANGLES;
+        RenderTextureSet textures{};
+        // drawn by a multi-draw call with the draws before and after it of the same program, textures, arena and primitive type
+        bool bMultiDraw = false;
+    };
+    // a glMultiDrawElementsIndirect call of a pass, its commands are commandCount of the command buffer from firstCommand on
+    struct MultiDrawBatch
+    {
+        const MeshArena* pArena = nullptr;
+        GLenum primitiveType = GL_TRIANGLES;
+        std::size_t firstCommand = 0;
+        std::size_t commandCount = 0;
+    };
 private:
     // window
     GLFWwindow* m_pWindow = nullptr;
@@ -134,8 +339,81 @@ private:
     bool m_bEnableCullFace = true;
     GLenum m_FaceCullingMode = GL_BACK;
     GLenum m_FrontFace = GL_CCW;
-    // models
+    // models, the slots of removed models are reused
     std::vector<ModelAttributes> m_Models;
+    HandleSlots m_ModelSlots;
+    // textures the renderer loaded, shared by path and referenced by the models that use them and by the handles of addTexture.
+    // a texture is deleted when its last reference is released
+    struct TextureEntry
+    {
+        GLuint id = 0;
+        std::string path;
+        std::size_t references = 0;
+    };
+    std::vector<TextureEntry> m_Textures;
+    HandleSlots m_TextureSlots;
+    std::unordered_map<std::string, std::uint32_t> m_TextureSlotsByPath;
+    std::unordered_map<GLuint, std::uint32_t> m_TextureSlotsById;
+    // GL objects and buffer ranges of removed models and textures. those retired during a frame are fenced after it
+    // and deleted once the GPU passed the fence, the in-flight frames may still read them until then
+    struct RetiredResources
+    {
+        GLsync fence = nullptr;
+        std::vector<GLuint> vertexArrays;
+        std::vector<GLuint> buffers;
+        std::vector<GLuint> textures;
+        std::vector<BufferHandle> allocations;
+        std::vector<std::pair<MeshArena*, MeshArenaRange>> arenaRanges;
+
+        std::size_t objectCount() const
+        {
+            return vertexArrays.size() + buffers.size() + textures.size() + allocations.size() + arenaRanges.size();
+        }
+    };
+    RetiredResources m_Retiring;
+    std::deque<RetiredResources> m_RetiredResources;
+    ResourceStatistics m_ResourceStats;
+    // async models waiting for upload, and the upload limit per frame in bytes
+    std::vector<AsyncModelHandle> m_PendingModels;
+    std::size_t m_AsyncUploadBudget = 64 * 1024 * 1024;
+    bool m_bRunning = false;
+    // the largest simplification error of the drawn level of detail on the screen, in pixels
+    float m_LodPixelError = 1.0f;
+    // meshlet culling of the last frame
+    MeshletCullingStatistics m_MeshletStats;
+    // frustum culling: the world space bounds of all models by model index in a hierarchy, and the models of the camera pass
+    // and of every shadow texture that are not completely outside of the frustum. the hierarchy is built again when the model table
+    // grew or refitting made it much worse, the bounds of changed and rotating models are refitted every frame
+    bool m_bFrustumCulling = true;
+    std::vector<BoundingVolume> m_ModelBounds;
+    BoundingVolumeHierarchy m_ModelHierarchy;
+    std::vector<std::uint32_t> m_ChangedModels;
+    std::vector<std::uint32_t> m_RotatingModels;
+    std::vector<std::uint8_t> m_CameraVisible;
+    std::vector<std::vector<std::uint8_t>> m_ShadowVisible;
+    FrustumCullingStatistics m_FrustumCullingStats;
+    // the state display sets per draw, redundant calls are skipped
+    GLStateCache m_GLState;
+    // the models of the camera pass of the frame, sorted by program, textures, material and depth
+    RenderQueue m_RenderQueue;
+    std::vector<ModelDraw> m_ModelDraws;
+    // multi-draw indirect: indexed models uploaded while it is enabled share the vertex and index buffers of an arena per vertex format,
+    // the commands and draw parameters of a pass are uploaded at once and every arena is drawn by one call per pass
+    bool m_bMultiDrawIndirect = false;
+    std::vector<std::unique_ptr<MeshArena>> m_MeshArenas;
+    std::vector<DrawElementsIndirectCommand> m_MultiDrawCommands;
+    std::vector<DrawParametersStd430> m_MultiDrawParameters;
+    std::vector<MultiDrawBatch> m_MultiDrawBatches;
+    GLuint m_DrawCommandBuffer = 0;
+    GLuint m_DrawParameterSsbo = 0;
+    // 0, 1, 2... the draw index attribute of the arenas for programs without gl_DrawID, one per arena model
+    GLuint m_DrawIndexVbo = 0;
+    std::size_t m_DrawIndexCapacity = 0;
+    MultiDrawStatistics m_MultiDrawStats;
+    // the vertices and indices of the models that are not in an arena, sub-allocated in a few large buffers.
+    // allocations are owned by model index, a part of the buffers is defragmented every frame
+    BufferAllocator m_GeometryBuffers;
+    std::size_t m_DefragmentBudget = 1024 * 1024;
     // matrices
     glm::mat4 m_ModelMatrix;
     glm::mat4 m_ViewMatrix;
@@ -145,14 +423,56 @@ private:
     Shader m_PureColorShader;
     Shader m_VaryingColorShader;
     Shader m_TextureShader;
-    Shader m_GouraudMaterialTextureShader;
-    Shader m_PhongMaterialTextureShader;
+    // LightingMaterialTexture programs, specialized for the features of the model and the lights of the scene
+    ShaderPermutations m_GouraudMaterialTexturePrograms;
+    ShaderPermutations m_PhongMaterialTexturePrograms;
     Shader m_SimpleShadowDepthShader;   // generate depth shadow texture for every light
     Shader m_ShadowShader;              // draw shadows use shadow texture
     Shader m_ShadowDebugShader1;        // just show the specific shadow texture.
     Shader m_ShadowDebugShader2;        // show simplified shadow result for specific light.
     Shader m_SkyBoxShader;              // render sky box
     Shader m_EnvironmentMapShader;      // render environment map (use texture of sky box) as texture
+    // INSTANCED variants of the programs above for instanced models
+    Shader m_InstancedPureColorShader;
+    Shader m_InstancedVaryingColorShader;
+    Shader m_InstancedTextureShader;
+    Shader m_InstancedShadowDepthShader;
+    Shader m_InstancedShadowShader;
+    Shader m_InstancedEnvironmentMapShader;
+    // MULTI_DRAW variants for the models of the arenas
+    Shader m_MultiDrawPureColorShader;
+    Shader m_MultiDrawVaryingColorShader;
+    Shader m_MultiDrawTextureShader;
+    Shader m_MultiDrawShadowDepthShader;
+    // uniform handles of the programs that draw models
+    ModelUniforms m_PureColorUniforms;
+    ModelUniforms m_VaryingColorUniforms;
+    ModelUniforms m_TextureUniforms;
+    // of the program variants (permutations, instanced, multi-draw) by program id, added when a variant is first used
+    std::unordered_map<GLuint, ModelUniforms> m_PermutationUniforms;
+    ModelUniforms m_ShadowUniforms;
+    ModelUniforms m_EnvironmentMapUniforms;
+    Uniform<glm::mat4> m_ShadowDepthMVPUniform;
+    Uniform<glm::mat4> m_InstancedShadowDepthMVPUniform;
+    Uniform<glm::mat4> m_MultiDrawShadowDepthVPUniform;
+    Uniform<GLuint> m_MultiDrawShadowDepthFirstDrawUniform;
+    // uniform buffers of FrameBlock and LightBlock
+    GLuint m_FrameUbo = 0;
+    GLuint m_LightUbo = 0;
+    // clustered forward shading: point and spot lights in storage buffers, the Phong and shadow programs shade the lights of the cluster of a fragment
+    LightClusterGrid m_LightClusters;
+    LightCullingMode m_LightCullingMode = CpuLightCulling;
+    Shader m_LightCullingShader;
+    Uniform<GLuint> m_CullingPointLightsSizeUniform;
+    Uniform<GLuint> m_CullingSpotLightsSizeUniform;
+    Uniform<GLuint> m_CullingClusterCountUniform;
+    Uniform<GLuint> m_CullingMaxLightIndicesUniform;
+    GLuint m_PointLightSsbo = 0;
+    GLuint m_SpotLightSsbo = 0;
+    GLuint m_ClusterSsbo = 0;
+    GLuint m_ClusterLightIndexSsbo = 0;
+    GLuint m_ClusterBoundsSsbo = 0;
+    GLuint m_ClusterCounterSsbo = 0;
     // xyz axis
     GLuint m_AxisesVao;
     GLuint m_AxisesVbo;
@@ -186,15 +506,52 @@ public:
 
     // run the render loop
     void run();
+    // wait for the built-in programs the constructor submitted to the driver, run does it before the first frame.
+    // the constructor does not wait for all of them, the driver compiles them while the models and lights are set up
+    void finishShaderPrograms();
 
     // replace built-in display function, use user-defined display function, for customizing rendering
     // the call back is called in form of: func(pWindow, currentTime);
     void setDisplayCallback(std::function<void(GLFWwindow*, float)> func);
     
-    // add model to render, return it's index
-    std::size_t addModel(std::shared_ptr<Model> spModel, RenderStyle renderStyle);
+    // add model to render, return its handle, which converts to its index
+    // packing selects separate vertex buffers per attribute or a single interleaved buffer for the model
+    // processing is a combination of ModelProcessing flags:
+    // QuantizeAttributes takes about half of the vertex memory, only for the built-in shaders, a display callback must decode them itself.
+    // OptimizeMesh applies to indexed models, it logs the ACMR and ATVR before and after at debug level.
+    // BuildMeshlets applies to indexed models, display culls their meshlets on the CPU every frame, shadows are drawn from all meshlets.
+    ModelHandle addModel(std::shared_ptr<Model> spModel, RenderStyle renderStyle, VertexPacking packing = SeparateBuffers, unsigned processing = NoProcessing);
+    // add model which is loaded by loader on a worker thread, loader must not call OpenGL functions.
+    // the GL buffers are created in the render loop after loading, the model is drawn from then on.
+    // the index of the returned handle is valid for the model setters right away.
+    AsyncModelHandle addModelAsync(std::function<std::shared_ptr<Model>()> loader, RenderStyle renderStyle, VertexPacking packing = SeparateBuffers,
+                                   unsigned processing = NoProcessing);
+    // max bytes of vertex data uploaded per frame for async models (at least one model per frame), default to 64MB
+    void setAsyncUploadBudget(std::size_t bytesPerFrame);
+    // wait for all async models and upload them now
+    void finishAsyncModels();
+    // the model was added and not removed
+    bool isModelValid(ModelHandle model) const;
+    // stop drawing the model and free its slot for later models, the handles of the model become stale.
+    // its vertex array, buffers and the textures only it uses are deleted once the GPU finished the frames that may use them.
+    // an async model that is still loading is dropped when loading finishes
+    void removeModel(ModelHandle model);
+    // replace the vertices and indices of the model, its handle, style, transform, textures, material and instances are kept.
+    // the old ones are deleted as by removeModel
+    void replaceModel(ModelHandle model, std::shared_ptr<Model> spModel, VertexPacking packing = SeparateBuffers, unsigned processing = NoProcessing);
+
+    // load a texture to the texture table, or share the one already loaded from the path.
+    // the texture is deleted when the handle is removed and no model uses it anymore, the texture setters of the models
+    // with a path use the table too
+    TextureHandle addTexture(const char* textureImagePath);
+    void removeTexture(TextureHandle texture);
+    // texture id for the texture setters of the models, 0 for a stale handle
+    GLuint getTexture(TextureHandle texture) const;
+    // models, textures and the GL objects waiting for deletion
+    const ResourceStatistics& getResourceStatistics() const;
 
     // add lighting to render, affect those objects with lighting modes
+    // at most 5 directional lights, any number of point and spot lights
     void setGlobalAmbientLight(glm::vec4 ambient);
     void addDirectionalLight(const DirectionalLight& light);
     void addDirectionalLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 direction);
@@ -210,6 +567,42 @@ public:
     // set pcf factor to adjust the diffusion range of soft shadow, a typical value is 2.5f
     void setPCFMode(PCFMode mode, float pcfFactor = 2.5f);
 
+    // assign point and spot lights to the clusters on the CPU (default) or in a compute shader
+    void setLightCullingMode(LightCullingMode mode);
+    // light clusters of the last frame, only filled by CpuLightCulling
+    const LightClusterStatistics& getLightClusterStatistics() const;
+
+    // level of detail selection for models added with GenerateLods: the coarsest level whose simplification error
+    // projects to at most pixelError pixels is drawn, default to 1 pixel
+    void setLodPixelError(float pixelError);
+    // meshlets of the last frame of models added with BuildMeshlets, summed up
+    const MeshletCullingStatistics& getMeshletCullingStatistics() const;
+    // frustum culling, default to true: models whose bounding box or sphere is outside of the view frustum of the camera
+    // or of the light of a shadow texture are not drawn in that pass. instanced models are tested with the bounds of all instances
+    void setFrustumCulling(bool enable);
+    // models tested, culled and drawn by the camera and every shadow texture in the last frame
+    const FrustumCullingStatistics& getFrustumCullingStatistics() const;
+    // the nearest model under the cursor (window coordinates, as the cursor position of GLFW) whose bounding box and sphere
+    // in the last frame the ray from the eye hits, an invalid handle if there is none
+    ModelHandle pickModel(double cursorX, double cursorY) const;
+    // state calls of the last frame drawn by the built-in display, issued to GL and skipped as redundant
+    const GLStateStatistics& getGLStateStatistics() const;
+    // draws of the last frame of the built-in display and their program and texture switches, sorted and in the order of the models
+    const RenderQueueStatistics& getRenderQueueStatistics() const;
+
+    // multi-draw indirect mode, default to false: indexed models uploaded while it is enabled are sub-allocated in one vertex buffer
+    // and one index buffer per vertex format. every pass draws the models of an arena that are not instanced with one
+    // glMultiDrawElementsIndirect call per run of the same program and textures, the transforms and materials are draw parameters
+    // in a storage buffer. models with culled meshlets, PhongShadingWithShadow and EnvironmentMap models are drawn one by one
+    // in the camera pass, from the arena too. enable it before adding the models, it does not move models added before.
+    void setMultiDrawIndirect(bool enable);
+    // arenas and multi-draw calls of the last frame of the built-in display
+    const MultiDrawStatistics& getMultiDrawStatistics() const;
+    // bytes of vertex and index data moved per frame to close the gaps of the geometry buffers, default to 1 MB, 0 to disable
+    void setDefragmentBudget(std::size_t bytesPerFrame);
+    // geometry buffers of the models that are not in an arena
+    const BufferAllocatorStatistics& getGeometryBufferStatistics() const;
+
     // enable sky box, set texture to sky box
     void enableSkyBox(const char* rightImage, const char* leftImage,
                    const char* topImage, const char* bottomImage,
@@ -237,13 +630,76 @@ public:
     // set height map for model, only for LightingMaterialTexture style
     void setHeightMap(std::size_t modelIndex, const char* textureImagePath, float heightFactor = 10.0f, bool doMipmapping = true, bool doAnisotropicFiltering = true);
     void setHeightMap(std::size_t modelIndex, GLuint textureId, float heightFactor = 10.0f, bool doMipmapping = true, bool doAnisotropicFiltering = true);
+    // draw the model once per instance in one instanced draw call, for all styles, shadows included.
+    // the instance buffer is orphaned and refilled on every call, call it every frame to move the instances.
+    // an empty span draws the model once without instancing again. instanced models are drawn in their finest level of detail
+    // and without meshlet culling, those are decided for the whole model.
+    void setModelInstances(std::size_t modelIndex, std::span<const ModelInstance> instances);
+    // materials the instances of the model select by index, for LightingMaterialTexture and PhongShadingWithShadow styles,
+    // instances with an index past the materials use the material of the model
+    void setInstanceMaterials(std::size_t modelIndex, std::span<const Material> materials);
 
     void drawAxises();
 private:
+    ModelHandle addModelAttributes(RenderStyle renderStyle);
+    void uploadModel(std::size_t modelIndex, const ModelUploadData& data);
+    // retire the vertex array and the ranges of the geometry buffers or the arena of the model, it is not uploaded anymore
+    void retireModelGeometry(ModelAttributes& attr);
+    // the entry of the texture table loaded from the path, loaded now if there is none yet
+    std::uint32_t acquireTexture(const std::string& textureImagePath);
+    // a reference to the texture if it is in the texture table, for the texture setters of the models
+    void retainTexture(GLuint textureId);
+    // release a reference to the texture if it is in the texture table, retire it with its last reference
+    void releaseTexture(GLuint textureId);
+    // fence the resources retired during the frame, after its commands
+    void fenceRetiredResources();
+    // delete the resources whose fence the GPU passed, or all of them when the renderer is destroyed
+    void deleteRetiredResources(bool deleteAll);
+    void updateResourceStatistics();
+    // copy the vertices and indices of an indexed model to the arena of its vertex format, false if they do not fit in one
+    bool uploadToMeshArena(ModelAttributes& attr, const ModelUploadData& data);
+    // point the vao of the model to its ranges of the geometry buffers
+    void attachGeometryBuffers(ModelAttributes& attr);
+    // move a part of the geometry buffers to close gaps and re-attach the models that moved
+    void defragmentGeometryBuffers();
+    void uploadPendingModels(bool waitForAll);
     void checkForModelAttributes();
+    void checkModelAttributes(std::size_t modelIndex);
     void updateViewArgsAccordingToCursorPos();
     void drawShadowTextures(float currentTime);
     void drawSkyBox();
+    void updateFrameUniforms();
+    void updateLightClusters();
+    // features of the LightingMaterialTexture program variant for the model
+    ShaderFeatureMask getShaderFeatures(const ModelAttributes& attr) const;
+    void selectModelLods(float currentTime);
+    void cullModelMeshlets(float currentTime);
+    // the bounds of all instances of an instanced model, after its vertices or its instances changed
+    void updateInstanceBounds(std::size_t modelIndex);
+    // the world space bounds of the models in this frame, in m_ModelBounds and m_ModelHierarchy
+    BoundingVolume getWorldBounds(const ModelAttributes& attr, float currentTime) const;
+    void updateModelBounds(float currentTime);
+    // visible[i] is 0 if model i is outside of the frustum of vpMat, the statistics count the uploaded models
+    void cullModels(const glm::mat4& vpMat, std::vector<std::uint8_t>& visible, FrustumCullingPassStatistics& stats);
+    // the draw call of the model in its current level of detail, its vao must be bound.
+    // cameraView draws only the meshlets that passed the culling of this frame. instanced models bind their instance buffers.
+    void drawModel(const ModelAttributes& attr, GLenum primitiveType, bool cameraView = false);
+    // the INSTANCED variant of a built-in program, for models with instances
+    const Shader& getInstancedShader(const Shader& shader) const;
+    // the MULTI_DRAW variant of a built-in program, the program itself if it has none
+    const Shader& getMultiDrawShader(const Shader& shader) const;
+    // the model is drawn by the multi-draw calls of the pass
+    bool isMultiDrawn(const ModelAttributes& attr, bool cameraView) const;
+    // append the command of the model in its current level of detail and its draw parameters, the view matrix is for the camera pass
+    void addMultiDraw(const ModelAttributes& attr, const glm::mat4& modelMatrix, const glm::mat4* pViewMatrix);
+    // drop the multi-draw calls of the last pass
+    void clearMultiDraws();
+    // the draw index attribute of the arenas counts up to at least count
+    void reserveDrawIndices(std::size_t count);
+    // orphan and fill the command and draw parameter buffers with the calls of the pass
+    void uploadMultiDraws();
+    // the program of the call is in use, the uniforms other than the draw parameters are set
+    void drawMultiDrawBatch(const MultiDrawBatch& batch, const Shader& shader, const Uniform<GLuint>& firstDrawUniform);
     void display(float currentTime);
     // debug functions
     void debugShowShadowTexture(std::size_t shadowIndex);
@@ -3,15 +3,69 @@
 #include <glm/glm.hpp>
 #include <glad/gl.h>
 #include <string>
+#include <string_view>
+#include <span>
+#include <cstdint>
+#include <memory>
 #include <source_location>
 
 namespace Utils
 {
 
+// location of an active uniform of a program, typed by the value the Shader::set overloads accept for it.
+// the location is -1 for names the program does not have, setting it does nothing like glUniform with location -1.
+template<typename T>
+class Uniform
+{
+private:
+    GLint m_Location = -1;
+public:
+    Uniform() = default;
+    explicit Uniform(GLint location) : m_Location(location) {}
+    GLint location() const { return m_Location; }
+    bool valid() const { return m_Location >= 0; }
+};
+
+// GLSL types a uniform handle of type T may refer to
+template<typename T> struct UniformType;
+template<> struct UniformType<bool> { static constexpr GLenum types[] = { GL_BOOL, GL_INT }; };
+template<> struct UniformType<GLint> { static constexpr GLenum types[] = { GL_INT, GL_BOOL, GL_SAMPLER_2D, GL_SAMPLER_CUBE, GL_SAMPLER_2D_SHADOW }; };
+template<> struct UniformType<GLuint> { static constexpr GLenum types[] = { GL_UNSIGNED_INT }; };
+template<> struct UniformType<GLfloat> { static constexpr GLenum types[] = { GL_FLOAT }; };
+template<> struct UniformType<glm::vec2> { static constexpr GLenum types[] = { GL_FLOAT_VEC2 }; };
+template<> struct UniformType<glm::vec3> { static constexpr GLenum types[] = { GL_FLOAT_VEC3 }; };
+template<> struct UniformType<glm::vec4> { static constexpr GLenum types[] = { GL_FLOAT_VEC4 }; };
+template<> struct UniformType<glm::mat2> { static constexpr GLenum types[] = { GL_FLOAT_MAT2 }; };
+template<> struct UniformType<glm::mat3> { static constexpr GLenum types[] = { GL_FLOAT_MAT3 }; };
+template<> struct UniformType<glm::mat4> { static constexpr GLenum types[] = { GL_FLOAT_MAT4 }; };
+
+// FNV-1a hash of a uniform name, the key of the uniform table of a program
+constexpr std::uint64_t hashUniformName(std::string_view name)
+{
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    for (char c : name)
+    {
+        h = (h ^ std::uint64_t(static_cast<unsigned char>(c))) * 0x100000001B3ull;
+    }
+    return h;
+}
+
+class UniformTable;
+class ProgramState;
+struct PendingProgram;
+
+// a shader program, copies share the program and its uniform table.
+// the active uniforms are reflected once after link, the set overloads by name look them up in that table instead of asking the driver,
+// hot paths get a typed handle once with getUniform and set it without any lookup.
+// a submitted program is finished (link status checked, uniforms reflected) when it is first used, see submit.
 class Shader
 {
 private:
     GLuint m_Id;
+    std::shared_ptr<ProgramState> m_spState;
+    void setProgram(PendingProgram pending, const std::source_location& loc);
+    const UniformTable* getUniformTable() const;
+    GLint findUniform(std::string_view name, std::uint64_t hash, std::span<const GLenum> types) const;
 public:
     Shader();
     Shader(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader = "",
@@ -26,6 +80,17 @@ public:
     void setShaderSource(const std::string& vertexShader, const std::string tessellationCtrlShader, const std::string& tessellationEvalShader,
                          const std::string& fragmentShader, const std::string& geometryShader = "",
                          const std::source_location& loc = std::source_location::current());
+    void setComputeShaderSource(const std::string& computeShader, const std::source_location& loc = std::source_location::current());
+    // submit the program to the driver and return without waiting for it, the constructors and setters above wait.
+    // submit all programs of a batch before using any of them, a driver with KHR_parallel_shader_compile compiles them all at once then.
+    // the first use (use, getUniform, set by name, finish) waits for the program and logs its errors
+    static Shader submit(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader = "",
+                         const std::source_location& loc = std::source_location::current());
+    static Shader submitCompute(const std::string& computeShader, const std::source_location& loc = std::source_location::current());
+    // using the program does not wait for the driver, always true without KHR_parallel_shader_compile
+    bool isReady() const;
+    // wait for a submitted program, nothing to do for others
+    void finish() const;
     GLuint getShaderId() const;
     void use() const;
     void setBool(const std::string& name, bool value) const;
@@ -41,6 +106,27 @@ public:
     void setMat2(const std::string& name, const glm::mat2& mat) const;
     void setMat3(const std::string& name, const glm::mat3& mat) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
+
+    // location of an active uniform, as glGetUniformLocation but from the reflected table, -1 if the program does not have it
+    GLint getUniformLocation(std::string_view name) const;
+    // typed handle of an active uniform, an invalid handle with a warning if its GLSL type does not take a T
+    template<typename T>
+    Uniform<T> getUniform(std::string_view name) const
+    {
+        return Uniform<T>(findUniform(name, hashUniformName(name), UniformType<T>::types));
+    }
+    void set(Uniform<bool> uniform, bool value) const;
+    void set(Uniform<GLint> uniform, GLint value) const;
+    void set(Uniform<GLuint> uniform, GLuint value) const;
+    void set(Uniform<GLfloat> uniform, GLfloat value) const;
+    void set(Uniform<glm::vec2> uniform, const glm::vec2& value) const;
+    void set(Uniform<glm::vec3> uniform, const glm::vec3& value) const;
+    void set(Uniform<glm::vec4> uniform, const glm::vec4& value) const;
+    void set(Uniform<glm::mat2> uniform, const glm::mat2& mat) const;
+    void set(Uniform<glm::mat3> uniform, const glm::mat3& mat) const;
+    void set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const;
+    // number of reflected uniform names, array elements counted one by one
+    std::size_t getUniformCount() const;
 };
 
 } // namespace Utils
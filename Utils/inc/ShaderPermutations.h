@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <unordered_map>
+#include <source_location>
+#include "Shader.h"
+
+namespace Utils
+{
+
+// features of a program variant, bit i enables the i-th feature name of its ShaderPermutations
+using ShaderFeatureMask = std::uint32_t;
+
+// source with "#define NAME" lines right after its #version line (the first line if it has none)
+std::string injectShaderDefines(std::string_view source, std::span<const std::string> defines);
+
+// variants of a program specialized at compile time: every feature is a #define the GLSL sources test with #ifdef,
+// instead of a uniform they branch on at runtime. a variant is compiled the first time its features are asked for.
+class ShaderPermutations
+{
+private:
+    std::string m_VertexShader;
+    std::string m_FragmentShader;
+    std::string m_GeometryShader;
+    std::vector<std::string> m_FeatureNames;
+    std::unordered_map<ShaderFeatureMask, Shader> m_Programs;
+    ShaderFeatureMask knownFeatures(ShaderFeatureMask features) const;
+public:
+    ShaderPermutations() = default;
+    // at most 32 features, the sources are copied
+    ShaderPermutations(std::string_view vertexShader, std::string_view fragmentShader, std::vector<std::string> featureNames,
+                       std::string_view geometryShader = "");
+
+    // the variant of the features, compiled and linked now if it is the first use, bits without a feature name are ignored
+    const Shader& get(ShaderFeatureMask features, const std::source_location& loc = std::source_location::current());
+    bool contains(ShaderFeatureMask features) const;
+    // defines of the features in bit order
+    std::vector<std::string> getDefines(ShaderFeatureMask features) const;
+    // compiled variants
+    std::size_t size() const;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -31,6 +31,10 @@ public:
     virtual std::vector<glm::vec3> getVertices() override;
     virtual std::vector<glm::vec2> getTexCoords() override;
     virtual std::vector<glm::vec3> getNormals() override;
+    virtual std::span<const int> getIndicesView() override;
+    virtual std::span<const glm::vec3> getVerticesView() override;
+    virtual std::span<const glm::vec2> getTexCoordsView() override;
+    virtual std::span<const glm::vec3> getNormalsView() override;
 };
 
 } // namespace Utils
\ No newline at end of file
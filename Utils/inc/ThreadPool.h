@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace Utils
+{
+
+// a fixed size pool of worker threads for CPU side work (model parsing, mesh processing, etc.)
+class ThreadPool
+{
+private:
+    std::vector<std::thread> m_Workers;
+    std::queue<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_bStop = false;
+public:
+    // 0 means one thread per hardware thread
+    ThreadPool(std::size_t threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const;
+
+    // run func asynchronously on the pool
+    template<typename Func>
+    auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>>
+    {
+        using ResultType = std::invoke_result_t<Func>;
+        // std::function requires a copyable callable, packaged_task is move-only
+        auto spTask = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+        std::future<ResultType> result = spTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.emplace([spTask]() { (*spTask)(); });
+        }
+        m_Condition.notify_one();
+        return result;
+    }
+
+    // call func(i) for every i in [0, count) and block until all calls are done, use at most maxThreads threads (0 for no limit).
+    // the calling thread takes part in the work, so it is safe to call from a task running on the pool itself.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& func, std::size_t maxThreads = 0);
+
+    // a pool shared by the whole process, one thread per hardware thread
+    static ThreadPool& globalPool();
+private:
+    void workerLoop();
+};
+
+} // namespace Utils
\ No newline at end of file
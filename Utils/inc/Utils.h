@@ -1,7 +1,10 @@
 #pragma once
 #include <glad/gl.h>
 #include <string>
+#include <vector>
+#include <span>
 #include <source_location>
+#include "ProgramBinaryCache.h"
 
 namespace Utils
 {
@@ -28,6 +31,8 @@ GLuint createShaderProgram(const std::string& vertexShader, const std::string& t
 // create and compile a shader of a specific type
 GLuint createAndCompileShader(const std::string& shaderSource, GLenum shaderType, const std::string& promptStr,
                               const std::source_location& loc = std::source_location::current());
+// the program creation functions below load a cached binary of the same sources from ProgramBinaryCache::globalCache() if there is one,
+// and store the binary of a program they compiled and linked.
 // create shader program from vertex, fragment, geometry shader sources
 GLuint createShaderProgramFromSource(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader = "",
                                      const std::source_location& loc = std::source_location::current());
@@ -35,6 +40,33 @@ GLuint createShaderProgramFromSource(const std::string& vertexShader, const std:
 GLuint createShaderProgramFromSource(const std::string& vertexShader, const std::string& tessellationCtrlShader, const std::string& tessellationEvalShader,
                                      const std::string& fragmentShader, const std::string& geometryShader = "",
                                      const std::source_location& loc = std::source_location::current());
+// create compute shader program from source
+GLuint createComputeProgramFromSource(const std::string& computeShader, const std::source_location& loc = std::source_location::current());
+
+// a program whose compilation and link were submitted to the driver without asking for any status
+struct PendingProgram
+{
+    struct Stage
+    {
+        GLenum type;
+        GLuint shader;
+        std::string source;
+    };
+    GLuint program = 0;
+    // shader objects, detached and deleted when the program is finished, empty for a program loaded from the binary cache
+    std::vector<Stage> stages;
+};
+// let the driver compile and link on up to count threads of its own (KHR_parallel_shader_compile), 0xFFFFFFFF for as many as it likes.
+// does nothing without the extension
+void setShaderCompilerThreads(GLuint count = 0xFFFFFFFF);
+// load the cached binary of the stages, or compile them and link the program without waiting for the driver.
+// submit all programs of a batch before finishing any, the driver works on all of them at once then
+PendingProgram submitShaderProgram(std::span<const ProgramStage> stages, const std::source_location& loc = std::source_location::current());
+// the driver is done with the program, finishShaderProgram does not block then (GL_COMPLETION_STATUS_KHR).
+// always true without KHR_parallel_shader_compile
+bool isProgramComplete(const PendingProgram& pending);
+// wait for the program, log compile and link errors, delete the shader objects and store the binary in the cache, return the program
+GLuint finishShaderProgram(PendingProgram& pending, const std::source_location& loc = std::source_location::current());
 
 // load texture to OpenGL texture object
 GLuint loadTexture(const std::string& textureImagePath, const std::source_location& loc = std::source_location::current());
@@ -0,0 +1,55 @@
+#pragma once
+#include <glad/gl.h>
+#include <vector>
+#include <cstddef>
+
+namespace Utils
+{
+
+// how the vertex attributes of a model are stored in vertex buffers
+enum VertexPacking
+{
+    SeparateBuffers,    // one tightly packed buffer per attribute
+    InterleavedBuffer   // all attributes of a vertex next to each other in a single strided buffer
+};
+
+// one vertex attribute, the arguments of glVertexAttribPointer
+struct VertexAttribute
+{
+    GLuint location = 0;
+    GLint components = 0;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    GLsizei size = 0;           // bytes per vertex
+    std::size_t offset = 0;     // offset in the vertex of the interleaved buffer, always 0 for separate buffers
+
+    bool operator==(const VertexAttribute&) const = default;
+};
+
+// the layout of the vertex buffers of a model
+class VertexLayout
+{
+private:
+    VertexPacking m_Packing;
+    std::vector<VertexAttribute> m_Attributes;
+    GLsizei m_Stride = 0;
+public:
+    // attributes in the interleaved buffer start at 4 bytes boundaries as OpenGL requires, so do the vertices
+    static constexpr GLsizei alignment = 4;
+
+    VertexLayout(VertexPacking packing = SeparateBuffers);
+    // append an attribute to the vertex
+    void addAttribute(GLuint location, GLint components, GLenum type, GLboolean normalized, GLsizei size);
+    VertexPacking getPacking() const;
+    const std::vector<VertexAttribute>& getAttributes() const;
+    // bytes per vertex of the interleaved buffer, 0 (tightly packed) for separate buffers
+    GLsizei getStride() const;
+    // glVertexAttribPointer and glEnableVertexAttribArray for the attribute, its buffer must be bound to GL_ARRAY_BUFFER.
+    // the vertices start at bufferOffset of the buffer
+    void setAttributePointer(const VertexAttribute& attribute, std::size_t bufferOffset = 0) const;
+
+    // same packing, attributes and stride
+    bool operator==(const VertexLayout&) const = default;
+};
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Utils
+{
+
+// compact encodings of vertex attributes for upload, decoded by the vertex fetch or the built-in shaders:
+//   texture coordinates to half floats (GL_HALF_FLOAT), exact for [0, 1] up to about 1/2048,
+//   unit vectors (normals, tangents) to the octahedral projection in 2 snorm16 (GL_SHORT, normalized), error below 0.01 degree,
+//   indices to 16 bits (GL_UNSIGNED_SHORT) when the vertex count allows.
+
+// largest vertex count addressable by 16 bits indices
+constexpr std::size_t maxShortIndexVertexCount = 65536;
+
+// IEEE 754 binary16 conversions, round to nearest even, out of range values become infinity
+std::uint16_t floatToHalf(float value);
+float halfToFloat(std::uint16_t value);
+
+// direction to the octahedral projection, need not be normalized, zero vector encodes (0, 0, 1)
+std::array<std::int16_t, 2> octEncode(glm::vec3 direction);
+// unit vector of an octahedral encoding, same as the GLSL octDecode of the built-in shaders
+glm::vec3 octDecode(std::array<std::int16_t, 2> encoded);
+
+// every float to a half
+std::vector<std::uint16_t> quantizeHalfFloats(std::span<const float> values);
+// every 3 floats (x, y, z) to 2 snorm16
+std::vector<std::int16_t> quantizeDirections(std::span<const float> directions);
+// every index to 16 bits, all of them must be less than maxShortIndexVertexCount
+std::vector<std::uint16_t> narrowIndices(std::span<const int> indices);
+
+} // namespace Utils
\ No newline at end of file
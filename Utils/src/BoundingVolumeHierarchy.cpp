@@ -0,0 +1,435 @@
+#include <BoundingVolumeHierarchy.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace Utils
+{
+
+namespace
+{
+
+constexpr std::uint32_t maxLeafObjects = 8;
+constexpr std::size_t binCount = 16;
+// the cost of visiting a node relative to testing an object
+constexpr float traversalCost = 1.0f;
+
+// half the surface area of a box
+float halfArea(glm::vec3 minCorner, glm::vec3 maxCorner)
+{
+    glm::vec3 d = glm::max(maxCorner - minCorner, glm::vec3(0.0f));
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+// the distance where the ray enters the box, or infinity if it misses it within maxDistance
+float rayBoxEntry(glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance, glm::vec3 minCorner, glm::vec3 maxCorner)
+{
+    glm::vec3 t1 = (minCorner - origin) * inverseDirection;
+    glm::vec3 t2 = (maxCorner - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t1, t2), tFar = glm::max(t1, t2);
+    float entry = std::max({ tNear.x, tNear.y, tNear.z, 0.0f });
+    float exit = std::min({ tFar.x, tFar.y, tFar.z, maxDistance });
+    return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+
+struct Bin
+{
+    glm::vec3 minCorner = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 maxCorner = glm::vec3(-std::numeric_limits<float>::max());
+    std::uint32_t count = 0;
+};
+
+} // namespace
+
+void BoundingVolumeHierarchy::build(std::span<const BoundingVolume> bounds)
+{
+    // the boxes and centroids of the build are partitioned with the objects, the bounds are in tree order after it
+    struct BuildObject
+    {
+        glm::vec3 minCorner;
+        glm::vec3 maxCorner;
+        glm::vec3 centroid;
+        std::uint32_t object;
+    };
+    std::vector<BuildObject> items(bounds.size());
+    for (std::uint32_t i = 0; i < items.size(); i++)
+    {
+        items[i] = BuildObject{ bounds[i].boxCenter - bounds[i].boxExtent, bounds[i].boxCenter + bounds[i].boxExtent, bounds[i].boxCenter, i };
+    }
+    m_Nodes.clear();
+    m_DirtyNodes.clear();
+    m_CostSum = 0.0f;
+    if (!items.empty())
+    {
+        m_Nodes.reserve(2 * items.size());
+        m_Nodes.push_back(Node{ glm::vec3(0.0f), 0, glm::vec3(0.0f), std::uint32_t(items.size()), 0, invalidObject });
+    }
+
+    std::vector<std::uint32_t> stack;
+    if (!m_Nodes.empty())
+    {
+        stack.push_back(0);
+    }
+    while (!stack.empty())
+    {
+        std::uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+        Node node = m_Nodes[nodeIndex];
+        std::uint32_t first = node.firstObject, count = node.objectCount;
+        auto begin = items.begin() + first, end = begin + count;
+        glm::vec3 centroidMin(std::numeric_limits<float>::max()), centroidMax(-std::numeric_limits<float>::max());
+        node.minCorner = centroidMin;
+        node.maxCorner = centroidMax;
+        for (auto it = begin; it != end; ++it)
+        {
+            node.minCorner = glm::min(node.minCorner, it->minCorner);
+            node.maxCorner = glm::max(node.maxCorner, it->maxCorner);
+            centroidMin = glm::min(centroidMin, it->centroid);
+            centroidMax = glm::max(centroidMax, it->centroid);
+        }
+        m_Nodes[nodeIndex].minCorner = node.minCorner;
+        m_Nodes[nodeIndex].maxCorner = node.maxCorner;
+        if (count <= 2)
+        {
+            continue;
+        }
+
+        // the split of the lowest cost between the bins of the three axes, against keeping the objects in a leaf
+        float bestCost = float(count);
+        int bestAxis = -1;
+        std::size_t bestSplit = 0;
+        float nodeArea = std::max(halfArea(node.minCorner, node.maxCorner), std::numeric_limits<float>::min());
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f)
+            {
+                continue;
+            }
+            float scale = float(binCount) / extent;
+            std::array<Bin, binCount> bins;
+            for (auto it = begin; it != end; ++it)
+            {
+                std::size_t bin = std::min(binCount - 1, std::size_t((it->centroid[axis] - centroidMin[axis]) * scale));
+                bins[bin].minCorner = glm::min(bins[bin].minCorner, it->minCorner);
+                bins[bin].maxCorner = glm::max(bins[bin].maxCorner, it->maxCorner);
+                bins[bin].count++;
+            }
+            // sweep from the right for the areas and counts of the right sides, then from the left
+            std::array<float, binCount> rightCosts{};
+            Bin right;
+            for (std::size_t bin = binCount - 1; bin > 0; bin--)
+            {
+                right.minCorner = glm::min(right.minCorner, bins[bin].minCorner);
+                right.maxCorner = glm::max(right.maxCorner, bins[bin].maxCorner);
+                right.count += bins[bin].count;
+                rightCosts[bin] = right.count > 0 ? halfArea(right.minCorner, right.maxCorner) * float(right.count) : 0.0f;
+            }
+            Bin left;
+            for (std::size_t split = 1; split < binCount; split++)
+            {
+                left.minCorner = glm::min(left.minCorner, bins[split - 1].minCorner);
+                left.maxCorner = glm::max(left.maxCorner, bins[split - 1].maxCorner);
+                left.count += bins[split - 1].count;
+                if (left.count == 0 || left.count == count)
+                {
+                    continue;
+                }
+                float cost = traversalCost + (halfArea(left.minCorner, left.maxCorner) * float(left.count) + rightCosts[split]) / nodeArea;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        std::uint32_t leftCount = 0;
+        if (bestAxis >= 0)
+        {
+            float scale = float(binCount) / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+            auto middle = std::partition(begin, end, [&](const BuildObject& item)
+            {
+                return std::min(binCount - 1, std::size_t((item.centroid[bestAxis] - centroidMin[bestAxis]) * scale)) < bestSplit;
+            });
+            leftCount = std::uint32_t(middle - begin);
+        }
+        else if (count > maxLeafObjects)
+        {
+            // no split is cheaper than the leaf, or all centroids are at one point: too many objects for a leaf, split in the middle
+            leftCount = count / 2;
+            glm::vec3 size = node.maxCorner - node.minCorner;
+            int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+            std::nth_element(begin, begin + leftCount, end, [&](const BuildObject& a, const BuildObject& b) { return a.centroid[axis] < b.centroid[axis]; });
+        }
+        if (leftCount == 0 || leftCount == count)
+        {
+            continue;
+        }
+
+        std::uint32_t leftChild = std::uint32_t(m_Nodes.size());
+        m_Nodes[nodeIndex].leftChild = leftChild;
+        m_Nodes.push_back(Node{ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount, 0, nodeIndex });
+        m_Nodes.push_back(Node{ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount, 0, nodeIndex });
+        stack.push_back(leftChild + 1);
+        stack.push_back(leftChild);
+    }
+
+    m_Bounds.resize(items.size());
+    m_Objects.resize(items.size());
+    m_ObjectSlots.resize(items.size());
+    m_ObjectLeaves.resize(items.size());
+    for (std::uint32_t k = 0; k < items.size(); k++)
+    {
+        m_Objects[k] = items[k].object;
+        m_ObjectSlots[items[k].object] = k;
+        m_Bounds[k] = bounds[items[k].object];
+    }
+    for (std::uint32_t i = 0; i < m_Nodes.size(); i++)
+    {
+        const Node& node = m_Nodes[i];
+        if (node.leftChild == 0)
+        {
+            for (std::uint32_t k = node.firstObject; k < node.firstObject + node.objectCount; k++)
+            {
+                m_ObjectLeaves[m_Objects[k]] = i;
+            }
+        }
+        m_CostSum += nodeCost(node);
+    }
+    m_Dirty.assign(m_Nodes.size(), 0);
+    m_BuildCost = getCost();
+}
+
+void BoundingVolumeHierarchy::update(std::uint32_t object, const BoundingVolume& bounds)
+{
+    m_Bounds[m_ObjectSlots[object]] = bounds;
+    // the leaf and its ancestors up to the first one marked already
+    for (std::uint32_t node = m_ObjectLeaves[object]; node != invalidObject && !m_Dirty[node]; node = m_Nodes[node].parent)
+    {
+        m_Dirty[node] = 1;
+        m_DirtyNodes.push_back(node);
+    }
+}
+
+void BoundingVolumeHierarchy::refit()
+{
+    // children are after their parent, refitting from the last node up sees the children refitted first.
+    // a few nodes are sorted, many are found by going over all of them
+    if (m_DirtyNodes.size() * 16 < m_Nodes.size())
+    {
+        std::sort(m_DirtyNodes.begin(), m_DirtyNodes.end(), std::greater<>());
+        for (std::uint32_t index : m_DirtyNodes)
+        {
+            refitNode(index);
+        }
+    }
+    else
+    {
+        for (std::size_t index = m_Nodes.size(); index-- > 0;)
+        {
+            if (m_Dirty[index])
+            {
+                refitNode(std::uint32_t(index));
+            }
+        }
+    }
+    m_DirtyNodes.clear();
+}
+
+std::size_t BoundingVolumeHierarchy::cull(const Frustum& frustum, std::vector<std::uint8_t>& visible) const
+{
+    visible.assign(m_Bounds.size(), 0);
+    if (m_Nodes.empty())
+    {
+        return 0;
+    }
+    const auto& planes = frustum.getPlanes();
+    std::array<glm::vec3, 6> absNormals;
+    for (std::size_t p = 0; p < planes.size(); p++)
+    {
+        absNormals[p] = glm::abs(glm::vec3(planes[p]));
+    }
+    // every node is tested against the planes its parent is not completely inside of
+    constexpr std::uint32_t allPlanes = 0x3F;
+    std::size_t visibleCount = 0;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> stack = { { 0, allPlanes } };
+    while (!stack.empty())
+    {
+        auto [index, planeMask] = stack.back();
+        stack.pop_back();
+        const Node& node = m_Nodes[index];
+        glm::vec3 center = (node.minCorner + node.maxCorner) * 0.5f;
+        glm::vec3 extent = (node.maxCorner - node.minCorner) * 0.5f;
+        bool bOutside = false;
+        for (std::size_t p = 0; p < planes.size() && !bOutside; p++)
+        {
+            if (!(planeMask & (1u << p)))
+            {
+                continue;
+            }
+            float distance = glm::dot(glm::vec3(planes[p]), center) + planes[p].w;
+            float projected = glm::dot(absNormals[p], extent);
+            bOutside = distance + projected < 0.0f;
+            if (distance - projected >= 0.0f) // the node is inside of the plane, so is every node below
+            {
+                planeMask &= ~(1u << p);
+            }
+        }
+        if (bOutside)
+        {
+            continue;
+        }
+        if (planeMask == 0 || node.leftChild == 0)
+        {
+            for (std::uint32_t k = node.firstObject; k < node.firstObject + node.objectCount; k++)
+            {
+                const BoundingVolume& b = m_Bounds[k];
+                bool bObjectOutside = false;
+                for (std::size_t p = 0; p < planes.size() && !bObjectOutside; p++)
+                {
+                    if (planeMask & (1u << p))
+                    {
+                        glm::vec3 normal(planes[p]);
+                        bObjectOutside = glm::dot(normal, b.boxCenter) + planes[p].w + glm::dot(absNormals[p], b.boxExtent) < 0.0f ||
+                                         glm::dot(normal, b.sphereCenter) + planes[p].w + b.sphereRadius < 0.0f;
+                    }
+                }
+                visible[m_Objects[k]] = std::uint8_t(!bObjectOutside);
+                visibleCount += bObjectOutside ? 0 : 1;
+            }
+            continue;
+        }
+        stack.emplace_back(node.leftChild + 1, planeMask);
+        stack.emplace_back(node.leftChild, planeMask);
+    }
+    return visibleCount;
+}
+
+BvhRayHit BoundingVolumeHierarchy::raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance,
+                                           const std::function<float(std::uint32_t, float)>& intersect) const
+{
+    BvhRayHit hit;
+    if (m_Nodes.empty())
+    {
+        return hit;
+    }
+    glm::vec3 inverseDirection = glm::vec3(1.0f) / direction;
+    float nearest = maxDistance;
+    // nodes with the distance where the ray enters them, the nearer child is visited first
+    std::vector<std::pair<std::uint32_t, float>> stack;
+    float rootEntry = rayBoxEntry(origin, inverseDirection, nearest, m_Nodes[0].minCorner, m_Nodes[0].maxCorner);
+    if (rootEntry <= nearest)
+    {
+        stack.emplace_back(0, rootEntry);
+    }
+    while (!stack.empty())
+    {
+        auto [index, entry] = stack.back();
+        stack.pop_back();
+        if (entry > nearest)
+        {
+            continue;
+        }
+        const Node& node = m_Nodes[index];
+        if (node.leftChild == 0)
+        {
+            for (std::uint32_t k = node.firstObject; k < node.firstObject + node.objectCount; k++)
+            {
+                const BoundingVolume& b = m_Bounds[k];
+                float distance = rayBoxEntry(origin, inverseDirection, nearest, b.boxCenter - b.boxExtent, b.boxCenter + b.boxExtent);
+                if (distance <= nearest && intersect)
+                {
+                    distance = intersect(m_Objects[k], distance);
+                    distance = distance < 0.0f ? std::numeric_limits<float>::infinity() : distance;
+                }
+                if (distance <= nearest)
+                {
+                    nearest = distance;
+                    hit.object = m_Objects[k];
+                    hit.distance = distance;
+                }
+            }
+            continue;
+        }
+        const Node& left = m_Nodes[node.leftChild];
+        const Node& right = m_Nodes[node.leftChild + 1];
+        float leftEntry = rayBoxEntry(origin, inverseDirection, nearest, left.minCorner, left.maxCorner);
+        float rightEntry = rayBoxEntry(origin, inverseDirection, nearest, right.minCorner, right.maxCorner);
+        std::pair<std::uint32_t, float> nearChild(node.leftChild, leftEntry), farChild(node.leftChild + 1, rightEntry);
+        if (rightEntry < leftEntry)
+        {
+            std::swap(nearChild, farChild);
+        }
+        if (farChild.second <= nearest)
+        {
+            stack.push_back(farChild);
+        }
+        if (nearChild.second <= nearest)
+        {
+            stack.push_back(nearChild);
+        }
+    }
+    return hit;
+}
+
+std::size_t BoundingVolumeHierarchy::size() const
+{
+    return m_Bounds.size();
+}
+
+std::size_t BoundingVolumeHierarchy::getNodeCount() const
+{
+    return m_Nodes.size();
+}
+
+float BoundingVolumeHierarchy::getCost() const
+{
+    if (m_Nodes.empty())
+    {
+        return 0.0f;
+    }
+    float rootArea = halfArea(m_Nodes[0].minCorner, m_Nodes[0].maxCorner);
+    return rootArea > 0.0f ? m_CostSum / rootArea : float(m_Nodes[0].objectCount);
+}
+
+float BoundingVolumeHierarchy::getBuildCost() const
+{
+    return m_BuildCost;
+}
+
+void BoundingVolumeHierarchy::refitNode(std::uint32_t index)
+{
+    Node& node = m_Nodes[index];
+    m_CostSum -= nodeCost(node);
+    if (node.leftChild == 0)
+    {
+        node.minCorner = glm::vec3(std::numeric_limits<float>::max());
+        node.maxCorner = glm::vec3(-std::numeric_limits<float>::max());
+        for (std::uint32_t k = node.firstObject; k < node.firstObject + node.objectCount; k++)
+        {
+            node.minCorner = glm::min(node.minCorner, m_Bounds[k].boxCenter - m_Bounds[k].boxExtent);
+            node.maxCorner = glm::max(node.maxCorner, m_Bounds[k].boxCenter + m_Bounds[k].boxExtent);
+        }
+    }
+    else
+    {
+        const Node& left = m_Nodes[node.leftChild];
+        const Node& right = m_Nodes[node.leftChild + 1];
+        node.minCorner = glm::min(left.minCorner, right.minCorner);
+        node.maxCorner = glm::max(left.maxCorner, right.maxCorner);
+    }
+    m_CostSum += nodeCost(node);
+    m_Dirty[index] = 0;
+}
+
+float BoundingVolumeHierarchy::nodeCost(const Node& node) const
+{
+    float weight = node.leftChild == 0 ? float(node.objectCount) : traversalCost;
+    return halfArea(node.minCorner, node.maxCorner) * weight;
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <BoundingVolumes.h>
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILS_BOUNDS_SSE2 1
+#endif
+
+namespace Utils
+{
+
+BoundingVolume BoundingVolume::transformed(const glm::mat4& matrix) const
+{
+    BoundingVolume result;
+    result.boxCenter = glm::vec3(matrix * glm::vec4(boxCenter, 1.0f));
+    // each axis of the new box is the sum of the absolute contributions of the old axes
+    glm::mat3 linear(matrix);
+    for (int i = 0; i < 3; i++)
+    {
+        result.boxExtent[i] = std::abs(linear[0][i]) * boxExtent.x + std::abs(linear[1][i]) * boxExtent.y + std::abs(linear[2][i]) * boxExtent.z;
+    }
+    result.sphereCenter = glm::vec3(matrix * glm::vec4(sphereCenter, 1.0f));
+    float scale = std::max({ glm::length(linear[0]), glm::length(linear[1]), glm::length(linear[2]) });
+    result.sphereRadius = sphereRadius * scale;
+    return result;
+}
+
+BoundingVolume BoundingVolume::inflated(float distance) const
+{
+    BoundingVolume result = *this;
+    result.boxExtent += glm::vec3(distance);
+    result.sphereRadius += distance;
+    return result;
+}
+
+BoundingVolume BoundingVolume::merged(const BoundingVolume& other) const
+{
+    BoundingVolume result;
+    glm::vec3 minCorner = glm::min(boxCenter - boxExtent, other.boxCenter - other.boxExtent);
+    glm::vec3 maxCorner = glm::max(boxCenter + boxExtent, other.boxCenter + other.boxExtent);
+    result.boxCenter = (minCorner + maxCorner) * 0.5f;
+    result.boxExtent = (maxCorner - minCorner) * 0.5f;
+    // the smallest sphere around both spheres
+    glm::vec3 offset = other.sphereCenter - sphereCenter;
+    float distance = glm::length(offset);
+    if (distance + other.sphereRadius <= sphereRadius)
+    {
+        result.sphereCenter = sphereCenter;
+        result.sphereRadius = sphereRadius;
+    }
+    else if (distance + sphereRadius <= other.sphereRadius)
+    {
+        result.sphereCenter = other.sphereCenter;
+        result.sphereRadius = other.sphereRadius;
+    }
+    else
+    {
+        result.sphereRadius = (distance + sphereRadius + other.sphereRadius) * 0.5f;
+        result.sphereCenter = sphereCenter + offset * ((result.sphereRadius - sphereRadius) / distance);
+    }
+    return result;
+}
+
+void BoundsArray::clear()
+{
+    for (auto* pArray : { &m_BoxCenterX, &m_BoxCenterY, &m_BoxCenterZ, &m_BoxExtentX, &m_BoxExtentY, &m_BoxExtentZ,
+                          &m_SphereCenterX, &m_SphereCenterY, &m_SphereCenterZ, &m_SphereRadius })
+    {
+        pArray->clear();
+    }
+}
+
+void BoundsArray::add(const BoundingVolume& bounds)
+{
+    m_BoxCenterX.push_back(bounds.boxCenter.x);
+    m_BoxCenterY.push_back(bounds.boxCenter.y);
+    m_BoxCenterZ.push_back(bounds.boxCenter.z);
+    m_BoxExtentX.push_back(bounds.boxExtent.x);
+    m_BoxExtentY.push_back(bounds.boxExtent.y);
+    m_BoxExtentZ.push_back(bounds.boxExtent.z);
+    m_SphereCenterX.push_back(bounds.sphereCenter.x);
+    m_SphereCenterY.push_back(bounds.sphereCenter.y);
+    m_SphereCenterZ.push_back(bounds.sphereCenter.z);
+    m_SphereRadius.push_back(bounds.sphereRadius);
+}
+
+std::size_t BoundsArray::size() const
+{
+    return m_SphereRadius.size();
+}
+
+std::size_t BoundsArray::cull(const Frustum& frustum, std::vector<std::uint8_t>& visible) const
+{
+    // a box is outside of a plane if its center is farther than its extent projected on the plane normal,
+    // dot(n, c) + w + dot(|n|, e) < 0, and a sphere if dot(n, c) + w + r < 0
+    const auto& planes = frustum.getPlanes();
+    std::size_t n = size();
+    visible.resize(n);
+    std::size_t visibleCount = 0;
+    std::size_t i = 0;
+#ifdef UTILS_BOUNDS_SSE2
+    __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 boxX = _mm_loadu_ps(&m_BoxCenterX[i]), boxY = _mm_loadu_ps(&m_BoxCenterY[i]), boxZ = _mm_loadu_ps(&m_BoxCenterZ[i]);
+        __m128 extentX = _mm_loadu_ps(&m_BoxExtentX[i]), extentY = _mm_loadu_ps(&m_BoxExtentY[i]), extentZ = _mm_loadu_ps(&m_BoxExtentZ[i]);
+        __m128 sphereX = _mm_loadu_ps(&m_SphereCenterX[i]), sphereY = _mm_loadu_ps(&m_SphereCenterY[i]), sphereZ = _mm_loadu_ps(&m_SphereCenterZ[i]);
+        __m128 radius = _mm_loadu_ps(&m_SphereRadius[i]);
+        __m128 outside = zero;
+        for (const auto& plane : planes)
+        {
+            __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z), w = _mm_set1_ps(plane.w);
+            __m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, boxX), _mm_mul_ps(ny, boxY)), _mm_add_ps(_mm_mul_ps(nz, boxZ), w));
+            __m128 projected = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), extentX), _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), extentY)),
+                                          _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), extentZ));
+            __m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sphereX), _mm_mul_ps(ny, sphereY)), _mm_add_ps(_mm_mul_ps(nz, sphereZ), w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(boxDistance, projected), zero));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(sphereDistance, radius), zero));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for (std::size_t k = 0; k < 4; k++)
+        {
+            std::uint8_t bVisible = std::uint8_t(((mask >> k) & 1) ^ 1);
+            visible[i + k] = bVisible;
+            visibleCount += bVisible;
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        bool bOutside = false;
+        for (const auto& plane : planes)
+        {
+            float boxDistance = plane.x * m_BoxCenterX[i] + plane.y * m_BoxCenterY[i] + plane.z * m_BoxCenterZ[i] + plane.w;
+            float projected = std::abs(plane.x) * m_BoxExtentX[i] + std::abs(plane.y) * m_BoxExtentY[i] + std::abs(plane.z) * m_BoxExtentZ[i];
+            float sphereDistance = plane.x * m_SphereCenterX[i] + plane.y * m_SphereCenterY[i] + plane.z * m_SphereCenterZ[i] + plane.w;
+            bOutside = bOutside || boxDistance + projected < 0.0f || sphereDistance + m_SphereRadius[i] < 0.0f;
+        }
+        visible[i] = std::uint8_t(!bOutside);
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+} // namespace Utils
\ No newline at end of file
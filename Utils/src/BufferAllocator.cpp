@@ -0,0 +1,497 @@
+#include <BufferAllocator.h>
+#include <Logger.h>
+#include <bit>
+#include <algorithm>
+#include <format>
+
+namespace Utils
+{
+
+namespace
+{
+
+std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // anonymous namespace
+
+RangeAllocator::RangeAllocator(std::size_t capacity)
+{
+    for (auto& lists : m_FreeLists)
+    {
+        lists.fill(none);
+    }
+    grow(capacity);
+}
+
+void RangeAllocator::mapping(std::size_t size, std::size_t& firstLevel, std::size_t& secondLevel)
+{
+    // sizes below secondLevelCount have a list each, the others are split in secondLevelCount steps per power of 2
+    if (size < secondLevelCount)
+    {
+        firstLevel = 0;
+        secondLevel = size;
+        return;
+    }
+    std::size_t log2 = std::size_t(std::bit_width(size)) - 1;
+    firstLevel = log2 - secondLevelBits + 1;
+    secondLevel = (size >> (log2 - secondLevelBits)) - secondLevelCount;
+}
+
+std::uint32_t RangeAllocator::newBlock(std::size_t offset, std::size_t size)
+{
+    std::uint32_t block;
+    if (!m_UnusedBlocks.empty())
+    {
+        block = m_UnusedBlocks.back();
+        m_UnusedBlocks.pop_back();
+        m_Blocks[block] = Block{};
+    }
+    else
+    {
+        block = std::uint32_t(m_Blocks.size());
+        m_Blocks.emplace_back();
+    }
+    m_Blocks[block].offset = offset;
+    m_Blocks[block].size = size;
+    return block;
+}
+
+void RangeAllocator::insertFree(std::uint32_t block)
+{
+    std::size_t fl, sl;
+    mapping(m_Blocks[block].size, fl, sl);
+    std::uint32_t head = m_FreeLists[fl][sl];
+    m_Blocks[block].bFree = true;
+    m_Blocks[block].prevFree = none;
+    m_Blocks[block].nextFree = head;
+    if (head != none)
+    {
+        m_Blocks[head].prevFree = block;
+    }
+    m_FreeLists[fl][sl] = block;
+    m_FirstLevelBitmap |= std::uint64_t(1) << fl;
+    m_SecondLevelBitmaps[fl] |= std::uint32_t(1) << sl;
+    m_FreeBlockCount++;
+}
+
+void RangeAllocator::removeFree(std::uint32_t block)
+{
+    std::size_t fl, sl;
+    mapping(m_Blocks[block].size, fl, sl);
+    Block& b = m_Blocks[block];
+    if (b.prevFree != none)
+    {
+        m_Blocks[b.prevFree].nextFree = b.nextFree;
+    }
+    else
+    {
+        m_FreeLists[fl][sl] = b.nextFree;
+    }
+    if (b.nextFree != none)
+    {
+        m_Blocks[b.nextFree].prevFree = b.prevFree;
+    }
+    if (m_FreeLists[fl][sl] == none)
+    {
+        m_SecondLevelBitmaps[fl] &= ~(std::uint32_t(1) << sl);
+        if (m_SecondLevelBitmaps[fl] == 0)
+        {
+            m_FirstLevelBitmap &= ~(std::uint64_t(1) << fl);
+        }
+    }
+    b.bFree = false;
+    b.prevFree = none;
+    b.nextFree = none;
+    m_FreeBlockCount--;
+}
+
+std::uint32_t RangeAllocator::findFree(std::size_t size) const
+{
+    // round up to the next size class so that any block of the class found fits
+    if (size >= secondLevelCount)
+    {
+        std::size_t log2 = std::size_t(std::bit_width(size)) - 1;
+        size += (std::size_t(1) << (log2 - secondLevelBits)) - 1;
+    }
+    std::size_t fl, sl;
+    mapping(size, fl, sl);
+    std::uint32_t secondLevelMap = m_SecondLevelBitmaps[fl] & (~std::uint32_t(0) << sl);
+    if (secondLevelMap == 0)
+    {
+        std::uint64_t firstLevelMap = fl + 1 < firstLevelCount ? m_FirstLevelBitmap & (~std::uint64_t(0) << (fl + 1)) : 0;
+        if (firstLevelMap == 0)
+        {
+            return none;
+        }
+        fl = std::size_t(std::countr_zero(firstLevelMap));
+        secondLevelMap = m_SecondLevelBitmaps[fl];
+    }
+    sl = std::size_t(std::countr_zero(secondLevelMap));
+    return m_FreeLists[fl][sl];
+}
+
+std::uint32_t RangeAllocator::split(std::uint32_t block, std::size_t size)
+{
+    std::uint32_t rest = newBlock(m_Blocks[block].offset + size, m_Blocks[block].size - size);
+    Block& b = m_Blocks[block];
+    Block& r = m_Blocks[rest];
+    r.prevPhysical = block;
+    r.nextPhysical = b.nextPhysical;
+    if (b.nextPhysical != none)
+    {
+        m_Blocks[b.nextPhysical].prevPhysical = rest;
+    }
+    else
+    {
+        m_LastBlock = rest;
+    }
+    b.nextPhysical = rest;
+    b.size = size;
+    return rest;
+}
+
+void RangeAllocator::absorb(std::uint32_t block, std::uint32_t next)
+{
+    Block& b = m_Blocks[block];
+    Block& n = m_Blocks[next];
+    b.size += n.size;
+    b.nextPhysical = n.nextPhysical;
+    if (n.nextPhysical != none)
+    {
+        m_Blocks[n.nextPhysical].prevPhysical = block;
+    }
+    else
+    {
+        m_LastBlock = block;
+    }
+    m_UnusedBlocks.push_back(next);
+}
+
+std::size_t RangeAllocator::allocate(std::size_t size, std::size_t alignment)
+{
+    size = std::max<std::size_t>(size, 1);
+    alignment = std::max<std::size_t>(alignment, 1);
+    std::uint32_t block = findFree(size + alignment - 1);
+    if (block == none)
+    {
+        return npos;
+    }
+    removeFree(block);
+    // free blocks have no free neighbors, the padding before the aligned offset and the tail stay separate free blocks
+    std::size_t offset = alignUp(m_Blocks[block].offset, alignment);
+    std::size_t padding = offset - m_Blocks[block].offset;
+    if (padding > 0)
+    {
+        std::uint32_t rest = split(block, padding);
+        insertFree(block);
+        block = rest;
+    }
+    if (m_Blocks[block].size > size)
+    {
+        insertFree(split(block, size));
+    }
+    m_Allocations.emplace(offset, block);
+    m_Used += size;
+    m_PeakUsed = std::max(m_PeakUsed, m_Used);
+    return offset;
+}
+
+void RangeAllocator::free(std::size_t offset)
+{
+    auto it = m_Allocations.find(offset);
+    if (it == m_Allocations.end())
+    {
+        return;
+    }
+    std::uint32_t block = it->second;
+    m_Allocations.erase(it);
+    m_Used -= m_Blocks[block].size;
+
+    std::uint32_t next = m_Blocks[block].nextPhysical;
+    if (next != none && m_Blocks[next].bFree)
+    {
+        removeFree(next);
+        absorb(block, next);
+    }
+    std::uint32_t prev = m_Blocks[block].prevPhysical;
+    if (prev != none && m_Blocks[prev].bFree)
+    {
+        removeFree(prev);
+        absorb(prev, block);
+        block = prev;
+    }
+    insertFree(block);
+}
+
+std::size_t RangeAllocator::sizeOf(std::size_t offset) const
+{
+    auto it = m_Allocations.find(offset);
+    return it != m_Allocations.end() ? m_Blocks[it->second].size : 0;
+}
+
+void RangeAllocator::grow(std::size_t capacity)
+{
+    if (capacity <= m_Capacity)
+    {
+        return;
+    }
+    std::size_t added = capacity - m_Capacity;
+    if (m_LastBlock != none && m_Blocks[m_LastBlock].bFree)
+    {
+        removeFree(m_LastBlock);
+        m_Blocks[m_LastBlock].size += added;
+        insertFree(m_LastBlock);
+    }
+    else
+    {
+        std::uint32_t block = newBlock(m_Capacity, added);
+        m_Blocks[block].prevPhysical = m_LastBlock;
+        if (m_LastBlock != none)
+        {
+            m_Blocks[m_LastBlock].nextPhysical = block;
+        }
+        m_LastBlock = block;
+        insertFree(block);
+    }
+    m_Capacity = capacity;
+}
+
+std::size_t RangeAllocator::lastAllocation() const
+{
+    std::uint32_t block = m_LastBlock;
+    while (block != none && m_Blocks[block].bFree)
+    {
+        block = m_Blocks[block].prevPhysical;
+    }
+    return block != none ? m_Blocks[block].offset : npos;
+}
+
+std::size_t RangeAllocator::getCapacity() const
+{
+    return m_Capacity;
+}
+
+std::size_t RangeAllocator::getUsed() const
+{
+    return m_Used;
+}
+
+std::size_t RangeAllocator::getPeakUsed() const
+{
+    return m_PeakUsed;
+}
+
+std::size_t RangeAllocator::getAllocationCount() const
+{
+    return m_Allocations.size();
+}
+
+std::size_t RangeAllocator::getFreeBlockCount() const
+{
+    return m_FreeBlockCount;
+}
+
+std::size_t RangeAllocator::getLargestFreeBlock() const
+{
+    if (m_FirstLevelBitmap == 0)
+    {
+        return 0;
+    }
+    // the largest block is in the highest non-empty list
+    std::size_t fl = 63 - std::size_t(std::countl_zero(m_FirstLevelBitmap));
+    std::size_t sl = 31 - std::size_t(std::countl_zero(m_SecondLevelBitmaps[fl]));
+    std::size_t largest = 0;
+    for (std::uint32_t block = m_FreeLists[fl][sl]; block != none; block = m_Blocks[block].nextFree)
+    {
+        largest = std::max(largest, m_Blocks[block].size);
+    }
+    return largest;
+}
+
+BufferAllocator::BufferAllocator(std::size_t pageSize)
+    : m_PageSize(pageSize)
+{
+}
+
+BufferHandle BufferAllocator::allocate(std::size_t size, std::size_t alignment, std::uint64_t owner)
+{
+    Page* pPage = nullptr;
+    std::size_t offset = RangeAllocator::npos;
+    for (auto& spPage : m_Pages)
+    {
+        offset = spPage->ranges.allocate(size, alignment);
+        if (offset != RangeAllocator::npos)
+        {
+            pPage = spPage.get();
+            break;
+        }
+    }
+    if (!pPage)
+    {
+        std::size_t capacity = std::max(m_PageSize, alignUp(std::max<std::size_t>(size, 1), 256));
+        auto spPage = std::make_unique<Page>();
+        spPage->ranges.grow(capacity);
+        glGenBuffers(1, &spPage->buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, spPage->buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(capacity), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        Logger::globalLogger().debug(std::format("buffer allocator: new buffer {} of {} bytes", spPage->buffer, capacity));
+        offset = spPage->ranges.allocate(size, alignment);
+        pPage = spPage.get();
+        m_Pages.push_back(std::move(spPage));
+    }
+
+    BufferHandle handle;
+    if (!m_FreeHandles.empty())
+    {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+    }
+    else
+    {
+        handle = BufferHandle(m_Entries.size());
+        m_Entries.emplace_back();
+    }
+    Entry& entry = m_Entries[handle];
+    entry.allocation = BufferAllocation{ pPage->buffer, offset, pPage->ranges.sizeOf(offset) };
+    entry.alignment = std::max<std::size_t>(alignment, 1);
+    entry.pPage = pPage;
+    entry.owner = owner;
+    pPage->handles.emplace(offset, handle);
+    updateStatistics();
+    return handle;
+}
+
+void BufferAllocator::free(BufferHandle handle)
+{
+    if (handle >= m_Entries.size() || !m_Entries[handle].pPage)
+    {
+        return;
+    }
+    Entry& entry = m_Entries[handle];
+    entry.pPage->ranges.free(entry.allocation.offset);
+    entry.pPage->handles.erase(entry.allocation.offset);
+    entry = Entry{};
+    m_FreeHandles.push_back(handle);
+    updateStatistics();
+}
+
+const BufferAllocation& BufferAllocator::get(BufferHandle handle) const
+{
+    return m_Entries[handle].allocation;
+}
+
+std::uint64_t BufferAllocator::getOwner(BufferHandle handle) const
+{
+    return m_Entries[handle].owner;
+}
+
+void BufferAllocator::upload(BufferHandle handle, const void* pData, std::size_t size)
+{
+    const BufferAllocation& allocation = m_Entries[handle].allocation;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, allocation.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(allocation.offset), GLsizeiptr(std::min(size, allocation.size)), pData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+const std::vector<BufferHandle>& BufferAllocator::defragment(std::size_t byteBudget)
+{
+    m_Moved.clear();
+    std::size_t moved = 0;
+    for (auto& spPage : m_Pages)
+    {
+        Page& page = *spPage;
+        while (moved < byteBudget)
+        {
+            // the last allocation moves to the first free block before it that fits, if there is one
+            std::size_t offset = page.ranges.lastAllocation();
+            if (offset == RangeAllocator::npos)
+            {
+                break;
+            }
+            BufferHandle handle = page.handles.at(offset);
+            Entry& entry = m_Entries[handle];
+            std::size_t newOffset = page.ranges.allocate(entry.allocation.size, entry.alignment);
+            if (newOffset == RangeAllocator::npos || newOffset > offset)
+            {
+                if (newOffset != RangeAllocator::npos)
+                {
+                    page.ranges.free(newOffset);
+                }
+                break;
+            }
+            // the ranges do not overlap, the new one was free while the old one is allocated
+            glBindBuffer(GL_COPY_READ_BUFFER, page.buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(offset), GLintptr(newOffset), GLsizeiptr(entry.allocation.size));
+            page.ranges.free(offset);
+            page.handles.erase(offset);
+            page.handles.emplace(newOffset, handle);
+            entry.allocation.offset = newOffset;
+            moved += entry.allocation.size;
+            m_Moved.push_back(handle);
+        }
+    }
+    if (moved > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    m_Stats.movedBytes += moved;
+
+    // empty buffers after the first are given back
+    for (std::size_t i = m_Pages.size(); i-- > 1;)
+    {
+        if (m_Pages[i]->ranges.getAllocationCount() == 0)
+        {
+            Logger::globalLogger().debug(std::format("buffer allocator: delete empty buffer {}", m_Pages[i]->buffer));
+            glDeleteBuffers(1, &m_Pages[i]->buffer);
+            m_Pages.erase(m_Pages.begin() + std::ptrdiff_t(i));
+        }
+    }
+    updateStatistics();
+    return m_Moved;
+}
+
+void BufferAllocator::release()
+{
+    for (auto& spPage : m_Pages)
+    {
+        glDeleteBuffers(1, &spPage->buffer);
+    }
+    m_Pages.clear();
+    m_Entries.clear();
+    m_FreeHandles.clear();
+    m_Moved.clear();
+    updateStatistics();
+}
+
+const BufferAllocatorStatistics& BufferAllocator::getStatistics() const
+{
+    return m_Stats;
+}
+
+void BufferAllocator::updateStatistics()
+{
+    BufferAllocatorStatistics stats;
+    stats.buffers = m_Pages.size();
+    for (const auto& spPage : m_Pages)
+    {
+        const RangeAllocator& ranges = spPage->ranges;
+        stats.capacity += ranges.getCapacity();
+        stats.bytesInUse += ranges.getUsed();
+        stats.allocations += ranges.getAllocationCount();
+        stats.freeBlocks += ranges.getFreeBlockCount();
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, ranges.getLargestFreeBlock());
+    }
+    std::size_t freeBytes = stats.capacity - stats.bytesInUse;
+    stats.fragmentation = freeBytes > 0 ? 1.0 - double(stats.largestFreeBlock) / double(freeBytes) : 0.0;
+    stats.peakBytesInUse = std::max(m_Stats.peakBytesInUse, stats.bytesInUse);
+    stats.movedBytes = m_Stats.movedBytes;
+    m_Stats = stats;
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include <Frustum.h>
+
+namespace Utils
+{
+
+Frustum::Frustum(const glm::mat4& matrix)
+{
+    // rows of the matrix, glm matrices are column major
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+    }
+    m_Planes[0] = rows[3] + rows[0];
+    m_Planes[1] = rows[3] - rows[0];
+    m_Planes[2] = rows[3] + rows[1];
+    m_Planes[3] = rows[3] - rows[1];
+    m_Planes[4] = rows[3] + rows[2];
+    m_Planes[5] = rows[3] - rows[2];
+    for (auto& plane : m_Planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+}
+
+bool Frustum::intersectsSphere(glm::vec3 center, float radius) const
+{
+    for (const auto& plane : m_Planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace Utils
\ No newline at end of file
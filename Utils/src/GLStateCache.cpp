@@ -0,0 +1,213 @@
+#include <GLStateCache.h>
+
+namespace Utils
+{
+
+namespace
+{
+
+// index of a tracked capability, trackedCapabilities for the others
+std::size_t capabilityIndex(GLenum capability)
+{
+    switch (capability)
+    {
+    case GL_CULL_FACE:
+        return 0;
+    case GL_DEPTH_TEST:
+        return 1;
+    case GL_BLEND:
+        return 2;
+    case GL_STENCIL_TEST:
+        return 3;
+    case GL_SCISSOR_TEST:
+        return 4;
+    default:
+        return GLStateCache::trackedCapabilities;
+    }
+}
+
+// index of a tracked texture target, 2 for the others
+std::size_t textureTargetIndex(GLenum target)
+{
+    return target == GL_TEXTURE_2D ? 0 : target == GL_TEXTURE_CUBE_MAP ? 1 : 2;
+}
+
+} // anonymous namespace
+
+GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+void GLStateCache::invalidate()
+{
+    m_Capabilities.fill(unknown);
+    m_CullFace = unknown;
+    m_FrontFace = unknown;
+    m_DepthFunc = unknown;
+    m_Program = unknown;
+    m_ActiveTexture = unknown;
+    for (auto& unit : m_Textures)
+    {
+        unit.fill(unknown);
+    }
+    m_VertexArray = unknown;
+    m_DrawFramebuffer = unknown;
+    m_ReadFramebuffer = unknown;
+}
+
+void GLStateCache::resetStatistics()
+{
+    m_Stats = GLStateStatistics{};
+}
+
+const GLStateStatistics& GLStateCache::getStatistics() const
+{
+    return m_Stats;
+}
+
+bool GLStateCache::change(GLuint& current, GLuint value)
+{
+    if (current == value)
+    {
+        m_Stats.skipped++;
+        return false;
+    }
+    current = value;
+    m_Stats.issued++;
+    return true;
+}
+
+void GLStateCache::setCapability(GLenum capability, bool enabled)
+{
+    std::size_t index = capabilityIndex(capability);
+    if (index < trackedCapabilities)
+    {
+        if (!change(m_Capabilities[index], enabled ? GL_TRUE : GL_FALSE))
+        {
+            return;
+        }
+    }
+    else
+    {
+        m_Stats.issued++;
+    }
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+}
+
+void GLStateCache::enable(GLenum capability)
+{
+    setCapability(capability, true);
+}
+
+void GLStateCache::disable(GLenum capability)
+{
+    setCapability(capability, false);
+}
+
+void GLStateCache::cullFace(GLenum mode)
+{
+    if (change(m_CullFace, mode))
+    {
+        glCullFace(mode);
+    }
+}
+
+void GLStateCache::frontFace(GLenum direction)
+{
+    if (change(m_FrontFace, direction))
+    {
+        glFrontFace(direction);
+    }
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+    if (change(m_DepthFunc, func))
+    {
+        glDepthFunc(func);
+    }
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (change(m_Program, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::useProgram(const Shader& shader)
+{
+    shader.finish();
+    useProgram(shader.getShaderId());
+}
+
+void GLStateCache::activeTexture(GLenum unit)
+{
+    if (change(m_ActiveTexture, unit))
+    {
+        glActiveTexture(unit);
+    }
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+    // the unit of a binding is the active one, unknown after invalidate until activeTexture is called
+    std::size_t unit = m_ActiveTexture - GL_TEXTURE0;
+    std::size_t targetIndex = textureTargetIndex(target);
+    if (m_ActiveTexture != unknown && unit < trackedTextureUnits && targetIndex < 2)
+    {
+        if (change(m_Textures[unit][targetIndex], texture))
+        {
+            glBindTexture(target, texture);
+        }
+        return;
+    }
+    m_Stats.issued++;
+    glBindTexture(target, texture);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+    if (change(m_VertexArray, vao))
+    {
+        glBindVertexArray(vao);
+    }
+}
+
+void GLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    bool bChanged = false;
+    if (target == GL_FRAMEBUFFER)
+    {
+        bChanged = m_DrawFramebuffer != framebuffer || m_ReadFramebuffer != framebuffer;
+        m_DrawFramebuffer = framebuffer;
+        m_ReadFramebuffer = framebuffer;
+        if (bChanged)
+        {
+            m_Stats.issued++;
+        }
+        else
+        {
+            m_Stats.skipped++;
+        }
+    }
+    else
+    {
+        bChanged = change(target == GL_DRAW_FRAMEBUFFER ? m_DrawFramebuffer : m_ReadFramebuffer, framebuffer);
+    }
+    if (bChanged)
+    {
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include <HandleSlots.h>
+
+namespace Utils
+{
+
+std::uint32_t HandleSlots::acquire()
+{
+    std::uint32_t index;
+    if (!m_FreeSlots.empty())
+    {
+        index = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else
+    {
+        index = std::uint32_t(m_Generations.size());
+        m_Generations.push_back(0);
+        m_Live.push_back(false);
+    }
+    m_Live[index] = true;
+    return index;
+}
+
+void HandleSlots::release(std::uint32_t index)
+{
+    if (index >= m_Live.size() || !m_Live[index])
+    {
+        return;
+    }
+    m_Live[index] = false;
+    m_Generations[index]++;
+    m_FreeSlots.push_back(index);
+}
+
+bool HandleSlots::isLive(std::uint32_t index, std::uint32_t generation) const
+{
+    return index < m_Live.size() && m_Live[index] && m_Generations[index] == generation;
+}
+
+std::uint32_t HandleSlots::getGeneration(std::uint32_t index) const
+{
+    return m_Generations[index];
+}
+
+std::size_t HandleSlots::getSize() const
+{
+    return m_Generations.size();
+}
+
+std::size_t HandleSlots::getLiveCount() const
+{
+    return m_Generations.size() - m_FreeSlots.size();
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -1,129 +1,658 @@
 #include <ImportedModel.h>
-#include <fstream>
 #include <string>
-#include <iostream>
-#include <sstream>
+#include <charconv>
 #include <format>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cmath>
+#include <MappedFile.h>
+#include <ThreadPool.h>
 #include <Logger.h>
+#include <MeshOptimizer.h>
 
 namespace Utils
 {
 
+// OBJ tokenizer, works in place on the mapped file content, no allocation per line.
+// the file is split at line boundaries into chunks which can be parsed in parallel.
+namespace
+{
 
-bool ImportedModel::supplyVertices()
+// parsed content of a range of whole lines of the file
+struct ObjChunk
 {
-    return true;
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    // 0-based indices of every face corner
+    std::vector<int> vertIndices;
+    std::vector<int> tcIndices;
+    std::vector<int> normalIndices;
+    // positions of the negative (relative) OBJ indices in the index arrays,
+    // they are resolved against the beginning of the chunk until fixed up with the prefix sums below.
+    std::vector<std::size_t> relativeVertIndices;
+    std::vector<std::size_t> relativeTcIndices;
+    std::vector<std::size_t> relativeNormalIndices;
+    // exclusive prefix sums of element counts over the chunks before this one
+    std::size_t vertexBase = 0;
+    std::size_t texCoordBase = 0;
+    std::size_t normalBase = 0;
+    std::size_t cornerBase = 0;
+    bool parsed = true;
+    bool inRange = true;
+};
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
 }
 
-bool ImportedModel::supplyTexCoords()
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p != end && isBlank(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+// the beginning of next line
+inline const char* nextLine(const char* p, const char* end)
 {
+    while (p != end && *p != '\n')
+    {
+        ++p;
+    }
+    return p == end ? end : p + 1;
+}
+
+inline bool parseFloat(const char*& p, const char* end, float& value)
+{
+    p = skipBlanks(p, end);
+    if (p != end && *p == '+') // from_chars does not accept leading plus sign
+    {
+        ++p;
+    }
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc())
+    {
+        return false;
+    }
+    p = ptr;
     return true;
 }
-bool ImportedModel::supplyNormals()
+
+inline bool parseInt(const char*& p, const char* end, int& value)
 {
+    if (p != end && *p == '+')
+    {
+        ++p;
+    }
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc())
+    {
+        return false;
+    }
+    p = ptr;
     return true;
 }
 
-ImportedModel::ImportedModel(const char* filePath)
+// OBJ indices are 1-based, negative index is relative to the end of the elements read so far
+inline void appendIndex(int idx, std::size_t count, std::vector<int>& indices, std::vector<std::size_t>& relativeIndices)
 {
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
+    if (idx < 0)
+    {
+        relativeIndices.push_back(indices.size());
+        indices.push_back(int(count) + idx);
+    }
+    else
+    {
+        indices.push_back(idx - 1);
+    }
+}
 
-    std::ifstream fin(filePath);
-    if (!fin.is_open())
+// parse one face corner in the form of v/t/n
+inline bool parseFaceCorner(const char*& p, const char* end, int& v, int& t, int& n)
+{
+    p = skipBlanks(p, end);
+    if (!parseInt(p, end, v) || p == end || *p++ != '/')
     {
-        Logger::globalLogger().warning(std::format("Model file {} does not exist!", filePath));
-        return;
+        return false;
     }
-    std::string line;
-    float x, y, z;
-    std::vector<int> vertIndices, tcIndices, normalIndices;
-    while (!fin.eof())
+    if (!parseInt(p, end, t) || p == end || *p++ != '/')
     {
-        std::getline(fin, line);
-        if (line.compare(0, 2, "v ") == 0)
+        return false;
+    }
+    return parseInt(p, end, n);
+}
+
+// parse v/vt/vn/f records of the chunk, other records are ignored
+bool parseObjChunk(ObjChunk& chunk)
+{
+    const char* end = chunk.end;
+    // rough estimation of the element count to avoid most of the reallocations: ~32 bytes per line
+    std::size_t estimatedLines = std::size_t(end - chunk.begin) / 32;
+    chunk.vertices.reserve(estimatedLines / 4);
+    chunk.vertIndices.reserve(estimatedLines);
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+    for (const char* p = chunk.begin; p != end; p = nextLine(p, end))
+    {
+        if (end - p < 2)
+        {
+            break;
+        }
+        if (p[0] == 'v' && p[1] == ' ')
         {
-            std::istringstream iss(line.erase(0, 1));
-            iss >> x;
-            iss >> y;
-            iss >> z;
-            vertices.push_back(glm::vec3(x, y, z));
+            const char* q = p + 1;
+            parseFloat(q, end, x);
+            parseFloat(q, end, y);
+            parseFloat(q, end, z);
+            chunk.vertices.emplace_back(x, y, z);
         }
-        else if (line.compare(0, 2, "vt") == 0)
+        else if (p[0] == 'v' && p[1] == 't')
         {
-            std::istringstream iss(line.erase(0, 2));
-            iss >> x;
-            iss >> y;
-            texCoords.push_back(glm::vec2(x, y));
+            const char* q = p + 2;
+            parseFloat(q, end, x);
+            parseFloat(q, end, y);
+            chunk.texCoords.emplace_back(x, y);
         }
-        else if (line.compare(0, 2, "vn") == 0)
+        else if (p[0] == 'v' && p[1] == 'n')
         {
-            std::istringstream iss(line.erase(0, 2));
-            iss >> x;
-            iss >> y;
-            iss >> z;
-            normals.push_back(glm::vec3(x, y, z));
+            const char* q = p + 2;
+            parseFloat(q, end, x);
+            parseFloat(q, end, y);
+            parseFloat(q, end, z);
+            chunk.normals.emplace_back(x, y, z);
         }
-        else if (line.compare(0, 2, "f ") == 0) 
+        else if (p[0] == 'f' && p[1] == ' ')
         {
-            std::string oneVertex, v, t, n;
-            std::istringstream iss(line.erase(0, 2));
+            const char* q = p + 2;
             for (int i = 0; i < 3; ++i)
             {
-                std::getline(iss, oneVertex, ' ');
-                std::istringstream oneVertexIss(oneVertex);
-                std::getline(oneVertexIss, v, '/');
-                std::getline(oneVertexIss, t, '/');
-                std::getline(oneVertexIss, n, '/');
+                int v = 0, t = 0, n = 0;
+                if (!parseFaceCorner(q, end, v, t, n))
+                {
+                    return false;
+                }
+                appendIndex(v, chunk.vertices.size(), chunk.vertIndices, chunk.relativeVertIndices);
+                appendIndex(t, chunk.texCoords.size(), chunk.tcIndices, chunk.relativeTcIndices);
+                appendIndex(n, chunk.normals.size(), chunk.normalIndices, chunk.relativeNormalIndices);
+            }
+        }
+    }
+    return true;
+}
 
-                if (v.empty() || t.empty() || n.empty())
+// split [begin, end) into about chunkCount ranges of whole lines
+std::vector<ObjChunk> splitAtLines(const char* begin, const char* end, std::size_t chunkCount)
+{
+    std::vector<ObjChunk> chunks;
+    chunks.reserve(chunkCount);
+    std::size_t size = std::size_t(end - begin);
+    const char* chunkBegin = begin;
+    for (std::size_t i = 1; i <= chunkCount && chunkBegin != end; i++)
+    {
+        const char* chunkEnd = (i == chunkCount) ? end : begin + size / chunkCount * i;
+        if (chunkEnd < chunkBegin)
+        {
+            chunkEnd = chunkBegin;
+        }
+        // move to the beginning of next line
+        if (chunkEnd != end && chunkEnd != begin && chunkEnd[-1] != '\n')
+        {
+            chunkEnd = nextLine(chunkEnd, end);
+        }
+        if (chunkEnd == chunkBegin)
+        {
+            continue;
+        }
+        chunks.emplace_back();
+        chunks.back().begin = chunkBegin;
+        chunks.back().end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+inline void fixupRelativeIndices(std::vector<int>& indices, const std::vector<std::size_t>& relativeIndices, std::size_t base)
+{
+    for (auto pos : relativeIndices)
+    {
+        indices[pos] += int(base);
+    }
+}
+
+inline bool indicesInRange(const std::vector<int>& indices, std::size_t count)
+{
+    for (auto idx : indices)
+    {
+        if (idx < 0 || std::size_t(idx) >= count)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// open addressing hash map from a (v, vt, vn) index triple to the index of the deduplicated vertex,
+// linear probing in a power of two table which is kept at most half full
+class CornerMap
+{
+private:
+    struct Slot
+    {
+        int v = 0;
+        int t = 0;
+        int n = 0;
+        int index = -1; // -1 for empty slot
+    };
+    std::vector<Slot> m_slots;
+    std::size_t m_mask = 0;
+    std::size_t m_size = 0;
+
+    static std::size_t hash(int v, int t, int n)
+    {
+        std::uint64_t h = std::uint64_t(std::uint32_t(v)) * 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 29) ^ std::uint32_t(t)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 32) ^ std::uint32_t(n)) * 0x94D049BB133111EBull;
+        return std::size_t(h ^ (h >> 31));
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        std::vector<Slot> oldSlots(capacity);
+        oldSlots.swap(m_slots);
+        m_mask = capacity - 1;
+        for (const auto& slot : oldSlots)
+        {
+            if (slot.index >= 0)
+            {
+                std::size_t i = hash(slot.v, slot.t, slot.n) & m_mask;
+                while (m_slots[i].index >= 0)
                 {
-                    Logger::globalLogger().warning(std::format("Object file {} parse error: none of vertex/texture coordinate/normal could be empty.", filePath));
-                    return;
+                    i = (i + 1) & m_mask;
                 }
+                m_slots[i] = slot;
+            }
+        }
+    }
+public:
+    explicit CornerMap(std::size_t expectedSize)
+    {
+        rehash(std::bit_ceil(std::max(expectedSize * 2, std::size_t(16))));
+    }
 
-                int vertIdx = std::stoi(v) - 1;
-                int tcIdx = std::stoi(t) - 1;
-                int normIdx = std::stoi(n) - 1;
-                vertIndices.push_back(vertIdx);
-                tcIndices.push_back(tcIdx);
-                normalIndices.push_back(normIdx);
+    // index of the triple, newIndex is inserted if the triple is not in the map yet
+    int findOrInsert(int v, int t, int n, int newIndex)
+    {
+        if ((m_size + 1) * 2 > m_slots.size())
+        {
+            rehash(m_slots.size() * 2);
+        }
+        for (std::size_t i = hash(v, t, n) & m_mask; ; i = (i + 1) & m_mask)
+        {
+            Slot& slot = m_slots[i];
+            if (slot.index < 0)
+            {
+                slot = Slot{ v, t, n, newIndex };
+                ++m_size;
+                return newIndex;
+            }
+            if (slot.v == v && slot.t == t && slot.n == n)
+            {
+                return slot.index;
             }
         }
     }
-    for (auto idx : vertIndices)
+};
+
+// per vertex tangents in direction of increasing texture coordinates, sTangent along s and tTangent along t,
+// accumulated over the adjacent triangles and made orthogonal to the normal
+void computeVertexTangents(const std::vector<int>& indices, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& texCoords,
+                           const std::vector<glm::vec3>& normals, std::vector<glm::vec3>& sTangents, std::vector<glm::vec3>& tTangents)
+{
+    std::vector<glm::vec3> sDirs(vertices.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> tDirs(vertices.size(), glm::vec3(0.0f));
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
     {
-        m_vertices.push_back(vertices[idx].x);
-        m_vertices.push_back(vertices[idx].y);
-        m_vertices.push_back(vertices[idx].z);
+        int i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+        glm::vec3 e1 = vertices[i1] - vertices[i0];
+        glm::vec3 e2 = vertices[i2] - vertices[i0];
+        glm::vec2 d1 = texCoords[i1] - texCoords[i0];
+        glm::vec2 d2 = texCoords[i2] - texCoords[i0];
+        float det = d1.s * d2.t - d2.s * d1.t;
+        if (std::abs(det) < 1e-12f) // degenerated texture mapping
+        {
+            continue;
+        }
+        glm::vec3 sDir = (e1 * d2.t - e2 * d1.t) / det;
+        glm::vec3 tDir = (e2 * d1.s - e1 * d2.s) / det;
+        for (int idx : { i0, i1, i2 })
+        {
+            sDirs[idx] += sDir;
+            tDirs[idx] += tDir;
+        }
     }
-    for (auto idx : tcIndices)
+    sTangents.resize(vertices.size());
+    tTangents.resize(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); i++)
     {
-        m_texCoords.push_back(texCoords[idx].s);
-        m_texCoords.push_back(texCoords[idx].t);
+        glm::vec3 n = normals[i];
+        glm::vec3 s = sDirs[i] - n * glm::dot(n, sDirs[i]);
+        if (glm::dot(s, s) < 1e-12f)
+        {
+            // no texture mapping around, any direction perpendicular to the normal
+            s = std::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        s = glm::normalize(s);
+        glm::vec3 t = glm::cross(n, s);
+        // mirrored texture mapping
+        if (glm::dot(t, tDirs[i]) < 0.0f)
+        {
+            t = -t;
+        }
+        sTangents[i] = s;
+        tTangents[i] = t;
     }
-    for (auto idx : normalIndices)
+}
+
+} // anonymous namespace
+
+bool ImportedModel::supplyVertices()
+{
+    return true;
+}
+
+bool ImportedModel::supplyTexCoords()
+{
+    return true;
+}
+bool ImportedModel::supplyNormals()
+{
+    return true;
+}
+
+bool ImportedModel::supplyTangents()
+{
+    return true;
+}
+
+ImportedModel::ImportedModel(const char* filePath, std::size_t parseThreads, bool useMeshCache)
+{
+    MappedFile file(filePath);
+    if (!file.isOpen())
+    {
+        Logger::globalLogger().warning(std::format("Model file {} does not exist!", filePath));
+        return;
+    }
+
+    std::string cachePath = std::string(filePath) + ".meshcache";
+    std::uint64_t sourceHash = useMeshCache ? MeshCache::hashBytes(file.data(), file.size()) : 0;
+    if (useMeshCache && m_cache.open(cachePath.c_str(), file.size(), sourceHash))
+    {
+        m_data = m_cache.data();
+        return;
+    }
+
+    if (!parse(file, filePath, parseThreads))
+    {
+        return;
+    }
+    computeTangents();
+    m_data.indices = m_indices;
+    m_data.vertices = m_vertices;
+    m_data.texCoords = m_texCoords;
+    m_data.normals = m_normals;
+    m_data.sTangents = m_sTangents;
+    m_data.tTangents = m_tTangents;
+
+    IndexingStatistics stats = getIndexingStatistics();
+    Logger::globalLogger().debug(std::format("Model file {}: {} face corners, {} unique vertices, {} KB of {} KB vertex data saved, post-transform cache hit rate {:.1f}% (ACMR {:.3f}).",
+        filePath, stats.corners, stats.uniqueVertices, (std::max(stats.flatBytes, stats.indexedBytes) - stats.indexedBytes) / 1024, stats.flatBytes / 1024,
+        stats.cacheHitRate * 100.0f, stats.acmr));
+
+    if (useMeshCache)
+    {
+        // switch to the mapped cache, so that the parsed model is not kept twice in memory
+        if (MeshCache::write(cachePath.c_str(), m_data, file.size(), sourceHash) && m_cache.open(cachePath.c_str(), file.size(), sourceHash))
+        {
+            m_data = m_cache.data();
+            m_indices = {};
+            m_vertices = {};
+            m_texCoords = {};
+            m_normals = {};
+            m_sTangents = {};
+            m_tTangents = {};
+        }
+        else
+        {
+            Logger::globalLogger().debug(std::format("Could not write mesh cache {}, model file {} will be parsed on every load.", cachePath, filePath));
+        }
+    }
+}
+
+bool ImportedModel::parse(const MappedFile& file, const char* filePath, std::size_t parseThreads)
+{
+    // the single threaded path is the parallel path with only one chunk, so both produce identical results
+    if (parseThreads == 0)
+    {
+        parseThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t chunkCount = 1;
+    if (parseThreads > 1)
+    {
+        // several chunks per thread for load balancing, but do not bother to split small files
+        constexpr std::size_t minChunkSize = 1 << 20;
+        chunkCount = std::clamp(file.size() / minChunkSize, std::size_t(1), parseThreads * 4);
+    }
+    const char* begin = file.data();
+    std::vector<ObjChunk> chunks = splitAtLines(begin, begin + file.size(), chunkCount);
+    auto forEachChunk = [&](const std::function<void(std::size_t)>& func)
+    {
+        if (chunks.size() == 1)
+        {
+            func(0); // do not wake up the pool for single threaded parsing
+        }
+        else
+        {
+            ThreadPool::globalPool().parallelFor(chunks.size(), func, parseThreads);
+        }
+    };
+
+    // pass 1: tokenize chunks independently
+    forEachChunk([&](std::size_t i) { chunks[i].parsed = parseObjChunk(chunks[i]); });
+    for (auto& chunk : chunks)
+    {
+        if (!chunk.parsed)
+        {
+            Logger::globalLogger().warning(std::format("Object file {} parse error: none of vertex/texture coordinate/normal could be empty.", filePath));
+            return false;
+        }
+    }
+
+    // pass 2: prefix sums of element counts give every chunk its global offsets
+    std::size_t vertexCount = 0, texCoordCount = 0, normalCount = 0, cornerCount = 0;
+    for (auto& chunk : chunks)
+    {
+        chunk.vertexBase = vertexCount;
+        chunk.texCoordBase = texCoordCount;
+        chunk.normalBase = normalCount;
+        chunk.cornerBase = cornerCount;
+        vertexCount += chunk.vertices.size();
+        texCoordCount += chunk.texCoords.size();
+        normalCount += chunk.normals.size();
+        cornerCount += chunk.vertIndices.size();
+    }
+
+    // pass 3: fix up relative indices, gather elements to global arrays
+    std::vector<glm::vec3> vertices(vertexCount);
+    std::vector<glm::vec2> texCoords(texCoordCount);
+    std::vector<glm::vec3> normals(normalCount);
+    forEachChunk([&](std::size_t i)
     {
-        m_normals.push_back(normals[idx].x);
-        m_normals.push_back(normals[idx].y);
-        m_normals.push_back(normals[idx].z);
+        ObjChunk& chunk = chunks[i];
+        fixupRelativeIndices(chunk.vertIndices, chunk.relativeVertIndices, chunk.vertexBase);
+        fixupRelativeIndices(chunk.tcIndices, chunk.relativeTcIndices, chunk.texCoordBase);
+        fixupRelativeIndices(chunk.normalIndices, chunk.relativeNormalIndices, chunk.normalBase);
+        chunk.inRange = indicesInRange(chunk.vertIndices, vertexCount) && indicesInRange(chunk.tcIndices, texCoordCount)
+                        && indicesInRange(chunk.normalIndices, normalCount);
+        std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + chunk.vertexBase);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordBase);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+    });
+    for (auto& chunk : chunks)
+    {
+        if (!chunk.inRange)
+        {
+            Logger::globalLogger().warning(std::format("Object file {} parse error: face index out of range.", filePath));
+            return false;
+        }
+    }
+
+    // pass 4: deduplicate (v, vt, vn) triples in the order of their first use, which is independent of the chunking.
+    // indices of a closed mesh are mostly shared by all the three arrays, so the unique triples are about as many as the largest one.
+    CornerMap cornerMap(std::max({ vertexCount, texCoordCount, normalCount }));
+    m_indices.resize(cornerCount);
+    m_vertices.reserve(vertexCount);
+    m_texCoords.reserve(vertexCount);
+    m_normals.reserve(vertexCount);
+    for (const auto& chunk : chunks)
+    {
+        for (std::size_t j = 0; j < chunk.vertIndices.size(); ++j)
+        {
+            int v = chunk.vertIndices[j], t = chunk.tcIndices[j], n = chunk.normalIndices[j];
+            int index = cornerMap.findOrInsert(v, t, n, int(m_vertices.size()));
+            if (index == int(m_vertices.size()))
+            {
+                m_vertices.push_back(vertices[v]);
+                m_texCoords.push_back(texCoords[t]);
+                m_normals.push_back(normals[n]);
+            }
+            m_indices[chunk.cornerBase + j] = index;
+        }
     }
+
+    return true;
+}
+
+void ImportedModel::computeTangents()
+{
+    computeVertexTangents(m_indices, m_vertices, m_texCoords, m_normals, m_sTangents, m_tTangents);
 }
 
 std::vector<float> ImportedModel::getVerticesArray()
 {
-    return m_vertices;
+    return deindex<glm::vec3>(m_data.indices, m_data.vertices);
 }
 
 std::vector<float> ImportedModel::getTexCoordsArray()
 {
-    return m_texCoords;
+    return deindex<glm::vec2>(m_data.indices, m_data.texCoords);
 }
 
 std::vector<float> ImportedModel::getNormalsArray()
 {
-    return m_normals;
+    return deindex<glm::vec3>(m_data.indices, m_data.normals);
+}
+
+std::vector<float> ImportedModel::getSTangentsArray()
+{
+    return deindex<glm::vec3>(m_data.indices, m_data.sTangents);
+}
+
+std::vector<float> ImportedModel::getTTangentsArray()
+{
+    return deindex<glm::vec3>(m_data.indices, m_data.tTangents);
+}
+
+bool ImportedModel::supplyIndices()
+{
+    return true;
+}
+
+std::vector<int> ImportedModel::getIndices()
+{
+    return std::vector<int>(m_data.indices.begin(), m_data.indices.end());
+}
+
+std::vector<glm::vec3> ImportedModel::getVertices()
+{
+    return std::vector<glm::vec3>(m_data.vertices.begin(), m_data.vertices.end());
+}
+
+std::vector<glm::vec2> ImportedModel::getTexCoords()
+{
+    return std::vector<glm::vec2>(m_data.texCoords.begin(), m_data.texCoords.end());
+}
+
+std::vector<glm::vec3> ImportedModel::getNormals()
+{
+    return std::vector<glm::vec3>(m_data.normals.begin(), m_data.normals.end());
+}
+
+std::vector<glm::vec3> ImportedModel::getSTangents()
+{
+    return std::vector<glm::vec3>(m_data.sTangents.begin(), m_data.sTangents.end());
+}
+
+std::vector<glm::vec3> ImportedModel::getTTangents()
+{
+    return std::vector<glm::vec3>(m_data.tTangents.begin(), m_data.tTangents.end());
+}
+
+std::span<const int> ImportedModel::getIndicesView()
+{
+    return m_data.indices;
+}
+
+std::span<const glm::vec3> ImportedModel::getVerticesView()
+{
+    return m_data.vertices;
+}
+
+std::span<const glm::vec2> ImportedModel::getTexCoordsView()
+{
+    return m_data.texCoords;
+}
+
+std::span<const glm::vec3> ImportedModel::getNormalsView()
+{
+    return m_data.normals;
+}
+
+std::span<const glm::vec3> ImportedModel::getSTangentsView()
+{
+    return m_data.sTangents;
+}
+
+std::span<const glm::vec3> ImportedModel::getTTangentsView()
+{
+    return m_data.tTangents;
+}
+
+bool ImportedModel::isLoadedFromCache() const
+{
+    return m_cache.isOpen();
+}
+
+IndexingStatistics ImportedModel::getIndexingStatistics() const
+{
+    IndexingStatistics stats;
+    stats.corners = m_data.indices.size();
+    stats.uniqueVertices = m_data.vertices.size();
+    constexpr std::size_t bytesPerVertex = sizeof(glm::vec3) * 4 + sizeof(glm::vec2); // vertex, normal, tangents and texture coordinate
+    stats.flatBytes = stats.corners * bytesPerVertex;
+    stats.indexedBytes = stats.uniqueVertices * bytesPerVertex + stats.corners * sizeof(int);
+    if (stats.corners >= 3)
+    {
+        std::size_t misses = simulateVertexCache(m_data.indices, stats.uniqueVertices, postTransformCacheSize);
+        stats.cacheHitRate = 1.0f - float(misses) / float(stats.corners);
+        stats.acmr = float(misses) / float(stats.corners / 3);
+    }
+    return stats;
 }
 
 } // namespace Utils
\ No newline at end of file
@@ -0,0 +1,296 @@
+#include <LightClusters.h>
+#include <glm/ext.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace Utils
+{
+
+float attenuationRange(float constant, float linear, float quadratic, float threshold)
+{
+    // solve c + l*d + q*d*d = 1 / threshold for d
+    float inverse = 1.0f / threshold;
+    if (constant >= inverse)
+    {
+        return 0.0f;
+    }
+    if (quadratic > 0.0f)
+    {
+        return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * (constant - inverse))) / (2.0f * quadratic);
+    }
+    if (linear > 0.0f)
+    {
+        return (inverse - constant) / linear;
+    }
+    return infiniteLightRange;
+}
+
+LightClusterGrid::LightClusterGrid(glm::uvec3 size)
+    : m_Size(glm::max(size, glm::uvec3(1)))
+{
+}
+
+bool LightClusterGrid::update(const glm::mat4& projMatrix, int width, int height)
+{
+    glm::vec2 viewport(float(std::max(width, 1)), float(std::max(height, 1)));
+    if (!m_Bounds.empty() && projMatrix == m_ProjMatrix && viewport == m_Viewport)
+    {
+        return false;
+    }
+    m_ProjMatrix = projMatrix;
+    m_Viewport = viewport;
+
+    glm::mat4 inverse = glm::inverse(projMatrix);
+    auto unproject = [&](float x, float y, float z)
+    {
+        glm::vec4 p = inverse * glm::vec4(x, y, z, 1.0f);
+        return glm::vec3(p) / p.w;
+    };
+    m_Far = -unproject(0.0f, 0.0f, 1.0f).z;
+    // an orthographic projection may start at the eye, the logarithmic slices need a positive near plane
+    m_Near = std::max(-unproject(0.0f, 0.0f, -1.0f).z, m_Far * 1e-5f);
+
+    m_Bounds.resize(getClusterCount());
+    m_Spheres.resize(getClusterCount());
+    m_RowSpheres.resize(std::size_t(m_Size.y) * m_Size.z);
+    std::vector<float> depths(m_Size.z + 1);
+    for (unsigned z = 0; z <= m_Size.z; z++)
+    {
+        depths[z] = m_Near * std::pow(m_Far / m_Near, float(z) / float(m_Size.z));
+    }
+    for (unsigned y = 0; y < m_Size.y; y++)
+    {
+        for (unsigned x = 0; x < m_Size.x; x++)
+        {
+            // the edges of the tile from the near to the far plane, they meet in the eye for a perspective projection
+            glm::vec3 nearCorners[4], farCorners[4];
+            for (int c = 0; c < 4; c++)
+            {
+                float ndcX = -1.0f + 2.0f * float(x + (c & 1)) / float(m_Size.x);
+                float ndcY = -1.0f + 2.0f * float(y + (c >> 1)) / float(m_Size.y);
+                nearCorners[c] = unproject(ndcX, ndcY, -1.0f);
+                farCorners[c] = unproject(ndcX, ndcY, 1.0f);
+            }
+            for (unsigned z = 0; z < m_Size.z; z++)
+            {
+                ClusterBounds& bounds = m_Bounds[x + m_Size.x * (y + m_Size.y * z)];
+                glm::vec3 minCorner(std::numeric_limits<float>::max()), maxCorner(-std::numeric_limits<float>::max());
+                for (int c = 0; c < 4; c++)
+                {
+                    for (float depth : { depths[z], depths[z + 1] })
+                    {
+                        float t = (depth + nearCorners[c].z) / (nearCorners[c].z - farCorners[c].z);
+                        glm::vec3 p = nearCorners[c] + (farCorners[c] - nearCorners[c]) * t;
+                        minCorner = glm::min(minCorner, p);
+                        maxCorner = glm::max(maxCorner, p);
+                    }
+                }
+                bounds.minCorner = glm::vec4(minCorner, 0.0f);
+                bounds.maxCorner = glm::vec4(maxCorner, 0.0f);
+                glm::vec3 center = (minCorner + maxCorner) * 0.5f;
+                m_Spheres[x + m_Size.x * (y + m_Size.y * z)] = glm::vec4(center, glm::length(maxCorner - center));
+            }
+        }
+    }
+    for (std::size_t row = 0; row < m_RowSpheres.size(); row++)
+    {
+        glm::vec3 minCorner(m_Bounds[row * m_Size.x].minCorner), maxCorner(m_Bounds[row * m_Size.x].maxCorner);
+        for (unsigned x = 1; x < m_Size.x; x++)
+        {
+            minCorner = glm::min(minCorner, glm::vec3(m_Bounds[row * m_Size.x + x].minCorner));
+            maxCorner = glm::max(maxCorner, glm::vec3(m_Bounds[row * m_Size.x + x].maxCorner));
+        }
+        glm::vec3 center = (minCorner + maxCorner) * 0.5f;
+        m_RowSpheres[row] = glm::vec4(center, glm::length(maxCorner - center));
+    }
+    return true;
+}
+
+void LightClusterGrid::addCandidates(const LightVolume& light, bool spot)
+{
+    float depth = -light.position.z;
+    float radius = light.range;
+    if (m_Bounds.empty() || depth + radius < m_Near || depth - radius > m_Far)
+    {
+        return;
+    }
+    auto slice = [&](float d)
+    {
+        float z = std::floor(std::log(d) * getDepthScale() + getDepthBias());
+        return unsigned(std::clamp(z, 0.0f, float(m_Size.z - 1)));
+    };
+    unsigned z0 = slice(std::max(depth - radius, m_Near));
+    unsigned z1 = slice(std::min(depth + radius, m_Far));
+
+    // the tiles the view space box of the sphere projects to, all of them if the box reaches behind the near plane
+    glm::uvec2 tile0(0), tile1(m_Size.x - 1, m_Size.y - 1);
+    if (depth - radius > m_Near)
+    {
+        glm::vec2 minNdc(std::numeric_limits<float>::max()), maxNdc(-std::numeric_limits<float>::max());
+        bool inFront = true;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 corner = light.position + glm::vec3((c & 1) ? radius : -radius, (c & 2) ? radius : -radius, (c & 4) ? radius : -radius);
+            glm::vec4 clip = m_ProjMatrix * glm::vec4(corner, 1.0f);
+            inFront = inFront && clip.w > 0.0f;
+            minNdc = glm::min(minNdc, glm::vec2(clip) / clip.w);
+            maxNdc = glm::max(maxNdc, glm::vec2(clip) / clip.w);
+        }
+        if (inFront)
+        {
+            if (maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f)
+            {
+                return;
+            }
+            glm::vec2 size(m_Size.x, m_Size.y);
+            glm::vec2 first = glm::clamp(glm::floor((minNdc * 0.5f + 0.5f) * size), glm::vec2(0.0f), size - 1.0f);
+            glm::vec2 last = glm::clamp(glm::floor((maxNdc * 0.5f + 0.5f) * size), glm::vec2(0.0f), size - 1.0f);
+            tile0 = glm::uvec2(first);
+            tile1 = glm::uvec2(last);
+        }
+    }
+
+    // the cone is tested against bounding spheres, of the row first (Wronski, cull that cone)
+    bool cone = spot && light.cutOffAngle < glm::half_pi<float>();
+    float cosAngle = std::cos(light.cutOffAngle), sinAngle = std::sin(light.cutOffAngle);
+    auto coneIntersects = [&](const glm::vec4& sphere)
+    {
+        glm::vec3 v = glm::vec3(sphere) - light.position;
+        float axial = glm::dot(v, light.direction);
+        float closest = cosAngle * std::sqrt(std::max(glm::dot(v, v) - axial * axial, 0.0f)) - axial * sinAngle;
+        return closest <= sphere.w && axial >= -sphere.w;
+    };
+    float radiusSquared = radius * radius;
+    for (unsigned z = z0; z <= z1; z++)
+    {
+        for (unsigned y = tile0.y; y <= tile1.y; y++)
+        {
+            if (cone && !coneIntersects(m_RowSpheres[y + m_Size.y * z]))
+            {
+                continue;
+            }
+            for (unsigned x = tile0.x; x <= tile1.x; x++)
+            {
+                std::uint32_t index = x + m_Size.x * (y + m_Size.y * z);
+                const ClusterBounds& bounds = m_Bounds[index];
+                glm::vec3 d = glm::max(glm::max(glm::vec3(bounds.minCorner) - light.position, light.position - glm::vec3(bounds.maxCorner)), glm::vec3(0.0f));
+                if (glm::dot(d, d) > radiusSquared || (cone && !coneIntersects(m_Spheres[index])))
+                {
+                    continue;
+                }
+                m_Candidates.push_back(index);
+            }
+        }
+    }
+}
+
+void LightClusterGrid::assignLights(std::span<const LightVolume> pointLights, std::span<const LightVolume> spotLights)
+{
+    m_Candidates.clear();
+    m_CandidateOffsets.assign(1, 0);
+    for (const auto& light : pointLights)
+    {
+        addCandidates(light, false);
+        m_CandidateOffsets.push_back(m_Candidates.size());
+    }
+    for (const auto& light : spotLights)
+    {
+        addCandidates(light, true);
+        m_CandidateOffsets.push_back(m_Candidates.size());
+    }
+
+    // counting sort of the light and cluster pairs by cluster, lights keep their order, so point lights come first
+    std::size_t count = getClusterCount();
+    std::size_t lightCount = pointLights.size() + spotLights.size();
+    m_Clusters.assign(count, glm::uvec4(0));
+    for (std::size_t light = 0; light < lightCount; light++)
+    {
+        for (std::size_t k = m_CandidateOffsets[light]; k < m_CandidateOffsets[light + 1]; k++)
+        {
+            glm::uvec4& cluster = m_Clusters[m_Candidates[k]];
+            (light < pointLights.size() ? cluster.y : cluster.z)++;
+        }
+    }
+    m_Stats = LightClusterStatistics{};
+    std::uint32_t offset = 0;
+    for (auto& cluster : m_Clusters)
+    {
+        cluster.x = offset;
+        offset += cluster.y + cluster.z;
+        m_Stats.occupiedClusters += (cluster.y + cluster.z) > 0;
+        m_Stats.maxClusterLights = std::max<std::size_t>(m_Stats.maxClusterLights, cluster.y + cluster.z);
+    }
+    m_LightIndices.resize(offset);
+    for (std::size_t light = 0; light < lightCount; light++)
+    {
+        std::uint32_t index = std::uint32_t(light < pointLights.size() ? light : light - pointLights.size());
+        for (std::size_t k = m_CandidateOffsets[light]; k < m_CandidateOffsets[light + 1]; k++)
+        {
+            glm::uvec4& cluster = m_Clusters[m_Candidates[k]];
+            m_LightIndices[cluster.x + cluster.w++] = index;
+        }
+    }
+    for (auto& cluster : m_Clusters)
+    {
+        cluster.w = 0;
+    }
+    m_Stats.clusters = count;
+    m_Stats.pointLights = pointLights.size();
+    m_Stats.spotLights = spotLights.size();
+    m_Stats.lightIndices = m_LightIndices.size();
+}
+
+glm::uvec3 LightClusterGrid::getSize() const
+{
+    return m_Size;
+}
+
+std::size_t LightClusterGrid::getClusterCount() const
+{
+    return std::size_t(m_Size.x) * m_Size.y * m_Size.z;
+}
+
+float LightClusterGrid::getDepthScale() const
+{
+    return m_Far > m_Near ? float(m_Size.z) / std::log(m_Far / m_Near) : 0.0f;
+}
+
+float LightClusterGrid::getDepthBias() const
+{
+    return -std::log(m_Near) * getDepthScale();
+}
+
+glm::vec2 LightClusterGrid::getTileSize() const
+{
+    return m_Viewport / glm::vec2(m_Size.x, m_Size.y);
+}
+
+std::size_t LightClusterGrid::getClusterIndex(glm::vec2 fragCoord, float viewDepth) const
+{
+    glm::vec2 tile = glm::clamp(glm::floor(fragCoord / getTileSize()), glm::vec2(0.0f), glm::vec2(m_Size.x - 1, m_Size.y - 1));
+    float z = std::floor(std::log(std::max(viewDepth, m_Near)) * getDepthScale() + getDepthBias());
+    z = std::clamp(z, 0.0f, float(m_Size.z - 1));
+    return std::size_t(tile.x) + m_Size.x * (std::size_t(tile.y) + m_Size.y * std::size_t(z));
+}
+
+const std::vector<ClusterBounds>& LightClusterGrid::getBounds() const
+{
+    return m_Bounds;
+}
+
+const std::vector<glm::uvec4>& LightClusterGrid::getClusters() const
+{
+    return m_Clusters;
+}
+
+const std::vector<std::uint32_t>& LightClusterGrid::getLightIndices() const
+{
+    return m_LightIndices;
+}
+
+const LightClusterStatistics& LightClusterGrid::getStatistics() const
+{
+    return m_Stats;
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <MappedFile.h>
+#include <utility>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Utils
+{
+
+MappedFile::MappedFile(const char* filePath)
+{
+    open(filePath);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    moveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+void MappedFile::moveFrom(MappedFile& other)
+{
+    m_pData = std::exchange(other.m_pData, nullptr);
+    m_Size = std::exchange(other.m_Size, 0);
+    m_bOpen = std::exchange(other.m_bOpen, false);
+#ifdef _WIN32
+    m_hFile = std::exchange(other.m_hFile, nullptr);
+    m_hMapping = std::exchange(other.m_hMapping, nullptr);
+#else
+    m_Fd = std::exchange(other.m_Fd, -1);
+#endif
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char* filePath)
+{
+    close();
+    HANDLE hFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize))
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+    m_hFile = hFile;
+    m_Size = std::size_t(fileSize.QuadPart);
+    m_bOpen = true;
+    if (m_Size == 0) // can not map an empty file
+    {
+        return true;
+    }
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL)
+    {
+        close();
+        return false;
+    }
+    m_hMapping = hMapping;
+    m_pData = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_pData)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_pData)
+    {
+        UnmapViewOfFile(m_pData);
+    }
+    if (m_hMapping)
+    {
+        CloseHandle(m_hMapping);
+    }
+    if (m_hFile)
+    {
+        CloseHandle(m_hFile);
+    }
+    m_pData = nullptr;
+    m_hMapping = nullptr;
+    m_hFile = nullptr;
+    m_Size = 0;
+    m_bOpen = false;
+}
+#else
+bool MappedFile::open(const char* filePath)
+{
+    close();
+    int fd = ::open(filePath, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_Fd = fd;
+    m_Size = std::size_t(st.st_size);
+    m_bOpen = true;
+    if (m_Size == 0) // can not map an empty file
+    {
+        return true;
+    }
+    void* p = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    // the whole file is going to be read from front to back
+    madvise(p, m_Size, MADV_SEQUENTIAL);
+    m_pData = static_cast<const char*>(p);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_pData)
+    {
+        munmap(const_cast<char*>(m_pData), m_Size);
+    }
+    if (m_Fd >= 0)
+    {
+        ::close(m_Fd);
+    }
+    m_pData = nullptr;
+    m_Fd = -1;
+    m_Size = 0;
+    m_bOpen = false;
+}
+#endif
+
+bool MappedFile::isOpen() const
+{
+    return m_bOpen;
+}
+
+const char* MappedFile::data() const
+{
+    return m_pData;
+}
+
+std::size_t MappedFile::size() const
+{
+    return m_Size;
+}
+
+} // namespace Utils
\ No newline at end of file
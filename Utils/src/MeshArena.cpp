@@ -0,0 +1,145 @@
+#include <MeshArena.h>
+#include <algorithm>
+
+namespace Utils
+{
+
+namespace
+{
+
+// vertices and indices of the first buffers
+constexpr std::size_t initialVertexCapacity = 64 * 1024;
+constexpr std::size_t initialIndexCapacity = 3 * 64 * 1024;
+
+} // anonymous namespace
+
+MeshArena::MeshArena(const VertexLayout& layout, GLenum indexType)
+    : m_Layout(interleavedLayout(layout))
+    , m_IndexType(indexType)
+    , m_IndexSize(indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))
+{
+    glGenVertexArrays(1, &m_Vao);
+}
+
+VertexLayout MeshArena::interleavedLayout(const VertexLayout& layout)
+{
+    VertexLayout interleaved(InterleavedBuffer);
+    for (const auto& attribute : layout.getAttributes())
+    {
+        interleaved.addAttribute(attribute.location, attribute.components, attribute.type, attribute.normalized, attribute.size);
+    }
+    return interleaved;
+}
+
+bool MeshArena::accepts(const VertexLayout& layout, GLenum indexType) const
+{
+    return indexType == m_IndexType && interleavedLayout(layout) == m_Layout;
+}
+
+std::size_t MeshArena::allocate(GLuint& buffer, RangeAllocator& ranges, std::size_t count, std::size_t initialCapacity, std::size_t elementSize)
+{
+    std::size_t offset = ranges.allocate(count);
+    if (offset != RangeAllocator::npos)
+    {
+        return offset;
+    }
+    // the allocations are anywhere in the old buffer, all of it is copied
+    std::size_t capacity = ranges.getCapacity();
+    std::size_t newCapacity = std::max({ initialCapacity, capacity * 2, capacity + count });
+    GLuint newBuffer = 0;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(newCapacity * elementSize), nullptr, GL_STATIC_DRAW);
+    if (ranges.getUsed() > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, GLsizeiptr(capacity * elementSize));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+    ranges.grow(newCapacity);
+    return ranges.allocate(count);
+}
+
+void MeshArena::attachBuffers()
+{
+    glBindVertexArray(m_Vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+    for (const auto& attribute : m_Layout.getAttributes())
+    {
+        m_Layout.setAttributePointer(attribute);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+    glBindVertexArray(0);
+}
+
+MeshArenaRange MeshArena::add(const void* pVertices, std::size_t vertexCount, const void* pIndices, std::size_t indexCount)
+{
+    std::size_t stride = std::size_t(m_Layout.getStride());
+    GLuint vertexBuffer = m_VertexBuffer, indexBuffer = m_IndexBuffer;
+    std::size_t baseVertex = allocate(m_VertexBuffer, m_Vertices, vertexCount, initialVertexCapacity, stride);
+    std::size_t firstIndex = allocate(m_IndexBuffer, m_Indices, indexCount, initialIndexCapacity, m_IndexSize);
+    if (vertexBuffer != m_VertexBuffer || indexBuffer != m_IndexBuffer)
+    {
+        attachBuffers();
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(baseVertex * stride), GLsizeiptr(vertexCount * stride), pVertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(firstIndex * m_IndexSize), GLsizeiptr(indexCount * m_IndexSize), pIndices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    m_MeshCount++;
+    return MeshArenaRange{ GLint(baseVertex), GLuint(firstIndex), GLuint(indexCount) };
+}
+
+void MeshArena::remove(const MeshArenaRange& range)
+{
+    m_Vertices.free(std::size_t(range.baseVertex));
+    m_Indices.free(range.firstIndex);
+    m_MeshCount--;
+}
+
+void MeshArena::setDrawIndexBuffer(GLuint buffer)
+{
+    glBindVertexArray(m_Vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribIPointer(drawIndexLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+    glVertexAttribDivisor(drawIndexLocation, 1);
+    glEnableVertexAttribArray(drawIndexLocation);
+    glBindVertexArray(0);
+}
+
+const VertexLayout& MeshArena::getLayout() const
+{
+    return m_Layout;
+}
+
+GLenum MeshArena::getIndexType() const
+{
+    return m_IndexType;
+}
+
+GLuint MeshArena::getVao() const
+{
+    return m_Vao;
+}
+
+std::size_t MeshArena::getVertexCount() const
+{
+    return m_Vertices.getUsed();
+}
+
+std::size_t MeshArena::getIndexCount() const
+{
+    return m_Indices.getUsed();
+}
+
+std::size_t MeshArena::getMeshCount() const
+{
+    return m_MeshCount;
+}
+
+} // namespace Utils
\ No newline at end of file
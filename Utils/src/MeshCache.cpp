@@ -0,0 +1,209 @@
+#include <MeshCache.h>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <filesystem>
+
+namespace Utils
+{
+
+namespace
+{
+
+enum Section
+{
+    IndicesSection,
+    VerticesSection,
+    TexCoordsSection,
+    NormalsSection,
+    STangentsSection,
+    TTangentsSection,
+    SectionCount
+};
+
+struct SectionEntry
+{
+    std::uint64_t offset;   // from the beginning of the file, multiple of sectionAlignment
+    std::uint64_t count;    // element count
+};
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint64_t sourceSize;
+    std::uint64_t sourceHash;
+    SectionEntry sections[SectionCount];
+};
+
+constexpr char cacheMagic[8] = { 'L', 'O', 'G', 'L', 'M', 'E', 'S', 'H' };
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+constexpr std::size_t elementSizes[SectionCount] = {
+    sizeof(int), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec3)
+};
+
+// the sections are used as arrays of their element types in place
+static_assert(sizeof(glm::vec3) == sizeof(float) * 3);
+static_assert(sizeof(glm::vec2) == sizeof(float) * 2);
+static_assert(MeshCache::sectionAlignment % alignof(glm::vec3) == 0 && MeshCache::sectionAlignment % alignof(int) == 0);
+
+constexpr std::uint64_t alignUp(std::uint64_t size)
+{
+    return (size + MeshCache::sectionAlignment - 1) / MeshCache::sectionAlignment * MeshCache::sectionAlignment;
+}
+
+template<typename T>
+std::span<const T> sectionView(const char* pBase, const SectionEntry& section)
+{
+    return std::span<const T>(reinterpret_cast<const T*>(pBase + section.offset), std::size_t(section.count));
+}
+
+template<typename T>
+std::span<const char> bytesOf(std::span<const T> view)
+{
+    return std::span<const char>(reinterpret_cast<const char*>(view.data()), view.size_bytes());
+}
+
+} // anonymous namespace
+
+bool MeshCache::open(const char* filePath, std::uint64_t sourceSize, std::uint64_t sourceHash)
+{
+    close();
+    MappedFile file(filePath);
+    if (!file.isOpen() || file.size() < sizeof(MeshCacheHeader))
+    {
+        return false;
+    }
+    MeshCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != version || header.byteOrderMark != byteOrderMark
+        || header.sourceSize != sourceSize || header.sourceHash != sourceHash)
+    {
+        return false;
+    }
+    // a truncated or broken file must not let the views out of the mapping
+    for (int i = 0; i < SectionCount; i++)
+    {
+        const SectionEntry& section = header.sections[i];
+        if (section.offset % sectionAlignment != 0 || section.offset > file.size()
+            || section.count > (file.size() - section.offset) / elementSizes[i])
+        {
+            return false;
+        }
+    }
+    std::uint64_t vertexCount = header.sections[VerticesSection].count;
+    for (int i = TexCoordsSection; i < SectionCount; i++)
+    {
+        if (header.sections[i].count != 0 && header.sections[i].count != vertexCount)
+        {
+            return false;
+        }
+    }
+
+    const char* pBase = file.data();
+    m_Data.indices = sectionView<int>(pBase, header.sections[IndicesSection]);
+    m_Data.vertices = sectionView<glm::vec3>(pBase, header.sections[VerticesSection]);
+    m_Data.texCoords = sectionView<glm::vec2>(pBase, header.sections[TexCoordsSection]);
+    m_Data.normals = sectionView<glm::vec3>(pBase, header.sections[NormalsSection]);
+    m_Data.sTangents = sectionView<glm::vec3>(pBase, header.sections[STangentsSection]);
+    m_Data.tTangents = sectionView<glm::vec3>(pBase, header.sections[TTangentsSection]);
+    m_File = std::move(file);
+    return true;
+}
+
+void MeshCache::close()
+{
+    m_File.close();
+    m_Data = MeshData{};
+}
+
+bool MeshCache::isOpen() const
+{
+    return m_File.isOpen();
+}
+
+const MeshData& MeshCache::data() const
+{
+    return m_Data;
+}
+
+bool MeshCache::write(const char* filePath, const MeshData& data, std::uint64_t sourceSize, std::uint64_t sourceHash)
+{
+    const std::span<const char> sections[SectionCount] = {
+        bytesOf(data.indices), bytesOf(data.vertices), bytesOf(data.texCoords), bytesOf(data.normals), bytesOf(data.sTangents), bytesOf(data.tTangents)
+    };
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = version;
+    header.byteOrderMark = byteOrderMark;
+    header.sourceSize = sourceSize;
+    header.sourceHash = sourceHash;
+    std::uint64_t offset = alignUp(sizeof(header));
+    for (int i = 0; i < SectionCount; i++)
+    {
+        header.sections[i].offset = offset;
+        header.sections[i].count = sections[i].size() / elementSizes[i];
+        offset = alignUp(offset + sections[i].size());
+    }
+
+    std::string tempPath = std::string(filePath) + ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if (!fout)
+        {
+            return false;
+        }
+        const char padding[sectionAlignment] = {};
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(padding, std::streamsize(alignUp(sizeof(header)) - sizeof(header)));
+        for (const auto& section : sections)
+        {
+            fout.write(section.data(), std::streamsize(section.size()));
+            fout.write(padding, std::streamsize(alignUp(section.size()) - section.size()));
+        }
+        if (!fout.flush())
+        {
+            fout.close();
+            std::filesystem::remove(tempPath);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, filePath, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t MeshCache::hashBytes(const char* pData, std::size_t size)
+{
+    // word at a time multiply-xorshift, fast enough to hash a model file on every load
+    auto mix = [](std::uint64_t h, std::uint64_t word)
+    {
+        h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+        return h ^ (h >> 32);
+    };
+    std::uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, pData + i, sizeof(word));
+        h = mix(h, word);
+    }
+    if (i < size)
+    {
+        std::uint64_t word = 0;
+        std::memcpy(&word, pData + i, size - i);
+        h = mix(h, word);
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 33);
+}
+
+} // namespace Utils
\ No newline at end of file
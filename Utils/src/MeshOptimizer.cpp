@@ -0,0 +1,336 @@
+#include <MeshOptimizer.h>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstring>
+
+namespace Utils
+{
+
+std::size_t simulateVertexCache(std::span<const int> indices, std::size_t vertexCount, std::size_t cacheSize)
+{
+    // a vertex is in the cache if it entered the cache during the last cacheSize misses
+    constexpr std::size_t notCached = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> enteredAt(vertexCount, notCached);
+    std::size_t misses = 0;
+    for (auto idx : indices)
+    {
+        std::size_t& entered = enteredAt[idx];
+        if (entered == notCached || misses - entered >= cacheSize)
+        {
+            entered = misses++;
+        }
+    }
+    return misses;
+}
+
+VertexCacheStatistics analyzeVertexCache(std::span<const int> indices, std::size_t vertexCount, std::size_t cacheSize)
+{
+    VertexCacheStatistics stats;
+    stats.triangles = indices.size() / 3;
+    std::vector<bool> referenced(vertexCount, false);
+    for (auto idx : indices)
+    {
+        if (!referenced[idx])
+        {
+            referenced[idx] = true;
+            stats.vertices++;
+        }
+    }
+    stats.transformedVertices = simulateVertexCache(indices, vertexCount, cacheSize);
+    if (stats.triangles > 0)
+    {
+        stats.acmr = float(stats.transformedVertices) / float(stats.triangles);
+        stats.atvr = float(stats.transformedVertices) / float(stats.vertices);
+    }
+    return stats;
+}
+
+// Tipsify: emit all remaining triangles around a fanning vertex, then continue with the adjacent vertex that will stay in the cache
+// for its remaining triangles, or at a dead end with the most recently used vertex that has triangles left.
+std::vector<int> optimizeVertexCache(std::span<const int> indices, std::size_t vertexCount, std::size_t cacheSize, std::vector<std::size_t>* pClusters)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    std::vector<int> res;
+    res.reserve(triangleCount * 3);
+    if (pClusters)
+    {
+        pClusters->clear();
+    }
+
+    // triangles adjacent to every vertex
+    std::vector<std::size_t> offsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < triangleCount * 3; i++)
+    {
+        offsets[indices[i] + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<std::size_t> adjacency(triangleCount * 3);
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < triangleCount * 3; i++)
+    {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    // remaining triangles of every vertex
+    std::vector<std::size_t> live(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++)
+    {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+    std::vector<std::size_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<int> deadEnd;
+    deadEnd.reserve(triangleCount * 3);
+    std::vector<int> candidates;
+    std::size_t time = cacheSize + 1;
+    std::size_t cursor = 0;
+    bool newCluster = true;
+
+    auto nextLiveVertex = [&]() -> int
+    {
+        while (!deadEnd.empty())
+        {
+            int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+            {
+                return v;
+            }
+        }
+        while (cursor < vertexCount)
+        {
+            if (live[cursor] > 0)
+            {
+                return int(cursor);
+            }
+            cursor++;
+        }
+        return -1;
+    };
+
+    int fan = nextLiveVertex();
+    while (fan >= 0)
+    {
+        candidates.clear();
+        for (std::size_t k = offsets[fan]; k < offsets[fan + 1]; k++)
+        {
+            std::size_t t = adjacency[k];
+            if (emitted[t])
+            {
+                continue;
+            }
+            if (newCluster && pClusters)
+            {
+                pClusters->push_back(res.size() / 3);
+            }
+            newCluster = false;
+            for (std::size_t c = 0; c < 3; c++)
+            {
+                int v = indices[t * 3 + c];
+                res.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = time++;
+                }
+            }
+            emitted[t] = true;
+        }
+
+        // prefer the candidate that entered the cache earliest, as long as all its triangles fit before it is evicted
+        int best = -1;
+        std::size_t bestPriority = 0;
+        for (int v : candidates)
+        {
+            if (live[v] == 0)
+            {
+                continue;
+            }
+            std::size_t priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+            {
+                priority = time - cacheTime[v];
+            }
+            if (best < 0 || priority > bestPriority)
+            {
+                best = v;
+                bestPriority = priority;
+            }
+        }
+        if (best < 0)
+        {
+            newCluster = true;
+            best = nextLiveVertex();
+        }
+        fan = best;
+    }
+    return res;
+}
+
+namespace
+{
+
+// start of every cluster of the cache order that can be moved without losing more than threshold of its ACMR
+std::vector<std::size_t> softClusters(std::span<const int> indices, std::size_t vertexCount, std::span<const std::size_t> hardClusters,
+                                      std::size_t cacheSize, float threshold)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    std::vector<std::size_t> res;
+    // cache entries of an earlier cluster are invalid, so that every cluster starts with an empty cache like after a flush
+    constexpr std::size_t notCached = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> enteredAt(vertexCount, notCached);
+    std::size_t misses = 0, base = 0;
+    auto miss = [&](int v)
+    {
+        std::size_t& entered = enteredAt[v];
+        if (entered == notCached || entered < base || misses - entered >= cacheSize)
+        {
+            entered = misses++;
+            return true;
+        }
+        return false;
+    };
+    for (std::size_t c = 0; c < hardClusters.size(); c++)
+    {
+        std::size_t start = hardClusters[c];
+        std::size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+        base = misses;
+        std::size_t clusterMisses = 0;
+        for (std::size_t t = start; t < end; t++)
+        {
+            clusterMisses += miss(indices[t * 3]) + miss(indices[t * 3 + 1]) + miss(indices[t * 3 + 2]);
+        }
+        float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+        res.push_back(start);
+        base = misses;
+        std::size_t softMisses = 0, softTriangles = 0;
+        for (std::size_t t = start; t < end; t++)
+        {
+            softMisses += miss(indices[t * 3]) + miss(indices[t * 3 + 1]) + miss(indices[t * 3 + 2]);
+            softTriangles++;
+            if (t + 1 < end && float(softMisses) <= clusterThreshold * float(softTriangles))
+            {
+                res.push_back(t + 1);
+                base = misses;
+                softMisses = 0;
+                softTriangles = 0;
+            }
+        }
+    }
+    return res;
+}
+
+} // anonymous namespace
+
+// the linear-speed overdraw ordering of Tipsify: clusters sorted by how far they face away from the center of the mesh
+std::vector<int> optimizeOverdraw(std::span<const int> indices, std::span<const glm::vec3> vertices, std::span<const std::size_t> clusters,
+                                  std::size_t cacheSize, float threshold)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return std::vector<int>(indices.begin(), indices.end());
+    }
+    std::vector<std::size_t> hardClusters(clusters.begin(), clusters.end());
+    if (hardClusters.empty() || hardClusters.front() != 0)
+    {
+        hardClusters.insert(hardClusters.begin(), 0);
+    }
+    std::vector<std::size_t> starts = softClusters(indices, vertices.size(), hardClusters, cacheSize, threshold);
+    std::size_t clusterCount = starts.size();
+
+    // area weighted centroid and normal of every cluster
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (std::size_t c = 0; c < clusterCount; c++)
+    {
+        std::size_t end = c + 1 < clusterCount ? starts[c + 1] : triangleCount;
+        float clusterArea = 0.0f;
+        glm::vec3 average(0.0f);
+        for (std::size_t t = starts[c]; t < end; t++)
+        {
+            glm::vec3 p0 = vertices[indices[t * 3]], p1 = vertices[indices[t * 3 + 1]], p2 = vertices[indices[t * 3 + 2]];
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(n);
+            glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+            centroids[c] += center * area;
+            average += center;
+            normals[c] += n;
+            clusterArea += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += clusterArea;
+        centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : average / float(end - starts[c]);
+    }
+    if (meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<float> sortKeys(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; c++)
+    {
+        float length = glm::length(normals[c]);
+        sortKeys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+    }
+    std::vector<std::size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<int> res;
+    res.reserve(triangleCount * 3);
+    for (std::size_t c : order)
+    {
+        std::size_t end = c + 1 < clusterCount ? starts[c + 1] : triangleCount;
+        res.insert(res.end(), indices.begin() + starts[c] * 3, indices.begin() + end * 3);
+    }
+    return res;
+}
+
+std::size_t buildVertexFetchRemap(std::span<const int> indices, std::size_t vertexCount, std::vector<int>& remap)
+{
+    remap.assign(vertexCount, -1);
+    int next = 0;
+    for (auto idx : indices)
+    {
+        if (remap[idx] < 0)
+        {
+            remap[idx] = next++;
+        }
+    }
+    return std::size_t(next);
+}
+
+std::vector<char> remapVertices(std::span<const char> vertices, std::size_t vertexSize, std::span<const int> remap, std::size_t newVertexCount)
+{
+    std::vector<char> res(newVertexCount * vertexSize);
+    std::size_t vertexCount = std::min(remap.size(), vertices.size() / vertexSize);
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        if (remap[i] >= 0)
+        {
+            std::memcpy(res.data() + std::size_t(remap[i]) * vertexSize, vertices.data() + i * vertexSize, vertexSize);
+        }
+    }
+    return res;
+}
+
+OptimizedMesh optimizeMesh(std::span<const int> indices, std::span<const glm::vec3> vertices, float overdrawThreshold)
+{
+    OptimizedMesh res;
+    std::vector<std::size_t> clusters;
+    std::vector<int> cacheOrder = optimizeVertexCache(indices, vertices.size(), optimizerCacheSize, &clusters);
+    std::vector<int> overdrawOrder = optimizeOverdraw(cacheOrder, vertices, clusters, optimizerCacheSize, overdrawThreshold);
+    res.vertexCount = buildVertexFetchRemap(overdrawOrder, vertices.size(), res.remap);
+    res.indices.resize(overdrawOrder.size());
+    std::transform(overdrawOrder.begin(), overdrawOrder.end(), res.indices.begin(), [&](int idx) { return res.remap[idx]; });
+    return res;
+}
+
+} // namespace Utils
\ No newline at end of file
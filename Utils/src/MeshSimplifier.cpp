@@ -0,0 +1,372 @@
+#include <MeshSimplifier.h>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+namespace Utils
+{
+
+namespace
+{
+
+// sum of weighted squared distances to planes, p^T A p + 2 b.p + c, divided by the total weight
+struct Quadric
+{
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+
+    // plane n.p + d = 0 with unit normal n
+    void addPlane(glm::vec3 n, float d, double w)
+    {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+        b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+        c += w * double(d) * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+        return *this;
+    }
+
+    // mean squared distance of p to the planes
+    double error(glm::vec3 p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                   + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+// triangles around every vertex
+struct Adjacency
+{
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> triangles;
+
+    Adjacency(std::span<const int> indices, std::size_t vertexCount)
+        : offsets(vertexCount + 1, 0)
+        , triangles(indices.size())
+    {
+        for (auto idx : indices)
+        {
+            offsets[idx + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); i++)
+        {
+            triangles[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::span<const std::size_t> around(int v) const
+    {
+        return std::span<const std::size_t>(triangles.data() + offsets[v], offsets[v + 1] - offsets[v]);
+    }
+};
+
+// count of triangles around from that have the directed edge from -> to
+std::size_t directedEdgeCount(const Adjacency& adjacency, std::span<const int> indices, int from, int to)
+{
+    std::size_t count = 0;
+    for (std::size_t t : adjacency.around(from))
+    {
+        for (std::size_t c = 0; c < 3; c++)
+        {
+            count += indices[t * 3 + c] == from && indices[t * 3 + (c + 1) % 3] == to;
+        }
+    }
+    return count;
+}
+
+enum VertexKind : unsigned char
+{
+    ManifoldVertex,     // collapses onto any neighbor
+    BorderVertex,       // collapses along the open border only
+    LockedVertex        // seam, non-manifold or complex border, never collapses
+};
+
+std::vector<VertexKind> classifyVertices(std::span<const int> indices, std::span<const glm::vec3> vertices, const Adjacency& adjacency)
+{
+    std::size_t vertexCount = vertices.size();
+    std::vector<VertexKind> kinds(vertexCount, ManifoldVertex);
+
+    // seams: another vertex at the same position, differing in texture coordinates or normal
+    struct PositionHash
+    {
+        std::size_t operator()(const glm::vec3& p) const
+        {
+            std::uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (std::size_t(bits[0]) * 73856093u) ^ (std::size_t(bits[1]) * 19349663u) ^ (std::size_t(bits[2]) * 83492791u);
+        }
+    };
+    std::unordered_map<glm::vec3, int, PositionHash> firstAt;
+    firstAt.reserve(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++)
+    {
+        auto [it, inserted] = firstAt.try_emplace(vertices[v], int(v));
+        if (!inserted)
+        {
+            kinds[v] = LockedVertex;
+            kinds[it->second] = LockedVertex;
+        }
+    }
+
+    // borders and non-manifold edges
+    std::vector<std::size_t> outgoingBorders(vertexCount, 0), incomingBorders(vertexCount, 0);
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        int from = indices[i], to = indices[i - i % 3 + (i + 1) % 3];
+        std::size_t forward = directedEdgeCount(adjacency, indices, from, to);
+        std::size_t backward = directedEdgeCount(adjacency, indices, to, from);
+        if (forward > 1 || forward + backward > 2)
+        {
+            kinds[from] = LockedVertex;
+            kinds[to] = LockedVertex;
+        }
+        else if (backward == 0)
+        {
+            outgoingBorders[from]++;
+            incomingBorders[to]++;
+        }
+    }
+    for (std::size_t v = 0; v < vertexCount; v++)
+    {
+        if (kinds[v] == ManifoldVertex && (outgoingBorders[v] > 0 || incomingBorders[v] > 0))
+        {
+            kinds[v] = outgoingBorders[v] == 1 && incomingBorders[v] == 1 ? BorderVertex : LockedVertex;
+        }
+    }
+    return kinds;
+}
+
+// planes of the triangles weighted by area, and planes through the border edges perpendicular to their triangle
+std::vector<Quadric> buildQuadrics(std::span<const int> indices, std::span<const glm::vec3> vertices, const Adjacency& adjacency)
+{
+    // borders must hold against the much larger total area of the interior
+    constexpr double borderWeight = 10.0;
+    std::vector<Quadric> quadrics(vertices.size());
+    for (std::size_t t = 0; t < indices.size() / 3; t++)
+    {
+        const int* tri = &indices[t * 3];
+        glm::vec3 p0 = vertices[tri[0]], p1 = vertices[tri[1]], p2 = vertices[tri[2]];
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(n);
+        if (length == 0.0f)
+        {
+            continue;
+        }
+        n /= length;
+        Quadric q;
+        q.addPlane(n, -glm::dot(n, p0), length * 0.5);
+        for (std::size_t c = 0; c < 3; c++)
+        {
+            quadrics[tri[c]] += q;
+        }
+        for (std::size_t c = 0; c < 3; c++)
+        {
+            int from = tri[c], to = tri[(c + 1) % 3];
+            if (directedEdgeCount(adjacency, indices, to, from) > 0)
+            {
+                continue;
+            }
+            glm::vec3 edge = vertices[to] - vertices[from];
+            glm::vec3 m = glm::cross(edge, n);
+            float edgeLength = glm::length(m);
+            if (edgeLength == 0.0f)
+            {
+                continue;
+            }
+            m /= edgeLength;
+            Quadric border;
+            border.addPlane(m, -glm::dot(m, vertices[from]), borderWeight * double(edgeLength) * edgeLength);
+            quadrics[from] += border;
+            quadrics[to] += border;
+        }
+    }
+    return quadrics;
+}
+
+struct Collapse
+{
+    int from = 0;
+    int to = 0;
+    double error = 0.0;
+};
+
+// whether moving from onto to turns any remaining triangle around from over or makes it degenerate
+bool flipsTriangles(std::span<const int> indices, std::span<const glm::vec3> vertices, const Adjacency& adjacency, int from, int to)
+{
+    for (std::size_t t : adjacency.around(from))
+    {
+        const int* tri = &indices[t * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+        {
+            continue; // collapses to nothing
+        }
+        glm::vec3 p[3], moved[3];
+        for (std::size_t c = 0; c < 3; c++)
+        {
+            p[c] = vertices[tri[c]];
+            moved[c] = tri[c] == from ? vertices[to] : p[c];
+        }
+        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+        if (glm::dot(before, after) <= 0.0f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+std::vector<int> simplifyMesh(std::span<const int> indices, std::span<const glm::vec3> vertices, std::size_t targetIndexCount,
+                              float maxError, float* pError)
+{
+    std::size_t vertexCount = vertices.size();
+    std::vector<int> res(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    float resultError = 0.0f;
+    std::vector<VertexKind> kinds;
+    std::vector<Quadric> quadrics;
+    {
+        Adjacency adjacency(res, vertexCount);
+        kinds = classifyVertices(res, vertices, adjacency);
+        quadrics = buildQuadrics(res, vertices, adjacency);
+    }
+    double maxSquaredError = double(maxError) * maxError;
+
+    std::vector<Collapse> collapses;
+    std::vector<int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    while (res.size() > targetIndexCount)
+    {
+        Adjacency adjacency(res, vertexCount);
+
+        // the cheaper direction of every edge that may collapse
+        collapses.clear();
+        for (std::size_t i = 0; i < res.size(); i++)
+        {
+            int a = res[i], b = res[i - i % 3 + (i + 1) % 3];
+            // every interior edge appears in two triangles, take it from one of them only
+            bool border = directedEdgeCount(adjacency, res, b, a) == 0;
+            if (!border && a > b)
+            {
+                continue;
+            }
+            Collapse best{ a, b, -1.0 };
+            for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } })
+            {
+                bool allowed = kinds[from] == ManifoldVertex || (kinds[from] == BorderVertex && border);
+                if (!allowed)
+                {
+                    continue;
+                }
+                double error = quadrics[from].error(vertices[to]);
+                if (best.error < 0.0 || error < best.error)
+                {
+                    best = Collapse{ from, to, error };
+                }
+            }
+            if (best.error >= 0.0 && best.error <= maxSquaredError)
+            {
+                collapses.push_back(best);
+            }
+        }
+        if (collapses.empty())
+        {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.error < r.error; });
+
+        // collapse in order of error, the triangles around a collapsed vertex stay untouched for the rest of the pass
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        std::size_t triangleCount = res.size() / 3;
+        std::size_t targetTriangles = targetIndexCount / 3;
+        std::size_t collapsed = 0;
+        for (const auto& collapse : collapses)
+        {
+            if (triangleCount <= targetTriangles)
+            {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] || flipsTriangles(res, vertices, adjacency, collapse.from, collapse.to))
+            {
+                continue;
+            }
+            for (std::size_t t : adjacency.around(collapse.from))
+            {
+                const int* tri = &res[t * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+                triangleCount -= tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            resultError = std::max(resultError, float(std::sqrt(collapse.error)));
+            collapsed++;
+        }
+        if (collapsed == 0)
+        {
+            break;
+        }
+
+        // drop the triangles that collapsed to an edge
+        std::size_t kept = 0;
+        for (std::size_t t = 0; t < res.size() / 3; t++)
+        {
+            int i0 = remap[res[t * 3]], i1 = remap[res[t * 3 + 1]], i2 = remap[res[t * 3 + 2]];
+            if (i0 != i1 && i1 != i2 && i0 != i2)
+            {
+                res[kept++] = i0;
+                res[kept++] = i1;
+                res[kept++] = i2;
+            }
+        }
+        res.resize(kept);
+    }
+    if (pError)
+    {
+        *pError = resultError;
+    }
+    return res;
+}
+
+std::vector<int> buildLodChain(std::span<const int> indices, std::span<const glm::vec3> vertices, std::vector<MeshLod>& lods,
+                               std::size_t levelCount, float reduction)
+{
+    std::vector<int> res(indices.begin(), indices.end());
+    lods.assign(1, MeshLod{ 0, indices.size(), 0.0f });
+    std::size_t targetIndexCount = indices.size();
+    for (std::size_t level = 1; level < levelCount; level++)
+    {
+        targetIndexCount = std::size_t(float(targetIndexCount / 3) * reduction) * 3;
+        float error = 0.0f;
+        std::vector<int> lod = simplifyMesh(indices, vertices, targetIndexCount, std::numeric_limits<float>::max(), &error);
+        // a level with at least 90% of the triangles before it is not worth it
+        if (lod.empty() || float(lod.size()) > float(lods.back().indexCount) * 0.9f)
+        {
+            break;
+        }
+        lods.push_back(MeshLod{ res.size(), lod.size(), error });
+        res.insert(res.end(), lod.begin(), lod.end());
+    }
+    return res;
+}
+
+} // namespace Utils
\ No newline at end of file
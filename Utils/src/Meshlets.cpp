@@ -0,0 +1,284 @@
+#include <Meshlets.h>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+
+namespace Utils
+{
+
+MeshletCullingStatistics& MeshletCullingStatistics::operator+=(const MeshletCullingStatistics& other)
+{
+    meshlets += other.meshlets;
+    outsideFrustum += other.outsideFrustum;
+    backFacing += other.backFacing;
+    visibleTriangles += other.visibleTriangles;
+    ranges += other.ranges;
+    return *this;
+}
+
+namespace
+{
+
+// bounding sphere around the center of the bounding box, and the normal cone of the triangles (Zeux, meshoptimizer)
+void computeMeshletBounds(Meshlet& meshlet, std::span<const std::size_t> triangles, std::span<const int> meshletVertices,
+                          std::span<const int> indices, std::span<const glm::vec3> vertices, std::span<const glm::vec3> normals)
+{
+    glm::vec3 minCorner = vertices[meshletVertices[0]], maxCorner = minCorner;
+    for (int v : meshletVertices)
+    {
+        minCorner = glm::min(minCorner, vertices[v]);
+        maxCorner = glm::max(maxCorner, vertices[v]);
+    }
+    meshlet.center = (minCorner + maxCorner) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (int v : meshletVertices)
+    {
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[v] - meshlet.center));
+    }
+
+    // degenerate triangles have zero normals and face nowhere
+    glm::vec3 axis(0.0f);
+    for (std::size_t t : triangles)
+    {
+        axis += normals[t];
+    }
+    float length = glm::length(axis);
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneCutoff = 1.0f;
+    if (length == 0.0f)
+    {
+        return;
+    }
+    axis /= length;
+    meshlet.coneAxis = axis;
+    float minDot = 1.0f;
+    for (std::size_t t : triangles)
+    {
+        if (normals[t] != glm::vec3(0.0f))
+        {
+            minDot = std::min(minDot, glm::dot(axis, normals[t]));
+        }
+    }
+    // a cone wider than about 170 degrees hardly ever culls anything
+    if (minDot <= 0.1f)
+    {
+        return;
+    }
+    // the apex is behind the planes of all triangles, seen from an eye inside the cone they are all back facing
+    float maxOffset = 0.0f;
+    for (std::size_t t : triangles)
+    {
+        if (normals[t] != glm::vec3(0.0f))
+        {
+            glm::vec3 p0 = vertices[indices[t * 3]];
+            maxOffset = std::max(maxOffset, glm::dot(meshlet.center - p0, normals[t]) / glm::dot(axis, normals[t]));
+        }
+    }
+    meshlet.coneApex = meshlet.center - axis * maxOffset;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+} // anonymous namespace
+
+std::vector<int> buildMeshlets(std::span<const int> indices, std::span<const glm::vec3> vertices, std::vector<Meshlet>& meshlets,
+                               std::size_t maxVertices, std::size_t maxTriangles)
+{
+    meshlets.clear();
+    std::size_t triangleCount = indices.size() / 3;
+    std::size_t vertexCount = vertices.size();
+    std::vector<int> res;
+    res.reserve(triangleCount * 3);
+    maxVertices = std::max<std::size_t>(maxVertices, 3);
+    maxTriangles = std::max<std::size_t>(maxTriangles, 1);
+
+    // triangles adjacent to every vertex
+    std::vector<std::size_t> offsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < triangleCount * 3; i++)
+    {
+        offsets[indices[i] + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<std::size_t> adjacency(triangleCount * 3);
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < triangleCount * 3; i++)
+    {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<glm::vec3> normals(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        glm::vec3 p0 = vertices[indices[t * 3]], p1 = vertices[indices[t * 3 + 1]], p2 = vertices[indices[t * 3 + 2]];
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(n);
+        normals[t] = area > 0.0f ? n / area : glm::vec3(0.0f);
+    }
+
+    // the meshlet a vertex was last added to
+    constexpr std::size_t noMeshlet = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> vertexMeshlet(vertexCount, noMeshlet);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<std::size_t> triangles;
+    std::vector<int> meshletVertices;
+    std::size_t cursor = 0;
+    while (true)
+    {
+        while (cursor < triangleCount && emitted[cursor])
+        {
+            cursor++;
+        }
+        if (cursor == triangleCount)
+        {
+            break;
+        }
+        std::size_t id = meshlets.size();
+        triangles.clear();
+        meshletVertices.clear();
+        glm::vec3 normalSum(0.0f);
+
+        auto newVertexCount = [&](std::size_t t)
+        {
+            int a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+            return std::size_t(vertexMeshlet[a] != id) + std::size_t(b != a && vertexMeshlet[b] != id) +
+                   std::size_t(c != a && c != b && vertexMeshlet[c] != id);
+        };
+        auto add = [&](std::size_t t)
+        {
+            emitted[t] = true;
+            triangles.push_back(t);
+            for (std::size_t c = 0; c < 3; c++)
+            {
+                int v = indices[t * 3 + c];
+                if (vertexMeshlet[v] != id)
+                {
+                    vertexMeshlet[v] = id;
+                    meshletVertices.push_back(v);
+                }
+            }
+            normalSum += normals[t];
+        };
+
+        add(cursor);
+        std::size_t last = cursor;
+        while (triangles.size() < maxTriangles)
+        {
+            // the remaining neighbour that adds the fewest vertices, then the one closest to the average direction
+            std::size_t best = triangleCount, bestNew = 4;
+            float bestDot = -2.0f;
+            float length = glm::length(normalSum);
+            glm::vec3 axis = length > 0.0f ? normalSum / length : glm::vec3(0.0f);
+            auto consider = [&](int v)
+            {
+                for (std::size_t k = offsets[v]; k < offsets[v + 1]; k++)
+                {
+                    std::size_t t = adjacency[k];
+                    if (emitted[t])
+                    {
+                        continue;
+                    }
+                    std::size_t added = newVertexCount(t);
+                    if (meshletVertices.size() + added > maxVertices)
+                    {
+                        continue;
+                    }
+                    float d = glm::dot(normals[t], axis);
+                    if (added < bestNew || (added == bestNew && d > bestDot))
+                    {
+                        best = t;
+                        bestNew = added;
+                        bestDot = d;
+                    }
+                }
+            };
+            // neighbours of the last triangle first, the whole border of the meshlet at a dead end
+            for (std::size_t c = 0; c < 3; c++)
+            {
+                consider(indices[last * 3 + c]);
+            }
+            if (best == triangleCount)
+            {
+                for (std::size_t i = 0; i < meshletVertices.size(); i++)
+                {
+                    consider(meshletVertices[i]);
+                }
+            }
+            if (best == triangleCount)
+            {
+                break;
+            }
+            add(best);
+            last = best;
+        }
+
+        std::sort(triangles.begin(), triangles.end());
+        Meshlet meshlet;
+        meshlet.firstIndex = res.size();
+        meshlet.indexCount = triangles.size() * 3;
+        meshlet.vertexCount = meshletVertices.size();
+        for (std::size_t t : triangles)
+        {
+            res.insert(res.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+        }
+        computeMeshletBounds(meshlet, triangles, meshletVertices, indices, vertices, normals);
+        meshlets.push_back(meshlet);
+    }
+    return res;
+}
+
+bool isMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, glm::vec3 eye, bool backFaceCulling, MeshletCullingStatistics* pStats)
+{
+    MeshletCullingStatistics stats;
+    stats.meshlets = 1;
+    bool visible = true;
+    if (!frustum.intersectsSphere(meshlet.center, meshlet.radius))
+    {
+        stats.outsideFrustum = 1;
+        visible = false;
+    }
+    else if (backFaceCulling && meshlet.coneCutoff < 1.0f)
+    {
+        glm::vec3 direction = meshlet.coneApex - eye;
+        if (glm::dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(direction))
+        {
+            stats.backFacing = 1;
+            visible = false;
+        }
+    }
+    if (visible)
+    {
+        stats.visibleTriangles = meshlet.indexCount / 3;
+    }
+    if (pStats)
+    {
+        *pStats += stats;
+    }
+    return visible;
+}
+
+void cullMeshlets(std::span<const Meshlet> meshlets, const Frustum& frustum, glm::vec3 eye, bool backFaceCulling,
+                  std::vector<IndexRange>& ranges, MeshletCullingStatistics* pStats)
+{
+    ranges.clear();
+    for (const auto& meshlet : meshlets)
+    {
+        if (!isMeshletVisible(meshlet, frustum, eye, backFaceCulling, pStats))
+        {
+            continue;
+        }
+        if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex)
+        {
+            ranges.back().indexCount += meshlet.indexCount;
+        }
+        else
+        {
+            ranges.push_back(IndexRange{ meshlet.firstIndex, meshlet.indexCount });
+        }
+    }
+    if (pStats)
+    {
+        pStats->ranges += ranges.size();
+    }
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -100,5 +100,35 @@ std::vector<glm::vec3> Model::getTTangents()
     throw NotImplementedFunction("Model::getTTangents");
 }
 
+std::span<const int> Model::getIndicesView()
+{
+    return {};
+}
+
+std::span<const glm::vec3> Model::getVerticesView()
+{
+    return {};
+}
+
+std::span<const glm::vec2> Model::getTexCoordsView()
+{
+    return {};
+}
+
+std::span<const glm::vec3> Model::getNormalsView()
+{
+    return {};
+}
+
+std::span<const glm::vec3> Model::getSTangentsView()
+{
+    return {};
+}
+
+std::span<const glm::vec3> Model::getTTangentsView()
+{
+    return {};
+}
+
 
 } // namespace Utils
\ No newline at end of file
@@ -27,7 +27,7 @@ Plane::Plane(float y, float width, float texWidth, int prec)
             m_texCoords[i * (prec + 1) + j] = glm::vec2(texX + texWidth/prec*j, texZ + texWidth/prec*i);
             m_normals[i * (prec + 1) + j] = glm::vec3(0.0f, 1.0f, 0.0f);
             m_sTangents[i * (prec + 1) + j] = glm::vec3(1.0f, 0.0f, 0.0f);
-            m_sTangents[i * (prec + 1) + j] = glm::vec3(0.0f, 0.0f, 1.0f);
+            m_tTangents[i * (prec + 1) + j] = glm::vec3(0.0f, 0.0f, 1.0f);
         }
     }
     for (int i = 0; i < prec; i++)
@@ -67,66 +67,27 @@ bool Plane::supplyTangents()
 
 std::vector<float> Plane::getVerticesArray()
 {
-    std::vector<float> verticesVec;
-    verticesVec.reserve(m_indices.size() * 3);
-    for (std::size_t i = 0; i < m_indices.size(); ++i)
-    {
-        verticesVec.push_back(m_vertices[m_indices[i]].x);
-        verticesVec.push_back(m_vertices[m_indices[i]].y);
-        verticesVec.push_back(m_vertices[m_indices[i]].z);
-    }
-    return verticesVec;
+    return deindex<glm::vec3>(m_indices, m_vertices);
 }
 
 std::vector<float> Plane::getTexCoordsArray()
 {
-    std::vector<float> texCoordsVec;
-    texCoordsVec.reserve(m_indices.size() * 2);
-    for (std::size_t i = 0; i < m_indices.size(); ++i)
-    {
-        texCoordsVec.push_back(m_texCoords[m_indices[i]].s);
-        texCoordsVec.push_back(m_texCoords[m_indices[i]].t);
-    }
-    return texCoordsVec;
+    return deindex<glm::vec2>(m_indices, m_texCoords);
 }
 
 std::vector<float> Plane::getNormalsArray()
 {
-    std::vector<float> normalsVec;
-    normalsVec.reserve(m_indices.size() * 3);
-    for (std::size_t i = 0; i < m_indices.size(); ++i)
-    {
-        normalsVec.push_back(m_normals[m_indices[i]].x);
-        normalsVec.push_back(m_normals[m_indices[i]].y);
-        normalsVec.push_back(m_normals[m_indices[i]].z);
-    }
-    return normalsVec;
+    return deindex<glm::vec3>(m_indices, m_normals);
 }
 
 std::vector<float> Plane::getSTangentsArray()
 {
-    std::vector<float> tangentsVec;
-    tangentsVec.reserve(m_indices.size() * 3);
-    for (std::size_t i = 0; i < m_indices.size(); ++i)
-    {
-        tangentsVec.push_back(m_sTangents[m_indices[i]].x);
-        tangentsVec.push_back(m_sTangents[m_indices[i]].y);
-        tangentsVec.push_back(m_sTangents[m_indices[i]].z);
-    }
-    return tangentsVec;
+    return deindex<glm::vec3>(m_indices, m_sTangents);
 }
 
 std::vector<float> Plane::getTTangentsArray()
 {
-    std::vector<float> tangentsVec;
-    tangentsVec.reserve(m_indices.size() * 3);
-    for (std::size_t i = 0; i < m_indices.size(); ++i)
-    {
-        tangentsVec.push_back(m_tTangents[m_indices[i]].x);
-        tangentsVec.push_back(m_tTangents[m_indices[i]].y);
-        tangentsVec.push_back(m_tTangents[m_indices[i]].z);
-    }
-    return tangentsVec;
+    return deindex<glm::vec3>(m_indices, m_tTangents);
 }
 
 // match with glDrawElements
@@ -166,4 +127,34 @@ std::vector<glm::vec3> Plane::getTTangents()
     return m_tTangents;
 }
 
+std::span<const int> Plane::getIndicesView()
+{
+    return m_indices;
+}
+
+std::span<const glm::vec3> Plane::getVerticesView()
+{
+    return m_vertices;
+}
+
+std::span<const glm::vec2> Plane::getTexCoordsView()
+{
+    return m_texCoords;
+}
+
+std::span<const glm::vec3> Plane::getNormalsView()
+{
+    return m_normals;
+}
+
+std::span<const glm::vec3> Plane::getSTangentsView()
+{
+    return m_sTangents;
+}
+
+std::span<const glm::vec3> Plane::getTTangentsView()
+{
+    return m_tTangents;
+}
+
 } // namespace Utils
@@ -0,0 +1,226 @@
+#include <ProgramBinaryCache.h>
+#include <MeshCache.h>
+#include <Logger.h>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <format>
+
+namespace Utils
+{
+
+namespace
+{
+
+struct ProgramCacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    GLenum binaryFormat;
+    // the whole key is not stored, its size and hash tell a hash collision of the file name from a match
+    std::uint64_t keySize;
+    std::uint64_t keyHash;
+    std::uint64_t binarySize;
+};
+
+constexpr char cacheMagic[8] = { 'L', 'O', 'G', 'L', 'P', 'R', 'O', 'G' };
+
+std::string_view glString(GLenum name)
+{
+    const GLubyte* pString = glGetString(name);
+    return pString ? std::string_view(reinterpret_cast<const char*>(pString)) : std::string_view();
+}
+
+bool supportsBinaryFormat(GLenum format)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    std::vector<GLint> formats(std::size_t(std::max(count, 0)));
+    if (count > 0)
+    {
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+    }
+    return std::find(formats.begin(), formats.end(), GLint(format)) != formats.end();
+}
+
+} // anonymous namespace
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path directory)
+    : m_Directory(std::move(directory))
+{
+}
+
+void ProgramBinaryCache::setDirectory(std::filesystem::path directory)
+{
+    m_Directory = std::move(directory);
+}
+
+const std::filesystem::path& ProgramBinaryCache::getDirectory() const
+{
+    return m_Directory;
+}
+
+bool ProgramBinaryCache::isEnabled() const
+{
+    if (m_Directory.empty())
+    {
+        return false;
+    }
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    return count > 0;
+}
+
+std::string ProgramBinaryCache::makeKey(std::span<const ProgramStage> stages) const
+{
+    std::string key;
+    for (const auto& stage : stages)
+    {
+        key.append(std::format("{:X}", stage.type)).push_back('\0');
+        key.append(stage.source).push_back('\0');
+    }
+    key.append(glString(GL_VENDOR)).push_back('\0');
+    key.append(glString(GL_RENDERER)).push_back('\0');
+    key.append(glString(GL_VERSION));
+    return key;
+}
+
+std::filesystem::path ProgramBinaryCache::makePath(std::uint64_t keyHash) const
+{
+    return m_Directory / std::format("{:016x}.bin", keyHash);
+}
+
+GLuint ProgramBinaryCache::load(std::span<const ProgramStage> stages)
+{
+    if (!isEnabled())
+    {
+        return 0;
+    }
+    std::string key = makeKey(stages);
+    std::uint64_t keyHash = MeshCache::hashBytes(key.data(), key.size());
+    std::filesystem::path path = makePath(keyHash);
+    std::ifstream fin(path, std::ios::binary);
+    // a truncated file must not make the binary read past its end
+    std::error_code ec;
+    std::uintmax_t fileSize = std::filesystem::file_size(path, ec);
+    ProgramCacheHeader header{};
+    if (!fin || !fin.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0
+        || header.version != version || header.keySize != key.size() || header.keyHash != keyHash
+        || ec || header.binarySize != fileSize - sizeof(header))
+    {
+        m_Stats.misses++;
+        return 0;
+    }
+    std::vector<char> binary(std::size_t(header.binarySize));
+    if (!fin.read(binary.data(), std::streamsize(binary.size())) || !supportsBinaryFormat(header.binaryFormat))
+    {
+        m_Stats.misses++;
+        return 0;
+    }
+    fin.close();
+
+    // the driver may reject a binary of its own, e.g. after an update that kept the version string, link fails then
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), GLsizei(binary.size()));
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+    {
+        Logger::globalLogger().debug(std::format("Program binary {} was rejected by the driver, compiling from source.", path.string()));
+        glDeleteProgram(program);
+        std::filesystem::remove(path, ec);
+        m_Stats.rejected++;
+        return 0;
+    }
+    m_Stats.hits++;
+    return program;
+}
+
+bool ProgramBinaryCache::store(GLuint program, std::span<const ProgramStage> stages)
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return false;
+    }
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    binary.resize(std::size_t(length));
+
+    std::string key = makeKey(stages);
+    ProgramCacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = version;
+    header.binaryFormat = format;
+    header.keySize = key.size();
+    header.keyHash = MeshCache::hashBytes(key.data(), key.size());
+    header.binarySize = binary.size();
+
+    // written to a temporary file and renamed as MeshCache, another process never reads a partial binary
+    std::error_code ec;
+    std::filesystem::create_directories(m_Directory, ec);
+    std::filesystem::path path = makePath(header.keyHash);
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if (!fout)
+        {
+            Logger::globalLogger().debug(std::format("Could not write program binary {}.", tempPath.string()));
+            return false;
+        }
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(binary.data(), std::streamsize(binary.size()));
+        if (!fout.flush())
+        {
+            fout.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    m_Stats.stored++;
+    return true;
+}
+
+void ProgramBinaryCache::clear()
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_Directory, ec))
+    {
+        if (entry.path().extension() == ".bin")
+        {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+const ProgramCacheStatistics& ProgramBinaryCache::getStatistics() const
+{
+    return m_Stats;
+}
+
+ProgramBinaryCache& ProgramBinaryCache::globalCache()
+{
+    static ProgramBinaryCache cache = []()
+    {
+        std::error_code ec;
+        std::filesystem::path directory = std::filesystem::temp_directory_path(ec);
+        return ProgramBinaryCache(ec ? std::filesystem::path() : directory / "LearnOpenGL-program-cache");
+    }();
+    return cache;
+}
+
+} // namespace Utils
\ No newline at end of file
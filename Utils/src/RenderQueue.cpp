@@ -0,0 +1,153 @@
+#include <RenderQueue.h>
+#include <bit>
+#include <algorithm>
+
+namespace Utils
+{
+
+namespace
+{
+
+constexpr unsigned programBits = 8;
+constexpr unsigned textureBits = 14;
+constexpr unsigned materialBits = 12;
+constexpr unsigned depthBits = 20;
+constexpr unsigned vaoBits = 10;
+static_assert(programBits + textureBits + materialBits + depthBits + vaoBits == 64);
+constexpr unsigned vaoShift = 0;
+constexpr unsigned depthShift = vaoShift + vaoBits;
+constexpr unsigned materialShift = depthShift + depthBits;
+constexpr unsigned textureShift = materialShift + materialBits;
+constexpr unsigned programShift = textureShift + textureBits;
+
+constexpr std::uint64_t fieldMask(unsigned bits)
+{
+    return (std::uint64_t(1) << bits) - 1;
+}
+
+// rank of the first add of the key this frame, clamped to the width of its field
+template<typename Map, typename Key>
+std::uint32_t rankOf(Map& ranks, const Key& key, unsigned bits)
+{
+    std::uint32_t rank = ranks.emplace(key, std::uint32_t(ranks.size())).first->second;
+    return std::uint32_t(std::min<std::uint64_t>(rank, fieldMask(bits)));
+}
+
+// stable, one histogram pass over all 8 bytes and one scatter pass per byte that is not the same in all keys
+void radixSort(std::vector<RenderItem>& items, std::vector<RenderItem>& scratch)
+{
+    std::size_t n = items.size();
+    std::array<std::array<std::size_t, 256>, 8> histograms{};
+    for (const auto& item : items)
+    {
+        for (unsigned b = 0; b < 8; b++)
+        {
+            histograms[b][(item.key >> (b * 8)) & 0xFF]++;
+        }
+    }
+    scratch.resize(n);
+    for (unsigned b = 0; b < 8; b++)
+    {
+        auto& histogram = histograms[b];
+        if (histogram[(items[0].key >> (b * 8)) & 0xFF] == n)
+        {
+            continue;
+        }
+        std::size_t offset = 0;
+        for (auto& count : histogram)
+        {
+            std::size_t c = count;
+            count = offset;
+            offset += c;
+        }
+        for (const auto& item : items)
+        {
+            scratch[histogram[(item.key >> (b * 8)) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
+
+// switches of program and texture set along the items
+void countSwitches(const std::vector<RenderItem>& items, std::size_t& programSwitches, std::size_t& textureSwitches)
+{
+    programSwitches = 0;
+    textureSwitches = 0;
+    for (std::size_t i = 0; i < items.size(); i++)
+    {
+        std::uint32_t program = RenderQueue::getProgramRank(items[i].key);
+        std::uint32_t textures = RenderQueue::getTextureRank(items[i].key);
+        if (i == 0 || program != RenderQueue::getProgramRank(items[i - 1].key))
+        {
+            programSwitches++;
+        }
+        if (i == 0 || textures != RenderQueue::getTextureRank(items[i - 1].key))
+        {
+            textureSwitches++;
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::uint64_t RenderQueue::makeKey(std::uint32_t programRank, std::uint32_t textureRank, std::uint32_t materialRank, float depth, std::uint32_t vaoRank)
+{
+    // the bits of a non-negative float grow with its value, the highest ones (the sign bit is 0) are a coarse depth
+    std::uint32_t depthBitsValue = std::bit_cast<std::uint32_t>(depth > 0.0f ? depth : 0.0f) >> (31 - depthBits);
+    return (std::uint64_t(programRank) & fieldMask(programBits)) << programShift
+         | (std::uint64_t(textureRank) & fieldMask(textureBits)) << textureShift
+         | (std::uint64_t(materialRank) & fieldMask(materialBits)) << materialShift
+         | (std::uint64_t(depthBitsValue) & fieldMask(depthBits)) << depthShift
+         | (std::uint64_t(vaoRank) & fieldMask(vaoBits)) << vaoShift;
+}
+
+std::uint32_t RenderQueue::getProgramRank(std::uint64_t key)
+{
+    return std::uint32_t((key >> programShift) & fieldMask(programBits));
+}
+
+std::uint32_t RenderQueue::getTextureRank(std::uint64_t key)
+{
+    return std::uint32_t((key >> textureShift) & fieldMask(textureBits));
+}
+
+void RenderQueue::clear()
+{
+    m_Items.clear();
+    m_ProgramRanks.clear();
+    m_TextureRanks.clear();
+    m_MaterialRanks.clear();
+    m_VaoRanks.clear();
+}
+
+void RenderQueue::add(std::uint32_t index, GLuint program, const RenderTextureSet& textures, const void* material, GLuint vao, float depth)
+{
+    std::uint64_t key = makeKey(rankOf(m_ProgramRanks, program, programBits), rankOf(m_TextureRanks, textures, textureBits),
+                                rankOf(m_MaterialRanks, material, materialBits), depth, rankOf(m_VaoRanks, vao, vaoBits));
+    m_Items.push_back(RenderItem{ key, index });
+}
+
+void RenderQueue::sort()
+{
+    m_Stats = RenderQueueStatistics{};
+    m_Stats.draws = m_Items.size();
+    if (m_Items.empty())
+    {
+        return;
+    }
+    countSwitches(m_Items, m_Stats.unsortedProgramSwitches, m_Stats.unsortedTextureSwitches);
+    radixSort(m_Items, m_Scratch);
+    countSwitches(m_Items, m_Stats.programSwitches, m_Stats.textureSwitches);
+}
+
+const std::vector<RenderItem>& RenderQueue::getItems() const
+{
+    return m_Items;
+}
+
+const RenderQueueStatistics& RenderQueue::getStatistics() const
+{
+    return m_Stats;
+}
+
+} // namespace Utils
\ No newline at end of file
@@ -5,11 +5,21 @@
 #include <utility>
 #include <format>
 #include <Utils.h>
+#include <ThreadPool.h>
+#include <VertexQuantization.h>
+#include <MeshOptimizer.h>
+#include <MeshSimplifier.h>
+#include <Meshlets.h>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
 
 namespace Utils
 {
 
 // predefined shader sources
+// the programs that draw models (and the shadow depth program) are also compiled with INSTANCED for instanced models,
+// the transforms of the instances are read from InstanceBuffer by gl_InstanceID
 // ================================ xyz axises ================================
 const char* axisesVertexShader = R"glsl(
 #version 430
@@ -53,13 +63,75 @@ void main(void)
 // ================================ pure color ================================ 
 const char* pureColorVertexShader = R"glsl(
 #version 430
+#if defined(MULTI_DRAW) && defined(SHADER_DRAW_PARAMETERS)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 layout (location = 0) in vec3 position; // the vertex array buffer
 uniform mat4 mvMatrix;
 uniform mat4 projMatrix;
 uniform vec4 inputColor;
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef INSTANCED
+flat out vec4 instanceColor;
+#endif
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+#ifdef SHADER_DRAW_PARAMETERS
+uniform uint firstDraw; // index of the parameters of the first draw of the call
+#define DRAW_ID (firstDraw + uint(gl_DrawIDARB))
+#else
+layout (location = 5) in uint drawIndex; // the baseInstance of the draw
+#define DRAW_ID drawIndex
+#endif
+flat out vec4 drawColor;
+// the uniforms below come from the parameters of the draw
+#define mvMatrix draws[DRAW_ID].mvMatrix
+#endif
 void main(void)
 {
-    gl_Position = projMatrix * mvMatrix * vec4(position, 1.0);
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+#endif
+    gl_Position = projMatrix * modelViewMatrix * vec4(position, 1.0);
+#ifdef INSTANCED
+    instanceColor = instances[gl_InstanceID].color;
+#endif
+#ifdef MULTI_DRAW
+    drawColor = draws[DRAW_ID].color;
+#endif
 }
 )glsl";
 
@@ -68,23 +140,87 @@ const char* pureColorFragmentShader = R"glsl(
 uniform mat4 mvMatrix;
 uniform mat4 projMatrix;
 uniform vec4 inputColor; // render to the input color
+#ifdef INSTANCED
+flat in vec4 instanceColor; // the color of the instance instead
+#endif
+#ifdef MULTI_DRAW
+flat in vec4 drawColor; // the color of the draw instead
+#endif
 out vec4 color;
 void main(void)
 {
+#ifdef INSTANCED
+    color = instanceColor;
+#elif defined(MULTI_DRAW)
+    color = drawColor;
+#else
     color = inputColor;
+#endif
 }
 )glsl";
 
 // ================================ varying color ================================ 
 const char* varyingColorVertexShader = R"glsl(
 #version 430
+#if defined(MULTI_DRAW) && defined(SHADER_DRAW_PARAMETERS)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 layout (location = 0) in vec3 position; // the vertex array buffer
 uniform mat4 mvMatrix;
 uniform mat4 projMatrix;
 out vec4 varyingColor;
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+#ifdef SHADER_DRAW_PARAMETERS
+uniform uint firstDraw; // index of the parameters of the first draw of the call
+#define DRAW_ID (firstDraw + uint(gl_DrawIDARB))
+#else
+layout (location = 5) in uint drawIndex; // the baseInstance of the draw
+#define DRAW_ID drawIndex
+#endif
+// the uniforms below come from the parameters of the draw
+#define mvMatrix draws[DRAW_ID].mvMatrix
+#endif
 void main(void)
 {
-    gl_Position = projMatrix * mvMatrix * vec4(position, 1.0);
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+#endif
+    gl_Position = projMatrix * modelViewMatrix * vec4(position, 1.0);
     varyingColor = vec4(position, 1.0) * 0.5 + vec4(0.5, 0.5, 0.5, 0.5);
 }
 )glsl";
@@ -104,15 +240,67 @@ void main(void)
 // ================================ texture ================================ 
 const char* textureVertexShader = R"glsl(
 #version 430
+#if defined(MULTI_DRAW) && defined(SHADER_DRAW_PARAMETERS)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 layout (location = 0) in vec3 position;     // the model vertex buffer
 layout (location = 1) in vec2 textureCoord;  // the texture vertex buffer
 uniform mat4 mvMatrix;
 uniform mat4 projMatrix;
 layout (binding = 0) uniform sampler2D samp; // always texture unit 0
 out vec2 tc; // texture coordinates output
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+#ifdef SHADER_DRAW_PARAMETERS
+uniform uint firstDraw; // index of the parameters of the first draw of the call
+#define DRAW_ID (firstDraw + uint(gl_DrawIDARB))
+#else
+layout (location = 5) in uint drawIndex; // the baseInstance of the draw
+#define DRAW_ID drawIndex
+#endif
+// the uniforms below come from the parameters of the draw
+#define mvMatrix draws[DRAW_ID].mvMatrix
+#endif
 void main(void)
 {
-    gl_Position = projMatrix * mvMatrix * vec4(position, 1.0);
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+#endif
+    gl_Position = projMatrix * modelViewMatrix * vec4(position, 1.0);
     tc = textureCoord;
 }
 )glsl";
@@ -131,12 +319,17 @@ void main()
 )glsl";
 
 // ================================ Gouraud shading with lighting & material & texture ================================ 
+// features, defined by the Renderer for every program variant:
+// FLAT_SHADING, OCT_NORMALS (normals are octahedral encoded in x and y, quantized model),
+// DIRECTIONAL_LIGHTS, POINT_LIGHTS, SPOT_LIGHTS (the scene has lights of that kind), INSTANCED (transforms and materials per instance),
+// MULTI_DRAW (transforms and materials per draw of a multi-draw call, never with INSTANCED)
 const char* GouraudLightingMaterialTextureVertexShader = R"glsl(
 #version 430
-// different max light numbers, must be same as the number in the Renderer class !
-#define MAX_POINT_LIGHT_SIZE 5
+#if defined(MULTI_DRAW) && defined(SHADER_DRAW_PARAMETERS)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+// max directional light number, must be same as the number in the Renderer class !
 #define MAX_DIRECTIONAL_LIGHT_SIZE 5
-#define MAX_SPOT_LIGHT_SIZE 5
 struct DirectionalLight
 {
     vec4 ambient;
@@ -154,6 +347,8 @@ struct PointLight
     float constant;
     float linear;
     float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
 };
 struct SpotLight
 {
@@ -161,9 +356,11 @@ struct SpotLight
     vec4 diffuse;
     vec4 specular;
     vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
     vec3 direction; // in view space
     float cutOffAngle;
     float strengthFactorExponent;
+    float range;
 };
 struct Material
 {
@@ -177,34 +374,149 @@ layout (location = 1) in vec2 textureCoord;      // texture coordinates
 layout (location = 2) in vec3 vertexNormal;     // normals of vertices
 // texture sampler
 layout (binding = 0) uniform sampler2D samp;
-// lights
-uniform vec4 globalAmbient;
-uniform uint directionalLightsSize;
-uniform uint pointLightsSize;
-uniform uint spotLightsSize;
-uniform DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
-uniform PointLight pointLights[MAX_POINT_LIGHT_SIZE];
-uniform SpotLight spotLights[MAX_SPOT_LIGHT_SIZE];
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef INSTANCED
+flat out uint varyingMaterialIndex;
+#endif
+// global ambient and directional lights in view space, filled once per frame, the layout must be same as LightBlock in the Renderer class !
+layout (std140, binding = 1) uniform LightBlock
+{
+    vec4 globalAmbient;
+    uint directionalLightsSize;
+    uint pointLightsSize;
+    uint spotLightsSize;
+    uint shadowsSize;   // the first shadowsSize lights (directional, point, spot) have a shadow texture
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
+};
+// point and spot lights in view space, filled once per frame, the layouts must be same as in the Renderer class !
+layout (std430, binding = 0) readonly buffer PointLightBuffer
+{
+    PointLight pointLights[];
+};
+layout (std430, binding = 1) readonly buffer SpotLightBuffer
+{
+    SpotLight spotLights[];
+};
 // material
 uniform Material material;
+#ifdef INSTANCED
+// materials the instances select by index, the layout must be same as MaterialStd430 in the Renderer class !
+layout (std430, binding = 7) readonly buffer InstanceMaterialBuffer
+{
+    Material instanceMaterials[];
+};
+uniform uint instanceMaterialsSize;
+Material instanceMaterial;
+// the material of the model for indices past the materials of the instances
+void selectInstanceMaterial(uint index)
+{
+    if (index < instanceMaterialsSize)
+    {
+        instanceMaterial = instanceMaterials[index];
+    }
+    else
+    {
+        instanceMaterial = material;
+    }
+}
+// the lighting below uses the material of the instance
+#define material instanceMaterial
+#endif
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 // matrices
 uniform mat4 mvMatrix;      // model-view matrix
-uniform mat4 projMatrix;    // projection matrix
 uniform mat4 normMatrix;    // for transformation of normal vector
-uniform int flatShading;    // flat shading or not
 // material and texture weight
 uniform float materialWeight;
 uniform float textureWeight;
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+#ifdef SHADER_DRAW_PARAMETERS
+uniform uint firstDraw; // index of the parameters of the first draw of the call
+#define DRAW_ID (firstDraw + uint(gl_DrawIDARB))
+#else
+layout (location = 5) in uint drawIndex; // the baseInstance of the draw
+#define DRAW_ID drawIndex
+#endif
+flat out uint varyingDrawId;
+// the uniforms below come from the parameters of the draw
+#define mvMatrix draws[DRAW_ID].mvMatrix
+#define normMatrix draws[DRAW_ID].normMatrix
+Material drawMaterial;
+#define material drawMaterial
+#endif
+
+// unit vector of the octahedral encoding
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+vec3 decodeDirection(vec3 v)
+{
+#ifdef OCT_NORMALS
+    return octDecode(v.xy);
+#else
+    return v;
+#endif
+}
 
-out vec3 ambient;
-out vec3 diffuse;
-out vec3 materialSpecular;
-out vec3 textureSpecular;
-
-flat out vec3 flatAmbient;
-flat out vec3 flatDiffuse;
-flat out vec3 flatMaterialSpecular;
-flat out vec3 flatTextureSpecular;
+// flat shading takes the lighting of the provoking vertex, Gouraud shading interpolates it
+#ifdef FLAT_SHADING
+#define SHADING_INTERPOLATION flat
+#else
+#define SHADING_INTERPOLATION
+#endif
+SHADING_INTERPOLATION out vec3 ambient;
+SHADING_INTERPOLATION out vec3 diffuse;
+SHADING_INTERPOLATION out vec3 materialSpecular;
+SHADING_INTERPOLATION out vec3 textureSpecular;
 
 out vec2 tc;
 
@@ -241,8 +553,12 @@ void calculatePointLight(PointLight light, vec3 P, vec3 N)
     vec3 V = normalize(-P);
     // reflect vector
     vec3 R = reflect(-L, N);
-    // attenuation factor
+    // attenuation factor, negligible out of range
     float distance = length(light.location - P);
+    if (distance > light.range)
+    {
+        return;
+    }
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
     // the ADS weight of vertex
     ambient += light.ambient.xyz * attenuation;
@@ -275,6 +591,22 @@ void calculateSpotLight(SpotLight light, vec3 P, vec3 N)
 
 void main()
 {
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+    mat4 normalMatrix = normMatrix * instances[gl_InstanceID].normalMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+    mat4 normalMatrix = normMatrix;
+#endif
+#ifdef INSTANCED
+    selectInstanceMaterial(instances[gl_InstanceID].materialIndex);
+    varyingMaterialIndex = instances[gl_InstanceID].materialIndex;
+#endif
+#ifdef MULTI_DRAW
+    drawMaterial = Material(draws[DRAW_ID].materialAmbient, draws[DRAW_ID].materialDiffuse, draws[DRAW_ID].materialSpecular,
+                            draws[DRAW_ID].materialShininess);
+    varyingDrawId = DRAW_ID;
+#endif
     // initialization
     ambient = vec3(0.0, 0.0, 0.0);
     diffuse = vec3(0.0, 0.0, 0.0);
@@ -282,36 +614,33 @@ void main()
     textureSpecular = vec3(0.0, 0.0, 0.0);
 
     // vertex position in view space
-    vec4 P = mvMatrix * vec4(vertexPos, 1.0);
+    vec4 P = modelViewMatrix * vec4(vertexPos, 1.0);
     // normal vector in view space
-    vec3 N = normalize((normMatrix * vec4(vertexNormal, 1.0)).xyz);
+    vec3 N = normalize((normalMatrix * vec4(decodeDirection(vertexNormal), 1.0)).xyz);
 
     // global ambient
     ambient += globalAmbient.xyz;
-    // directional lights
+#ifdef DIRECTIONAL_LIGHTS
     for (uint i = 0; i < directionalLightsSize; i++)
     {
         calculateDirectionalLight(directionalLights[i], P.xyz, N);
     }
-    // point lights
+#endif
+#ifdef POINT_LIGHTS
     for (uint i = 0; i < pointLightsSize; i++)
     {
         calculatePointLight(pointLights[i], P.xyz, N);
     }
-    // spot lights
+#endif
+#ifdef SPOT_LIGHTS
     for (uint i = 0; i < spotLightsSize; i++)
     {
         calculateSpotLight(spotLights[i], P.xyz, N);
     }
-    
-    // for flat shading
-    flatAmbient = ambient;
-    flatDiffuse = diffuse;
-    flatMaterialSpecular = materialSpecular;
-    flatTextureSpecular = textureSpecular;
+#endif
 
     // position
-    gl_Position = projMatrix * mvMatrix * vec4(vertexPos, 1.0);
+    gl_Position = projMatrix * modelViewMatrix * vec4(vertexPos, 1.0);
 
     // texture coordinates
     tc = textureCoord;
@@ -320,10 +649,8 @@ void main()
 
 const char* GouraudLightingMaterialTextureFragmentShader = R"glsl(
 #version 430
-// different max light numbers, must be same as the number in the Renderer class !
-#define MAX_POINT_LIGHT_SIZE 5
+// max directional light number, must be same as the number in the Renderer class !
 #define MAX_DIRECTIONAL_LIGHT_SIZE 5
-#define MAX_SPOT_LIGHT_SIZE 5
 struct DirectionalLight
 {
     vec4 ambient;
@@ -341,6 +668,8 @@ struct PointLight
     float constant;
     float linear;
     float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
 };
 struct SpotLight
 {
@@ -348,9 +677,11 @@ struct SpotLight
     vec4 diffuse;
     vec4 specular;
     vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
     vec3 direction; // in view space
     float cutOffAngle;
     float strengthFactorExponent;
+    float range;
 };
 struct Material
 {
@@ -364,72 +695,137 @@ layout (location = 1) in vec2 textureCoord;      // texture coordinates
 layout (location = 2) in vec3 vertexNormal;     // normals of vertices
 // texture sampler
 layout (binding = 0) uniform sampler2D samp;
-// lights
-uniform vec4 globalAmbient;
-uniform uint directionalLightsSize;
-uniform uint pointLightsSize;
-uniform uint spotLightsSize;
-uniform DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
-uniform PointLight pointLights[MAX_POINT_LIGHT_SIZE];
-uniform SpotLight spotLights[MAX_SPOT_LIGHT_SIZE];
+// global ambient and directional lights in view space, filled once per frame, the layout must be same as LightBlock in the Renderer class !
+layout (std140, binding = 1) uniform LightBlock
+{
+    vec4 globalAmbient;
+    uint directionalLightsSize;
+    uint pointLightsSize;
+    uint spotLightsSize;
+    uint shadowsSize;   // the first shadowsSize lights (directional, point, spot) have a shadow texture
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
+};
 // material
 uniform Material material;
+#ifdef INSTANCED
+// materials the instances select by index, the layout must be same as MaterialStd430 in the Renderer class !
+layout (std430, binding = 7) readonly buffer InstanceMaterialBuffer
+{
+    Material instanceMaterials[];
+};
+uniform uint instanceMaterialsSize;
+Material instanceMaterial;
+// the material of the model for indices past the materials of the instances
+void selectInstanceMaterial(uint index)
+{
+    if (index < instanceMaterialsSize)
+    {
+        instanceMaterial = instanceMaterials[index];
+    }
+    else
+    {
+        instanceMaterial = material;
+    }
+}
+// the lighting below uses the material of the instance
+#define material instanceMaterial
+#endif
+#ifdef INSTANCED
+flat in uint varyingMaterialIndex;
+#endif
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 // matrices
 uniform mat4 mvMatrix;      // model-view matrix
-uniform mat4 projMatrix;    // projection matrix
 uniform mat4 normMatrix;    // for transformation of normal vector
-uniform int flatShading;    // flat shading or not
 // material and texture weight
 uniform float materialWeight;
 uniform float textureWeight;
-
-in vec3 ambient;
-in vec3 diffuse;
-in vec3 materialSpecular;
-in vec3 textureSpecular;
-flat in vec3 flatAmbient;
-flat in vec3 flatDiffuse;
-flat in vec3 flatMaterialSpecular;
-flat in vec3 flatTextureSpecular;
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+flat in uint varyingDrawId;
+// the uniforms below come from the parameters of the draw
+#define materialWeight draws[varyingDrawId].materialWeight
+#define textureWeight draws[varyingDrawId].textureWeight
+Material drawMaterial;
+#define material drawMaterial
+#endif
+
+#ifdef FLAT_SHADING
+#define SHADING_INTERPOLATION flat
+#else
+#define SHADING_INTERPOLATION
+#endif
+SHADING_INTERPOLATION in vec3 ambient;
+SHADING_INTERPOLATION in vec3 diffuse;
+SHADING_INTERPOLATION in vec3 materialSpecular;
+SHADING_INTERPOLATION in vec3 textureSpecular;
 in vec2 tc;
 
 out vec4 fragColor;
 
 void main()
 {
+#ifdef INSTANCED
+    selectInstanceMaterial(varyingMaterialIndex);
+#endif
+#ifdef MULTI_DRAW
+    drawMaterial = Material(draws[varyingDrawId].materialAmbient, draws[varyingDrawId].materialDiffuse, draws[varyingDrawId].materialSpecular,
+                            draws[varyingDrawId].materialShininess);
+#endif
     fragColor = vec4(0.0, 0.0, 0.0, 0.0);
-    if (flatShading == 1) // flat shading
+    if (textureWeight != 0.0)
     {
-        if (textureWeight != 0.0)
-        {
-            fragColor += textureWeight * (texture(samp, tc) * vec4(0.3 * flatAmbient + 0.4 * flatDiffuse + 0.4 * flatTextureSpecular, 1.0));
-        }
-        if (materialWeight != 0.0)
-        {
-            fragColor += materialWeight * vec4(material.ambient.xyz * flatAmbient + material.diffuse.xyz * flatDiffuse + material.specular.xyz * flatMaterialSpecular, 1.0);
-        }
+        fragColor += textureWeight * (texture(samp, tc) * vec4(0.3 * ambient + 0.4 * diffuse + 0.4 * textureSpecular, 1.0));
     }
-    else // Gouraud shading
+    if (materialWeight != 0.0)
     {
-        if (textureWeight != 0.0)
-        {
-            fragColor += textureWeight * (texture(samp, tc) * vec4(0.3 * ambient + 0.4 * diffuse + 0.4 * textureSpecular, 1.0));
-        }
-        if (materialWeight != 0.0)
-        {
-            fragColor += materialWeight * vec4(material.ambient.xyz * ambient + material.diffuse.xyz * diffuse + material.specular.xyz * materialSpecular, 1.0);
-        }
+        fragColor += materialWeight * vec4(material.ambient.xyz * ambient + material.diffuse.xyz * diffuse + material.specular.xyz * materialSpecular, 1.0);
     }
 }
 )glsl";
 
 // ================================ Phong shading with lighting & material & texture ================================ 
+// features, defined by the Renderer for every program variant:
+// BUMP_MAP, NORMAL_MAP, HEIGHT_MAP, OCT_NORMALS (normals and tangents are octahedral encoded in x and y, quantized model),
+// DIRECTIONAL_LIGHTS, POINT_LIGHTS, SPOT_LIGHTS (the scene has lights of that kind), INSTANCED (transforms and materials per instance),
+// MULTI_DRAW (transforms and materials per draw of a multi-draw call, never with INSTANCED)
 const char* PhongLightingMaterialTextureVertexShader = R"glsl(
 #version 430
-// different max light numbers, must be same as the number in the Renderer class !
-#define MAX_POINT_LIGHT_SIZE 5
+#if defined(MULTI_DRAW) && defined(SHADER_DRAW_PARAMETERS)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+// max directional light number, must be same as the number in the Renderer class !
 #define MAX_DIRECTIONAL_LIGHT_SIZE 5
-#define MAX_SPOT_LIGHT_SIZE 5
 struct DirectionalLight
 {
     vec4 ambient;
@@ -447,6 +843,8 @@ struct PointLight
     float constant;
     float linear;
     float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
 };
 struct SpotLight
 {
@@ -454,9 +852,11 @@ struct SpotLight
     vec4 diffuse;
     vec4 specular;
     vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
     vec3 direction; // in view space
     float cutOffAngle;
     float strengthFactorExponent;
+    float range;
 };
 struct Material
 {
@@ -473,36 +873,109 @@ layout (location = 3) in vec3 sTangent;         // s direction tangent
 layout (binding = 0) uniform sampler2D samp;
 layout (binding = 1) uniform sampler2D normalMap;
 layout (binding = 2) uniform sampler2D heightMap;
-// lights
-uniform vec4 globalAmbient;
-uniform uint directionalLightsSize;
-uniform uint pointLightsSize;
-uniform uint spotLightsSize;
-uniform DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
-uniform PointLight pointLights[MAX_POINT_LIGHT_SIZE];
-uniform SpotLight spotLights[MAX_SPOT_LIGHT_SIZE];
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef INSTANCED
+flat out uint varyingMaterialIndex;
+#endif
+// global ambient and directional lights in view space, filled once per frame, the layout must be same as LightBlock in the Renderer class !
+layout (std140, binding = 1) uniform LightBlock
+{
+    vec4 globalAmbient;
+    uint directionalLightsSize;
+    uint pointLightsSize;
+    uint spotLightsSize;
+    uint shadowsSize;   // the first shadowsSize lights (directional, point, spot) have a shadow texture
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
+};
 // material
 uniform Material material;
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 // matrices
 uniform mat4 mvMatrix;      // model-view matrix
-uniform mat4 projMatrix;    // projection matrix
 uniform mat4 normMatrix;    // for transformation of normal vector
 // material and texture weight
 uniform float materialWeight;
 uniform float textureWeight;
-// bump map mode
-uniform int enableBumpMap;
-// enable normal map or not
-uniform int enableNormalMap;
-// enable height map or not
-uniform int enableHeightMap;
-uniform float heightFactor;
+uniform float heightFactor;  // for height map
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+#ifdef SHADER_DRAW_PARAMETERS
+uniform uint firstDraw; // index of the parameters of the first draw of the call
+#define DRAW_ID (firstDraw + uint(gl_DrawIDARB))
+#else
+layout (location = 5) in uint drawIndex; // the baseInstance of the draw
+#define DRAW_ID drawIndex
+#endif
+flat out uint varyingDrawId;
+// the uniforms below come from the parameters of the draw
+#define mvMatrix draws[DRAW_ID].mvMatrix
+#define normMatrix draws[DRAW_ID].normMatrix
+#define heightFactor draws[DRAW_ID].heightFactor
+#endif
+
+// unit vector of the octahedral encoding
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+vec3 decodeDirection(vec3 v)
+{
+#ifdef OCT_NORMALS
+    return octDecode(v.xy);
+#else
+    return v;
+#endif
+}
 
 out vec3 varyingNormal;
 out vec3 varyingVertexPos;
-// varying light direction (from vertex to light source) for different light sources (in view space)
-out vec3 varyingPointLightDirections[MAX_POINT_LIGHT_SIZE];
-out vec3 varyingSpotLightDirections[MAX_SPOT_LIGHT_SIZE];
 out vec2 tc;
 // for bump map
 out vec3 originalVertexPos;
@@ -511,35 +984,42 @@ out vec3 varyingSTangent;
 
 void main()
 {
-    // height map
-    vec3 pos = vertexPos + normalize(vertexNormal) * texture(heightMap, textureCoord).x * heightFactor;
-
-    varyingVertexPos = (mvMatrix * vec4(pos, 1.0)).xyz;
-    varyingNormal = (normMatrix * vec4(vertexNormal, 1.0)).xyz;
-    for (uint i = 0; i < pointLightsSize; i++)
-    {
-        varyingPointLightDirections[i] = pointLights[i].location - varyingVertexPos;
-    }
-    for (uint i = 0; i < spotLightsSize; i++)
-    {
-        varyingSpotLightDirections[i] = spotLights[i].location - varyingVertexPos;
-    }
-    gl_Position = projMatrix * mvMatrix * vec4(pos, 1.0);
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+    mat4 normalMatrix = normMatrix * instances[gl_InstanceID].normalMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+    mat4 normalMatrix = normMatrix;
+#endif
+#ifdef INSTANCED
+    varyingMaterialIndex = instances[gl_InstanceID].materialIndex;
+#endif
+#ifdef MULTI_DRAW
+    varyingDrawId = DRAW_ID;
+#endif
+    vec3 normal = decodeDirection(vertexNormal);
+#ifdef HEIGHT_MAP
+    vec3 pos = vertexPos + normalize(normal) * texture(heightMap, textureCoord).x * heightFactor;
+#else
+    vec3 pos = vertexPos;
+#endif
+
+    varyingVertexPos = (modelViewMatrix * vec4(pos, 1.0)).xyz;
+    varyingNormal = (normalMatrix * vec4(normal, 1.0)).xyz;
+    gl_Position = projMatrix * modelViewMatrix * vec4(pos, 1.0);
     // texture coordinates
     tc = textureCoord;
     // bump map information
     originalVertexPos = pos;
     // for normal map
-    varyingSTangent = sTangent;
+    varyingSTangent = decodeDirection(sTangent);
 }
 )glsl";
 
 const char* PhongLightingMaterialTextureFragmentShader = R"glsl(
 #version 430
-// different max light numbers, must be same as the number in the Renderer class !
-#define MAX_POINT_LIGHT_SIZE 5
+// max directional light number, must be same as the number in the Renderer class !
 #define MAX_DIRECTIONAL_LIGHT_SIZE 5
-#define MAX_SPOT_LIGHT_SIZE 5
 struct DirectionalLight
 {
     vec4 ambient;
@@ -557,6 +1037,8 @@ struct PointLight
     float constant;
     float linear;
     float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
 };
 struct SpotLight
 {
@@ -564,9 +1046,11 @@ struct SpotLight
     vec4 diffuse;
     vec4 specular;
     vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
     vec3 direction; // in view space
     float cutOffAngle;
     float strengthFactorExponent;
+    float range;
 };
 struct Material
 {
@@ -583,36 +1067,112 @@ layout (location = 3) in vec3 sTangent;         // s direction tangent
 layout (binding = 0) uniform sampler2D samp;
 layout (binding = 1) uniform sampler2D normalMap;
 layout (binding = 2) uniform sampler2D heightMap;
-// lights
-uniform vec4 globalAmbient;
-uniform uint directionalLightsSize;
-uniform uint pointLightsSize;
-uniform uint spotLightsSize;
-uniform DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
-uniform PointLight pointLights[MAX_POINT_LIGHT_SIZE];
-uniform SpotLight spotLights[MAX_SPOT_LIGHT_SIZE];
+// global ambient and directional lights in view space, filled once per frame, the layout must be same as LightBlock in the Renderer class !
+layout (std140, binding = 1) uniform LightBlock
+{
+    vec4 globalAmbient;
+    uint directionalLightsSize;
+    uint pointLightsSize;
+    uint spotLightsSize;
+    uint shadowsSize;   // the first shadowsSize lights (directional, point, spot) have a shadow texture
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
+};
+// point and spot lights in view space, filled once per frame, the layouts must be same as in the Renderer class !
+layout (std430, binding = 0) readonly buffer PointLightBuffer
+{
+    PointLight pointLights[];
+};
+layout (std430, binding = 1) readonly buffer SpotLightBuffer
+{
+    SpotLight spotLights[];
+};
+// lights of every cluster: first index in clusterLightIndices, point light count, spot light count, point lights first
+layout (std430, binding = 2) readonly buffer ClusterBuffer
+{
+    uvec4 clusters[];
+};
+layout (std430, binding = 3) readonly buffer ClusterLightIndexBuffer
+{
+    uint clusterLightIndices[];
+};
 // material
 uniform Material material;
+#ifdef INSTANCED
+// materials the instances select by index, the layout must be same as MaterialStd430 in the Renderer class !
+layout (std430, binding = 7) readonly buffer InstanceMaterialBuffer
+{
+    Material instanceMaterials[];
+};
+uniform uint instanceMaterialsSize;
+Material instanceMaterial;
+// the material of the model for indices past the materials of the instances
+void selectInstanceMaterial(uint index)
+{
+    if (index < instanceMaterialsSize)
+    {
+        instanceMaterial = instanceMaterials[index];
+    }
+    else
+    {
+        instanceMaterial = material;
+    }
+}
+// the lighting below uses the material of the instance
+#define material instanceMaterial
+#endif
+#ifdef INSTANCED
+flat in uint varyingMaterialIndex;
+#endif
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 // matrices
 uniform mat4 mvMatrix;      // model-view matrix
-uniform mat4 projMatrix;    // projection matrix
 uniform mat4 normMatrix;    // for transformation of normal vector
 // material and texture weight
 uniform float materialWeight;
 uniform float textureWeight;
-// bump map mode
-uniform int enableBumpMap;
-// enable normal map or not
-uniform int enableNormalMap;
-// enable height map or not
-uniform int enableHeightMap;
-uniform float heightFactor;
+uniform float heightFactor;  // for height map
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+flat in uint varyingDrawId;
+// the uniforms below come from the parameters of the draw
+#define materialWeight draws[varyingDrawId].materialWeight
+#define textureWeight draws[varyingDrawId].textureWeight
+Material drawMaterial;
+#define material drawMaterial
+#endif
 
 in vec3 varyingNormal;
 in vec3 varyingVertexPos;
-// varying light direction (from vertex to light source) for different light sources (in view space)
-in vec3 varyingPointLightDirections[MAX_POINT_LIGHT_SIZE];
-in vec3 varyingSpotLightDirections[MAX_SPOT_LIGHT_SIZE];
 in vec2 tc;
 // for bump map
 in vec3 originalVertexPos;
@@ -626,6 +1186,15 @@ vec3 diffuse;
 vec3 materialSpecular;
 vec3 textureSpecular;
 
+// the lights of the cluster of this fragment, P in view space
+uvec4 fragmentCluster(vec3 P)
+{
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize.xy), clusterGrid.xy - 1u);
+    float slice = floor(log(max(-P.z, 1e-6)) * clusterDepthScale + clusterDepthBias);
+    uint z = uint(clamp(slice, 0.0, float(clusterGrid.z - 1u)));
+    return clusters[tile.x + clusterGrid.x * (tile.y + clusterGrid.y * z)];
+}
+
 void calculateDirectionalLight(DirectionalLight light, vec3 P, vec3 N)
 {
     // light vector (from vertex to light source) in view space
@@ -642,10 +1211,10 @@ void calculateDirectionalLight(DirectionalLight light, vec3 P, vec3 N)
     textureSpecular += light.specular.xyz * max(dot(R, V), 0.0);
 }
 
-void calculatePointLight(PointLight light, uint index, vec3 P, vec3 N)
+void calculatePointLight(PointLight light, vec3 P, vec3 N)
 {
     // light vector (from vertex to light source) in view space
-    vec3 L = normalize(varyingPointLightDirections[index]);
+    vec3 L = normalize(light.location - P);
     // visual vector (from vertex to eye) equals to the negative vertex position in view space
     vec3 V = normalize(-P);
     // reflect vector
@@ -661,10 +1230,10 @@ void calculatePointLight(PointLight light, uint index, vec3 P, vec3 N)
     textureSpecular += light.specular.xyz * max(dot(R, V), 0.0) * attenuation;
 }
 
-void calculateSpotLight(SpotLight light, uint index, vec3 P, vec3 N)
+void calculateSpotLight(SpotLight light, vec3 P, vec3 N)
 {
     // light vector (from vertex to light source) in view space
-    vec3 L = normalize(varyingSpotLightDirections[index]);
+    vec3 L = normalize(light.location - P);
     // visual vector (from vertex to eye)
     vec3 V = normalize(-P);
     // reflect vector
@@ -684,6 +1253,13 @@ void calculateSpotLight(SpotLight light, uint index, vec3 P, vec3 N)
 
 void main()
 {
+#ifdef INSTANCED
+    selectInstanceMaterial(varyingMaterialIndex);
+#endif
+#ifdef MULTI_DRAW
+    drawMaterial = Material(draws[varyingDrawId].materialAmbient, draws[varyingDrawId].materialDiffuse, draws[varyingDrawId].materialSpecular,
+                            draws[varyingDrawId].materialShininess);
+#endif
     // initialization
     ambient = vec3(0.0, 0.0, 0.0);
     diffuse = vec3(0.0, 0.0, 0.0);
@@ -692,7 +1268,7 @@ void main()
 
     // calculate bump map
     vec3 N = varyingNormal;
-    if (enableBumpMap == 1)
+#ifdef BUMP_MAP
     {
         float a = 0.25;
         float b = 50;
@@ -701,9 +1277,10 @@ void main()
         N.z += a * sin(b * originalVertexPos.z);
         N = normalize(N);
     }
+#endif
 
     // calculate normal map
-    if (enableNormalMap == 1)
+#ifdef NORMAL_MAP
     {
         vec3 normal = normalize(varyingNormal);
         vec3 tangent = normalize(varyingSTangent);
@@ -714,24 +1291,32 @@ void main()
         retrievedNormal = retrievedNormal * 2.0 - 1.0; // from RGB space to tangent space ([0.0,1.0] to [-1.0, 1.0])
         N = normalize(tbn * retrievedNormal); // tangent space to same space with normal
     }
+#endif
 
     // global ambient
     ambient += globalAmbient.xyz;
-    // directional lights
+#ifdef DIRECTIONAL_LIGHTS
     for (uint i = 0; i < directionalLightsSize; i++)
     {
         calculateDirectionalLight(directionalLights[i], varyingVertexPos, N);
     }
-    // point lights
-    for (uint i = 0; i < pointLightsSize; i++)
+#endif
+    // point and spot lights of the cluster
+#if defined(POINT_LIGHTS) || defined(SPOT_LIGHTS)
+    uvec4 cluster = fragmentCluster(varyingVertexPos);
+#endif
+#ifdef POINT_LIGHTS
+    for (uint i = 0; i < cluster.y; i++)
     {
-        calculatePointLight(pointLights[i], i, varyingVertexPos, N);
+        calculatePointLight(pointLights[clusterLightIndices[cluster.x + i]], varyingVertexPos, N);
     }
-    // spot lights
-    for (uint i = 0; i < spotLightsSize; i++)
+#endif
+#ifdef SPOT_LIGHTS
+    for (uint i = 0; i < cluster.z; i++)
     {
-        calculateSpotLight(spotLights[i], i, varyingVertexPos, N);
+        calculateSpotLight(spotLights[clusterLightIndices[cluster.x + cluster.y + i]], varyingVertexPos, N);
     }
+#endif
     // result
     fragColor = vec4(0.0, 0.0, 0.0, 0.0);
     if (textureWeight != 0.0)
@@ -748,11 +1333,62 @@ void main()
 // ================================ Phong shading with lighting & material & texture ================================ 
 const char* shadowDepthVertexShader = R"glsl(
 #version 430
+#if defined(MULTI_DRAW) && defined(SHADER_DRAW_PARAMETERS)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 layout (location = 0) in vec3 vertexPos;
-uniform mat4 shadowMVP;
+uniform mat4 shadowMVP;    // the view projection matrix of the light for MULTI_DRAW
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef MULTI_DRAW
+// parameters of the draws of a multi-draw call, the layout must be same as DrawParametersStd430 in the Renderer class !
+struct DrawParameters
+{
+    mat4 modelMatrix;
+    mat4 mvMatrix;
+    mat4 normMatrix;
+    vec4 color;
+    vec4 materialAmbient;
+    vec4 materialDiffuse;
+    vec4 materialSpecular;
+    float materialShininess;
+    float materialWeight;
+    float textureWeight;
+    float heightFactor;
+};
+layout (std430, binding = 8) readonly buffer DrawParameterBuffer
+{
+    DrawParameters draws[];
+};
+#ifdef SHADER_DRAW_PARAMETERS
+uniform uint firstDraw; // index of the parameters of the first draw of the call
+#define DRAW_ID (firstDraw + uint(gl_DrawIDARB))
+#else
+layout (location = 5) in uint drawIndex; // the baseInstance of the draw
+#define DRAW_ID drawIndex
+#endif
+#endif
 void main()
 {
+#ifdef INSTANCED
+    gl_Position = shadowMVP * instances[gl_InstanceID].modelMatrix * vec4(vertexPos, 1.0);
+#elif defined(MULTI_DRAW)
+    gl_Position = shadowMVP * draws[DRAW_ID].modelMatrix * vec4(vertexPos, 1.0);
+#else
     gl_Position = shadowMVP * vec4(vertexPos, 1.0);
+#endif
 }
 )glsl";
 
@@ -765,10 +1401,8 @@ void main()
 
 const char* shadowShadingVertexShader = R"glsl(
 #version 430
-// different max light numbers, must be same as the number in the Renderer class !
-#define MAX_POINT_LIGHT_SIZE 5
+// max directional light number, must be same as the number in the Renderer class !
 #define MAX_DIRECTIONAL_LIGHT_SIZE 5
-#define MAX_SPOT_LIGHT_SIZE 5
 #define MAX_SHADOW_TEXTURE_SIZE 15
 struct DirectionalLight
 {
@@ -787,6 +1421,8 @@ struct PointLight
     float constant;
     float linear;
     float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
 };
 struct SpotLight
 {
@@ -794,9 +1430,11 @@ struct SpotLight
     vec4 diffuse;
     vec4 specular;
     vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
     vec3 direction; // in view space
     float cutOffAngle;
     float strengthFactorExponent;
+    float range;
 };
 struct Material
 {
@@ -810,19 +1448,33 @@ layout (location = 1) in vec2 textureCoord;      // texture coordinates
 layout (location = 2) in vec3 vertexNormal;     // normals of vertices
 // texture sampler
 layout (binding = 0) uniform sampler2D samp;
-// lights
-uniform vec4 globalAmbient;
-uniform uint directionalLightsSize;
-uniform uint pointLightsSize;
-uniform uint spotLightsSize;
-uniform DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
-uniform PointLight pointLights[MAX_POINT_LIGHT_SIZE];
-uniform SpotLight spotLights[MAX_SPOT_LIGHT_SIZE];
+// global ambient and directional lights in view space, filled once per frame, the layout must be same as LightBlock in the Renderer class !
+layout (std140, binding = 1) uniform LightBlock
+{
+    vec4 globalAmbient;
+    uint directionalLightsSize;
+    uint pointLightsSize;
+    uint spotLightsSize;
+    uint shadowsSize;   // the first shadowsSize lights (directional, point, spot) have a shadow texture
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
+};
 // material
 uniform Material material;
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 // matrices
 uniform mat4 mvMatrix;      // model-view matrix
-uniform mat4 projMatrix;    // projection matrix
 uniform mat4 normMatrix;    // for transformation of normal vector
 // material and texture weight
 uniform float materialWeight;
@@ -845,49 +1497,77 @@ layout (binding = 21) uniform sampler2D shadowTextureSampler11;
 layout (binding = 22) uniform sampler2D shadowTextureSampler12;
 layout (binding = 23) uniform sampler2D shadowTextureSampler13;
 layout (binding = 24) uniform sampler2D shadowTextureSampler14;
-// pcf mode
-uniform int pcfMode;
-uniform float pcfFactor;
+uniform bool octNormals;    // normals and tangents are octahedral encoded in x and y (quantized model)
+
+// unit vector of the octahedral encoding
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+vec3 decodeDirection(vec3 v)
+{
+    return octNormals ? octDecode(v.xy) : v;
+}
 
 out vec3 varyingNormal;
 out vec3 varyingVertexPos;
-// varying light direction (from vertex to light source) for different light sources (in view space)
-out vec3 varyingPointLightDirections[MAX_POINT_LIGHT_SIZE];
-out vec3 varyingSpotLightDirections[MAX_SPOT_LIGHT_SIZE];
 out vec2 tc;
 // shadow coordinates output
 out vec4 shadowCoord[MAX_SHADOW_TEXTURE_SIZE];
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
+#ifdef INSTANCED
+flat out uint varyingMaterialIndex;
+#endif
 
 void main()
 {
-    varyingVertexPos = (mvMatrix * vec4(vertexPos, 1.0)).xyz;
-    varyingNormal = (normMatrix * vec4(vertexNormal, 1.0)).xyz;
-    for (uint i = 0; i < pointLightsSize; i++)
-    {
-        varyingPointLightDirections[i] = pointLights[i].location - varyingVertexPos;
-    }
-    for (uint i = 0; i < spotLightsSize; i++)
-    {
-        varyingSpotLightDirections[i] = spotLights[i].location - varyingVertexPos;
-    }
-    gl_Position = projMatrix * mvMatrix * vec4(vertexPos, 1.0);
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+    mat4 normalMatrix = normMatrix * instances[gl_InstanceID].normalMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+    mat4 normalMatrix = normMatrix;
+#endif
+#ifdef INSTANCED
+    mat4 instanceMatrix = instances[gl_InstanceID].modelMatrix;
+    varyingMaterialIndex = instances[gl_InstanceID].materialIndex;
+#else
+    mat4 instanceMatrix = mat4(1.0);
+#endif
+    varyingVertexPos = (modelViewMatrix * vec4(vertexPos, 1.0)).xyz;
+    varyingNormal = (normalMatrix * vec4(decodeDirection(vertexNormal), 1.0)).xyz;
+    gl_Position = projMatrix * modelViewMatrix * vec4(vertexPos, 1.0);
     // texture coordinates
     tc = textureCoord;
     // shadow coordinates
-    uint shadowSize = directionalLightsSize + pointLightsSize + spotLightsSize;
-    for (uint i = 0; i < shadowSize; i++)
+    for (uint i = 0; i < shadowsSize; i++)
     {
-        shadowCoord[i] = shadowMVPs[i] * vec4(vertexPos, 1.0);
+        shadowCoord[i] = shadowMVPs[i] * instanceMatrix * vec4(vertexPos, 1.0);
     }
 }
 )glsl";
 
 const char* shadowShadingFragmentShader = R"glsl(
 #version 430
-// different max light numbers, must be same as the number in the Renderer class !
-#define MAX_POINT_LIGHT_SIZE 5
+// max directional light number, must be same as the number in the Renderer class !
 #define MAX_DIRECTIONAL_LIGHT_SIZE 5
-#define MAX_SPOT_LIGHT_SIZE 5
 #define MAX_SHADOW_TEXTURE_SIZE 15
 struct DirectionalLight
 {
@@ -906,6 +1586,8 @@ struct PointLight
     float constant;
     float linear;
     float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
 };
 struct SpotLight
 {
@@ -913,9 +1595,11 @@ struct SpotLight
     vec4 diffuse;
     vec4 specular;
     vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
     vec3 direction; // in view space
     float cutOffAngle;
     float strengthFactorExponent;
+    float range;
 };
 struct Material
 {
@@ -929,19 +1613,77 @@ layout (location = 1) in vec2 textureCoord;      // texture coordinates
 layout (location = 2) in vec3 vertexNormal;     // normals of vertices
 // texture sampler
 layout (binding = 0) uniform sampler2D samp;
-// lights
-uniform vec4 globalAmbient;
-uniform uint directionalLightsSize;
-uniform uint pointLightsSize;
-uniform uint spotLightsSize;
-uniform DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
-uniform PointLight pointLights[MAX_POINT_LIGHT_SIZE];
-uniform SpotLight spotLights[MAX_SPOT_LIGHT_SIZE];
+// global ambient and directional lights in view space, filled once per frame, the layout must be same as LightBlock in the Renderer class !
+layout (std140, binding = 1) uniform LightBlock
+{
+    vec4 globalAmbient;
+    uint directionalLightsSize;
+    uint pointLightsSize;
+    uint spotLightsSize;
+    uint shadowsSize;   // the first shadowsSize lights (directional, point, spot) have a shadow texture
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_SIZE];
+};
+// point and spot lights in view space, filled once per frame, the layouts must be same as in the Renderer class !
+layout (std430, binding = 0) readonly buffer PointLightBuffer
+{
+    PointLight pointLights[];
+};
+layout (std430, binding = 1) readonly buffer SpotLightBuffer
+{
+    SpotLight spotLights[];
+};
+// lights of every cluster: first index in clusterLightIndices, point light count, spot light count, point lights first
+layout (std430, binding = 2) readonly buffer ClusterBuffer
+{
+    uvec4 clusters[];
+};
+layout (std430, binding = 3) readonly buffer ClusterLightIndexBuffer
+{
+    uint clusterLightIndices[];
+};
 // material
 uniform Material material;
+#ifdef INSTANCED
+// materials the instances select by index, the layout must be same as MaterialStd430 in the Renderer class !
+layout (std430, binding = 7) readonly buffer InstanceMaterialBuffer
+{
+    Material instanceMaterials[];
+};
+uniform uint instanceMaterialsSize;
+Material instanceMaterial;
+// the material of the model for indices past the materials of the instances
+void selectInstanceMaterial(uint index)
+{
+    if (index < instanceMaterialsSize)
+    {
+        instanceMaterial = instanceMaterials[index];
+    }
+    else
+    {
+        instanceMaterial = material;
+    }
+}
+// the lighting below uses the material of the instance
+#define material instanceMaterial
+#endif
+#ifdef INSTANCED
+flat in uint varyingMaterialIndex;
+#endif
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 // matrices
 uniform mat4 mvMatrix;      // model-view matrix
-uniform mat4 projMatrix;    // projection matrix
 uniform mat4 normMatrix;    // for transformation of normal vector
 // material and texture weight
 uniform float materialWeight;
@@ -964,15 +1706,9 @@ layout (binding = 21) uniform sampler2D shadowTextureSampler11;
 layout (binding = 22) uniform sampler2D shadowTextureSampler12;
 layout (binding = 23) uniform sampler2D shadowTextureSampler13;
 layout (binding = 24) uniform sampler2D shadowTextureSampler14;
-// pcf mode
-uniform int pcfMode;
-uniform float pcfFactor;
 
 in vec3 varyingNormal;
 in vec3 varyingVertexPos;
-// varying light direction (from vertex to light source) for different light sources (in view space)
-in vec3 varyingPointLightDirections[MAX_POINT_LIGHT_SIZE];
-in vec3 varyingSpotLightDirections[MAX_SPOT_LIGHT_SIZE];
 in vec2 tc;
 // shadow coordinates input
 in vec4 shadowCoord[MAX_SHADOW_TEXTURE_SIZE];
@@ -1057,6 +1793,15 @@ float myTextureProj()
     return 1.0f; // not in shadow
 }
 
+// the lights of the cluster of this fragment, P in view space
+uvec4 fragmentCluster(vec3 P)
+{
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize.xy), clusterGrid.xy - 1u);
+    float slice = floor(log(max(-P.z, 1e-6)) * clusterDepthScale + clusterDepthBias);
+    uint z = uint(clamp(slice, 0.0, float(clusterGrid.z - 1u)));
+    return clusters[tile.x + clusterGrid.x * (tile.y + clusterGrid.y * z)];
+}
+
 void calculateDirectionalLight(DirectionalLight light, vec3 P, vec3 N)
 {
     // light vector (from vertex to light source) in view space
@@ -1075,10 +1820,10 @@ void calculateDirectionalLight(DirectionalLight light, vec3 P, vec3 N)
     textureSpecular += light.specular.xyz * max(dot(R, V), 0.0) * shadowFactor;
 }
 
-void calculatePointLight(PointLight light, uint index, vec3 P, vec3 N)
+void calculatePointLight(PointLight light, vec3 P, vec3 N)
 {
     // light vector (from vertex to light source) in view space
-    vec3 L = normalize(varyingPointLightDirections[index]);
+    vec3 L = normalize(light.location - P);
     // visual vector (from vertex to eye) equals to the negative vertex position in view space
     vec3 V = normalize(-P);
     // reflect vector
@@ -1089,6 +1834,7 @@ void calculatePointLight(PointLight light, uint index, vec3 P, vec3 N)
     // the ADS weight of vertex
     ambient += light.ambient.xyz * attenuation;
     // deal with shadow
+    shadowIndex = light.shadowIndex < 0 ? uint(MAX_SHADOW_TEXTURE_SIZE) : uint(light.shadowIndex);
     float shadowFactor = myTextureProj();
     diffuse += light.diffuse.xyz * max(dot(N, L), 0.0) * attenuation * shadowFactor;
     materialSpecular += light.specular.xyz * pow(max(dot(R, V), 0.0), material.shininess) * attenuation * shadowFactor;
@@ -1096,10 +1842,10 @@ void calculatePointLight(PointLight light, uint index, vec3 P, vec3 N)
     textureSpecular += light.specular.xyz * max(dot(R, V), 0.0) * attenuation * shadowFactor;
 }
 
-void calculateSpotLight(SpotLight light, uint index, vec3 P, vec3 N)
+void calculateSpotLight(SpotLight light, vec3 P, vec3 N)
 {
     // light vector (from vertex to light source) in view space
-    vec3 L = normalize(varyingSpotLightDirections[index]);
+    vec3 L = normalize(light.location - P);
     // visual vector (from vertex to eye)
     vec3 V = normalize(-P);
     // reflect vector
@@ -1112,6 +1858,7 @@ void calculateSpotLight(SpotLight light, uint index, vec3 P, vec3 N)
     // ADS weight of vertex
     ambient += light.ambient.xyz * strengthFactor;
     // deal with shadow
+    shadowIndex = light.shadowIndex < 0 ? uint(MAX_SHADOW_TEXTURE_SIZE) : uint(light.shadowIndex);
     float shadowFactor = myTextureProj();
     diffuse += light.diffuse.xyz * max(dot(N, L), 0.0) * strengthFactor * shadowFactor;
     materialSpecular += light.specular.xyz * pow(max(dot(R, V), 0.0), material.shininess) * strengthFactor * shadowFactor;
@@ -1121,29 +1868,31 @@ void calculateSpotLight(SpotLight light, uint index, vec3 P, vec3 N)
 
 void main()
 {
+#ifdef INSTANCED
+    selectInstanceMaterial(varyingMaterialIndex);
+#endif
     // initialization
     ambient = vec3(0.0, 0.0, 0.0);
     diffuse = vec3(0.0, 0.0, 0.0);
     materialSpecular = vec3(0.0, 0.0, 0.0);
     textureSpecular = vec3(0.0, 0.0, 0.0);
-    shadowIndex = 0;
-
     // global ambient
     ambient += globalAmbient.xyz;
     // directional lights
-    for (uint i = 0; i < directionalLightsSize; i++, shadowIndex++)
+    for (uint i = 0; i < directionalLightsSize; i++)
     {
+        shadowIndex = i < shadowsSize ? i : uint(MAX_SHADOW_TEXTURE_SIZE);
         calculateDirectionalLight(directionalLights[i], varyingVertexPos, varyingNormal);
     }
-    // point lights
-    for (uint i = 0; i < pointLightsSize; i++, shadowIndex++)
+    // point and spot lights of the cluster
+    uvec4 cluster = fragmentCluster(varyingVertexPos);
+    for (uint i = 0; i < cluster.y; i++)
     {
-        calculatePointLight(pointLights[i], i, varyingVertexPos, varyingNormal);
+        calculatePointLight(pointLights[clusterLightIndices[cluster.x + i]], varyingVertexPos, varyingNormal);
     }
-    // spot lights
-    for (uint i = 0; i < spotLightsSize; i++, shadowIndex++)
+    for (uint i = 0; i < cluster.z; i++)
     {
-        calculateSpotLight(spotLights[i], i, varyingVertexPos, varyingNormal);
+        calculateSpotLight(spotLights[clusterLightIndices[cluster.x + cluster.y + i]], varyingVertexPos, varyingNormal);
     }
     // result
     fragColor = vec4(0.0, 0.0, 0.0, 0.0);
@@ -1322,18 +2071,66 @@ const char* environmentMapVertexShader = R"glsl(
 #version 430
 layout (location = 0) in vec3 vertexPos;
 layout (location = 2) in vec3 vertexNormal; // note: normals in location 2 for all shaders.
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 uniform mat4 mvMatrix;
-uniform mat4 projMatrix;
 uniform mat4 normMatrix;    // matrix to transform normals
 uniform samplerCube skyboxTex;
+uniform bool octNormals;    // normals are octahedral encoded in x and y (quantized model)
+
+// unit vector of the octahedral encoding
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+vec3 decodeDirection(vec3 v)
+{
+    return octNormals ? octDecode(v.xy) : v;
+}
 
 out vec3 varyingNormal;
 out vec3 varyingVertexPos;
+#ifdef INSTANCED
+// transforms of the instances, the layout must be same as InstanceStd430 in the Renderer class !
+struct Instance
+{
+    mat4 modelMatrix;   // applied before the model matrix
+    mat4 normalMatrix;  // inverse transpose of modelMatrix
+    vec4 color;
+    uint materialIndex;
+};
+layout (std430, binding = 6) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
+#endif
 void main()
 {
-    varyingVertexPos = (mvMatrix * vec4(vertexPos, 1.0)).xyz;
-    varyingNormal = (normMatrix * vec4(vertexNormal, 1.0)).xyz;
-    gl_Position = projMatrix * mvMatrix * vec4(vertexPos, 1.0);
+#ifdef INSTANCED
+    mat4 modelViewMatrix = mvMatrix * instances[gl_InstanceID].modelMatrix;
+    mat4 normalMatrix = normMatrix * instances[gl_InstanceID].normalMatrix;
+#else
+    mat4 modelViewMatrix = mvMatrix;
+    mat4 normalMatrix = normMatrix;
+#endif
+    varyingVertexPos = (modelViewMatrix * vec4(vertexPos, 1.0)).xyz;
+    varyingNormal = (normalMatrix * vec4(decodeDirection(vertexNormal), 1.0)).xyz;
+    gl_Position = projMatrix * modelViewMatrix * vec4(vertexPos, 1.0);
 }
 )glsl";
 
@@ -1341,8 +2138,20 @@ const char* environmentMapFragmentShader = R"glsl(
 #version 430
 layout (location = 0) in vec3 vertexPos;
 layout (location = 1) in vec3 vertexNormal;
+// per frame data, the layout must be same as FrameBlock in the Renderer class !
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 viewMatrix;
+    mat4 projMatrix;    // projection matrix
+    int pcfMode;        // pcf mode
+    float pcfFactor;
+    // light clusters: the slice of view depth d is floor(log(d) * clusterDepthScale + clusterDepthBias)
+    float clusterDepthScale;
+    float clusterDepthBias;
+    uvec4 clusterGrid;      // clusters in x, y, z
+    vec4 clusterTileSize;   // pixels of a tile in x and y
+};
 uniform mat4 mvMatrix;
-uniform mat4 projMatrix;
 uniform mat4 normMatrix;    // matrix to transform normals
 uniform samplerCube skyboxTex;
 
@@ -1357,11 +2166,256 @@ void main()
 }
 )glsl";
 
-// ======================================================= Renderer ==============================================
-Renderer::Renderer(const char* windowTitle, int width, int height, float axisLength)
-    : m_AxisLength(axisLength)
+// ========================================= clustered light culling ==========================================
+// assign lights to clusters on the GPU, one invocation per cluster, same tests as LightClusterGrid on the CPU
+const char* lightCullingComputeShader = R"glsl(
+#version 430
+layout (local_size_x = 64) in;
+struct PointLight
 {
-    // init glfw
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec3 location; // in view space
+    // for attenuation factor
+    float constant;
+    float linear;
+    float quadratic;
+    float range;        // distance where the attenuation becomes negligible
+    int shadowIndex;    // -1 for lights without shadow
+};
+struct SpotLight
+{
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec3 location; // in view space
+    int shadowIndex;    // -1 for lights without shadow
+    vec3 direction; // in view space
+    float cutOffAngle;
+    float strengthFactorExponent;
+    float range;
+};
+struct ClusterBounds
+{
+    vec4 minCorner;
+    vec4 maxCorner;
+};
+layout (std430, binding = 0) readonly buffer PointLightBuffer
+{
+    PointLight pointLights[];
+};
+layout (std430, binding = 1) readonly buffer SpotLightBuffer
+{
+    SpotLight spotLights[];
+};
+layout (std430, binding = 2) writeonly buffer ClusterBuffer
+{
+    uvec4 clusters[];
+};
+layout (std430, binding = 3) writeonly buffer ClusterLightIndexBuffer
+{
+    uint clusterLightIndices[];
+};
+layout (std430, binding = 4) readonly buffer ClusterBoundsBuffer
+{
+    ClusterBounds clusterBounds[];
+};
+// light indices used so far, zero before the dispatch
+layout (std430, binding = 5) buffer ClusterCounterBuffer
+{
+    uint clusterLightIndexCount;
+};
+uniform uint pointLightsSize;
+uniform uint spotLightsSize;
+uniform uint clusterCount;
+uniform uint maxClusterLightIndices;    // room in clusterLightIndices
+
+bool pointLightIntersects(PointLight light, vec3 minCorner, vec3 maxCorner)
+{
+    vec3 d = max(max(minCorner - light.location, light.location - maxCorner), vec3(0.0));
+    return dot(d, d) <= light.range * light.range;
+}
+
+bool spotLightIntersects(SpotLight light, vec3 minCorner, vec3 maxCorner)
+{
+    vec3 d = max(max(minCorner - light.location, light.location - maxCorner), vec3(0.0));
+    if (dot(d, d) > light.range * light.range)
+    {
+        return false;
+    }
+    if (light.cutOffAngle >= 1.5707963)
+    {
+        return true;
+    }
+    // cone against the bounding sphere of the cluster
+    vec3 center = (minCorner + maxCorner) * 0.5;
+    float radius = length(maxCorner - center);
+    vec3 v = center - light.location;
+    float axial = dot(v, normalize(light.direction));
+    float closest = cos(light.cutOffAngle) * sqrt(max(dot(v, v) - axial * axial, 0.0)) - axial * sin(light.cutOffAngle);
+    return closest <= radius && axial >= -radius;
+}
+
+void main()
+{
+    uint cluster = gl_GlobalInvocationID.x;
+    if (cluster >= clusterCount)
+    {
+        return;
+    }
+    vec3 minCorner = clusterBounds[cluster].minCorner.xyz;
+    vec3 maxCorner = clusterBounds[cluster].maxCorner.xyz;
+    // count, reserve room, then write the indices
+    uint pointCount = 0;
+    uint spotCount = 0;
+    for (uint i = 0; i < pointLightsSize; i++)
+    {
+        pointCount += pointLightIntersects(pointLights[i], minCorner, maxCorner) ? 1u : 0u;
+    }
+    for (uint i = 0; i < spotLightsSize; i++)
+    {
+        spotCount += spotLightIntersects(spotLights[i], minCorner, maxCorner) ? 1u : 0u;
+    }
+    uint first = atomicAdd(clusterLightIndexCount, pointCount + spotCount);
+    // drop the lights that do not fit
+    uint room = first < maxClusterLightIndices ? maxClusterLightIndices - first : 0u;
+    pointCount = min(pointCount, room);
+    spotCount = min(spotCount, room - pointCount);
+    uint index = first;
+    for (uint i = 0; i < pointLightsSize && index < first + pointCount; i++)
+    {
+        if (pointLightIntersects(pointLights[i], minCorner, maxCorner))
+        {
+            clusterLightIndices[index++] = i;
+        }
+    }
+    for (uint i = 0; i < spotLightsSize && index < first + pointCount + spotCount; i++)
+    {
+        if (spotLightIntersects(spotLights[i], minCorner, maxCorner))
+        {
+            clusterLightIndices[index++] = i;
+        }
+    }
+    clusters[cluster] = uvec4(first, pointCount, spotCount, 0);
+}
+)glsl";
+
+// =========================== uniform and storage blocks shared by the shaders ================================
+namespace
+{
+
+// same layouts as the blocks in the shaders above, vec3 members are padded to 16 bytes as std140 requires
+struct DirectionalLightStd140
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec3 direction;
+    float padding;
+};
+// std430 elements of the point and spot light buffers
+struct PointLightStd430
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec3 location;
+    float constant;
+    float linear;
+    float quadratic;
+    float range;
+    GLint shadowIndex;
+};
+struct SpotLightStd430
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec3 location;
+    GLint shadowIndex;
+    glm::vec3 direction;
+    float cutOffAngle;
+    float strengthFactorExponent;
+    float range;
+    float padding[2];
+};
+template<std::size_t DirectionalSize>
+struct LightBlockStd140
+{
+    glm::vec4 globalAmbient;
+    GLuint directionalLightsSize;
+    GLuint pointLightsSize;
+    GLuint spotLightsSize;
+    GLuint shadowsSize;
+    DirectionalLightStd140 directionalLights[DirectionalSize];
+};
+struct FrameBlockStd140
+{
+    glm::mat4 viewMatrix;
+    glm::mat4 projMatrix;
+    GLint pcfMode;
+    GLfloat pcfFactor;
+    GLfloat clusterDepthScale;
+    GLfloat clusterDepthBias;
+    glm::uvec4 clusterGrid;
+    glm::vec4 clusterTileSize;
+};
+
+// element of InstanceBuffer
+struct InstanceStd430
+{
+    glm::mat4 modelMatrix;
+    glm::mat4 normalMatrix;
+    glm::vec4 color;
+    GLuint materialIndex;
+    GLuint padding[3];
+};
+
+// element of InstanceMaterialBuffer, the struct Material of the shaders
+struct MaterialStd430
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    GLfloat shininess;
+    GLfloat padding[3];
+};
+
+static_assert(sizeof(DirectionalLightStd140) == 64 && offsetof(DirectionalLightStd140, direction) == 48);
+static_assert(sizeof(PointLightStd430) == 80 && offsetof(PointLightStd430, constant) == 60 && offsetof(PointLightStd430, shadowIndex) == 76);
+static_assert(sizeof(SpotLightStd430) == 96 && offsetof(SpotLightStd430, direction) == 64 && offsetof(SpotLightStd430, range) == 84);
+static_assert(offsetof(LightBlockStd140<1>, directionalLights) == 32);
+static_assert(sizeof(InstanceStd430) == 160 && offsetof(InstanceStd430, materialIndex) == 144);
+static_assert(sizeof(MaterialStd430) == 64 && offsetof(MaterialStd430, shininess) == 48);
+static_assert(offsetof(FrameBlockStd140, pcfMode) == 128 && offsetof(FrameBlockStd140, clusterGrid) == 144 && sizeof(FrameBlockStd140) == 176);
+
+} // anonymous namespace
+
+// element of DrawParameterBuffer, the parameters of a draw of a multi-draw call
+struct DrawParametersStd430
+{
+    glm::mat4 modelMatrix;
+    glm::mat4 mvMatrix;
+    glm::mat4 normMatrix;
+    glm::vec4 color;
+    glm::vec4 materialAmbient;
+    glm::vec4 materialDiffuse;
+    glm::vec4 materialSpecular;
+    GLfloat materialShininess;
+    GLfloat materialWeight;
+    GLfloat textureWeight;
+    GLfloat heightFactor;
+};
+
+static_assert(sizeof(DrawParametersStd430) == 272 && offsetof(DrawParametersStd430, materialShininess) == 256);
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+// ======================================================= Renderer ==============================================
+Renderer::Renderer(const char* windowTitle, int width, int height, float axisLength)
+    : m_AxisLength(axisLength)
+{
+    // init glfw
     if (!glfwInit())
     {
         glfwTerminate();
@@ -1389,22 +2443,91 @@ Renderer::Renderer(const char* windowTitle, int width, int height, float axisLen
     }
     glfwSwapInterval(1);
 
-    // shaders
-    m_AxisesShader.setShaderSource(axisesVertexShader, axisesFragmentShader);
-    m_PureColorShader.setShaderSource(pureColorVertexShader, pureColorFragmentShader);
-    m_VaryingColorShader.setShaderSource(varyingColorVertexShader, varyingColorFragmentShader);
-    m_TextureShader.setShaderSource(textureVertexShader, textureFragmentShader);
-    m_GouraudMaterialTextureShader.setShaderSource(GouraudLightingMaterialTextureVertexShader, GouraudLightingMaterialTextureFragmentShader);
-    m_PhongMaterialTextureShader.setShaderSource(PhongLightingMaterialTextureVertexShader, PhongLightingMaterialTextureFragmentShader);
+    // shaders, all submitted before any is used so that the driver compiles them in parallel, the uniform handles below wait for them
+    setShaderCompilerThreads();
+    m_AxisesShader = Shader::submit(axisesVertexShader, axisesFragmentShader);
+    m_PureColorShader = Shader::submit(pureColorVertexShader, pureColorFragmentShader);
+    m_VaryingColorShader = Shader::submit(varyingColorVertexShader, varyingColorFragmentShader);
+    m_TextureShader = Shader::submit(textureVertexShader, textureFragmentShader);
+    // variants are compiled in display when a model needs them, the names in the order of the ShaderFeature bits
+    std::vector<std::string> featureNames = { "FLAT_SHADING", "BUMP_MAP", "NORMAL_MAP", "HEIGHT_MAP", "OCT_NORMALS",
+                                              "DIRECTIONAL_LIGHTS", "POINT_LIGHTS", "SPOT_LIGHTS", "INSTANCED", "MULTI_DRAW" };
+    // the multi-draw variants read the index of a draw from gl_DrawIDARB if the driver has it, else from the draw index attribute
+    std::vector<std::string> drawParameterDefines;
+    if (GLAD_GL_ARB_shader_draw_parameters)
+    {
+        drawParameterDefines.push_back("SHADER_DRAW_PARAMETERS");
+    }
+    m_GouraudMaterialTexturePrograms = ShaderPermutations(injectShaderDefines(GouraudLightingMaterialTextureVertexShader, drawParameterDefines),
+                                                          GouraudLightingMaterialTextureFragmentShader, featureNames);
+    m_PhongMaterialTexturePrograms = ShaderPermutations(injectShaderDefines(PhongLightingMaterialTextureVertexShader, drawParameterDefines),
+                                                        PhongLightingMaterialTextureFragmentShader, featureNames);
     // shadow
-    m_SimpleShadowDepthShader.setShaderSource(shadowDepthVertexShader, shadowDepthFragmentShader);
-    m_ShadowShader.setShaderSource(shadowShadingVertexShader, shadowShadingFragmentShader);
-    m_ShadowDebugShader1.setShaderSource(shadowDebugVertexShader1, shadowDebugFragmentShader1);
-    m_ShadowDebugShader2.setShaderSource(shadowDebugVertexShader2, shadowDebugFragmentShader2);
+    m_SimpleShadowDepthShader = Shader::submit(shadowDepthVertexShader, shadowDepthFragmentShader);
+    m_ShadowShader = Shader::submit(shadowShadingVertexShader, shadowShadingFragmentShader);
+    m_ShadowDebugShader1 = Shader::submit(shadowDebugVertexShader1, shadowDebugFragmentShader1);
+    m_ShadowDebugShader2 = Shader::submit(shadowDebugVertexShader2, shadowDebugFragmentShader2);
     // skybox
-    m_SkyBoxShader.setShaderSource(skyBoxVertexShader, skyBoxFragmentShader);
+    m_SkyBoxShader = Shader::submit(skyBoxVertexShader, skyBoxFragmentShader);
     // environment map
-    m_EnvironmentMapShader.setShaderSource(environmentMapVertexShader, environmentMapFragmentShader);
+    m_EnvironmentMapShader = Shader::submit(environmentMapVertexShader, environmentMapFragmentShader);
+    // light culling of clustered shading
+    m_LightCullingShader = Shader::submitCompute(lightCullingComputeShader);
+    // instanced variants, the transforms of the instances come from the instance buffer of the model
+    const std::string instancedDefines[] = { "INSTANCED" };
+    auto submitInstanced = [&](const char* vertexShader, const char* fragmentShader)
+    {
+        return Shader::submit(injectShaderDefines(vertexShader, instancedDefines), injectShaderDefines(fragmentShader, instancedDefines));
+    };
+    m_InstancedPureColorShader = submitInstanced(pureColorVertexShader, pureColorFragmentShader);
+    m_InstancedVaryingColorShader = submitInstanced(varyingColorVertexShader, varyingColorFragmentShader);
+    m_InstancedTextureShader = submitInstanced(textureVertexShader, textureFragmentShader);
+    m_InstancedShadowDepthShader = submitInstanced(shadowDepthVertexShader, shadowDepthFragmentShader);
+    m_InstancedShadowShader = submitInstanced(shadowShadingVertexShader, shadowShadingFragmentShader);
+    m_InstancedEnvironmentMapShader = submitInstanced(environmentMapVertexShader, environmentMapFragmentShader);
+    // multi-draw variants, the transforms and materials of the draws come from the draw parameter buffer
+    std::vector<std::string> multiDrawDefines = drawParameterDefines;
+    multiDrawDefines.push_back("MULTI_DRAW");
+    auto submitMultiDraw = [&](const char* vertexShader, const char* fragmentShader)
+    {
+        return Shader::submit(injectShaderDefines(vertexShader, multiDrawDefines), injectShaderDefines(fragmentShader, multiDrawDefines));
+    };
+    m_MultiDrawPureColorShader = submitMultiDraw(pureColorVertexShader, pureColorFragmentShader);
+    m_MultiDrawVaryingColorShader = submitMultiDraw(varyingColorVertexShader, varyingColorFragmentShader);
+    m_MultiDrawTextureShader = submitMultiDraw(textureVertexShader, textureFragmentShader);
+    m_MultiDrawShadowDepthShader = submitMultiDraw(shadowDepthVertexShader, shadowDepthFragmentShader);
+    // uniform handles
+    m_PureColorUniforms = ModelUniforms(m_PureColorShader);
+    m_VaryingColorUniforms = ModelUniforms(m_VaryingColorShader);
+    m_TextureUniforms = ModelUniforms(m_TextureShader);
+    m_ShadowUniforms = ModelUniforms(m_ShadowShader);
+    m_EnvironmentMapUniforms = ModelUniforms(m_EnvironmentMapShader);
+    m_ShadowDepthMVPUniform = m_SimpleShadowDepthShader.getUniform<glm::mat4>("shadowMVP");
+    m_InstancedShadowDepthMVPUniform = m_InstancedShadowDepthShader.getUniform<glm::mat4>("shadowMVP");
+    m_MultiDrawShadowDepthVPUniform = m_MultiDrawShadowDepthShader.getUniform<glm::mat4>("shadowMVP");
+    m_MultiDrawShadowDepthFirstDrawUniform = m_MultiDrawShadowDepthShader.getUniform<GLuint>("firstDraw");
+    // uniform buffers, filled every frame
+    glGenBuffers(1, &m_FrameUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_FrameUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlockStd140), nullptr, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &m_LightUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_LightUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlockStd140<MAX_DIRECTIONAL_LIGHT_SIZE>), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    // storage buffers of the clustered lights, filled every frame, and the uniforms of the light culling program
+    glGenBuffers(1, &m_PointLightSsbo);
+    glGenBuffers(1, &m_SpotLightSsbo);
+    glGenBuffers(1, &m_ClusterSsbo);
+    glGenBuffers(1, &m_ClusterLightIndexSsbo);
+    glGenBuffers(1, &m_ClusterBoundsSsbo);
+    glGenBuffers(1, &m_ClusterCounterSsbo);
+    m_CullingPointLightsSizeUniform = m_LightCullingShader.getUniform<GLuint>("pointLightsSize");
+    m_CullingSpotLightsSizeUniform = m_LightCullingShader.getUniform<GLuint>("spotLightsSize");
+    m_CullingClusterCountUniform = m_LightCullingShader.getUniform<GLuint>("clusterCount");
+    m_CullingMaxLightIndicesUniform = m_LightCullingShader.getUniform<GLuint>("maxClusterLightIndices");
+    // buffers of the multi-draw calls, filled every pass
+    glGenBuffers(1, &m_DrawCommandBuffer);
+    glGenBuffers(1, &m_DrawParameterSsbo);
 
     // init window attributes
     s_WindowAttrs.insert(std::make_pair(m_pWindow, WindowAttributes{}));
@@ -1495,6 +2618,8 @@ Renderer::Renderer(const char* windowTitle, int width, int height, float axisLen
 
 Renderer::~Renderer()
 {
+    deleteRetiredResources(true);
+    m_GeometryBuffers.release();
     glfwDestroyWindow(m_pWindow);
     glfwTerminate();
 }
@@ -1502,9 +2627,16 @@ Renderer::~Renderer()
 void Renderer::run()
 {
     checkForModelAttributes();
+    m_bRunning = true;
+    finishShaderPrograms();
     
-    // create shadow frame buffers
-    std::size_t shadowSize = m_DirectionalLights.size() + m_PointLights.size() + m_SpotLights.size();
+    // create shadow frame buffers, only for the first lights
+    std::size_t lightSize = m_DirectionalLights.size() + m_PointLights.size() + m_SpotLights.size();
+    std::size_t shadowSize = std::min(lightSize, MAX_SHADOW_SIZE);
+    if (lightSize > shadowSize)
+    {
+        Utils::Logger::globalLogger().debug(std::format("{} of {} lights cast shadows", shadowSize, lightSize));
+    }
     if (shadowSize > 0)
     {
         m_ShadowBuffers.resize(shadowSize);
@@ -1542,6 +2674,8 @@ void Renderer::run()
     // render loop
     while (!glfwWindowShouldClose(m_pWindow))
     {
+        deleteRetiredResources(false);
+        uploadPendingModels(false);
         updateViewArgsAccordingToCursorPos();
         if (m_bDisplayCallbackSet)
         {
@@ -1551,11 +2685,27 @@ void Renderer::run()
         {
             display(float(glfwGetTime()));
         }
+        fenceRetiredResources();
         glfwSwapBuffers(m_pWindow);
         glfwPollEvents();
     }
 }
 
+// the driver had the time from the constructor to now to compile them, some (debug, sky box) may never be used by display,
+// their shader objects are released and their binaries cached now too
+void Renderer::finishShaderPrograms()
+{
+    for (const Shader* pShader : { &m_AxisesShader, &m_PureColorShader, &m_VaryingColorShader, &m_TextureShader, &m_SimpleShadowDepthShader,
+                                   &m_ShadowShader, &m_ShadowDebugShader1, &m_ShadowDebugShader2, &m_SkyBoxShader, &m_EnvironmentMapShader,
+                                   &m_LightCullingShader, &m_InstancedPureColorShader, &m_InstancedVaryingColorShader, &m_InstancedTextureShader,
+                                   &m_InstancedShadowDepthShader, &m_InstancedShadowShader, &m_InstancedEnvironmentMapShader,
+                                   &m_MultiDrawPureColorShader, &m_MultiDrawVaryingColorShader, &m_MultiDrawTextureShader,
+                                   &m_MultiDrawShadowDepthShader })
+    {
+        pShader->finish();
+    }
+}
+
 // replace built-in display function, use user-defined display function, for customizing rendering
 // the call back is called in form of: func(pWindow, currentTime);
 void Renderer::setDisplayCallback(std::function<void(GLFWwindow*, float)> func)
@@ -1564,667 +2714,2162 @@ void Renderer::setDisplayCallback(std::function<void(GLFWwindow*, float)> func)
     m_DisplayCallback = func;
 }
 
-// add model to render, return it's index
-std::size_t Renderer::addModel(std::shared_ptr<Model> spModel, RenderStyle renderStyle)
+// =======================================model data upload=========================================
+
+// one vertex attribute or the indices of a model, in a view of the storage of the model or of a copy owned here
+struct AttributeData
 {
-    m_Models.push_back(ModelAttributes{});
-    ModelAttributes& attr = m_Models.back();
-    attr.spModel = spModel;
-    attr.style = renderStyle;
-    if (renderStyle == PhongShadingWithShadow)
+    bool supplied = false;
+    std::size_t count = 0; // element count
+    std::span<const char> bytes;
+    std::shared_ptr<const void> spStorage; // the copy or the quantized data, for models that do not provide views
+    // format of a vertex attribute
+    GLint components = 0;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    GLsizei vertexSize = 0; // bytes per vertex
+};
+
+// CPU side data of a model ready for upload, for async models it is prepared on a worker thread
+struct ModelUploadData
+{
+    // vertices, texCoords, normals, sTangents, tTangents, the index is the attribute location too
+    static constexpr GLuint attributeCount = 5;
+    static constexpr GLint components[attributeCount] = { 3, 2, 3, 3, 3 };
+
+    std::shared_ptr<Model> spModel;
+    bool indexed = false;
+    GLsizei drawCount = 0; // index count or vertex count
+    GLenum indexType = GL_UNSIGNED_INT;
+    bool quantized = false;
+    std::vector<MeshLod> lods; // ranges of the indices, empty without levels of detail
+    std::vector<Meshlet> meshlets;
+    std::vector<std::size_t> lodMeshlets; // first meshlet of every level of detail and the meshlet count
+    BoundingVolume bounds;
+    AttributeData indices;
+    AttributeData attributes[attributeCount]; // by attribute location, empty after interleaving
+    VertexLayout layout;
+    std::vector<char> interleaved; // the vertex buffer for InterleavedBuffer packing
+
+    std::size_t sizeInBytes() const
     {
-        attr.lightingMode = PhongShading;
+        std::size_t size = indices.bytes.size() + interleaved.size();
+        for (const auto& attribute : attributes)
+        {
+            size += attribute.bytes.size();
+        }
+        return size;
     }
+};
 
-    // vao
-    glGenVertexArrays(1, &attr.vao);
-    glBindVertexArray(attr.vao);
+// state shared by the loading task and the handles of an async model
+struct AsyncModelState
+{
+    std::shared_future<void> loaded;
+    std::unique_ptr<ModelUploadData> spData; // written by the loading task before loaded becomes ready, null if loader returned null
+    std::shared_ptr<Model> spModel;
+    std::atomic<bool> uploaded = false;
+};
 
-    // vbos
-    if (spModel->supplyIndices() && spModel->supplyVertices())
-    {
-        // ensuring the assumptions we depend on are valid.
-        static_assert(sizeof(glm::vec3) == sizeof(float) * 3);
-        static_assert(sizeof(glm::vec2) == sizeof(float) * 2);
-
-        std::vector<int> indices = spModel->getIndices();
-        std::vector<glm::vec3> vertices = spModel->getVertices();
-        glGenBuffers(1, &attr.indicesVbo);
-        glGenBuffers(1, &attr.verticesVbo);
-        attr.verticesCount = GLsizei(indices.size());
-        // indices
-        glBindBuffer(GL_ARRAY_BUFFER, attr.indicesVbo);
-        glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(int), indices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, attr.indicesVbo);
-        // vertices
-        glBindBuffer(GL_ARRAY_BUFFER, attr.verticesVbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(0);
+namespace
+{
 
-        if (spModel->supplyTexCoords())
-        {
-            std::vector<glm::vec2> texCoords = spModel->getTexCoords();
-            glGenBuffers(1, &attr.texCoordVbo);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.texCoordVbo);
-            glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(1);
-        }
-        if (spModel->supplyNormals())
-        {
-            std::vector<glm::vec3> normals = spModel->getNormals();
-            glGenBuffers(1, &attr.normalVbo);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.normalVbo);
-            glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(2);
-        }
-        if (spModel->supplyTangents())
-        {
-            std::vector<glm::vec3> sTanVec = spModel->getSTangents();
-            std::vector<glm::vec3> tTanVec = spModel->getTTangents();
-            glGenBuffers(1, &attr.sTanVbo);
-            glGenBuffers(1, &attr.tTanVbo);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.sTanVbo);
-            glBufferData(GL_ARRAY_BUFFER, sTanVec.size() * sizeof(glm::vec3), sTanVec.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(3);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.tTanVbo);
-            glBufferData(GL_ARRAY_BUFFER, tTanVec.size() * sizeof(glm::vec3), tTanVec.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(4);
-        }
-    }
-    else if (spModel->supplyVertices())
-    {
-        std::vector<float> vertices = spModel->getVerticesArray();
-        attr.verticesCount = GLsizei(vertices.size() / 3);
-        glGenBuffers(1, &attr.verticesVbo);
-        glBindBuffer(GL_ARRAY_BUFFER, attr.verticesVbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(0);
-        
-        if (spModel->supplyTexCoords())
-        {
-            std::vector<float> texCoords = spModel->getTexCoordsArray();
-            glGenBuffers(1, &attr.texCoordVbo);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.texCoordVbo);
-            glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(float), texCoords.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(1);
-        }
-        if (spModel->supplyNormals())
-        {
-            std::vector<float> normals = spModel->getNormalsArray();
-            glGenBuffers(1, &attr.normalVbo);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.normalVbo);
-            glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(float), normals.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(2);
-        }
-        if (spModel->supplyTangents())
-        {
-            std::vector<float> sTanVec = spModel->getSTangentsArray();
-            std::vector<float> tTanVec = spModel->getTTangentsArray();
-            glGenBuffers(1, &attr.sTanVbo);
-            glGenBuffers(1, &attr.tTanVbo);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.sTanVbo);
-            glBufferData(GL_ARRAY_BUFFER, sTanVec.size() * sizeof(float), sTanVec.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(3);
-            glBindBuffer(GL_ARRAY_BUFFER, attr.tTanVbo);
-            glBufferData(GL_ARRAY_BUFFER, tTanVec.size() * sizeof(float), tTanVec.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(4);
-        }
+// ensuring the assumptions we depend on are valid.
+static_assert(sizeof(glm::vec3) == sizeof(float) * 3);
+static_assert(sizeof(glm::vec2) == sizeof(float) * 2);
+
+// of the ranges of the geometry buffers, a multiple of the index sizes and of the sizes of the attribute components
+constexpr std::size_t geometryAlignment = 16;
+
+// use the view of the model if it provides one, else a copy returned by the vector getter
+template<typename T>
+AttributeData attributeData(std::span<const T> view, const std::function<std::vector<T>()>& getCopy)
+{
+    AttributeData res;
+    res.supplied = true;
+    if (view.empty())
+    {
+        auto spCopy = std::make_shared<const std::vector<T>>(getCopy());
+        view = *spCopy;
+        res.spStorage = std::move(spCopy);
     }
-    glBindVertexArray(0);
-    checkOpenGLError();
-    return m_Models.size() - 1;
+    res.count = view.size();
+    res.bytes = std::span<const char>(reinterpret_cast<const char*>(view.data()), view.size_bytes());
+    return res;
 }
 
-// add different kinds of lighting
-void Renderer::setGlobalAmbientLight(glm::vec4 ambient)
+// replace the data of a supplied attribute by its encoding
+template<typename T>
+void replaceAttributeData(AttributeData& attribute, std::vector<T>&& encoded, GLint components, GLenum type, GLboolean normalized)
 {
-    m_GlobalAmbient = ambient;
+    auto spEncoded = std::make_shared<const std::vector<T>>(std::move(encoded));
+    attribute.bytes = std::span<const char>(reinterpret_cast<const char*>(spEncoded->data()), spEncoded->size() * sizeof(T));
+    attribute.spStorage = std::move(spEncoded);
+    attribute.components = components;
+    attribute.type = type;
+    attribute.normalized = normalized;
+    attribute.vertexSize = GLsizei(sizeof(T) * components);
 }
-void Renderer::addDirectionalLight(const DirectionalLight& light)
+
+std::span<const float> floatsOf(const AttributeData& attribute)
 {
-    if (m_DirectionalLights.size() == MAX_DIRECTIONAL_LIGHT_SIZE)
+    return std::span<const float>(reinterpret_cast<const float*>(attribute.bytes.data()), attribute.bytes.size() / sizeof(float));
+}
+
+// triangles in vertex cache and overdraw order, vertices in order of first use
+// replace the indices by a copy owned here
+void replaceIndices(AttributeData& indices, std::vector<int>&& replacement)
+{
+    auto spIndices = std::make_shared<const std::vector<int>>(std::move(replacement));
+    indices.bytes = std::span<const char>(reinterpret_cast<const char*>(spIndices->data()), spIndices->size() * sizeof(int));
+    indices.count = spIndices->size();
+    indices.spStorage = std::move(spIndices);
+}
+
+std::span<const int> indicesOf(const ModelUploadData& data)
+{
+    return std::span<const int>(reinterpret_cast<const int*>(data.indices.bytes.data()), data.indices.count);
+}
+
+std::span<const glm::vec3> verticesOf(const ModelUploadData& data)
+{
+    return std::span<const glm::vec3>(reinterpret_cast<const glm::vec3*>(data.attributes[0].bytes.data()), data.attributes[0].count);
+}
+
+// bounding box, and the bounding sphere around its center
+void computeBounds(ModelUploadData& data)
+{
+    std::span<const float> floats(reinterpret_cast<const float*>(data.attributes[0].bytes.data()), data.attributes[0].bytes.size() / sizeof(float));
+    if (floats.size() < 3)
     {
-        Utils::Logger::globalLogger().warning(std::format("Directional light sources number exceed the limit of {}!", MAX_DIRECTIONAL_LIGHT_SIZE));
+        return;
     }
-    else
+    glm::vec3 minCorner(floats[0], floats[1], floats[2]), maxCorner = minCorner;
+    for (std::size_t i = 0; i + 2 < floats.size(); i += 3)
     {
-        m_DirectionalLights.push_back(light);
+        glm::vec3 p(floats[i], floats[i + 1], floats[i + 2]);
+        minCorner = glm::min(minCorner, p);
+        maxCorner = glm::max(maxCorner, p);
+    }
+    data.bounds.boxCenter = (minCorner + maxCorner) * 0.5f;
+    data.bounds.boxExtent = (maxCorner - minCorner) * 0.5f;
+    data.bounds.sphereCenter = data.bounds.boxCenter;
+    float radius = 0.0f;
+    for (std::size_t i = 0; i + 2 < floats.size(); i += 3)
+    {
+        radius = std::max(radius, glm::length(glm::vec3(floats[i], floats[i + 1], floats[i + 2]) - data.bounds.sphereCenter));
     }
+    data.bounds.sphereRadius = radius;
 }
-void Renderer::addDirectionalLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 direction)
+
+// simplified levels of detail after the full mesh in the indices, they share the vertices
+void generateLods(ModelUploadData& data)
 {
-    if (m_DirectionalLights.size() == MAX_DIRECTIONAL_LIGHT_SIZE)
+    std::vector<MeshLod> lods;
+    std::vector<int> chain = buildLodChain(indicesOf(data), verticesOf(data), lods);
+    replaceIndices(data.indices, std::move(chain));
+    data.drawCount = GLsizei(lods.front().indexCount);
+    data.lods = std::move(lods);
+    std::string levels;
+    for (const auto& lod : data.lods)
     {
-        Utils::Logger::globalLogger().warning(std::format("Directional light sources number exceed the limit of {}!", MAX_DIRECTIONAL_LIGHT_SIZE));
+        levels += std::format(" {} ({:.4f})", lod.indexCount / 3, lod.error);
     }
-    else
+    Logger::globalLogger().debug(std::format("Levels of detail, triangles (error):{}", levels));
+}
+
+// triangles of every level of detail in vertex cache and overdraw order, vertices in order of first use
+void optimizeModelData(ModelUploadData& data)
+{
+    std::span<const int> indices = indicesOf(data);
+    std::span<const glm::vec3> vertices = verticesOf(data);
+    std::vector<MeshLod> ranges = data.lods;
+    if (ranges.empty())
     {
-        m_DirectionalLights.emplace_back(ambient, diffuse, specular, direction);
+        ranges.push_back(MeshLod{ 0, indices.size(), 0.0f });
+    }
+    std::vector<int> ordered;
+    ordered.reserve(indices.size());
+    std::vector<std::size_t> clusters;
+    for (const auto& range : ranges)
+    {
+        std::vector<int> cacheOrder = optimizeVertexCache(indices.subspan(range.firstIndex, range.indexCount), vertices.size(), optimizerCacheSize, &clusters);
+        std::vector<int> overdrawOrder = optimizeOverdraw(cacheOrder, vertices, clusters);
+        ordered.insert(ordered.end(), overdrawOrder.begin(), overdrawOrder.end());
+    }
+    std::vector<int> remap;
+    std::size_t vertexCount = buildVertexFetchRemap(ordered, vertices.size(), remap);
+    std::transform(ordered.begin(), ordered.end(), ordered.begin(), [&](int idx) { return remap[idx]; });
+    VertexCacheStatistics before = analyzeVertexCache(indices.first(ranges.front().indexCount), vertices.size(), optimizerCacheSize);
+    VertexCacheStatistics after = analyzeVertexCache(std::span<const int>(ordered).first(ranges.front().indexCount), vertexCount, optimizerCacheSize);
+
+    for (auto& attribute : data.attributes)
+    {
+        if (attribute.supplied)
+        {
+            std::size_t vertexSize = std::size_t(attribute.vertexSize);
+            auto spRemapped = std::make_shared<const std::vector<char>>(remapVertices(attribute.bytes, vertexSize, remap, vertexCount));
+            attribute.bytes = *spRemapped;
+            attribute.count = vertexCount;
+            attribute.spStorage = std::move(spRemapped);
+        }
     }
+    replaceIndices(data.indices, std::move(ordered));
+    Logger::globalLogger().debug(std::format("Mesh optimization of {} triangles: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} ({} entries FIFO cache).",
+        before.triangles, before.acmr, after.acmr, before.atvr, after.atvr, optimizerCacheSize));
 }
-void Renderer::addPointLight(const PointLight& light)
+
+// meshlets of every level of detail, the triangles are reordered by meshlet within their level
+void buildModelMeshlets(ModelUploadData& data)
 {
-    if (m_PointLights.size() == MAX_POINT_LIGHT_SIZE)
+    std::span<const int> indices = indicesOf(data);
+    std::span<const glm::vec3> vertices = verticesOf(data);
+    std::vector<MeshLod> ranges = data.lods;
+    if (ranges.empty())
     {
-        Utils::Logger::globalLogger().warning(std::format("Point light sources number exceed the limit of {}!", MAX_POINT_LIGHT_SIZE));
+        ranges.push_back(MeshLod{ 0, indices.size(), 0.0f });
     }
-    else
+    std::vector<int> ordered;
+    ordered.reserve(indices.size());
+    std::vector<Meshlet> meshlets;
+    for (const auto& range : ranges)
+    {
+        data.lodMeshlets.push_back(data.meshlets.size());
+        std::vector<int> levelIndices = buildMeshlets(indices.subspan(range.firstIndex, range.indexCount), vertices, meshlets);
+        for (auto& meshlet : meshlets)
+        {
+            meshlet.firstIndex += range.firstIndex;
+            data.meshlets.push_back(meshlet);
+        }
+        ordered.insert(ordered.end(), levelIndices.begin(), levelIndices.end());
+    }
+    data.lodMeshlets.push_back(data.meshlets.size());
+    replaceIndices(data.indices, std::move(ordered));
+
+    std::size_t fullMeshlets = data.lodMeshlets[1], fullVertices = 0;
+    for (std::size_t i = 0; i < fullMeshlets; i++)
     {
-        m_PointLights.push_back(light);
+        fullVertices += data.meshlets[i].vertexCount;
     }
+    Logger::globalLogger().debug(std::format("{} meshlets of {} triangles, {:.1f} vertices and {:.1f} triangles per meshlet.", fullMeshlets,
+        ranges.front().indexCount / 3, double(fullVertices) / double(fullMeshlets), double(ranges.front().indexCount / 3) / double(fullMeshlets)));
 }
-void Renderer::addPointLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 location, float constant, float linear, float quadratic)
+
+// half float texCoords, octahedral snorm16 normals and tangents, and 16 bits indices if the vertex count allows.
+// vertices stay 32 bits floats, their precision is what the depth test and the shadows depend on.
+void quantizeAttributes(ModelUploadData& data)
 {
-    if (m_PointLights.size() == MAX_POINT_LIGHT_SIZE)
+    AttributeData& texCoords = data.attributes[1];
+    if (texCoords.supplied)
     {
-        Utils::Logger::globalLogger().warning(std::format("Point light sources number exceed the limit of {}!", MAX_POINT_LIGHT_SIZE));
+        replaceAttributeData(texCoords, quantizeHalfFloats(floatsOf(texCoords)), 2, GL_HALF_FLOAT, GL_FALSE);
     }
-    else
+    // normals, sTangents, tTangents
+    for (GLuint i = 2; i < ModelUploadData::attributeCount; i++)
+    {
+        AttributeData& directions = data.attributes[i];
+        if (directions.supplied)
+        {
+            replaceAttributeData(directions, quantizeDirections(floatsOf(directions)), 2, GL_SHORT, GL_TRUE);
+        }
+    }
+    std::size_t vertexCount = data.attributes[0].bytes.size() / std::size_t(data.attributes[0].vertexSize);
+    if (data.indexed && vertexCount <= maxShortIndexVertexCount)
     {
-        m_PointLights.emplace_back(ambient, diffuse, specular, location, constant, linear, quadratic);
+        std::span<const int> indices(reinterpret_cast<const int*>(data.indices.bytes.data()), data.indices.count);
+        replaceAttributeData(data.indices, narrowIndices(indices), 1, GL_UNSIGNED_SHORT, GL_FALSE);
+        data.indexType = GL_UNSIGNED_SHORT;
     }
+    data.quantized = true;
 }
-void Renderer::addSpotLight(const SpotLight& light)
+
+// the separate attributes packed next to each other in every vertex as described by the interleaved layout
+std::vector<char> interleavedVertices(const ModelUploadData& data, const VertexLayout& layout, std::size_t vertexCount)
 {
-    if (m_SpotLights.size() == MAX_SPOT_LIGHT_SIZE)
+    std::size_t stride = std::size_t(layout.getStride());
+    std::vector<char> interleaved(vertexCount * stride);
+    for (const auto& attribute : layout.getAttributes())
     {
-        Utils::Logger::globalLogger().warning(std::format("Spot light sources number exceed the limit of {}!", MAX_SPOT_LIGHT_SIZE));
+        const char* pSrc = data.attributes[attribute.location].bytes.data();
+        char* pDst = interleaved.data() + attribute.offset;
+        std::size_t size = std::size_t(attribute.size);
+        for (std::size_t i = 0; i < vertexCount; i++)
+        {
+            std::memcpy(pDst + i * stride, pSrc + i * size, size);
+        }
     }
-    else
+    return interleaved;
+}
+
+// pack the attributes of every vertex next to each other as described by the layout, release the separate attributes
+void interleaveAttributes(ModelUploadData& data, std::size_t vertexCount)
+{
+    data.interleaved = interleavedVertices(data, data.layout, vertexCount);
+    for (const auto& attribute : data.layout.getAttributes())
     {
-        m_SpotLights.push_back(light);
+        data.attributes[attribute.location].bytes = {};
+        data.attributes[attribute.location].spStorage.reset();
     }
 }
-void Renderer::addSpotLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 location, glm::vec3 direction, float cutoff, float exponent)
+
+// describe the supplied attributes, and pack them to one buffer for InterleavedBuffer packing
+void layoutAttributes(ModelUploadData& data, VertexPacking packing)
 {
-    if (m_SpotLights.size() == MAX_SPOT_LIGHT_SIZE)
+    std::size_t vertexCount = data.attributes[0].bytes.size() / std::size_t(data.attributes[0].vertexSize);
+    if (packing == InterleavedBuffer)
+    {
+        for (GLuint i = 0; i < ModelUploadData::attributeCount; i++)
+        {
+            const AttributeData& attribute = data.attributes[i];
+            if (attribute.supplied && attribute.bytes.size() != vertexCount * std::size_t(attribute.vertexSize))
+            {
+                Logger::globalLogger().warning("Model attributes have different vertex counts, can not be interleaved, use separate buffers instead.");
+                packing = SeparateBuffers;
+                break;
+            }
+        }
+    }
+    data.layout = VertexLayout(packing);
+    for (GLuint i = 0; i < ModelUploadData::attributeCount; i++)
     {
-        Utils::Logger::globalLogger().warning(std::format("Spot light sources number exceed the limit of {}!", MAX_SPOT_LIGHT_SIZE));
+        const AttributeData& attribute = data.attributes[i];
+        if (attribute.supplied)
+        {
+            data.layout.addAttribute(i, attribute.components, attribute.type, attribute.normalized, attribute.vertexSize);
+        }
     }
-    else
+    if (packing == InterleavedBuffer)
     {
-        m_SpotLights.emplace_back(ambient, diffuse, specular, location, direction, cutoff, exponent);
+        interleaveAttributes(data, vertexCount);
     }
 }
 
-// set face culling attributes, defualt to true/GL_BACK/GL_CCW
-void Renderer::setFaceCullingAttribute(bool enable, GLenum mode, GLenum front)
+// collect the data of glDrawElements if indices are supplied, else the data of glDrawArrays. does not use OpenGL.
+std::unique_ptr<ModelUploadData> prepareModelData(std::shared_ptr<Model> spModel, VertexPacking packing, unsigned processing)
 {
-    m_bEnableCullFace = enable;
-    m_FaceCullingMode = mode;
-    m_FrontFace = front;
-} 
+    auto spData = std::make_unique<ModelUploadData>();
+    ModelUploadData& data = *spData;
+    Model& model = *spModel;
+    data.spModel = spModel;
+    if (model.supplyIndices() && model.supplyVertices())
+    {
+        data.indexed = true;
+        data.indices = attributeData<int>(model.getIndicesView(), [&]() { return model.getIndices(); });
+        data.drawCount = GLsizei(data.indices.count);
+        data.attributes[0] = attributeData<glm::vec3>(model.getVerticesView(), [&]() { return model.getVertices(); });
+        if (model.supplyTexCoords())
+        {
+            data.attributes[1] = attributeData<glm::vec2>(model.getTexCoordsView(), [&]() { return model.getTexCoords(); });
+        }
+        if (model.supplyNormals())
+        {
+            data.attributes[2] = attributeData<glm::vec3>(model.getNormalsView(), [&]() { return model.getNormals(); });
+        }
+        if (model.supplyTangents())
+        {
+            data.attributes[3] = attributeData<glm::vec3>(model.getSTangentsView(), [&]() { return model.getSTangents(); });
+            data.attributes[4] = attributeData<glm::vec3>(model.getTTangentsView(), [&]() { return model.getTTangents(); });
+        }
+    }
+    else if (model.supplyVertices())
+    {
+        data.attributes[0] = attributeData<float>({}, [&]() { return model.getVerticesArray(); });
+        data.drawCount = GLsizei(data.attributes[0].count / 3);
+        if (model.supplyTexCoords())
+        {
+            data.attributes[1] = attributeData<float>({}, [&]() { return model.getTexCoordsArray(); });
+        }
+        if (model.supplyNormals())
+        {
+            data.attributes[2] = attributeData<float>({}, [&]() { return model.getNormalsArray(); });
+        }
+        if (model.supplyTangents())
+        {
+            data.attributes[3] = attributeData<float>({}, [&]() { return model.getSTangentsArray(); });
+            data.attributes[4] = attributeData<float>({}, [&]() { return model.getTTangentsArray(); });
+        }
+    }
+    // 32 bits floats unless quantized
+    for (GLuint i = 0; i < ModelUploadData::attributeCount; i++)
+    {
+        data.attributes[i].components = ModelUploadData::components[i];
+        data.attributes[i].vertexSize = GLsizei(sizeof(float) * ModelUploadData::components[i]);
+    }
+    computeBounds(data);
+    if ((processing & Renderer::GenerateLods) && data.indexed)
+    {
+        generateLods(data);
+    }
+    if ((processing & Renderer::OptimizeMesh) && data.indexed)
+    {
+        optimizeModelData(data);
+    }
+    if ((processing & Renderer::BuildMeshlets) && data.indexed && data.indices.count >= 3)
+    {
+        buildModelMeshlets(data);
+    }
+    if ((processing & Renderer::QuantizeAttributes) && model.supplyVertices())
+    {
+        quantizeAttributes(data);
+    }
+    layoutAttributes(data, packing);
+    return spData;
+}
 
-// set PCF(Percentage Closer Filtering) mode, for soft shadow, default to NoPCF, only affect models with PhongShadingWithShadow style
-void Renderer::setPCFMode(PCFMode mode, float pcfFactor)
+} // anonymous namespace
+
+// =======================================AsyncModelHandle==========================================
+
+AsyncModelHandle::AsyncModelHandle(ModelHandle model, std::shared_ptr<AsyncModelState> spState)
+    : m_Model(model)
+    , m_spState(std::move(spState))
 {
-    m_PCFMode = mode;
-    m_PCFFactor = pcfFactor;
 }
 
-void Renderer::enableSkyBox(const char* rightImage, const char* leftImage,
-                            const char* topImage, const char* bottomImage,
-                            const char* frontImage, const char* backImage)
+std::size_t AsyncModelHandle::index() const
 {
-    m_bEanbleSkyBox = true;
-    m_SkyBoxTexture = loadCubeMap(rightImage, leftImage,
-                                   topImage, bottomImage,
-                                   frontImage, backImage);
-    std::vector<float> vertices = {
-        -1.0f,  1.0f, -1.0f,
-        -1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
+    return m_Model.index;
+}
 
-        -1.0f, -1.0f,  1.0f,
-        -1.0f, -1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,
+ModelHandle AsyncModelHandle::model() const
+{
+    return m_Model;
+}
 
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
+bool AsyncModelHandle::valid() const
+{
+    return m_spState != nullptr;
+}
 
-        -1.0f, -1.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f, -1.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,
+bool AsyncModelHandle::isLoaded() const
+{
+    return m_spState->loaded.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
 
-        -1.0f,  1.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,
-        -1.0f,  1.0f, -1.0f,
+bool AsyncModelHandle::isUploaded() const
+{
+    return m_spState->uploaded.load();
+}
 
-        -1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f,  1.0f
-    };
-    m_SkyBoxVerticesCount = GLsizei(vertices.size() / 3);
-    glGenVertexArrays(1, &m_SkyBoxVao);
-    glBindVertexArray(m_SkyBoxVao);
-    glGenBuffers(1, &m_SkyBoxVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_SkyBoxVbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-    // set texture attributes
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_SkyBoxTexture);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    checkOpenGLError();
+void AsyncModelHandle::wait() const
+{
+    m_spState->loaded.wait();
 }
 
-// set model attributes
-// set rotatoin attributes, default to false
-void Renderer::setModelRotation(std::size_t modelIndex, glm::vec3 rotationAxis, float rotationRate)
+std::shared_ptr<Model> AsyncModelHandle::get() const
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].bRotate = true;
-    m_Models[modelIndex].rotationAxis = rotationAxis;
-    m_Models[modelIndex].rotationRate = rotationRate;
+    m_spState->loaded.get();
+    return m_spState->spModel;
 }
 
-// set render style
-void Renderer::setRenderStyle(std::size_t modelIndex, RenderStyle renderStyle)
+// =======================================Renderer: models==========================================
+
+// add model to render, return its handle
+ModelHandle Renderer::addModel(std::shared_ptr<Model> spModel, RenderStyle renderStyle, VertexPacking packing, unsigned processing)
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].style = renderStyle;
+    ModelHandle model = addModelAttributes(renderStyle);
+    uploadModel(model.index, *prepareModelData(spModel, packing, processing));
+    return model;
 }
 
-// set color to render, for PureColorPoints/PureColorLineStrip/PureColorTriangles style, default to 
-void Renderer::setColor(std::size_t modelIndex, glm::vec4 color)
+// add model that is loaded on a worker thread, the returned handle holds the model index for the setters below.
+AsyncModelHandle Renderer::addModelAsync(std::function<std::shared_ptr<Model>()> loader, RenderStyle renderStyle, VertexPacking packing, unsigned processing)
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].color = color;
+    ModelHandle model = addModelAttributes(renderStyle);
+    auto spState = std::make_shared<AsyncModelState>();
+    spState->loaded = ThreadPool::globalPool().submit([spState, loader, packing, processing]()
+    {
+        std::shared_ptr<Model> spModel = loader();
+        if (spModel)
+        {
+            spState->spData = prepareModelData(spModel, packing, processing);
+        }
+        spState->spModel = std::move(spModel);
+    }).share();
+    AsyncModelHandle handle(model, std::move(spState));
+    m_PendingModels.push_back(handle);
+    return handle;
 }
 
-// set texture for model, just for SpecificTexture/LightingMaterialTexture style
-void Renderer::setTexture(std::size_t modelIndex, const char* textureImagePath, float weight, bool doMipmapping, bool doAnisotropicFiltering)
+void Renderer::setAsyncUploadBudget(std::size_t bytesPerFrame)
 {
-    assert(modelIndex < m_Models.size());
-    setTexture(modelIndex, loadTexture(textureImagePath), weight, doMipmapping, doAnisotropicFiltering);
+    m_AsyncUploadBudget = bytesPerFrame;
 }
-void Renderer::setTexture(std::size_t modelIndex, GLuint textureId, float weight, bool doMipmapping, bool doAnisotropicFiltering)
+
+void Renderer::finishAsyncModels()
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].texture = textureId;
-    m_Models[modelIndex].textureWeight = weight;
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    if (doMipmapping)
+    uploadPendingModels(true);
+}
+
+// the slot of a removed model, or a new one
+ModelHandle Renderer::addModelAttributes(RenderStyle renderStyle)
+{
+    std::uint32_t modelIndex = m_ModelSlots.acquire();
+    if (modelIndex == m_Models.size())
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmapping
+        m_Models.emplace_back();
     }
-    if (doAnisotropicFiltering && GLAD_GL_EXT_texture_filter_anisotropic) // check if anisotropic filtering extension is supported ?
+    ModelAttributes& attr = m_Models[modelIndex];
+    attr.style = renderStyle;
+    if (renderStyle == PhongShadingWithShadow)
     {
-        GLfloat anisoSetting = 0.0f;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoSetting);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisoSetting); // enable anisotropic filtering
+        attr.lightingMode = PhongShading;
     }
+    updateResourceStatistics();
+    return ModelHandle{ modelIndex, m_ModelSlots.getGeneration(modelIndex) };
 }
 
-// set material for model, for LightingMaterialTexture style
-void Renderer::setMaterial(std::size_t modelIndex, const Material& material, float weight)
+bool Renderer::isModelValid(ModelHandle model) const
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].spMaterial = std::make_unique<Material>(material);
-    m_Models[modelIndex].materialWeight = weight;
+    return m_ModelSlots.isLive(model.index, model.generation);
 }
 
-// set lighting mode of model
-void Renderer::setLightingMode(std::size_t modelIndex, LightingMode mode)
+void Renderer::removeModel(ModelHandle model)
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].lightingMode = mode;
+    if (!isModelValid(model))
+    {
+        Logger::globalLogger().warning(std::format("Remove model {} of generation {}: the handle is stale.", model.index, model.generation));
+        return;
+    }
+    std::erase_if(m_PendingModels, [&](const AsyncModelHandle& handle) { return handle.index() == model.index; });
+    ModelAttributes& attr = m_Models[model.index];
+    retireModelGeometry(attr);
+    for (GLuint buffer : { attr.instanceSsbo, attr.instanceMaterialSsbo })
+    {
+        if (buffer != 0)
+        {
+            m_Retiring.buffers.push_back(buffer);
+        }
+    }
+    releaseTexture(attr.texture);
+    releaseTexture(attr.normalMap);
+    releaseTexture(attr.heightMap);
+    if (attr.bRotate)
+    {
+        std::erase(m_RotatingModels, model.index);
+    }
+    attr = ModelAttributes{};
+    m_ChangedModels.push_back(model.index);
+    m_ModelSlots.release(model.index);
+    updateResourceStatistics();
 }
 
-// enable bump map for model, only for LightingMaterialTexture style
-void Renderer::enableBumpMap(std::size_t modelIndex)
+void Renderer::replaceModel(ModelHandle model, std::shared_ptr<Model> spModel, VertexPacking packing, unsigned processing)
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].generateBumpMap = true;
+    if (!isModelValid(model))
+    {
+        Logger::globalLogger().warning(std::format("Replace model {} of generation {}: the handle is stale.", model.index, model.generation));
+        return;
+    }
+    std::erase_if(m_PendingModels, [&](const AsyncModelHandle& handle) { return handle.index() == model.index; });
+    retireModelGeometry(m_Models[model.index]);
+    uploadModel(model.index, *prepareModelData(spModel, packing, processing));
+    if (m_bRunning)
+    {
+        checkModelAttributes(model.index);
+    }
+    updateResourceStatistics();
 }
 
-// set normal map for model, only for LightingMaterialTexture style
-void Renderer::setNormalMap(std::size_t modelIndex, const char* textureImagePath, bool doMipmapping, bool doAnisotropicFiltering)
+void Renderer::retireModelGeometry(ModelAttributes& attr)
 {
-    assert(modelIndex < m_Models.size());
-    setNormalMap(modelIndex, loadTexture(textureImagePath), doMipmapping, doAnisotropicFiltering);
+    if (attr.pArena)
+    {
+        m_Retiring.arenaRanges.emplace_back(attr.pArena, attr.arenaRange);
+        m_MultiDrawStats.arenaModels--;
+    }
+    else
+    {
+        if (attr.vao != 0)
+        {
+            m_Retiring.vertexArrays.push_back(attr.vao);
+        }
+        for (BufferHandle allocation : attr.vertexAllocations)
+        {
+            if (allocation != BufferAllocator::invalidHandle)
+            {
+                m_Retiring.allocations.push_back(allocation);
+            }
+        }
+        if (attr.indexAllocation != BufferAllocator::invalidHandle)
+        {
+            m_Retiring.allocations.push_back(attr.indexAllocation);
+        }
+    }
+    attr.vao = 0;
+    attr.pArena = nullptr;
+    attr.indexAllocation = BufferAllocator::invalidHandle;
+    attr.vertexAllocations.fill(BufferAllocator::invalidHandle);
+    attr.firstIndex = 0;
+    attr.baseVertex = 0;
+    attr.bUploaded = false;
 }
-void Renderer::setNormalMap(std::size_t modelIndex, GLuint textureId, bool doMipmapping, bool doAnisotropicFiltering)
+
+// =======================================Renderer: textures and retired resources==================
+
+std::uint32_t Renderer::acquireTexture(const std::string& textureImagePath)
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].enableNormalMap = true;
-    m_Models[modelIndex].normalMap = textureId;
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    if (doMipmapping)
+    auto it = m_TextureSlotsByPath.find(textureImagePath);
+    if (it != m_TextureSlotsByPath.end())
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmapping
+        return it->second;
     }
-    if (doAnisotropicFiltering && GLAD_GL_EXT_texture_filter_anisotropic) // check if anisotropic filtering extension is supported ?
+    std::uint32_t slot = m_TextureSlots.acquire();
+    if (slot == m_Textures.size())
     {
-        GLfloat anisoSetting = 0.0f;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoSetting);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisoSetting); // enable anisotropic filtering
+        m_Textures.emplace_back();
+    }
+    m_Textures[slot] = TextureEntry{ loadTexture(textureImagePath), textureImagePath, 0 };
+    m_TextureSlotsByPath.emplace(textureImagePath, slot);
+    m_TextureSlotsById.emplace(m_Textures[slot].id, slot);
+    updateResourceStatistics();
+    return slot;
+}
+
+void Renderer::retainTexture(GLuint textureId)
+{
+    auto it = m_TextureSlotsById.find(textureId);
+    if (it != m_TextureSlotsById.end())
+    {
+        m_Textures[it->second].references++;
+    }
+}
+
+void Renderer::releaseTexture(GLuint textureId)
+{
+    auto it = m_TextureSlotsById.find(textureId);
+    if (it == m_TextureSlotsById.end())
+    {
+        return;
+    }
+    std::uint32_t slot = it->second;
+    TextureEntry& entry = m_Textures[slot];
+    if (entry.references > 1)
+    {
+        entry.references--;
+        return;
+    }
+    m_Retiring.textures.push_back(entry.id);
+    m_TextureSlotsById.erase(it);
+    m_TextureSlotsByPath.erase(entry.path);
+    entry = TextureEntry{};
+    m_TextureSlots.release(slot);
+    updateResourceStatistics();
+}
+
+TextureHandle Renderer::addTexture(const char* textureImagePath)
+{
+    std::uint32_t slot = acquireTexture(textureImagePath);
+    m_Textures[slot].references++;
+    return TextureHandle{ slot, m_TextureSlots.getGeneration(slot) };
+}
+
+void Renderer::removeTexture(TextureHandle texture)
+{
+    if (!m_TextureSlots.isLive(texture.index, texture.generation))
+    {
+        Logger::globalLogger().warning(std::format("Remove texture {} of generation {}: the handle is stale.", texture.index, texture.generation));
+        return;
+    }
+    releaseTexture(m_Textures[texture.index].id);
+}
+
+GLuint Renderer::getTexture(TextureHandle texture) const
+{
+    return m_TextureSlots.isLive(texture.index, texture.generation) ? m_Textures[texture.index].id : 0;
+}
+
+void Renderer::fenceRetiredResources()
+{
+    if (m_Retiring.objectCount() == 0)
+    {
+        return;
+    }
+    m_Retiring.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_RetiredResources.push_back(std::move(m_Retiring));
+    m_Retiring = RetiredResources{};
+    updateResourceStatistics();
+}
+
+void Renderer::deleteRetiredResources(bool deleteAll)
+{
+    if (deleteAll)
+    {
+        m_RetiredResources.push_back(std::move(m_Retiring));
+        m_Retiring = RetiredResources{};
+    }
+    while (!m_RetiredResources.empty())
+    {
+        // the fences are passed in order, a frame that is not finished is followed by frames that are not finished either
+        RetiredResources& retired = m_RetiredResources.front();
+        if (!deleteAll && retired.fence && glClientWaitSync(retired.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            break;
+        }
+        if (retired.fence)
+        {
+            glDeleteSync(retired.fence);
+        }
+        glDeleteVertexArrays(GLsizei(retired.vertexArrays.size()), retired.vertexArrays.data());
+        glDeleteBuffers(GLsizei(retired.buffers.size()), retired.buffers.data());
+        glDeleteTextures(GLsizei(retired.textures.size()), retired.textures.data());
+        for (BufferHandle allocation : retired.allocations)
+        {
+            m_GeometryBuffers.free(allocation);
+        }
+        for (const auto& [pArena, range] : retired.arenaRanges)
+        {
+            pArena->remove(range);
+        }
+        m_ResourceStats.deletedObjects += retired.objectCount();
+        m_RetiredResources.pop_front();
+    }
+    updateResourceStatistics();
+}
+
+void Renderer::updateResourceStatistics()
+{
+    m_ResourceStats.models = m_ModelSlots.getLiveCount();
+    m_ResourceStats.modelSlots = m_ModelSlots.getSize();
+    m_ResourceStats.textures = m_TextureSlots.getLiveCount();
+    m_ResourceStats.retiredFrames = m_RetiredResources.size();
+    m_ResourceStats.retiredObjects = m_Retiring.objectCount();
+    for (const auto& retired : m_RetiredResources)
+    {
+        m_ResourceStats.retiredObjects += retired.objectCount();
+    }
+}
+
+const ResourceStatistics& Renderer::getResourceStatistics() const
+{
+    return m_ResourceStats;
+}
+
+// create the vao of the model and upload its vertices and indices to the geometry buffers or an arena, the model is drawn after this
+void Renderer::uploadModel(std::size_t modelIndex, const ModelUploadData& data)
+{
+    ModelAttributes& attr = m_Models[modelIndex];
+    attr.spModel = data.spModel;
+    attr.verticesCount = data.drawCount;
+    attr.indexType = data.indexType;
+    attr.bQuantized = data.quantized;
+    attr.lods = data.lods;
+    attr.currentLod = 0;
+    attr.meshlets = data.meshlets;
+    attr.lodMeshlets = data.lodMeshlets;
+    attr.bMeshletsCulled = false;
+    attr.bounds = data.bounds;
+    updateInstanceBounds(modelIndex);
+    if (m_bMultiDrawIndirect && data.indexed && uploadToMeshArena(attr, data))
+    {
+        attr.bUploaded = true;
+        return;
+    }
+
+    // ranges of the geometry buffers, owned by the model index and generation
+    std::uint64_t owner = std::uint64_t(m_ModelSlots.getGeneration(std::uint32_t(modelIndex))) << 32 | modelIndex;
+    if (data.indexed)
+    {
+        attr.indexAllocation = m_GeometryBuffers.allocate(data.indices.bytes.size(), geometryAlignment, owner);
+        m_GeometryBuffers.upload(attr.indexAllocation, data.indices.bytes.data(), data.indices.bytes.size());
+    }
+    if (data.layout.getPacking() == InterleavedBuffer)
+    {
+        // all attributes in one range
+        attr.vertexAllocations[0] = m_GeometryBuffers.allocate(data.interleaved.size(), geometryAlignment, owner);
+        m_GeometryBuffers.upload(attr.vertexAllocations[0], data.interleaved.data(), data.interleaved.size());
+    }
+    else
+    {
+        for (const auto& attribute : data.layout.getAttributes())
+        {
+            std::span<const char> bytes = data.attributes[attribute.location].bytes;
+            attr.vertexAllocations[attribute.location] = m_GeometryBuffers.allocate(bytes.size(), geometryAlignment, owner);
+            m_GeometryBuffers.upload(attr.vertexAllocations[attribute.location], bytes.data(), bytes.size());
+        }
+    }
+    attr.layout = data.layout;
+
+    // vao
+    glGenVertexArrays(1, &attr.vao);
+    attachGeometryBuffers(attr);
+    checkOpenGLError();
+    attr.bUploaded = true;
+}
+
+// the vertex buffer of the arena is interleaved, the attributes of separate buffers are interleaved here
+bool Renderer::uploadToMeshArena(ModelAttributes& attr, const ModelUploadData& data)
+{
+    VertexLayout layout = MeshArena::interleavedLayout(data.layout);
+    std::vector<char> vertices;
+    std::span<const char> bytes = data.interleaved;
+    std::size_t vertexCount = 0;
+    if (data.layout.getPacking() == InterleavedBuffer)
+    {
+        vertexCount = data.interleaved.size() / std::size_t(data.layout.getStride());
+    }
+    else
+    {
+        vertexCount = data.attributes[0].bytes.size() / std::size_t(data.attributes[0].vertexSize);
+        for (const auto& attribute : data.layout.getAttributes())
+        {
+            if (data.attributes[attribute.location].bytes.size() != vertexCount * std::size_t(attribute.size))
+            {
+                return false;
+            }
+        }
+        vertices = interleavedVertices(data, layout, vertexCount);
+        bytes = vertices;
+    }
+
+    // one draw index per arena model for the camera pass, the shadow pass grows it to one per model and light
+    reserveDrawIndices(m_MultiDrawStats.arenaModels + 1);
+    auto it = std::find_if(m_MeshArenas.begin(), m_MeshArenas.end(), [&](const auto& spArena) { return spArena->accepts(layout, data.indexType); });
+    if (it == m_MeshArenas.end())
+    {
+        m_MeshArenas.push_back(std::make_unique<MeshArena>(layout, data.indexType));
+        m_MeshArenas.back()->setDrawIndexBuffer(m_DrawIndexVbo);
+        it = m_MeshArenas.end() - 1;
+        m_MultiDrawStats.arenas = m_MeshArenas.size();
+    }
+    MeshArena& arena = **it;
+    std::size_t indexSize = data.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    attr.arenaRange = arena.add(bytes.data(), vertexCount, data.indices.bytes.data(), data.indices.bytes.size() / indexSize);
+    attr.firstIndex = attr.arenaRange.firstIndex;
+    attr.baseVertex = attr.arenaRange.baseVertex;
+    attr.pArena = &arena;
+    attr.vao = arena.getVao();
+    attr.layout = arena.getLayout();
+    m_MultiDrawStats.arenaModels++;
+    checkOpenGLError();
+    return true;
+}
+
+void Renderer::attachGeometryBuffers(ModelAttributes& attr)
+{
+    glBindVertexArray(attr.vao);
+    for (const auto& attribute : attr.layout.getAttributes())
+    {
+        GLuint location = attr.layout.getPacking() == InterleavedBuffer ? 0 : attribute.location;
+        const BufferAllocation& allocation = m_GeometryBuffers.get(attr.vertexAllocations[location]);
+        glBindBuffer(GL_ARRAY_BUFFER, allocation.buffer);
+        attr.layout.setAttributePointer(attribute, allocation.offset);
+    }
+    if (attr.indexAllocation != BufferAllocator::invalidHandle)
+    {
+        // index ranges are aligned to the index size
+        const BufferAllocation& allocation = m_GeometryBuffers.get(attr.indexAllocation);
+        std::size_t indexSize = attr.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, allocation.buffer);
+        attr.firstIndex = GLuint(allocation.offset / indexSize);
+    }
+    glBindVertexArray(0);
+}
+
+void Renderer::defragmentGeometryBuffers()
+{
+    if (m_DefragmentBudget == 0)
+    {
+        return;
+    }
+    const std::vector<BufferHandle>& moved = m_GeometryBuffers.defragment(m_DefragmentBudget);
+    std::vector<std::size_t> models;
+    for (BufferHandle handle : moved)
+    {
+        // ranges of removed models wait for deletion, the slot may hold a later model
+        std::uint64_t owner = m_GeometryBuffers.getOwner(handle);
+        if (m_ModelSlots.isLive(std::uint32_t(owner), std::uint32_t(owner >> 32)))
+        {
+            models.push_back(std::size_t(std::uint32_t(owner)));
+        }
+    }
+    std::sort(models.begin(), models.end());
+    models.erase(std::unique(models.begin(), models.end()), models.end());
+    for (std::size_t modelIndex : models)
+    {
+        // a replaced model may be in an arena now
+        ModelAttributes& attr = m_Models[modelIndex];
+        if (attr.bUploaded && !attr.pArena)
+        {
+            attachGeometryBuffers(attr);
+        }
+    }
+}
+
+// create buffers of async models that finished loading, in order of adding.
+// at most the upload budget per call (but at least one model), or all of them after waiting for loading.
+void Renderer::uploadPendingModels(bool waitForAll)
+{
+    std::size_t uploadedBytes = 0;
+    std::vector<AsyncModelHandle> remaining;
+    for (auto& handle : m_PendingModels)
+    {
+        if (!waitForAll && (uploadedBytes >= m_AsyncUploadBudget || !handle.isLoaded()))
+        {
+            remaining.push_back(handle);
+            continue;
+        }
+        AsyncModelState& state = *handle.m_spState;
+        try
+        {
+            state.loaded.get();
+        }
+        catch (const std::exception& e)
+        {
+            Logger::globalLogger().warning(std::format("Async loading of model {} failed: {}", handle.index(), e.what()));
+            continue;
+        }
+        if (!state.spData)
+        {
+            Logger::globalLogger().warning(std::format("Async loading of model {} failed: no model returned.", handle.index()));
+            continue;
+        }
+        uploadModel(handle.index(), *state.spData);
+        uploadedBytes += state.spData->sizeInBytes();
+        state.spData.reset(); // release the copies, the model itself is kept by the renderer
+        state.uploaded = true;
+        if (m_bRunning)
+        {
+            checkModelAttributes(handle.index());
+        }
+    }
+    m_PendingModels.swap(remaining);
+}
+
+// add different kinds of lighting
+void Renderer::setGlobalAmbientLight(glm::vec4 ambient)
+{
+    m_GlobalAmbient = ambient;
+}
+void Renderer::addDirectionalLight(const DirectionalLight& light)
+{
+    if (m_DirectionalLights.size() == MAX_DIRECTIONAL_LIGHT_SIZE)
+    {
+        Utils::Logger::globalLogger().warning(std::format("Directional light sources number exceed the limit of {}!", MAX_DIRECTIONAL_LIGHT_SIZE));
+    }
+    else
+    {
+        m_DirectionalLights.push_back(light);
+    }
+}
+void Renderer::addDirectionalLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 direction)
+{
+    if (m_DirectionalLights.size() == MAX_DIRECTIONAL_LIGHT_SIZE)
+    {
+        Utils::Logger::globalLogger().warning(std::format("Directional light sources number exceed the limit of {}!", MAX_DIRECTIONAL_LIGHT_SIZE));
+    }
+    else
+    {
+        m_DirectionalLights.emplace_back(ambient, diffuse, specular, direction);
+    }
+}
+void Renderer::addPointLight(const PointLight& light)
+{
+    m_PointLights.push_back(light);
+}
+void Renderer::addPointLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 location, float constant, float linear, float quadratic)
+{
+    m_PointLights.emplace_back(ambient, diffuse, specular, location, constant, linear, quadratic);
+}
+void Renderer::addSpotLight(const SpotLight& light)
+{
+    m_SpotLights.push_back(light);
+}
+void Renderer::addSpotLight(glm::vec4 ambient, glm::vec4 diffuse, glm::vec4 specular, glm::vec3 location, glm::vec3 direction, float cutoff, float exponent)
+{
+    m_SpotLights.emplace_back(ambient, diffuse, specular, location, direction, cutoff, exponent);
+}
+
+// set face culling attributes, defualt to true/GL_BACK/GL_CCW
+void Renderer::setFaceCullingAttribute(bool enable, GLenum mode, GLenum front)
+{
+    m_bEnableCullFace = enable;
+    m_FaceCullingMode = mode;
+    m_FrontFace = front;
+} 
+
+// set PCF(Percentage Closer Filtering) mode, for soft shadow, default to NoPCF, only affect models with PhongShadingWithShadow style
+void Renderer::setPCFMode(PCFMode mode, float pcfFactor)
+{
+    m_PCFMode = mode;
+    m_PCFFactor = pcfFactor;
+}
+
+void Renderer::setLodPixelError(float pixelError)
+{
+    m_LodPixelError = pixelError;
+}
+
+const GLStateStatistics& Renderer::getGLStateStatistics() const
+{
+    return m_GLState.getStatistics();
+}
+
+void Renderer::setMultiDrawIndirect(bool enable)
+{
+    m_bMultiDrawIndirect = enable;
+}
+
+const MultiDrawStatistics& Renderer::getMultiDrawStatistics() const
+{
+    return m_MultiDrawStats;
+}
+
+void Renderer::setDefragmentBudget(std::size_t bytesPerFrame)
+{
+    m_DefragmentBudget = bytesPerFrame;
+}
+
+const BufferAllocatorStatistics& Renderer::getGeometryBufferStatistics() const
+{
+    return m_GeometryBuffers.getStatistics();
+}
+
+const RenderQueueStatistics& Renderer::getRenderQueueStatistics() const
+{
+    return m_RenderQueue.getStatistics();
+}
+
+const MeshletCullingStatistics& Renderer::getMeshletCullingStatistics() const
+{
+    return m_MeshletStats;
+}
+
+void Renderer::setFrustumCulling(bool enable)
+{
+    m_bFrustumCulling = enable;
+}
+
+const FrustumCullingStatistics& Renderer::getFrustumCullingStatistics() const
+{
+    return m_FrustumCullingStats;
+}
+
+ModelHandle Renderer::pickModel(double cursorX, double cursorY) const
+{
+    int width = 0, height = 0;
+    glfwGetWindowSize(m_pWindow, &width, &height);
+    if (width == 0 || height == 0)
+    {
+        return ModelHandle{};
+    }
+    // the ray from the near plane to the far plane through the cursor, its distances are from 0 to 1
+    glm::vec2 ndc(2.0f * float(cursorX) / float(width) - 1.0f, 1.0f - 2.0f * float(cursorY) / float(height));
+    glm::mat4 inverseVP = glm::inverse(getProjMatrix(m_pWindow) *
+                                       glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow)));
+    glm::vec4 nearPoint = inverseVP * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseVP * glm::vec4(ndc, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+    // the box is hit, the sphere must be hit too
+    BvhRayHit hit = m_ModelHierarchy.raycast(origin, direction, 1.0f, [&](std::uint32_t i, float boxDistance)
+    {
+        if (!m_Models[i].bUploaded)
+        {
+            return -1.0f;
+        }
+        const BoundingVolume& bounds = m_ModelBounds[i];
+        glm::vec3 offset = origin - bounds.sphereCenter;
+        float a = glm::dot(direction, direction);
+        float b = glm::dot(direction, offset);
+        float c = glm::dot(offset, offset) - bounds.sphereRadius * bounds.sphereRadius;
+        float discriminant = b * b - a * c;
+        if (discriminant < 0.0f)
+        {
+            return -1.0f;
+        }
+        float root = std::sqrt(discriminant);
+        if ((-b + root) / a < 0.0f) // behind the eye
+        {
+            return -1.0f;
+        }
+        return std::max((-b - root) / a, boxDistance);
+    });
+    if (hit.object == BoundingVolumeHierarchy::invalidObject)
+    {
+        return ModelHandle{};
+    }
+    return ModelHandle{ hit.object, m_ModelSlots.getGeneration(hit.object) };
+}
+
+// assign the point and spot lights to the clusters on the CPU, or in a compute shader, default to CpuLightCulling
+void Renderer::setLightCullingMode(LightCullingMode mode)
+{
+    m_LightCullingMode = mode;
+}
+
+// statistics of the last frame, only updated with CpuLightCulling
+const LightClusterStatistics& Renderer::getLightClusterStatistics() const
+{
+    return m_LightClusters.getStatistics();
+}
+
+void Renderer::enableSkyBox(const char* rightImage, const char* leftImage,
+                            const char* topImage, const char* bottomImage,
+                            const char* frontImage, const char* backImage)
+{
+    m_bEanbleSkyBox = true;
+    m_SkyBoxTexture = loadCubeMap(rightImage, leftImage,
+                                   topImage, bottomImage,
+                                   frontImage, backImage);
+    std::vector<float> vertices = {
+        -1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        -1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        -1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f
+    };
+    m_SkyBoxVerticesCount = GLsizei(vertices.size() / 3);
+    glGenVertexArrays(1, &m_SkyBoxVao);
+    glBindVertexArray(m_SkyBoxVao);
+    glGenBuffers(1, &m_SkyBoxVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_SkyBoxVbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    // set texture attributes
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_SkyBoxTexture);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    checkOpenGLError();
+}
+
+// set model attributes
+// set rotatoin attributes, default to false
+void Renderer::setModelRotation(std::size_t modelIndex, glm::vec3 rotationAxis, float rotationRate)
+{
+    assert(modelIndex < m_Models.size());
+    if (!m_Models[modelIndex].bRotate)
+    {
+        m_RotatingModels.push_back(std::uint32_t(modelIndex));
+    }
+    m_Models[modelIndex].bRotate = true;
+    m_Models[modelIndex].rotationAxis = rotationAxis;
+    m_Models[modelIndex].rotationRate = rotationRate;
+}
+
+// set render style
+void Renderer::setRenderStyle(std::size_t modelIndex, RenderStyle renderStyle)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].style = renderStyle;
+}
+
+// set color to render, for PureColorPoints/PureColorLineStrip/PureColorTriangles style, default to 
+void Renderer::setColor(std::size_t modelIndex, glm::vec4 color)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].color = color;
+}
+
+// set texture for model, just for SpecificTexture/LightingMaterialTexture style
+void Renderer::setTexture(std::size_t modelIndex, const char* textureImagePath, float weight, bool doMipmapping, bool doAnisotropicFiltering)
+{
+    assert(modelIndex < m_Models.size());
+    setTexture(modelIndex, m_Textures[acquireTexture(textureImagePath)].id, weight, doMipmapping, doAnisotropicFiltering);
+}
+void Renderer::setTexture(std::size_t modelIndex, GLuint textureId, float weight, bool doMipmapping, bool doAnisotropicFiltering)
+{
+    assert(modelIndex < m_Models.size());
+    retainTexture(textureId);
+    releaseTexture(m_Models[modelIndex].texture);
+    m_Models[modelIndex].texture = textureId;
+    m_Models[modelIndex].textureWeight = weight;
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (doMipmapping)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmapping
+    }
+    if (doAnisotropicFiltering && GLAD_GL_EXT_texture_filter_anisotropic) // check if anisotropic filtering extension is supported ?
+    {
+        GLfloat anisoSetting = 0.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoSetting);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisoSetting); // enable anisotropic filtering
+    }
+}
+
+// set material for model, for LightingMaterialTexture style
+void Renderer::setMaterial(std::size_t modelIndex, const Material& material, float weight)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].spMaterial = std::make_unique<Material>(material);
+    m_Models[modelIndex].materialWeight = weight;
+}
+
+void Renderer::setModelInstances(std::size_t modelIndex, std::span<const ModelInstance> instances)
+{
+    assert(modelIndex < m_Models.size());
+    auto& attr = m_Models[modelIndex];
+    std::vector<InstanceStd430> data(instances.size());
+    for (std::size_t i = 0; i < instances.size(); i++)
+    {
+        data[i].modelMatrix = instances[i].transform;
+        data[i].normalMatrix = glm::transpose(glm::inverse(instances[i].transform));
+        data[i].color = instances[i].color;
+        data[i].materialIndex = instances[i].materialIndex;
+    }
+    if (attr.instanceSsbo == 0)
+    {
+        glGenBuffers(1, &attr.instanceSsbo);
+    }
+    // orphaning: the driver hands out new storage instead of waiting for the draws of the last frame that read the old one
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, attr.instanceSsbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(std::max<std::size_t>(data.size(), 1) * sizeof(InstanceStd430)), nullptr, GL_STREAM_DRAW);
+    if (!data.empty())
+    {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(data.size() * sizeof(InstanceStd430)), data.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    attr.instanceCount = GLsizei(instances.size());
+    attr.instanceTransforms.resize(instances.size());
+    for (std::size_t i = 0; i < instances.size(); i++)
+    {
+        attr.instanceTransforms[i] = instances[i].transform;
+    }
+    updateInstanceBounds(modelIndex);
+}
+
+void Renderer::setInstanceMaterials(std::size_t modelIndex, std::span<const Material> materials)
+{
+    assert(modelIndex < m_Models.size());
+    auto& attr = m_Models[modelIndex];
+    std::vector<MaterialStd430> data(materials.size());
+    for (std::size_t i = 0; i < materials.size(); i++)
+    {
+        Material material = materials[i];
+        data[i].ambient = material.getAmbient();
+        data[i].diffuse = material.getDiffuse();
+        data[i].specular = material.getSpecular();
+        data[i].shininess = material.getShininess();
+    }
+    if (attr.instanceMaterialSsbo == 0)
+    {
+        glGenBuffers(1, &attr.instanceMaterialSsbo);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, attr.instanceMaterialSsbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(std::max<std::size_t>(data.size(), 1) * sizeof(MaterialStd430)), nullptr, GL_STATIC_DRAW);
+    if (!data.empty())
+    {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(data.size() * sizeof(MaterialStd430)), data.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    attr.instanceMaterialsSize = GLuint(materials.size());
+}
+
+// set lighting mode of model
+void Renderer::setLightingMode(std::size_t modelIndex, LightingMode mode)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].lightingMode = mode;
+}
+
+// enable bump map for model, only for LightingMaterialTexture style
+void Renderer::enableBumpMap(std::size_t modelIndex)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].generateBumpMap = true;
+}
+
+// set normal map for model, only for LightingMaterialTexture style
+void Renderer::setNormalMap(std::size_t modelIndex, const char* textureImagePath, bool doMipmapping, bool doAnisotropicFiltering)
+{
+    assert(modelIndex < m_Models.size());
+    setNormalMap(modelIndex, m_Textures[acquireTexture(textureImagePath)].id, doMipmapping, doAnisotropicFiltering);
+}
+void Renderer::setNormalMap(std::size_t modelIndex, GLuint textureId, bool doMipmapping, bool doAnisotropicFiltering)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].enableNormalMap = true;
+    retainTexture(textureId);
+    releaseTexture(m_Models[modelIndex].normalMap);
+    m_Models[modelIndex].normalMap = textureId;
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (doMipmapping)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmapping
+    }
+    if (doAnisotropicFiltering && GLAD_GL_EXT_texture_filter_anisotropic) // check if anisotropic filtering extension is supported ?
+    {
+        GLfloat anisoSetting = 0.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoSetting);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisoSetting); // enable anisotropic filtering
+    }
+}
+
+// set height map for model, only for LightingMaterialTexture style
+void Renderer::setHeightMap(std::size_t modelIndex, const char* textureImagePath, float heightFactor, bool doMipmapping, bool doAnisotropicFiltering)
+{
+    assert(modelIndex < m_Models.size());
+    setHeightMap(modelIndex, m_Textures[acquireTexture(textureImagePath)].id, heightFactor, doMipmapping, doAnisotropicFiltering);
+}
+void Renderer::setHeightMap(std::size_t modelIndex, GLuint textureId, float heightFactor, bool doMipmapping, bool doAnisotropicFiltering)
+{
+    assert(modelIndex < m_Models.size());
+    m_Models[modelIndex].enableHeightMap = true;
+    retainTexture(textureId);
+    releaseTexture(m_Models[modelIndex].heightMap);
+    m_Models[modelIndex].heightMap = textureId;
+    m_Models[modelIndex].heightFactor = heightFactor;
+    updateInstanceBounds(modelIndex);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (doMipmapping)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmapping
+    }
+    if (doAnisotropicFiltering && GLAD_GL_EXT_texture_filter_anisotropic) // check if anisotropic filtering extension is supported ?
+    {
+        GLfloat anisoSetting = 0.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoSetting);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisoSetting); // enable anisotropic filtering
+    }
+}
+
+// check whether all data are prepared for model and specific render style
+// support some check that is not proper to do in display
+void Renderer::checkForModelAttributes()
+{
+    for (std::size_t i = 0; i < m_Models.size(); ++i)
+    {
+        // async models are checked once uploaded
+        if (m_Models[i].bUploaded)
+        {
+            checkModelAttributes(i);
+        }
+    }
+}
+
+void Renderer::checkModelAttributes(std::size_t modelIndex)
+{
+    const ModelAttributes& attr = m_Models[modelIndex];
+    if (attr.style == LightingMaterialTexture)
+    {
+        if (!attr.spModel->supplyNormals())
+        {
+            Utils::Logger::globalLogger().warning(std::format("Model {} set to LightingMaterialTexture render style but normals are not supplied.", modelIndex));
+        }
+    }
+    else if (attr.style == EnvironmentMap)
+    {
+        if (!m_bEanbleSkyBox)
+        {
+            Utils::Logger::globalLogger().warning(std::format("Model {} set to EnvironmentMap render style but no sky box texture supplied.", modelIndex));
+        }
+    }
+}
+
+// when left mouse button is holding, update view matrix according cursor change
+// the cursor coordinate
+// O -|------------> X
+//    |
+//    |
+//    |
+//    v Y
+// 1080 pixels for one circle/360 degrees/2*PI radian
+// The rotation logic is just like Blender !
+// keep y axis always be vertical in screen pixels, so use y-axis as x rotation axis, not up vector.
+void Renderer::updateViewArgsAccordingToCursorPos()
+{
+    if (getHoldLeftMouseButton(m_pWindow))
+    {
+        int deltaX = getCursorPosX(m_pWindow) - getLastCursorPosX(m_pWindow);
+        int deltaY = getCursorPosY(m_pWindow) - getLastCursorPosY(m_pWindow);
+        float xRotationAngle = -2 * glm::pi<float>() / 1080.0f * deltaX;
+        float yRotationAngle = 2 * glm::pi<float>() / 1080.0f * deltaY;
+        glm::vec3& eyeLocation = getEyeLocation(m_pWindow);
+        glm::vec3& objectLocation = getObjectLocation(m_pWindow);
+        glm::vec3& upVector = getUpVector(m_pWindow);
+        if (deltaX != 0)
+        {
+            auto dotRes = glm::dot(upVector, glm::vec3(0.0f, 1.0f, 0.0f));
+            if (dotRes < 0) // > 90 degrees
+            {
+                xRotationAngle = -xRotationAngle;
+            }
+            // the rotation axis of X is y-axis, this is the key point!
+            glm::mat4 rotationMat = glm::rotate(glm::mat4(1.0f), xRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+            upVector = rotationMat * glm::vec4(upVector, 1.0f);
+            eyeLocation = glm::vec3(rotationMat * glm::vec4(eyeLocation - objectLocation, 1.0f)) + objectLocation;
+        }
+        if (deltaY != 0)
+        {
+            // the rotation axis of Y is cross(Eye - Object, Up)
+            glm::mat4 rotationMat = glm::rotate(glm::mat4(1.0f), yRotationAngle, glm::cross(eyeLocation - objectLocation, upVector));
+            upVector = rotationMat * glm::vec4(upVector, 1.0f);
+            eyeLocation = glm::vec3(rotationMat * glm::vec4(eyeLocation - objectLocation, 1.0f)) + objectLocation;
+        }
+    }
+    getLastCursorPosX(m_pWindow) = getCursorPosX(m_pWindow);
+    getLastCursorPosY(m_pWindow) = getCursorPosY(m_pWindow);
+}
+
+void Renderer::drawAxises()
+{
+    if (m_bEnableAxises)
+    {
+        // also called by display callbacks, which do not go through the state cache
+        m_GLState.invalidate();
+        m_GLState.useProgram(m_AxisesShader);
+        m_GLState.enable(GL_DEPTH_TEST);
+        m_GLState.depthFunc(GL_LEQUAL);
+
+        m_ModelMatrix = glm::mat4(1.0f);
+        m_ViewMatrix = glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
+        m_ModelViewMatrix = m_ViewMatrix * m_ModelMatrix;
+
+        m_AxisesShader.setFloat("axisLength", m_AxisLength);
+        m_AxisesShader.setMat4("mvMatrix", m_ModelViewMatrix);
+        m_AxisesShader.setMat4("projMatrix", getProjMatrix(m_pWindow));
+
+        m_GLState.bindVertexArray(m_AxisesVao);
+        glDrawArrays(GL_LINES, 0, 6);
+        m_GLState.bindVertexArray(0);
+    }
+    checkOpenGLError();
+}
+
+// draw shadow depth textures
+void Renderer::drawShadowTextures(float currentTime)
+{
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(m_pWindow, &width, &height);
+    // deal with minimization
+    if (width == 0 || height == 0)
+    {
+        width = 1920;
+        height = 1080;
+    }
+    // these parameters may need to adjust dynamically, fixed for now: eye location, up vector, angle, near plane, far plane.
+    // directional lights: orthogonal projection, point and spot lights: perspective projection
+    std::size_t shadowCount = 0;
+    for (std::size_t i = 0; i < m_DirectionalLights.size() && shadowCount < m_ShadowBuffers.size(); i++, shadowCount++)
+    {
+        glm::mat4 vMat = glm::lookAt(m_DirectionalLights[i].getDirection() * (-1.0f) * 5.0f, glm::vec3(0.0f), glm::vec3(-1.0f, 2.0f, -1.0f));
+        glm::mat4 pMat = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
+        m_ShadowVPs[shadowCount] = pMat * vMat;
+    }
+    // todo: the shadow texture of point light should be a cube map (from six different directions)
+    for (std::size_t i = 0; i < m_PointLights.size() && shadowCount < m_ShadowBuffers.size(); i++, shadowCount++)
+    {
+        glm::mat4 vMat = glm::lookAt(m_PointLights[i].getLocation(), glm::vec3(0.0f), glm::vec3(-1.0f, 2.0f, -1.0f));
+        glm::mat4 pMat = glm::perspective(glm::pi<float>() / 2.0f, float(width)/float(height), 1.0f, 1000.0f);
+        m_ShadowVPs[shadowCount] = pMat * vMat;
+    }
+    for (std::size_t i = 0; i < m_SpotLights.size() && shadowCount < m_ShadowBuffers.size(); i++, shadowCount++)
+    {
+        glm::mat4 vMat = glm::lookAt(m_SpotLights[i].getLocation(), glm::vec3(0.0f), glm::vec3(-1.0f, 2.0f, -1.0f));
+        glm::mat4 pMat = glm::perspective(glm::pi<float>() / 2.0f, float(width)/float(height), 1.0f, 1000.0f);
+        m_ShadowVPs[shadowCount] = pMat * vMat;
+    }
+
+    // the casters of every light are the models in its frustum, the models of an arena are drawn by one multi-draw call per light.
+    // the commands of all lights are uploaded at once, batchOffsets[s] is the first batch of shadow texture s
+    m_ShadowVisible.resize(shadowCount);
+    m_FrustumCullingStats.shadows.resize(shadowCount);
+    std::vector<std::size_t> batchOffsets(shadowCount + 1, 0);
+    clearMultiDraws();
+    for (std::size_t shadowIndex = 0; shadowIndex < shadowCount; shadowIndex++)
+    {
+        cullModels(m_ShadowVPs[shadowIndex], m_ShadowVisible[shadowIndex], m_FrustumCullingStats.shadows[shadowIndex]);
+        const std::vector<std::uint8_t>& visible = m_ShadowVisible[shadowIndex];
+        for (const auto& spArena : m_MeshArenas)
+        {
+            MultiDrawBatch batch{ spArena.get(), GL_TRIANGLES, m_MultiDrawCommands.size(), 0 };
+            for (std::size_t j = 0; j < m_Models.size(); j++)
+            {
+                const ModelAttributes& attr = m_Models[j];
+                if (attr.bUploaded && visible[j] && attr.pArena == spArena.get() && isMultiDrawn(attr, false))
+                {
+                    glm::mat4 mMat = glm::mat4(1.0f);
+                    if (attr.bRotate)
+                    {
+                        mMat = glm::rotate(mMat, currentTime * attr.rotationRate, attr.rotationAxis);
+                    }
+                    addMultiDraw(attr, mMat, nullptr);
+                    batch.commandCount++;
+                }
+            }
+            if (batch.commandCount > 0)
+            {
+                m_MultiDrawBatches.push_back(batch);
+            }
+        }
+        batchOffsets[shadowIndex + 1] = m_MultiDrawBatches.size();
+    }
+    uploadMultiDraws();
+
+    if (m_bEnableCullFace)
+    {
+        m_GLState.enable(GL_CULL_FACE);
+        m_GLState.cullFace(m_FaceCullingMode);
+        m_GLState.frontFace(m_FrontFace);
+    }
+    // draw the casters to the shadow texture of every light, instanced models with the instanced depth program
+    for (std::size_t shadowIndex = 0; shadowIndex < shadowCount; shadowIndex++)
+    {
+        m_GLState.bindFramebuffer(GL_FRAMEBUFFER, m_ShadowBuffers[shadowIndex]);
+        glClear(GL_DEPTH_BUFFER_BIT); // Note: this is a key point !!!
+        m_GLState.enable(GL_DEPTH_TEST);
+        m_GLState.depthFunc(GL_LEQUAL);
+
+        const glm::mat4& vpMat = m_ShadowVPs[shadowIndex];
+        for (std::size_t b = batchOffsets[shadowIndex]; b < batchOffsets[shadowIndex + 1]; b++)
+        {
+            m_GLState.useProgram(m_MultiDrawShadowDepthShader);
+            m_MultiDrawShadowDepthShader.set(m_MultiDrawShadowDepthVPUniform, vpMat);
+            drawMultiDrawBatch(m_MultiDrawBatches[b], m_MultiDrawShadowDepthShader, m_MultiDrawShadowDepthFirstDrawUniform);
+        }
+        const std::vector<std::uint8_t>& visible = m_ShadowVisible[shadowIndex];
+        for (std::size_t j = 0; j < m_Models.size(); j++)
+        {
+            // still loading, outside of the frustum of the light, or drawn above
+            if (!m_Models[j].bUploaded || !visible[j] || isMultiDrawn(m_Models[j], false))
+            {
+                continue;
+            }
+            // model matrix
+            glm::mat4 mMat = glm::mat4(1.0f);
+            if (m_Models[j].bRotate)
+            {
+                mMat = glm::rotate(mMat, currentTime * m_Models[j].rotationRate, m_Models[j].rotationAxis);
+            }
+            bool bInstanced = m_Models[j].instanceCount > 0;
+            const Shader& shader = bInstanced ? m_InstancedShadowDepthShader : m_SimpleShadowDepthShader;
+            m_GLState.useProgram(shader);
+            shader.set(bInstanced ? m_InstancedShadowDepthMVPUniform : m_ShadowDepthMVPUniform, vpMat * mMat);
+            m_GLState.bindVertexArray(m_Models[j].vao);
+            drawModel(m_Models[j], GL_TRIANGLES);
+        }
+    }
+    m_GLState.bindVertexArray(0);
+    m_GLState.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    checkOpenGLError();
+}
+
+// draw sky box
+void Renderer::drawSkyBox()
+{
+    // disable depth test
+    if (m_bEanbleSkyBox)
+    {
+        m_GLState.disable(GL_DEPTH_TEST);
+        m_GLState.disable(GL_CULL_FACE);
+        m_GLState.useProgram(m_SkyBoxShader);
+        m_GLState.bindVertexArray(m_SkyBoxVao);
+        
+        m_ModelMatrix = glm::mat4(1.0f);
+        m_ViewMatrix = glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
+        m_ModelViewMatrix = m_ViewMatrix * m_ModelMatrix;
+        m_SkyBoxShader.setMat4("mvMatrix", m_ModelViewMatrix);
+        m_SkyBoxShader.setMat4("projMatrix", getProjMatrix(m_pWindow));
+
+        m_GLState.activeTexture(GL_TEXTURE0);
+        m_GLState.bindTexture(GL_TEXTURE_CUBE_MAP, m_SkyBoxTexture);
+        glDrawArrays(GL_TRIANGLES, 0, m_SkyBoxVerticesCount);
+        m_GLState.bindVertexArray(0);
+        checkOpenGLError();
+    }
+}
+
+// a simplification error of e model units at distance d from the eye covers e * proj[1][1] * height / 2 / d pixels,
+// the shadow passes draw the same level as the camera so that models do not shadow themselves.
+void Renderer::selectModelLods(float currentTime)
+{
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(m_pWindow, &width, &height);
+    float pixelsPerUnit = getProjMatrix(m_pWindow)[1][1] * float(height) * 0.5f;
+    glm::vec3 eyeLocation = getEyeLocation(m_pWindow);
+    for (auto& attr : m_Models)
+    {
+        attr.currentLod = 0;
+        if (attr.lods.size() < 2 || attr.instanceCount > 0)
+        {
+            continue;
+        }
+        glm::vec3 center = attr.bounds.sphereCenter;
+        if (attr.bRotate)
+        {
+            center = glm::vec3(glm::rotate(glm::mat4(1.0f), currentTime * attr.rotationRate, attr.rotationAxis) * glm::vec4(center, 1.0f));
+        }
+        float distance = glm::length(center - eyeLocation) - attr.bounds.sphereRadius;
+        if (distance <= 0.0f) // eye inside the bounding sphere
+        {
+            continue;
+        }
+        float scale = pixelsPerUnit / distance;
+        while (attr.currentLod + 1 < attr.lods.size() && attr.lods[attr.currentLod + 1].error * scale <= m_LodPixelError)
+        {
+            attr.currentLod++;
+        }
+    }
+}
+
+// meshlets of the current level of detail outside the view frustum or facing away from the eye are not drawn by the camera,
+// the tests run in model space. the visible ranges are the arguments of one glMultiDrawElements call per model.
+void Renderer::cullModelMeshlets(float currentTime)
+{
+    m_MeshletStats = MeshletCullingStatistics{};
+    glm::vec3 eyeLocation = getEyeLocation(m_pWindow);
+    glm::mat4 vpMat = getProjMatrix(m_pWindow) * glm::lookAt(eyeLocation, getObjectLocation(m_pWindow), getUpVector(m_pWindow));
+    // the normal cones assume that back faces of counter-clockwise triangles are culled
+    bool backFaceCulling = m_bEnableCullFace && ((m_FaceCullingMode == GL_BACK && m_FrontFace == GL_CCW) ||
+                                                 (m_FaceCullingMode == GL_FRONT && m_FrontFace == GL_CW));
+    std::vector<IndexRange> ranges;
+    for (auto& attr : m_Models)
+    {
+        attr.bMeshletsCulled = false;
+        if (attr.meshlets.empty() || attr.instanceCount > 0)
+        {
+            continue;
+        }
+        glm::mat4 mMat = glm::mat4(1.0f);
+        if (attr.bRotate)
+        {
+            mMat = glm::rotate(mMat, currentTime * attr.rotationRate, attr.rotationAxis);
+        }
+        Frustum frustum(vpMat * mMat);
+        glm::vec3 eye = glm::vec3(glm::inverse(mMat) * glm::vec4(eyeLocation, 1.0f));
+        std::size_t first = attr.lodMeshlets[attr.currentLod];
+        std::span<const Meshlet> meshlets(attr.meshlets.data() + first, attr.lodMeshlets[attr.currentLod + 1] - first);
+        cullMeshlets(meshlets, frustum, eye, backFaceCulling, ranges, &m_MeshletStats);
+
+        // the indices of the model start at its first index
+        std::size_t indexSize = attr.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        std::size_t firstIndex = attr.firstIndex;
+        attr.visibleCounts.resize(ranges.size());
+        attr.visibleOffsets.resize(ranges.size());
+        attr.visibleBaseVertices.assign(ranges.size(), attr.baseVertex);
+        for (std::size_t i = 0; i < ranges.size(); i++)
+        {
+            attr.visibleCounts[i] = GLsizei(ranges[i].indexCount);
+            attr.visibleOffsets[i] = reinterpret_cast<const void*>((firstIndex + ranges[i].firstIndex) * indexSize);
+        }
+        attr.bMeshletsCulled = true;
+    }
+}
+
+// the height map moves the vertices along their normals by up to heightFactor, before the instance and model transforms
+void Renderer::updateInstanceBounds(std::size_t modelIndex)
+{
+    ModelAttributes& attr = m_Models[modelIndex];
+    m_ChangedModels.push_back(std::uint32_t(modelIndex));
+    BoundingVolume bounds = attr.enableHeightMap ? attr.bounds.inflated(std::abs(attr.heightFactor)) : attr.bounds;
+    if (attr.instanceTransforms.empty())
+    {
+        attr.instanceBounds = bounds;
+        return;
+    }
+    attr.instanceBounds = bounds.transformed(attr.instanceTransforms[0]);
+    for (std::size_t i = 1; i < attr.instanceTransforms.size(); i++)
+    {
+        attr.instanceBounds = attr.instanceBounds.merged(bounds.transformed(attr.instanceTransforms[i]));
+    }
+}
+
+BoundingVolume Renderer::getWorldBounds(const ModelAttributes& attr, float currentTime) const
+{
+    if (!attr.bRotate)
+    {
+        return attr.instanceBounds;
+    }
+    return attr.instanceBounds.transformed(glm::rotate(glm::mat4(1.0f), currentTime * attr.rotationRate, attr.rotationAxis));
+}
+
+void Renderer::updateModelBounds(float currentTime)
+{
+    if (m_ModelHierarchy.size() != m_Models.size())
+    {
+        m_ModelBounds.resize(m_Models.size());
+        for (std::size_t i = 0; i < m_Models.size(); i++)
+        {
+            m_ModelBounds[i] = getWorldBounds(m_Models[i], currentTime);
+        }
+        m_ModelHierarchy.build(m_ModelBounds);
+        m_ChangedModels.clear();
+        return;
+    }
+    for (std::uint32_t i : m_ChangedModels)
+    {
+        m_ModelBounds[i] = getWorldBounds(m_Models[i], currentTime);
+        m_ModelHierarchy.update(i, m_ModelBounds[i]);
+    }
+    for (std::uint32_t i : m_RotatingModels)
+    {
+        m_ModelBounds[i] = getWorldBounds(m_Models[i], currentTime);
+        m_ModelHierarchy.update(i, m_ModelBounds[i]);
+    }
+    m_ChangedModels.clear();
+    m_ModelHierarchy.refit();
+    // the boxes of moved models overlap more and more, a new build separates them again
+    if (m_ModelHierarchy.getCost() > 2.0f * m_ModelHierarchy.getBuildCost())
+    {
+        m_ModelHierarchy.build(m_ModelBounds);
+    }
+}
+
+void Renderer::cullModels(const glm::mat4& vpMat, std::vector<std::uint8_t>& visible, FrustumCullingPassStatistics& stats)
+{
+    if (m_bFrustumCulling)
+    {
+        m_ModelHierarchy.cull(Frustum(vpMat), visible);
+    }
+    else
+    {
+        visible.assign(m_Models.size(), 1);
+    }
+    stats = FrustumCullingPassStatistics{};
+    for (std::size_t i = 0; i < m_Models.size(); i++)
+    {
+        if (!m_Models[i].bUploaded)
+        {
+            continue;
+        }
+        stats.tested++;
+        stats.culled += visible[i] ? 0 : 1;
+        stats.drawn += visible[i] ? 1 : 0;
+    }
+}
+
+void Renderer::drawModel(const ModelAttributes& attr, GLenum primitiveType, bool cameraView)
+{
+    m_MultiDrawStats.singleDraws++;
+    // the indices of the model start at its first index in the geometry buffer or arena and count from its base vertex
+    std::size_t indexSize = attr.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    std::size_t firstIndex = attr.firstIndex;
+    GLint baseVertex = attr.baseVertex;
+    if (attr.instanceCount > 0)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_STORAGE_BINDING, attr.instanceSsbo);
+        if (attr.instanceMaterialSsbo != 0)
+        {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_MATERIAL_STORAGE_BINDING, attr.instanceMaterialSsbo);
+        }
+        // the level of detail and the meshlets are not selected for instanced models
+        if (!attr.spModel->supplyIndices())
+        {
+            glDrawArraysInstanced(primitiveType, 0, attr.verticesCount, attr.instanceCount);
+        }
+        else
+        {
+            GLsizei count = attr.lods.empty() ? attr.verticesCount : GLsizei(attr.lods[0].indexCount);
+            std::size_t first = firstIndex + (attr.lods.empty() ? 0 : attr.lods[0].firstIndex);
+            glDrawElementsInstancedBaseVertex(primitiveType, count, attr.indexType, reinterpret_cast<const void*>(first * indexSize),
+                                              attr.instanceCount, baseVertex);
+        }
+    }
+    else if (!attr.spModel->supplyIndices())
+    {
+        glDrawArrays(primitiveType, 0, attr.verticesCount);
+    }
+    else if (cameraView && attr.bMeshletsCulled && primitiveType == GL_TRIANGLES)
+    {
+        if (!attr.visibleCounts.empty())
+        {
+            glMultiDrawElementsBaseVertex(primitiveType, attr.visibleCounts.data(), attr.indexType, attr.visibleOffsets.data(),
+                                          GLsizei(attr.visibleCounts.size()), attr.visibleBaseVertices.data());
+        }
+    }
+    else if (attr.lods.empty())
+    {
+        glDrawElementsBaseVertex(primitiveType, attr.verticesCount, attr.indexType, reinterpret_cast<const void*>(firstIndex * indexSize), baseVertex);
+    }
+    else
+    {
+        const MeshLod& lod = attr.lods[attr.currentLod];
+        glDrawElementsBaseVertex(primitiveType, GLsizei(lod.indexCount), attr.indexType,
+                                 reinterpret_cast<const void*>((firstIndex + lod.firstIndex) * indexSize), baseVertex);
     }
 }
 
-// set height map for model, only for LightingMaterialTexture style
-void Renderer::setHeightMap(std::size_t modelIndex, const char* textureImagePath, float heightFactor, bool doMipmapping, bool doAnisotropicFiltering)
-{
-    assert(modelIndex < m_Models.size());
-    setHeightMap(modelIndex, loadTexture(textureImagePath), heightFactor, doMipmapping, doAnisotropicFiltering);
-}
-void Renderer::setHeightMap(std::size_t modelIndex, GLuint textureId, float heightFactor, bool doMipmapping, bool doAnisotropicFiltering)
+Renderer::ModelUniforms::ModelUniforms(const Shader& shader)
+    : mvMatrix(shader.getUniform<glm::mat4>("mvMatrix"))
+    , projMatrix(shader.getUniform<glm::mat4>("projMatrix"))
+    , normMatrix(shader.getUniform<glm::mat4>("normMatrix"))
+    , octNormals(shader.getUniform<bool>("octNormals"))
+    , inputColor(shader.getUniform<glm::vec4>("inputColor"))
+    , materialWeight(shader.getUniform<GLfloat>("materialWeight"))
+    , textureWeight(shader.getUniform<GLfloat>("textureWeight"))
+    , materialAmbient(shader.getUniform<glm::vec4>("material.ambient"))
+    , materialDiffuse(shader.getUniform<glm::vec4>("material.diffuse"))
+    , materialSpecular(shader.getUniform<glm::vec4>("material.specular"))
+    , materialShininess(shader.getUniform<GLfloat>("material.shininess"))
+    , heightFactor(shader.getUniform<GLfloat>("heightFactor"))
+    , instanceMaterialsSize(shader.getUniform<GLuint>("instanceMaterialsSize"))
+    , firstDraw(shader.getUniform<GLuint>("firstDraw"))
 {
-    assert(modelIndex < m_Models.size());
-    m_Models[modelIndex].enableHeightMap = true;
-    m_Models[modelIndex].heightMap = textureId;
-    m_Models[modelIndex].heightFactor = heightFactor;
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    if (doMipmapping)
+    for (std::size_t j = 0; j < shadowMVPs.size(); j++)
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmapping
-    }
-    if (doAnisotropicFiltering && GLAD_GL_EXT_texture_filter_anisotropic) // check if anisotropic filtering extension is supported ?
-    {
-        GLfloat anisoSetting = 0.0f;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisoSetting);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisoSetting); // enable anisotropic filtering
+        shadowMVPs[j] = shader.getUniform<glm::mat4>(std::format("shadowMVPs[{}]", j));
     }
 }
 
-// check whether all data are prepared for model and specific render style
-// support some check that is not proper to do in display
-void Renderer::checkForModelAttributes()
+const Shader& Renderer::getInstancedShader(const Shader& shader) const
 {
-    for (std::size_t i = 0; i < m_Models.size(); ++i)
+    for (auto [pShader, pInstancedShader] : { std::pair{ &m_PureColorShader, &m_InstancedPureColorShader },
+                                              std::pair{ &m_VaryingColorShader, &m_InstancedVaryingColorShader },
+                                              std::pair{ &m_TextureShader, &m_InstancedTextureShader },
+                                              std::pair{ &m_SimpleShadowDepthShader, &m_InstancedShadowDepthShader },
+                                              std::pair{ &m_ShadowShader, &m_InstancedShadowShader },
+                                              std::pair{ &m_EnvironmentMapShader, &m_InstancedEnvironmentMapShader } })
     {
-        if (m_Models[i].style == LightingMaterialTexture)
-        {
-            if (!m_Models[i].spModel->supplyNormals())
-            {
-                Utils::Logger::globalLogger().warning(std::format("Model {} set to LightingMaterialTexture render style but normals are not supplied.", i));
-            }
-        }
-        else if (m_Models[i].style == EnvironmentMap)
+        if (pShader == &shader)
         {
-            if (!m_bEanbleSkyBox)
-            {
-                Utils::Logger::globalLogger().warning(std::format("Model {} set to EnvironmentMap render style but no sky box texture supplied.", i));
-            }
+            return *pInstancedShader;
         }
     }
+    return shader;
 }
 
-// when left mouse button is holding, update view matrix according cursor change
-// the cursor coordinate
-// O -|------------> X
-//    |
-//    |
-//    |
-//    v Y
-// 1080 pixels for one circle/360 degrees/2*PI radian
-// The rotation logic is just like Blender !
-// keep y axis always be vertical in screen pixels, so use y-axis as x rotation axis, not up vector.
-void Renderer::updateViewArgsAccordingToCursorPos()
+const Shader& Renderer::getMultiDrawShader(const Shader& shader) const
 {
-    if (getHoldLeftMouseButton(m_pWindow))
+    for (auto [pShader, pMultiDrawShader] : { std::pair{ &m_PureColorShader, &m_MultiDrawPureColorShader },
+                                              std::pair{ &m_VaryingColorShader, &m_MultiDrawVaryingColorShader },
+                                              std::pair{ &m_TextureShader, &m_MultiDrawTextureShader },
+                                              std::pair{ &m_SimpleShadowDepthShader, &m_MultiDrawShadowDepthShader } })
     {
-        int deltaX = getCursorPosX(m_pWindow) - getLastCursorPosX(m_pWindow);
-        int deltaY = getCursorPosY(m_pWindow) - getLastCursorPosY(m_pWindow);
-        float xRotationAngle = -2 * glm::pi<float>() / 1080.0f * deltaX;
-        float yRotationAngle = 2 * glm::pi<float>() / 1080.0f * deltaY;
-        glm::vec3& eyeLocation = getEyeLocation(m_pWindow);
-        glm::vec3& objectLocation = getObjectLocation(m_pWindow);
-        glm::vec3& upVector = getUpVector(m_pWindow);
-        if (deltaX != 0)
+        if (pShader == &shader)
         {
-            auto dotRes = glm::dot(upVector, glm::vec3(0.0f, 1.0f, 0.0f));
-            if (dotRes < 0) // > 90 degrees
-            {
-                xRotationAngle = -xRotationAngle;
-            }
-            // the rotation axis of X is y-axis, this is the key point!
-            glm::mat4 rotationMat = glm::rotate(glm::mat4(1.0f), xRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-            upVector = rotationMat * glm::vec4(upVector, 1.0f);
-            eyeLocation = glm::vec3(rotationMat * glm::vec4(eyeLocation - objectLocation, 1.0f)) + objectLocation;
+            return *pMultiDrawShader;
         }
-        if (deltaY != 0)
+    }
+    return shader;
+}
+
+// instanced models are drawn with their instances, the camera pass draws the culled meshlets of a model by themselves,
+// the shadow and environment map programs have no multi-draw variant
+bool Renderer::isMultiDrawn(const ModelAttributes& attr, bool cameraView) const
+{
+    if (attr.pArena == nullptr || attr.instanceCount > 0)
+    {
+        return false;
+    }
+    return !cameraView || (!attr.bMeshletsCulled && attr.style != PhongShadingWithShadow && attr.style != EnvironmentMap);
+}
+
+void Renderer::addMultiDraw(const ModelAttributes& attr, const glm::mat4& modelMatrix, const glm::mat4* pViewMatrix)
+{
+    // baseInstance is the draw index attribute of programs without gl_DrawID
+    DrawElementsIndirectCommand command;
+    command.count = attr.lods.empty() ? GLuint(attr.verticesCount) : GLuint(attr.lods[attr.currentLod].indexCount);
+    command.firstIndex = attr.firstIndex + (attr.lods.empty() ? 0 : GLuint(attr.lods[attr.currentLod].firstIndex));
+    command.baseVertex = attr.baseVertex;
+    command.baseInstance = GLuint(m_MultiDrawCommands.size());
+    m_MultiDrawCommands.push_back(command);
+
+    DrawParametersStd430 parameters{};
+    parameters.modelMatrix = modelMatrix;
+    if (pViewMatrix)
+    {
+        parameters.mvMatrix = *pViewMatrix * modelMatrix;
+        parameters.normMatrix = glm::transpose(glm::inverse(parameters.mvMatrix));
+        parameters.color = attr.color;
+        if (attr.spMaterial)
         {
-            // the rotation axis of Y is cross(Eye - Object, Up)
-            glm::mat4 rotationMat = glm::rotate(glm::mat4(1.0f), yRotationAngle, glm::cross(eyeLocation - objectLocation, upVector));
-            upVector = rotationMat * glm::vec4(upVector, 1.0f);
-            eyeLocation = glm::vec3(rotationMat * glm::vec4(eyeLocation - objectLocation, 1.0f)) + objectLocation;
+            Material& material = *attr.spMaterial;
+            parameters.materialAmbient = material.getAmbient();
+            parameters.materialDiffuse = material.getDiffuse();
+            parameters.materialSpecular = material.getSpecular();
+            parameters.materialShininess = material.getShininess();
         }
+        parameters.materialWeight = attr.materialWeight;
+        parameters.textureWeight = attr.textureWeight;
+        parameters.heightFactor = attr.heightFactor;
     }
-    getLastCursorPosX(m_pWindow) = getCursorPosX(m_pWindow);
-    getLastCursorPosY(m_pWindow) = getCursorPosY(m_pWindow);
+    m_MultiDrawParameters.push_back(parameters);
 }
 
-void Renderer::drawAxises()
+void Renderer::clearMultiDraws()
 {
-    if (m_bEnableAxises)
+    m_MultiDrawCommands.clear();
+    m_MultiDrawParameters.clear();
+    m_MultiDrawBatches.clear();
+}
+
+void Renderer::reserveDrawIndices(std::size_t count)
+{
+    if (count <= m_DrawIndexCapacity)
+    {
+        return;
+    }
+    // the arenas keep pointing to the same buffer name, its new storage is seen by their vaos
+    m_DrawIndexCapacity = std::max<std::size_t>(count, m_DrawIndexCapacity * 2);
+    std::vector<GLuint> drawIndices(m_DrawIndexCapacity);
+    std::iota(drawIndices.begin(), drawIndices.end(), 0);
+    if (m_DrawIndexVbo == 0)
     {
-        m_AxisesShader.use();
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        glGenBuffers(1, &m_DrawIndexVbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_DrawIndexVbo);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(drawIndices.size() * sizeof(GLuint)), drawIndices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-        m_ModelMatrix = glm::mat4(1.0f);
-        m_ViewMatrix = glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
-        m_ModelViewMatrix = m_ViewMatrix * m_ModelMatrix;
+void Renderer::uploadMultiDraws()
+{
+    if (m_MultiDrawCommands.empty())
+    {
+        return;
+    }
+    reserveDrawIndices(m_MultiDrawCommands.size());
+    // orphaning, as the instance buffers: the calls of the last pass may still read the old storage
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_DrawCommandBuffer);
+    GLsizeiptr commandsSize = GLsizeiptr(m_MultiDrawCommands.size() * sizeof(DrawElementsIndirectCommand));
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commandsSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandsSize, m_MultiDrawCommands.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_DrawParameterSsbo);
+    GLsizeiptr parametersSize = GLsizeiptr(m_MultiDrawParameters.size() * sizeof(DrawParametersStd430));
+    glBufferData(GL_SHADER_STORAGE_BUFFER, parametersSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, parametersSize, m_MultiDrawParameters.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_PARAMETER_STORAGE_BINDING, m_DrawParameterSsbo);
+}
 
-        m_AxisesShader.setFloat("axisLength", m_AxisLength);
-        m_AxisesShader.setMat4("mvMatrix", m_ModelViewMatrix);
-        m_AxisesShader.setMat4("projMatrix", getProjMatrix(m_pWindow));
+void Renderer::drawMultiDrawBatch(const MultiDrawBatch& batch, const Shader& shader, const Uniform<GLuint>& firstDrawUniform)
+{
+    // the draw indirect buffer binding is not part of the vertex array, it stays bound from the upload
+    shader.set(firstDrawUniform, GLuint(batch.firstCommand));
+    m_GLState.bindVertexArray(batch.pArena->getVao());
+    glMultiDrawElementsIndirect(batch.primitiveType, batch.pArena->getIndexType(),
+                                reinterpret_cast<const void*>(batch.firstCommand * sizeof(DrawElementsIndirectCommand)), GLsizei(batch.commandCount), 0);
+    m_MultiDrawStats.multiDrawCalls++;
+    m_MultiDrawStats.multiDrawCommands += batch.commandCount;
+}
 
-        glBindVertexArray(m_AxisesVao);
-        glDrawArrays(GL_LINES, 0, 6);
-        glBindVertexArray(0);
+// only the features the program of the lighting mode has: the maps are Phong shading only
+ShaderFeatureMask Renderer::getShaderFeatures(const ModelAttributes& attr) const
+{
+    // every feature is a 0 or 1 times its bit
+    ShaderFeatureMask features = 0;
+    features |= ShaderFeatureMask(attr.lightingMode == FlatShading) * FlatShadingFeature;
+    if (attr.lightingMode == PhongShading)
+    {
+        features |= ShaderFeatureMask(attr.generateBumpMap) * BumpMapFeature;
+        features |= ShaderFeatureMask(attr.enableNormalMap) * NormalMapFeature;
+        features |= ShaderFeatureMask(attr.enableHeightMap) * HeightMapFeature;
     }
-    checkOpenGLError();
+    features |= ShaderFeatureMask(attr.bQuantized) * OctNormalsFeature;
+    features |= ShaderFeatureMask(!m_DirectionalLights.empty()) * DirectionalLightsFeature;
+    features |= ShaderFeatureMask(!m_PointLights.empty()) * PointLightsFeature;
+    features |= ShaderFeatureMask(!m_SpotLights.empty()) * SpotLightsFeature;
+    features |= ShaderFeatureMask(attr.instanceCount > 0) * InstancedFeature;
+    features |= ShaderFeatureMask(isMultiDrawn(attr, true)) * MultiDrawFeature;
+    return features;
 }
 
-// draw shadow depth textures
-void Renderer::drawShadowTextures(float currentTime)
+// fill FrameBlock and LightBlock for all programs that use them, the lights are transformed to view space once here
+void Renderer::updateFrameUniforms()
 {
-    int width = 0, height = 0;
-    glfwGetFramebufferSize(m_pWindow, &width, &height);
-    // deal with minimization
-    if (width == 0 || height == 0)
+    m_ViewMatrix = glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
+    // transform directions with the inverse transpose of the view matrix
+    glm::mat4 directionMatrix = glm::transpose(glm::inverse(m_ViewMatrix));
+
+    // the cluster grid follows the projection and the viewport
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (m_LightClusters.update(getProjMatrix(m_pWindow), viewport[2], viewport[3]))
     {
-        width = 1920;
-        height = 1080;
+        const auto& bounds = m_LightClusters.getBounds();
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ClusterBoundsSsbo);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(bounds.size() * sizeof(ClusterBounds)), bounds.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
     }
-    Shader shader = m_SimpleShadowDepthShader;
-    shader.use();
-    std::size_t shadowIndex = 0;
 
-    if (m_bEnableCullFace)
+    FrameBlockStd140 frame{};
+    frame.viewMatrix = m_ViewMatrix;
+    frame.projMatrix = getProjMatrix(m_pWindow);
+    frame.pcfMode = GLint(m_PCFMode);
+    frame.pcfFactor = m_PCFFactor;
+    frame.clusterDepthScale = m_LightClusters.getDepthScale();
+    frame.clusterDepthBias = m_LightClusters.getDepthBias();
+    glm::uvec3 gridSize = m_LightClusters.getSize();
+    frame.clusterGrid = glm::uvec4(gridSize.x, gridSize.y, gridSize.z, 0);
+    frame.clusterTileSize = glm::vec4(m_LightClusters.getTileSize(), 0.0f, 0.0f);
+
+    LightBlockStd140<MAX_DIRECTIONAL_LIGHT_SIZE> lights{};
+    lights.globalAmbient = m_GlobalAmbient;
+    lights.directionalLightsSize = GLuint(m_DirectionalLights.size());
+    lights.pointLightsSize = GLuint(m_PointLights.size());
+    lights.spotLightsSize = GLuint(m_SpotLights.size());
+    lights.shadowsSize = GLuint(m_ShadowBuffers.size());
+    for (std::size_t j = 0; j < m_DirectionalLights.size(); ++j)
     {
-        glEnable(GL_CULL_FACE);
-        glCullFace(m_FaceCullingMode);
-        glFrontFace(m_FrontFace);
+        auto& light = lights.directionalLights[j];
+        light.ambient = m_DirectionalLights[j].getAmbient();
+        light.diffuse = m_DirectionalLights[j].getDiffuse();
+        light.specular = m_DirectionalLights[j].getSpecular();
+        light.direction = glm::vec3(directionMatrix * glm::vec4(m_DirectionalLights[j].getDirection(), 1.0f));
     }
-    // shadow of directional lights
-    for (std::size_t i = 0; i < m_DirectionalLights.size(); i++, shadowIndex++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_ShadowBuffers[shadowIndex]);
-        glClear(GL_DEPTH_BUFFER_BIT); // Note: this is a key point !!!
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
 
-        // these parameters may need to adjust dynamically, fixed for now: eye location, up vector, near plane, far plane
-        // view matrix
-        glm::mat4 vMat = glm::lookAt(m_DirectionalLights[i].getDirection() * (-1.0f) * 5.0f, glm::vec3(0.0f), glm::vec3(-1.0f, 2.0f, -1.0f));
-        // projection matrix : orthogonal projection for directional light
-        glm::mat4 pMat = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
-        // glm::mat4 pMat = glm::perspective(glm::pi<float>() / 2.0f, float(width)/float(height), 1.0f, 1000.0f);
-        m_ShadowVPs[shadowIndex] = pMat * vMat;
-        for (std::size_t j = 0; j < m_Models.size(); j++)
-        {
-            // model matrix
-            glm::mat4 mMat = glm::mat4(1.0f);
-            if (m_Models[j].bRotate)
-            {
-                mMat = glm::rotate(mMat, currentTime * m_Models[j].rotationRate, m_Models[j].rotationAxis);
-            }
-            shader.setMat4("shadowMVP", pMat * vMat * mMat);
-            // draw models to shadow texture
-            glBindVertexArray(m_Models[j].vao);
-            if (m_Models[j].spModel->supplyIndices())
-            {
-                glDrawElements(GL_TRIANGLES, m_Models[j].verticesCount, GL_UNSIGNED_INT, 0);
-            }
-            else
-            {
-                glDrawArrays(GL_TRIANGLES, 0, m_Models[j].verticesCount);
-            }
-            glBindVertexArray(0);
-        }
+    // respecify the whole buffer, the driver can give a new storage instead of waiting for the draws of the last frame
+    glBindBuffer(GL_UNIFORM_BUFFER, m_FrameUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(frame), &frame, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_LightUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(lights), &lights, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, m_FrameUbo);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_UNIFORM_BINDING, m_LightUbo);
+}
+
+// fill the point and spot light buffers in view space and assign the lights to the clusters, after updateFrameUniforms
+void Renderer::updateLightClusters()
+{
+    glm::mat4 directionMatrix = glm::transpose(glm::inverse(m_ViewMatrix));
+    // shadow textures follow the order of the lights: directional, point, spot
+    std::size_t shadowIndex = m_DirectionalLights.size();
+    auto nextShadowIndex = [&]()
+    {
+        GLint index = shadowIndex < m_ShadowBuffers.size() ? GLint(shadowIndex) : -1;
+        shadowIndex++;
+        return index;
+    };
+    std::vector<PointLightStd430> pointLights(m_PointLights.size());
+    std::vector<LightVolume> pointVolumes(m_PointLights.size());
+    for (std::size_t j = 0; j < m_PointLights.size(); ++j)
+    {
+        auto& light = pointLights[j];
+        light.ambient = m_PointLights[j].getAmbient();
+        light.diffuse = m_PointLights[j].getDiffuse();
+        light.specular = m_PointLights[j].getSpecular();
+        light.location = glm::vec3(m_ViewMatrix * glm::vec4(m_PointLights[j].getLocation(), 1.0f));
+        light.constant = m_PointLights[j].getConstant();
+        light.linear = m_PointLights[j].getLinear();
+        light.quadratic = m_PointLights[j].getQuadratic();
+        light.range = attenuationRange(light.constant, light.linear, light.quadratic);
+        light.shadowIndex = nextShadowIndex();
+        pointVolumes[j] = LightVolume{ light.location, light.range };
     }
-    // shadow of point lights
-    // todo: the shadow texture of point light should be a cube map (from six different directions)
-    for (std::size_t i = 0; i < m_PointLights.size(); i++, shadowIndex++)
+    std::vector<SpotLightStd430> spotLights(m_SpotLights.size());
+    std::vector<LightVolume> spotVolumes(m_SpotLights.size());
+    for (std::size_t j = 0; j < m_SpotLights.size(); ++j)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_ShadowBuffers[shadowIndex]);
-        glClear(GL_DEPTH_BUFFER_BIT); // Note: this is a key point !!!
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        auto& light = spotLights[j];
+        light.ambient = m_SpotLights[j].getAmbient();
+        light.diffuse = m_SpotLights[j].getDiffuse();
+        light.specular = m_SpotLights[j].getSpecular();
+        light.location = glm::vec3(m_ViewMatrix * glm::vec4(m_SpotLights[j].getLocation(), 1.0f));
+        light.direction = glm::normalize(glm::vec3(directionMatrix * glm::vec4(m_SpotLights[j].getDirection(), 1.0f)));
+        light.cutOffAngle = m_SpotLights[j].getCutOffAngle();
+        light.strengthFactorExponent = m_SpotLights[j].getStrengthFactorExponent();
+        // spot lights do not fade with the distance
+        light.range = infiniteLightRange;
+        light.shadowIndex = nextShadowIndex();
+        spotVolumes[j] = LightVolume{ light.location, light.range, light.direction, light.cutOffAngle };
+    }
 
-        // arguments fixed for now: up vector, angle, near plane, far plane
-        // view matrix
-        glm::mat4 vMat = glm::lookAt(m_PointLights[i].getLocation(), glm::vec3(0.0f), glm::vec3(-1.0f, 2.0f, -1.0f));
-        // projection matrix
-        // glm::mat4 pMat = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
-        glm::mat4 pMat = glm::perspective(glm::pi<float>() / 2.0f, float(width)/float(height), 1.0f, 1000.0f);
-        m_ShadowVPs[shadowIndex] = pMat * vMat;
-        for (std::size_t j = 0; j < m_Models.size(); j++)
+    // respecify the buffers every frame as the uniform buffers, a buffer needs some storage to be bound even without lights
+    auto upload = [](GLuint buffer, const void* data, std::size_t size, std::size_t minimumSize, GLenum usage)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(std::max(size, minimumSize)), nullptr, usage);
+        if (data && size > 0)
         {
-            // model matrix
-            glm::mat4 mMat = glm::mat4(1.0f);
-            if (m_Models[j].bRotate)
-            {
-                mMat = glm::rotate(mMat, currentTime * m_Models[j].rotationRate, m_Models[j].rotationAxis);
-            }
-            shader.setMat4("shadowMVP", pMat * vMat * mMat);
-            // draw models to shadow texture
-            glBindVertexArray(m_Models[j].vao);
-            if (m_Models[j].spModel->supplyIndices())
-            {
-                glDrawElements(GL_TRIANGLES, m_Models[j].verticesCount, GL_UNSIGNED_INT, 0);
-            }
-            else
-            {
-                glDrawArrays(GL_TRIANGLES, 0, m_Models[j].verticesCount);
-            }
-            glBindVertexArray(0);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(size), data);
         }
+    };
+    upload(m_PointLightSsbo, pointLights.data(), pointLights.size() * sizeof(PointLightStd430), sizeof(PointLightStd430), GL_DYNAMIC_DRAW);
+    upload(m_SpotLightSsbo, spotLights.data(), spotLights.size() * sizeof(SpotLightStd430), sizeof(SpotLightStd430), GL_DYNAMIC_DRAW);
+    std::size_t clusterCount = m_LightClusters.getClusterCount();
+    if (m_LightCullingMode == CpuLightCulling)
+    {
+        m_LightClusters.assignLights(pointVolumes, spotVolumes);
+        const auto& clusters = m_LightClusters.getClusters();
+        const auto& indices = m_LightClusters.getLightIndices();
+        upload(m_ClusterSsbo, clusters.data(), clusters.size() * sizeof(glm::uvec4), sizeof(glm::uvec4), GL_DYNAMIC_DRAW);
+        upload(m_ClusterLightIndexSsbo, indices.data(), indices.size() * sizeof(GLuint), sizeof(GLuint), GL_DYNAMIC_DRAW);
     }
-    // shadow of spot lights
-    for (std::size_t i = 0; i < m_SpotLights.size(); i++, shadowIndex++)
+    else
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_ShadowBuffers[shadowIndex]);
-        glClear(GL_DEPTH_BUFFER_BIT); // Note: this is a key point !!!
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-
-        // arguments fixed for now: up vector, angle, near plane, far plane
-        // view matrix
-        glm::mat4 vMat = glm::lookAt(m_SpotLights[i].getLocation(), glm::vec3(0.0f), glm::vec3(-1.0f, 2.0f, -1.0f));
-        // projection matrix
-        // glm::mat4 pMat = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
-        glm::mat4 pMat = glm::perspective(glm::pi<float>() / 2.0f, float(width)/float(height), 1.0f, 1000.0f);
-        m_ShadowVPs[shadowIndex] = pMat * vMat;
-        for (std::size_t j = 0; j < m_Models.size(); j++)
-        {
-            // model matrix
-            glm::mat4 mMat = glm::mat4(1.0f);
-            if (m_Models[j].bRotate)
-            {
-                mMat = glm::rotate(mMat, currentTime * m_Models[j].rotationRate, m_Models[j].rotationAxis);
-            }
-            shader.setMat4("shadowMVP", pMat * vMat * mMat);
-            // draw models to shadow texture
-            glBindVertexArray(m_Models[j].vao);
-            if (m_Models[j].spModel->supplyIndices())
-            {
-                glDrawElements(GL_TRIANGLES, m_Models[j].verticesCount, GL_UNSIGNED_INT, 0);
-            }
-            else
-            {
-                glDrawArrays(GL_TRIANGLES, 0, m_Models[j].verticesCount);
-            }
-            glBindVertexArray(0);
-        }
+        // written by the compute shader
+        GLuint zero = 0;
+        upload(m_ClusterSsbo, nullptr, clusterCount * sizeof(glm::uvec4), 0, GL_DYNAMIC_COPY);
+        upload(m_ClusterLightIndexSsbo, nullptr, clusterCount * GPU_CLUSTER_LIGHT_INDICES * sizeof(GLuint), 0, GL_DYNAMIC_COPY);
+        upload(m_ClusterCounterSsbo, &zero, sizeof(zero), 0, GL_DYNAMIC_COPY);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    checkOpenGLError();
-}
-
-// draw sky box
-void Renderer::drawSkyBox()
-{
-    // disable depth test
-    if (m_bEanbleSkyBox)
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_STORAGE_BINDING, m_PointLightSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SPOT_LIGHT_STORAGE_BINDING, m_SpotLightSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_STORAGE_BINDING, m_ClusterSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHT_INDEX_STORAGE_BINDING, m_ClusterLightIndexSsbo);
+    if (m_LightCullingMode == GpuLightCulling)
     {
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
-        m_SkyBoxShader.use();
-        glBindVertexArray(m_SkyBoxVao);
-        
-        m_ModelMatrix = glm::mat4(1.0f);
-        m_ViewMatrix = glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
-        m_ModelViewMatrix = m_ViewMatrix * m_ModelMatrix;
-        m_SkyBoxShader.setMat4("mvMatrix", m_ModelViewMatrix);
-        m_SkyBoxShader.setMat4("projMatrix", getProjMatrix(m_pWindow));
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_SkyBoxTexture);
-        glDrawArrays(GL_TRIANGLES, 0, m_SkyBoxVerticesCount);
-        glBindVertexArray(0);
-        checkOpenGLError();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_BOUNDS_STORAGE_BINDING, m_ClusterBoundsSsbo);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNTER_STORAGE_BINDING, m_ClusterCounterSsbo);
+        m_GLState.useProgram(m_LightCullingShader);
+        m_LightCullingShader.set(m_CullingPointLightsSizeUniform, GLuint(m_PointLights.size()));
+        m_LightCullingShader.set(m_CullingSpotLightsSizeUniform, GLuint(m_SpotLights.size()));
+        m_LightCullingShader.set(m_CullingClusterCountUniform, GLuint(clusterCount));
+        m_LightCullingShader.set(m_CullingMaxLightIndicesUniform, GLuint(clusterCount * GPU_CLUSTER_LIGHT_INDICES));
+        glDispatchCompute(GLuint((clusterCount + 63) / 64), 1, 1);
+        // the fragment shaders read the clusters
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
+    checkOpenGLError();
 }
 
 // display models
 void Renderer::display(float currentTime)
 {
-    glEnable(GL_DEPTH_TEST);
+    defragmentGeometryBuffers();
+    // model uploads, the defragmentation and the driver may have changed the state since the last frame
+    m_GLState.invalidate();
+    m_GLState.resetStatistics();
+    m_MultiDrawStats.multiDrawCalls = 0;
+    m_MultiDrawStats.multiDrawCommands = 0;
+    m_MultiDrawStats.singleDraws = 0;
+    m_GLState.enable(GL_DEPTH_TEST);
+    selectModelLods(currentTime);
+    cullModelMeshlets(currentTime);
+    updateModelBounds(currentTime);
+    glm::mat4 cameraVP = getProjMatrix(m_pWindow) * glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
+    cullModels(cameraVP, m_CameraVisible, m_FrustumCullingStats.camera);
+    updateFrameUniforms();
+    updateLightClusters();
     
     // draw shadow textures for all lights
     drawShadowTextures(currentTime);
@@ -2238,88 +4883,216 @@ void Renderer::display(float currentTime)
 
     drawAxises();
 
+    // the program and textures of every model, the draws are issued in the order of the render queue
+    m_RenderQueue.clear();
+    m_ModelDraws.clear();
+    glm::vec3 eyeLocation = getEyeLocation(m_pWindow);
     for (std::size_t i = 0; i < m_Models.size(); ++i)
     {
+        const ModelAttributes& attr = m_Models[i];
+        if (!attr.bUploaded || !m_CameraVisible[i]) // still loading, or outside of the view frustum
+        {
+            continue;
+        }
         // render style for different render program
-        RenderStyle style = m_Models[i].style;
-        GLenum primitiveType = GL_TRIANGLES;
-        Shader shader;
+        RenderStyle style = attr.style;
+        ModelDraw draw;
+        draw.modelIndex = i;
         switch (style)
         {
         case PureColorPoints:
-            primitiveType = GL_POINTS;
-            shader = m_PureColorShader;
+            draw.primitiveType = GL_POINTS;
+            draw.pShader = &m_PureColorShader;
+            draw.pUniforms = &m_PureColorUniforms;
             break;
         case PureColorLines:
-            primitiveType = GL_LINES;
-            shader = m_PureColorShader;
+            draw.primitiveType = GL_LINES;
+            draw.pShader = &m_PureColorShader;
+            draw.pUniforms = &m_PureColorUniforms;
             break;
         case PureColorLineStrip:
-            primitiveType = GL_LINE_STRIP;
-            shader = m_PureColorShader;
+            draw.primitiveType = GL_LINE_STRIP;
+            draw.pShader = &m_PureColorShader;
+            draw.pUniforms = &m_PureColorUniforms;
             break;
         case PureColorTriangles:
-            primitiveType = GL_TRIANGLES;
-            shader = m_PureColorShader;
+            draw.primitiveType = GL_TRIANGLES;
+            draw.pShader = &m_PureColorShader;
+            draw.pUniforms = &m_PureColorUniforms;
             break;
         case VaryingColorPoints:
-            primitiveType = GL_POINTS;
-            shader = m_VaryingColorShader;
+            draw.primitiveType = GL_POINTS;
+            draw.pShader = &m_VaryingColorShader;
+            draw.pUniforms = &m_VaryingColorUniforms;
             break;
         case VaryingColorLines:
-            primitiveType = GL_LINES;
-            shader = m_VaryingColorShader;
+            draw.primitiveType = GL_LINES;
+            draw.pShader = &m_VaryingColorShader;
+            draw.pUniforms = &m_VaryingColorUniforms;
             break;
         case VaryingColorLineStrip:
-            primitiveType = GL_LINE_STRIP;
-            shader = m_VaryingColorShader;
+            draw.primitiveType = GL_LINE_STRIP;
+            draw.pShader = &m_VaryingColorShader;
+            draw.pUniforms = &m_VaryingColorUniforms;
             break;
         case VaryingColorTriangles:
-            primitiveType = GL_TRIANGLES;
-            shader = m_VaryingColorShader;
+            draw.primitiveType = GL_TRIANGLES;
+            draw.pShader = &m_VaryingColorShader;
+            draw.pUniforms = &m_VaryingColorUniforms;
             break;
         case SpecificTexture:
-            primitiveType = GL_TRIANGLES;
-            shader = m_TextureShader;
+            draw.primitiveType = GL_TRIANGLES;
+            draw.pShader = &m_TextureShader;
+            draw.pUniforms = &m_TextureUniforms;
             break;
         case LightingMaterialTexture:
-            primitiveType = GL_TRIANGLES;
-            if (m_Models[i].lightingMode == FlatShading || m_Models[i].lightingMode == GouraudShading)
+            draw.primitiveType = GL_TRIANGLES;
+            if (attr.lightingMode == FlatShading || attr.lightingMode == GouraudShading)
             {
-                shader = m_GouraudMaterialTextureShader;
+                draw.pShader = &m_GouraudMaterialTexturePrograms.get(getShaderFeatures(attr));
             }
             else // Phong shading
             {
-                shader = m_PhongMaterialTextureShader;
+                draw.pShader = &m_PhongMaterialTexturePrograms.get(getShaderFeatures(attr));
             }
+            draw.pUniforms = &m_PermutationUniforms.try_emplace(draw.pShader->getShaderId(), *draw.pShader).first->second;
             break;
         case PhongShadingWithShadow:
-            primitiveType = GL_TRIANGLES;
-            shader = m_ShadowShader;
+            draw.primitiveType = GL_TRIANGLES;
+            draw.pShader = &m_ShadowShader;
+            draw.pUniforms = &m_ShadowUniforms;
             break;
         case EnvironmentMap:
-            primitiveType = GL_TRIANGLES;
-            shader = m_EnvironmentMapShader;
+            draw.primitiveType = GL_TRIANGLES;
+            draw.pShader = &m_EnvironmentMapShader;
+            draw.pUniforms = &m_EnvironmentMapUniforms;
             break;
         default:
-            primitiveType = GL_TRIANGLES;
-            shader = m_PureColorShader;
+            draw.primitiveType = GL_TRIANGLES;
+            draw.pShader = &m_PureColorShader;
+            draw.pUniforms = &m_PureColorUniforms;
             break;
         }
-        shader.use();
+        // the lighting permutations have INSTANCED and MULTI_DRAW features, the other programs instanced and multi-draw variants
+        if (attr.instanceCount > 0 && style != LightingMaterialTexture)
+        {
+            draw.pShader = &getInstancedShader(*draw.pShader);
+            draw.pUniforms = &m_PermutationUniforms.try_emplace(draw.pShader->getShaderId(), *draw.pShader).first->second;
+        }
+        draw.bMultiDraw = isMultiDrawn(attr, true);
+        if (draw.bMultiDraw && style != LightingMaterialTexture)
+        {
+            draw.pShader = &getMultiDrawShader(*draw.pShader);
+            draw.pUniforms = &m_PermutationUniforms.try_emplace(draw.pShader->getShaderId(), *draw.pShader).first->second;
+        }
+
+        RenderTextureSet textures{};
+        const Material* pMaterial = nullptr;
+        if (style == SpecificTexture || style == LightingMaterialTexture || style == PhongShadingWithShadow)
+        {
+            textures[0] = attr.texture;
+        }
+        if (style == LightingMaterialTexture)
+        {
+            textures[1] = attr.enableNormalMap ? attr.normalMap : 0;
+            textures[2] = attr.enableHeightMap ? attr.heightMap : 0;
+        }
+        if (style == EnvironmentMap)
+        {
+            textures[3] = m_SkyBoxTexture;
+        }
+        if (style == LightingMaterialTexture || style == PhongShadingWithShadow)
+        {
+            pMaterial = attr.spMaterial.get();
+        }
+        // the material of a multi-draw model is a draw parameter, the arena takes its place in the key
+        // so that the models of an arena are consecutive and still front to back
+        const void* pMaterialKey = draw.bMultiDraw ? static_cast<const void*>(attr.pArena) : pMaterial;
+        draw.textures = textures;
+        // distance of the eye to the bounding sphere, all models are opaque and drawn front to back within the same state
+        glm::vec3 center = attr.bounds.sphereCenter;
+        if (attr.bRotate)
+        {
+            center = glm::vec3(glm::rotate(glm::mat4(1.0f), currentTime * attr.rotationRate, attr.rotationAxis) * glm::vec4(center, 1.0f));
+        }
+        float depth = glm::length(center - eyeLocation) - attr.bounds.sphereRadius;
+        m_RenderQueue.add(std::uint32_t(m_ModelDraws.size()), draw.pShader->getShaderId(), textures, pMaterialKey, attr.vao, depth);
+        m_ModelDraws.push_back(draw);
+    }
+    m_RenderQueue.sort();
+
+    // consecutive multi-draw items of the same program, textures, arena and primitive type are one multi-draw call,
+    // the commands and draw parameters of all calls are uploaded before the first draw
+    const std::vector<RenderItem>& items = m_RenderQueue.getItems();
+    glm::mat4 viewMatrix = glm::lookAt(getEyeLocation(m_pWindow), getObjectLocation(m_pWindow), getUpVector(m_pWindow));
+    clearMultiDraws();
+    for (std::size_t k = 0; k < items.size(); k++)
+    {
+        const ModelDraw& draw = m_ModelDraws[items[k].index];
+        if (!draw.bMultiDraw)
+        {
+            continue;
+        }
+        const ModelAttributes& attr = m_Models[draw.modelIndex];
+        const ModelDraw* pPrevious = k > 0 ? &m_ModelDraws[items[k - 1].index] : nullptr;
+        if (pPrevious == nullptr || !pPrevious->bMultiDraw || pPrevious->pShader != draw.pShader || pPrevious->textures != draw.textures ||
+            pPrevious->primitiveType != draw.primitiveType || m_Models[pPrevious->modelIndex].pArena != attr.pArena)
+        {
+            m_MultiDrawBatches.push_back(MultiDrawBatch{ attr.pArena, draw.primitiveType, m_MultiDrawCommands.size(), 0 });
+        }
+        glm::mat4 mMat = glm::mat4(1.0f);
+        if (attr.bRotate)
+        {
+            mMat = glm::rotate(mMat, currentTime * attr.rotationRate, attr.rotationAxis);
+        }
+        addMultiDraw(attr, mMat, &viewMatrix);
+        m_MultiDrawBatches.back().commandCount++;
+    }
+    uploadMultiDraws();
+
+    std::size_t batchIndex = 0;
+    for (std::size_t k = 0; k < items.size(); k++)
+    {
+        const ModelDraw& draw = m_ModelDraws[items[k].index];
+        std::size_t i = draw.modelIndex;
+        RenderStyle style = m_Models[i].style;
+        GLenum primitiveType = draw.primitiveType;
+        const Shader& shader = *draw.pShader;
+        m_GLState.useProgram(shader);
+        const ModelUniforms& uniforms = *draw.pUniforms;
 
         // backface culling 
         if (m_bEnableCullFace)
         {
-            glEnable(GL_CULL_FACE);
-            glCullFace(m_FaceCullingMode);
-            glFrontFace(m_FrontFace);
+            m_GLState.enable(GL_CULL_FACE);
+            m_GLState.cullFace(m_FaceCullingMode);
+            m_GLState.frontFace(m_FrontFace);
         }
         // depth test
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        m_GLState.enable(GL_DEPTH_TEST);
+        m_GLState.depthFunc(GL_LEQUAL);
         checkOpenGLError();
 
+        // the draws of the call share the program and the textures, the rest are draw parameters
+        if (draw.bMultiDraw)
+        {
+            const MultiDrawBatch& batch = m_MultiDrawBatches[batchIndex++];
+            shader.set(uniforms.projMatrix, getProjMatrix(m_pWindow));
+            shader.set(uniforms.octNormals, m_Models[i].bQuantized);
+            for (GLenum unit = 0; unit < 3; unit++)
+            {
+                if (draw.textures[unit] != 0 || (unit == 0 && (style == SpecificTexture || style == LightingMaterialTexture)))
+                {
+                    m_GLState.activeTexture(GL_TEXTURE0 + unit);
+                    m_GLState.bindTexture(GL_TEXTURE_2D, draw.textures[unit]);
+                }
+            }
+            drawMultiDrawBatch(batch, shader, uniforms.firstDraw);
+            checkOpenGLError();
+            k += batch.commandCount - 1;
+            continue;
+        }
+
         // model matrix
         // rotation
         m_ModelMatrix = glm::mat4(1.0f);
@@ -2333,22 +5106,24 @@ void Renderer::display(float currentTime)
         // model-view matrix
         m_ModelViewMatrix = m_ViewMatrix * m_ModelMatrix;
 
-        shader.setMat4("mvMatrix", m_ModelViewMatrix);
-        shader.setMat4("projMatrix", getProjMatrix(m_pWindow));
+        shader.set(uniforms.mvMatrix, m_ModelViewMatrix);
+        shader.set(uniforms.projMatrix, getProjMatrix(m_pWindow));
+        // normals and tangents of quantized models are octahedral encoded
+        shader.set(uniforms.octNormals, m_Models[i].bQuantized);
         checkOpenGLError();
 
         // input color for pure color shaders
         if (style == PureColorPoints || style == PureColorLineStrip || style == PureColorLines || style == PureColorTriangles)
         {
-            shader.setVec4("inputColor", m_Models[i].color);
+            shader.set(uniforms.inputColor, m_Models[i].color);
         }
         checkOpenGLError();
 
         // texture
         if (style == SpecificTexture || style == LightingMaterialTexture || style == PhongShadingWithShadow)
         {
-            glActiveTexture(GL_TEXTURE0); // always use texture unit 0
-            glBindTexture(GL_TEXTURE_2D, m_Models[i].texture);
+            m_GLState.activeTexture(GL_TEXTURE0); // always use texture unit 0
+            m_GLState.bindTexture(GL_TEXTURE_2D, m_Models[i].texture);
         }
         checkOpenGLError();
 
@@ -2356,70 +5131,22 @@ void Renderer::display(float currentTime)
         if (style == LightingMaterialTexture || style == PhongShadingWithShadow)
         {
             // do not check normals and material, assume they are supplied.
-            
-            // flat shading and Gouraud shading
-            if (m_Models[i].lightingMode == FlatShading || m_Models[i].lightingMode == GouraudShading)
-            {
-                shader.setInt("flatShading", (m_Models[i].lightingMode == FlatShading) ? 1 : 0);
-            }
-            // global ambient
-            shader.setVec4("globalAmbient", m_GlobalAmbient);
-            
-            // directional lights
-            shader.setUint("directionalLightsSize", GLuint(m_DirectionalLights.size()));
-            for (std::size_t j = 0; j < m_DirectionalLights.size(); ++j)
-            {
-                glm::vec3 directionInViewSpace = glm::vec3(glm::transpose(glm::inverse(m_ViewMatrix)) * glm::vec4(m_DirectionalLights[j].getDirection(), 1.0f));
-                std::string str = "directionalLights[" + std::to_string(j) + "]";
-                shader.setVec4(str + ".ambient", m_DirectionalLights[j].getAmbient());
-                shader.setVec4(str + ".diffuse", m_DirectionalLights[j].getDiffuse());
-                shader.setVec4(str + ".specular", m_DirectionalLights[j].getSpecular());
-                shader.setVec3(str + ".direction", directionInViewSpace);
-            }
-            // point lights
-            shader.setUint("pointLightsSize", GLuint(m_PointLights.size()));
-            for (std::size_t j = 0; j < m_PointLights.size(); ++j)
-            {
-                glm::vec3 locationInViewSpace = glm::vec3(m_ViewMatrix * glm::vec4(m_PointLights[j].getLocation(), 1.0f));
-                std::string str = "pointLights[" + std::to_string(j) + "]";
-                shader.setVec4(str + ".ambient", m_PointLights[j].getAmbient());
-                shader.setVec4(str + ".diffuse", m_PointLights[j].getDiffuse());
-                shader.setVec4(str + ".specular", m_PointLights[j].getSpecular());
-                shader.setVec3(str + ".location", locationInViewSpace);
-                shader.setFloat(str + ".constant", m_PointLights[j].getConstant());
-                shader.setFloat(str + ".linear", m_PointLights[j].getLinear());
-                shader.setFloat(str + ".quadratic", m_PointLights[j].getQuadratic());
-            }
-            // spot lights
-            shader.setUint("spotLightsSize", GLuint(m_SpotLights.size()));
-            for (std::size_t j = 0; j < m_SpotLights.size(); ++j)
-            {
-                glm::vec3 locationInViewSpace = glm::vec3(m_ViewMatrix * glm::vec4(m_SpotLights[j].getLocation(), 1.0f));
-                glm::vec3 directionInViewSpace = glm::vec3(glm::transpose(glm::inverse(m_ViewMatrix)) * glm::vec4(m_SpotLights[j].getDirection(), 1.0f));
-                std::string str = "spotLights[" + std::to_string(j) + "]";
-                shader.setVec4(str + ".ambient", m_SpotLights[j].getAmbient());
-                shader.setVec4(str + ".diffuse", m_SpotLights[j].getDiffuse());
-                shader.setVec4(str + ".specular", m_SpotLights[j].getSpecular());
-                shader.setVec3(str + ".location", locationInViewSpace);
-                shader.setVec3(str + ".direction", directionInViewSpace);
-                shader.setFloat(str + ".cutOffAngle", m_SpotLights[j].getCutOffAngle());
-                shader.setFloat(str + ".strengthFactorExponent", m_SpotLights[j].getStrengthFactorExponent());
-            }
             // material and texture weight
-            shader.setFloat("materialWeight", m_Models[i].materialWeight);
-            shader.setFloat("textureWeight", m_Models[i].textureWeight);
+            shader.set(uniforms.materialWeight, m_Models[i].materialWeight);
+            shader.set(uniforms.textureWeight, m_Models[i].textureWeight);
+            shader.set(uniforms.instanceMaterialsSize, m_Models[i].instanceMaterialsSize);
             // material
             if (m_Models[i].spMaterial)
             {
-                shader.setVec4("material.ambient", m_Models[i].spMaterial->getAmbient());
-                shader.setVec4("material.diffuse", m_Models[i].spMaterial->getDiffuse());
-                shader.setVec4("material.specular", m_Models[i].spMaterial->getSpecular());
-                shader.setFloat("material.shininess", m_Models[i].spMaterial->getShininess());
+                shader.set(uniforms.materialAmbient, m_Models[i].spMaterial->getAmbient());
+                shader.set(uniforms.materialDiffuse, m_Models[i].spMaterial->getDiffuse());
+                shader.set(uniforms.materialSpecular, m_Models[i].spMaterial->getSpecular());
+                shader.set(uniforms.materialShininess, m_Models[i].spMaterial->getShininess());
             }
 
             // build the inverse transpose of model-view matrix to transform vertex normal
             glm::mat4 inverseTransposeMvMatrix = glm::transpose(glm::inverse(m_ModelViewMatrix));
-            shader.setMat4("normMatrix", inverseTransposeMvMatrix);
+            shader.set(uniforms.normMatrix, inverseTransposeMvMatrix);
         }
         checkOpenGLError();
 
@@ -2430,57 +5157,45 @@ void Renderer::display(float currentTime)
             {
                 // MVP matrix
                 glm::mat4 shadowMVP = m_BMatrix * m_ShadowVPs[shadowIndex] * m_ModelMatrix;
-                shader.setMat4("shadowMVPs["s + std::to_string(shadowIndex) + "]"s, shadowMVP);
+                shader.set(uniforms.shadowMVPs[shadowIndex], shadowMVP);
                 
                 // shadow texture
-                glActiveTexture(GLenum(m_FirstShadowTextureUnit + shadowIndex));
-                glBindTexture(GL_TEXTURE_2D, m_ShadowTextures[shadowIndex]);
+                m_GLState.activeTexture(GLenum(m_FirstShadowTextureUnit + shadowIndex));
+                m_GLState.bindTexture(GL_TEXTURE_2D, m_ShadowTextures[shadowIndex]);
             }
-            shader.setInt("pcfMode", m_PCFMode);
-            shader.setFloat("pcfFactor", m_PCFFactor);
         }
         checkOpenGLError();
 
         // environment map, sky box will be the environment
         if (style == EnvironmentMap)
         {
-            shader.setMat4("normMatrix", glm::transpose(glm::inverse(m_ModelViewMatrix)));
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, m_SkyBoxTexture);
+            shader.set(uniforms.normMatrix, glm::transpose(glm::inverse(m_ModelViewMatrix)));
+            m_GLState.activeTexture(GL_TEXTURE0);
+            m_GLState.bindTexture(GL_TEXTURE_CUBE_MAP, m_SkyBoxTexture);
         }
 
-        // bump map, normal map, height map
+        // normal map, height map, the bump map is computed in the shader
         if (style == LightingMaterialTexture)
         {
-            shader.setBool("enableBumpMap", m_Models[i].generateBumpMap);
-            shader.setBool("enableNormalMap", m_Models[i].enableNormalMap);
             if (m_Models[i].enableNormalMap)
             {
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, m_Models[i].normalMap);
+                m_GLState.activeTexture(GL_TEXTURE1);
+                m_GLState.bindTexture(GL_TEXTURE_2D, m_Models[i].normalMap);
             }
-            shader.setBool("enableHeightMap", m_Models[i].enableHeightMap);
             if (m_Models[i].enableHeightMap)
             {
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, m_Models[i].heightMap);
-                shader.setFloat("heightFactor", m_Models[i].heightFactor);
+                m_GLState.activeTexture(GL_TEXTURE2);
+                m_GLState.bindTexture(GL_TEXTURE_2D, m_Models[i].heightMap);
+                shader.set(uniforms.heightFactor, m_Models[i].heightFactor);
             }
         }
         checkOpenGLError();
 
-        glBindVertexArray(m_Models[i].vao);
-        if (m_Models[i].spModel->supplyIndices())
-        {
-            glDrawElements(primitiveType, m_Models[i].verticesCount, GL_UNSIGNED_INT, 0);
-        }
-        else
-        {
-            glDrawArrays(primitiveType, 0, m_Models[i].verticesCount);
-        }
-        glBindVertexArray(0);
+        m_GLState.bindVertexArray(m_Models[i].vao);
+        drawModel(m_Models[i], primitiveType, true);
         checkOpenGLError();
     }
+    m_GLState.bindVertexArray(0);
 
     // visual debugging for specific shadow texture, uncomment this when debugging a specific shadow texture.
     // debugShowShadowTexture(0);
@@ -2489,13 +5204,13 @@ void Renderer::display(float currentTime)
 
 void Renderer::debugShowShadowTexture(std::size_t shadowIndex)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_GLState.bindFramebuffer(GL_FRAMEBUFFER, 0);
     glClear(GL_DEPTH_BUFFER_BIT);
     glClear(GL_COLOR_BUFFER_BIT);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    m_ShadowDebugShader1.use();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_ShadowTextures[shadowIndex]);
+    m_GLState.useProgram(m_ShadowDebugShader1);
+    m_GLState.activeTexture(GL_TEXTURE0);
+    m_GLState.bindTexture(GL_TEXTURE_2D, m_ShadowTextures[shadowIndex]);
     static GLuint quadVao = 0;
     if (quadVao == 0)
     {
@@ -2510,7 +5225,7 @@ void Renderer::debugShowShadowTexture(std::size_t shadowIndex)
         // setup plane VAO
         glGenVertexArrays(1, &quadVao);
         glGenBuffers(1, &quadVbo);
-        glBindVertexArray(quadVao);
+        m_GLState.bindVertexArray(quadVao);
         glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
@@ -2518,26 +5233,30 @@ void Renderer::debugShowShadowTexture(std::size_t shadowIndex)
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
         glEnableVertexAttribArray(1);
     }
-    glBindVertexArray(quadVao);
+    m_GLState.bindVertexArray(quadVao);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    m_GLState.bindVertexArray(0);
     checkOpenGLError();
 }
 
 void Renderer::debugShowSimplifiedShadowResult(std::size_t shadowIndex, float currentTime)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_GLState.bindFramebuffer(GL_FRAMEBUFFER, 0);
     glClear(GL_DEPTH_BUFFER_BIT);
     glClear(GL_COLOR_BUFFER_BIT);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    m_ShadowDebugShader2.use();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_ShadowTextures[shadowIndex]);
+    m_GLState.useProgram(m_ShadowDebugShader2);
+    m_GLState.activeTexture(GL_TEXTURE0);
+    m_GLState.bindTexture(GL_TEXTURE_2D, m_ShadowTextures[shadowIndex]);
     // pcf attributes
     m_ShadowDebugShader2.setInt("pcfMode", m_PCFMode);
     m_ShadowDebugShader2.setFloat("pcfFactor", m_PCFFactor);
     for (std::size_t i = 0; i < m_Models.size(); i++)
     {
+        if (!m_Models[i].bUploaded) // still loading
+        {
+            continue;
+        }
         m_ModelMatrix = glm::mat4(1.0f);
         if (m_Models[i].bRotate)
         {
@@ -2552,17 +5271,10 @@ void Renderer::debugShowSimplifiedShadowResult(std::size_t shadowIndex, float cu
 
         glm::mat4 shadowMVP = m_BMatrix * m_ShadowVPs[shadowIndex] * m_ModelMatrix;
         m_ShadowDebugShader2.setMat4("shadowMVP", shadowMVP);
-        glBindVertexArray(m_Models[i].vao);
-        if (m_Models[i].spModel->supplyIndices())
-        {
-            glDrawElements(GL_TRIANGLES, m_Models[i].verticesCount, GL_UNSIGNED_INT, 0);
-        }
-        else
-        {
-            glDrawArrays(GL_TRIANGLES, 0, m_Models[i].verticesCount);
-        }
+        m_GLState.bindVertexArray(m_Models[i].vao);
+        drawModel(m_Models[i], GL_TRIANGLES);
     }
-    glBindVertexArray(0);
+    m_GLState.bindVertexArray(0);
     checkOpenGLError();
     drawAxises();
 }
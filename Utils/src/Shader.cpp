@@ -1,32 +1,208 @@
 #include <Shader.h>
 #include <Utils.h>
+#include <Logger.h>
 #include <glm/ext.hpp>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <bit>
+#include <format>
 
 namespace Utils
 {
 
+// the active uniforms of a program outside of uniform blocks by name, reflected once after link.
+// open addressing with linear probing in a power of two table which is kept at most half full, keyed by hashUniformName.
+class UniformTable
+{
+private:
+    struct Slot
+    {
+        std::uint64_t hash = 0;
+        std::string name;
+        GLint location = -1; // -1 for empty slot
+        GLenum type = 0;
+    };
+    std::vector<Slot> m_slots;
+    std::size_t m_mask = 0;
+    std::size_t m_size = 0;
+
+    void insert(std::string name, GLint location, GLenum type)
+    {
+        std::uint64_t hash = hashUniformName(name);
+        std::size_t i = std::size_t(hash) & m_mask;
+        while (m_slots[i].location >= 0)
+        {
+            if (m_slots[i].hash == hash && m_slots[i].name == name)
+            {
+                return;
+            }
+            i = (i + 1) & m_mask;
+        }
+        m_slots[i] = Slot{ hash, std::move(name), location, type };
+        ++m_size;
+    }
+public:
+    explicit UniformTable(GLuint program)
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+        glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxLength);
+        // every element of an array has its own name
+        struct Resource
+        {
+            std::string name;
+            GLint location;
+            GLenum type;
+            GLint arraySize;
+        };
+        std::vector<Resource> resources;
+        std::size_t nameCount = 0;
+        std::vector<char> nameBuffer(std::size_t(std::max(maxLength, 1)));
+        const GLenum properties[] = { GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE };
+        for (GLint i = 0; i < count; i++)
+        {
+            GLint values[4] = { -1, -1, 0, 1 };
+            glGetProgramResourceiv(program, GL_UNIFORM, GLuint(i), 4, properties, 4, nullptr, values);
+            if (values[0] != -1 || values[1] < 0) // member of a uniform block, no location
+            {
+                continue;
+            }
+            GLsizei length = 0;
+            glGetProgramResourceName(program, GL_UNIFORM, GLuint(i), GLsizei(nameBuffer.size()), &length, nameBuffer.data());
+            resources.push_back(Resource{ std::string(nameBuffer.data(), std::size_t(length)), values[1], GLenum(values[2]), std::max(values[3], 1) });
+            nameCount += std::size_t(std::max(values[3], 1)) + 1;
+        }
+        m_slots.resize(std::bit_ceil(std::max(nameCount * 2, std::size_t(16))));
+        m_mask = m_slots.size() - 1;
+        for (auto& resource : resources)
+        {
+            // "a[0]" is reported for an array a, glGetUniformLocation accepts "a" and "a[i]" too, the locations of the elements are consecutive
+            const std::string_view arraySuffix = "[0]";
+            if (resource.name.ends_with(arraySuffix))
+            {
+                std::string base = resource.name.substr(0, resource.name.size() - arraySuffix.size());
+                insert(base, resource.location, resource.type);
+                for (GLint k = 1; k < resource.arraySize; k++)
+                {
+                    insert(std::format("{}[{}]", base, k), resource.location + k, resource.type);
+                }
+            }
+            insert(std::move(resource.name), resource.location, resource.type);
+        }
+    }
+
+    // the slot of the name, nullptr if the program does not have it
+    const Slot* find(std::string_view name, std::uint64_t hash) const
+    {
+        for (std::size_t i = std::size_t(hash) & m_mask; ; i = (i + 1) & m_mask)
+        {
+            const Slot& slot = m_slots[i];
+            if (slot.location < 0)
+            {
+                return nullptr;
+            }
+            if (slot.hash == hash && slot.name == name)
+            {
+                return &slot;
+            }
+        }
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+};
+
+// the program of a Shader and its copies, the uniforms are reflected when the pending program is finished
+class ProgramState
+{
+public:
+    PendingProgram pending;
+    std::source_location loc;
+    std::optional<UniformTable> uniforms;
+
+    ProgramState(PendingProgram pendingProgram, const std::source_location& location)
+        : pending(std::move(pendingProgram)), loc(location)
+    {
+    }
+};
+
 Shader::Shader() : m_Id(0)
 {
 }
 Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::source_location& loc)
 {
-    m_Id = createShaderProgramFromSource(vertexShader, fragmentShader, geometryShader, loc);
+    PendingProgram pending;
+    pending.program = createShaderProgramFromSource(vertexShader, fragmentShader, geometryShader, loc);
+    setProgram(std::move(pending), loc);
+    finish();
 }
 Shader::Shader(const std::string& vertexShader, const std::string tessellationCtrlShader, const std::string& tessellationEvalShader,
                const std::string& fragmentShader, const std::string& geometryShader,
                const std::source_location& loc)
 {
-    m_Id = createShaderProgramFromSource(vertexShader, tessellationCtrlShader, tessellationEvalShader, fragmentShader, geometryShader, loc);
+    PendingProgram pending;
+    pending.program = createShaderProgramFromSource(vertexShader, tessellationCtrlShader, tessellationEvalShader, fragmentShader, geometryShader, loc);
+    setProgram(std::move(pending), loc);
+    finish();
 }
 
-Shader::Shader(const Shader& shader) : m_Id(shader.m_Id)
+Shader::Shader(const Shader& shader) : m_Id(shader.m_Id), m_spState(shader.m_spState)
 {
 }
 Shader& Shader::operator=(const Shader& shader)
 {
     m_Id = shader.m_Id;
+    m_spState = shader.m_spState;
     return *this;
 }
+
+Shader Shader::submit(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::source_location& loc)
+{
+    std::vector<ProgramStage> stages = { { GL_VERTEX_SHADER, vertexShader }, { GL_FRAGMENT_SHADER, fragmentShader } };
+    if (!geometryShader.empty())
+    {
+        stages.push_back(ProgramStage{ GL_GEOMETRY_SHADER, geometryShader });
+    }
+    Shader shader;
+    shader.setProgram(submitShaderProgram(stages, loc), loc);
+    return shader;
+}
+Shader Shader::submitCompute(const std::string& computeShader, const std::source_location& loc)
+{
+    const ProgramStage stages[] = { { GL_COMPUTE_SHADER, computeShader } };
+    Shader shader;
+    shader.setProgram(submitShaderProgram(stages, loc), loc);
+    return shader;
+}
+
+void Shader::setProgram(PendingProgram pending, const std::source_location& loc)
+{
+    m_Id = pending.program;
+    m_spState = m_Id != 0 ? std::make_shared<ProgramState>(std::move(pending), loc) : nullptr;
+}
+
+bool Shader::isReady() const
+{
+    return !m_spState || m_spState->uniforms || isProgramComplete(m_spState->pending);
+}
+
+void Shader::finish() const
+{
+    if (m_spState && !m_spState->uniforms)
+    {
+        finishShaderProgram(m_spState->pending, m_spState->loc);
+        m_spState->uniforms.emplace(m_Id);
+    }
+}
+
+const UniformTable* Shader::getUniformTable() const
+{
+    finish();
+    return m_spState ? &*m_spState->uniforms : nullptr;
+}
 void Shader::setShaderSource(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::source_location& loc)
 {
     *this = Shader(vertexShader, fragmentShader, geometryShader, loc);
@@ -38,6 +214,12 @@ void Shader::setShaderSource(const std::string& vertexShader, const std::string
     *this = Shader(vertexShader, tessellationCtrlShader, tessellationEvalShader, fragmentShader, geometryShader, loc);
 }
 
+void Shader::setComputeShaderSource(const std::string& computeShader, const std::source_location& loc)
+{
+    *this = submitCompute(computeShader, loc);
+    finish();
+}
+
 GLuint Shader::getShaderId() const
 {
     return m_Id;
@@ -45,60 +227,129 @@ GLuint Shader::getShaderId() const
 
 void Shader::use() const
 {
+    finish();
     glUseProgram(m_Id);
 }
 
 void Shader::setBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(m_Id, name.c_str()), GLint(value));
+    glUniform1i(getUniformLocation(name), GLint(value));
 }
 void Shader::setInt(const std::string& name, GLint value) const
 {
-    glUniform1i(glGetUniformLocation(m_Id, name.c_str()), value);
+    glUniform1i(getUniformLocation(name), value);
 }
 void Shader::setUint(const std::string& name, GLuint value) const
 {
-    glUniform1ui(glGetUniformLocation(m_Id, name.c_str()), GLint(value));
+    glUniform1ui(getUniformLocation(name), GLint(value));
 }
 void Shader::setFloat(const std::string& name, GLfloat value) const
 {
-    glUniform1f(glGetUniformLocation(m_Id, name.c_str()), value);
+    glUniform1f(getUniformLocation(name), value);
 }
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const
 {
-    glUniform2fv(glGetUniformLocation(m_Id, name.c_str()), 1, glm::value_ptr(value));
+    glUniform2fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 void Shader::setVec2(const std::string& name, GLfloat x, GLfloat y) const
 {
-    glUniform2f(glGetUniformLocation(m_Id, name.c_str()), x, y);
+    glUniform2f(getUniformLocation(name), x, y);
 }
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(m_Id, name.c_str()), 1, glm::value_ptr(value));
+    glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 void Shader::setVec3(const std::string& name, GLfloat x, GLfloat y, GLfloat z) const
 {
-    glUniform3f(glGetUniformLocation(m_Id, name.c_str()), x, y, z);
+    glUniform3f(getUniformLocation(name), x, y, z);
 }
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const
 {
-    glUniform4fv(glGetUniformLocation(m_Id, name.c_str()), 1, glm::value_ptr(value));
+    glUniform4fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 void Shader::setVec4(const std::string& name, GLfloat x, GLfloat y, GLfloat z, GLfloat w) const
 {
-    glUniform4f(glGetUniformLocation(m_Id, name.c_str()), x, y, z, w);
+    glUniform4f(getUniformLocation(name), x, y, z, w);
 }
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(m_Id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(m_Id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_Id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+GLint Shader::findUniform(std::string_view name, std::uint64_t hash, std::span<const GLenum> types) const
+{
+    const UniformTable* pUniforms = getUniformTable();
+    const auto* pSlot = pUniforms ? pUniforms->find(name, hash) : nullptr;
+    if (!pSlot)
+    {
+        return -1;
+    }
+    if (!types.empty() && std::find(types.begin(), types.end(), pSlot->type) == types.end())
+    {
+        Logger::globalLogger().warning(std::format("Uniform {} of program {} has GLSL type 0x{:X}, which the handle type can not set.", name, m_Id, pSlot->type));
+        return -1;
+    }
+    return pSlot->location;
+}
+
+GLint Shader::getUniformLocation(std::string_view name) const
+{
+    return findUniform(name, hashUniformName(name), {});
+}
+
+void Shader::set(Uniform<bool> uniform, bool value) const
+{
+    glUniform1i(uniform.location(), GLint(value));
+}
+void Shader::set(Uniform<GLint> uniform, GLint value) const
+{
+    glUniform1i(uniform.location(), value);
+}
+void Shader::set(Uniform<GLuint> uniform, GLuint value) const
+{
+    glUniform1ui(uniform.location(), value);
+}
+void Shader::set(Uniform<GLfloat> uniform, GLfloat value) const
+{
+    glUniform1f(uniform.location(), value);
+}
+void Shader::set(Uniform<glm::vec2> uniform, const glm::vec2& value) const
+{
+    glUniform2fv(uniform.location(), 1, glm::value_ptr(value));
+}
+void Shader::set(Uniform<glm::vec3> uniform, const glm::vec3& value) const
+{
+    glUniform3fv(uniform.location(), 1, glm::value_ptr(value));
+}
+void Shader::set(Uniform<glm::vec4> uniform, const glm::vec4& value) const
+{
+    glUniform4fv(uniform.location(), 1, glm::value_ptr(value));
+}
+void Shader::set(Uniform<glm::mat2> uniform, const glm::mat2& mat) const
+{
+    glUniformMatrix2fv(uniform.location(), 1, GL_FALSE, glm::value_ptr(mat));
+}
+void Shader::set(Uniform<glm::mat3> uniform, const glm::mat3& mat) const
+{
+    glUniformMatrix3fv(uniform.location(), 1, GL_FALSE, glm::value_ptr(mat));
+}
+void Shader::set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(uniform.location(), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+std::size_t Shader::getUniformCount() const
+{
+    const UniformTable* pUniforms = getUniformTable();
+    return pUniforms ? pUniforms->size() : 0;
 }
 
 } // namespace Utils
@@ -0,0 +1,94 @@
+#include <ShaderPermutations.h>
+#include <Logger.h>
+#include <format>
+
+namespace Utils
+{
+
+std::string injectShaderDefines(std::string_view source, std::span<const std::string> defines)
+{
+    // #version must stay the first directive, a leading newline of a raw string literal is skipped
+    std::size_t position = 0;
+    std::size_t versionPosition = source.find("#version");
+    if (versionPosition != std::string_view::npos && source.find_first_not_of(" \t\r\n") == versionPosition)
+    {
+        std::size_t lineEnd = source.find('\n', versionPosition);
+        position = lineEnd == std::string_view::npos ? source.size() : lineEnd + 1;
+    }
+    std::string res;
+    res.reserve(source.size() + defines.size() * 32);
+    res.append(source.substr(0, position));
+    if (position > 0 && res.back() != '\n')
+    {
+        res.push_back('\n');
+    }
+    for (const auto& define : defines)
+    {
+        res.append("#define ").append(define).push_back('\n');
+    }
+    res.append(source.substr(position));
+    return res;
+}
+
+ShaderPermutations::ShaderPermutations(std::string_view vertexShader, std::string_view fragmentShader, std::vector<std::string> featureNames,
+                                       std::string_view geometryShader)
+    : m_VertexShader(vertexShader), m_FragmentShader(fragmentShader), m_GeometryShader(geometryShader), m_FeatureNames(std::move(featureNames))
+{
+    if (m_FeatureNames.size() > 32)
+    {
+        Logger::globalLogger().warning(std::format("{} shader features, only the first 32 are used!", m_FeatureNames.size()));
+        m_FeatureNames.resize(32);
+    }
+}
+
+ShaderFeatureMask ShaderPermutations::knownFeatures(ShaderFeatureMask features) const
+{
+    return m_FeatureNames.size() < 32 ? features & ((ShaderFeatureMask(1) << m_FeatureNames.size()) - 1) : features;
+}
+
+const Shader& ShaderPermutations::get(ShaderFeatureMask features, const std::source_location& loc)
+{
+    features = knownFeatures(features);
+    auto iter = m_Programs.find(features);
+    if (iter != m_Programs.end())
+    {
+        return iter->second;
+    }
+    std::vector<std::string> defines = getDefines(features);
+    Shader shader;
+    shader.setShaderSource(injectShaderDefines(m_VertexShader, defines), injectShaderDefines(m_FragmentShader, defines),
+                           m_GeometryShader.empty() ? std::string() : injectShaderDefines(m_GeometryShader, defines), loc);
+    std::string names;
+    for (const auto& define : defines)
+    {
+        names.append(names.empty() ? "" : " ").append(define);
+    }
+    Logger::globalLogger().debug(std::format("Compiled shader permutation {:#x} ({}), {} variants.", features, names.empty() ? "no features" : names,
+                                             m_Programs.size() + 1));
+    return m_Programs.emplace(features, shader).first->second;
+}
+
+bool ShaderPermutations::contains(ShaderFeatureMask features) const
+{
+    return m_Programs.contains(knownFeatures(features));
+}
+
+std::vector<std::string> ShaderPermutations::getDefines(ShaderFeatureMask features) const
+{
+    std::vector<std::string> res;
+    for (std::size_t i = 0; i < m_FeatureNames.size(); i++)
+    {
+        if (features & (ShaderFeatureMask(1) << i))
+        {
+            res.push_back(m_FeatureNames[i]);
+        }
+    }
+    return res;
+}
+
+std::size_t ShaderPermutations::size() const
+{
+    return m_Programs.size();
+}
+
+} // namespace Utils
\ No newline at end of file
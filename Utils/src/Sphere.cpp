@@ -65,40 +65,17 @@ bool Sphere::supplyNormals()
 
 std::vector<float> Sphere::getVerticesArray()
 {
-    std::vector<float> verticesVec;
-    verticesVec.reserve(m_numIndices * 3);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        verticesVec.push_back(m_vertices[m_indices[i]].x);
-        verticesVec.push_back(m_vertices[m_indices[i]].y);
-        verticesVec.push_back(m_vertices[m_indices[i]].z);
-    }
-    return verticesVec;
+    return deindex<glm::vec3>(m_indices, m_vertices);
 }
 
 std::vector<float> Sphere::getTexCoordsArray()
 {
-    std::vector<float> texCoordsVec;
-    texCoordsVec.reserve(m_numIndices * 2);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        texCoordsVec.push_back(m_texCoords[m_indices[i]].s);
-        texCoordsVec.push_back(m_texCoords[m_indices[i]].t);
-    }
-    return texCoordsVec;
+    return deindex<glm::vec2>(m_indices, m_texCoords);
 }
 
 std::vector<float> Sphere::getNormalsArray()
 {
-    std::vector<float> normalsVec;
-    normalsVec.reserve(m_numIndices * 3);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        normalsVec.push_back(m_normals[m_indices[i]].x);
-        normalsVec.push_back(m_normals[m_indices[i]].y);
-        normalsVec.push_back(m_normals[m_indices[i]].z);
-    }
-    return normalsVec;
+    return deindex<glm::vec3>(m_indices, m_normals);
 }
 
 bool Sphere::supplyIndices()
@@ -126,5 +103,25 @@ std::vector<glm::vec3> Sphere::getNormals()
     return m_normals;
 }
 
+std::span<const int> Sphere::getIndicesView()
+{
+    return m_indices;
+}
+
+std::span<const glm::vec3> Sphere::getVerticesView()
+{
+    return m_vertices;
+}
+
+std::span<const glm::vec2> Sphere::getTexCoordsView()
+{
+    return m_texCoords;
+}
+
+std::span<const glm::vec3> Sphere::getNormalsView()
+{
+    return m_normals;
+}
+
 
 } // namespace Utils
\ No newline at end of file
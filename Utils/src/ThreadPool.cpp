@@ -0,0 +1,124 @@
+#include <ThreadPool.h>
+#include <atomic>
+#include <algorithm>
+
+namespace Utils
+{
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_Workers.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; i++)
+    {
+        m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStop = true;
+    }
+    m_Condition.notify_all();
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const
+{
+    return m_Workers.size();
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_bStop || !m_Tasks.empty(); });
+            // finish queued tasks before stopping
+            if (m_Tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& func, std::size_t maxThreads)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (count == 1 || maxThreads == 1)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            func(i);
+        }
+        return;
+    }
+    // shared with the helpers, a helper may start after this call returned and must find nothing left to do
+    struct State
+    {
+        std::atomic<std::size_t> next = 0;
+        std::atomic<std::size_t> done = 0;
+        std::size_t count = 0;
+        const std::function<void(std::size_t)>* pFunc = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto spState = std::make_shared<State>();
+    spState->count = count;
+    spState->pFunc = &func;
+    auto work = [](State& state)
+    {
+        std::size_t i;
+        while ((i = state.next.fetch_add(1)) < state.count)
+        {
+            (*state.pFunc)(i);
+            if (state.done.fetch_add(1) + 1 == state.count)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.finished.notify_all();
+            }
+        }
+    };
+    std::size_t helperCount = std::min(count - 1, size());
+    if (maxThreads != 0)
+    {
+        helperCount = std::min(helperCount, maxThreads - 1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (std::size_t i = 0; i < helperCount; i++)
+        {
+            m_Tasks.emplace([spState, work]() { work(*spState); });
+        }
+    }
+    m_Condition.notify_all();
+    work(*spState);
+    // only wait for the items that have been claimed by other threads, they are running already
+    std::unique_lock<std::mutex> lock(spState->mutex);
+    spState->finished.wait(lock, [&]() { return spState->done.load() == count; });
+}
+
+ThreadPool& ThreadPool::globalPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace Utils
\ No newline at end of file
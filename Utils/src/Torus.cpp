@@ -100,66 +100,27 @@ bool Torus::supplyTangents()
 
 std::vector<float> Torus::getVerticesArray()
 {
-    std::vector<float> verticesVec;
-    verticesVec.reserve(m_numIndices * 3);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        verticesVec.push_back(m_vertices[m_indices[i]].x);
-        verticesVec.push_back(m_vertices[m_indices[i]].y);
-        verticesVec.push_back(m_vertices[m_indices[i]].z);
-    }
-    return verticesVec;
+    return deindex<glm::vec3>(m_indices, m_vertices);
 }
 
 std::vector<float> Torus::getTexCoordsArray()
 {
-    std::vector<float> texCoordsVec;
-    texCoordsVec.reserve(m_numIndices * 2);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        texCoordsVec.push_back(m_texCoords[m_indices[i]].s);
-        texCoordsVec.push_back(m_texCoords[m_indices[i]].t);
-    }
-    return texCoordsVec;
+    return deindex<glm::vec2>(m_indices, m_texCoords);
 }
 
 std::vector<float> Torus::getNormalsArray()
 {
-    std::vector<float> normalsVec;
-    normalsVec.reserve(m_numIndices * 3);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        normalsVec.push_back(m_normals[m_indices[i]].x);
-        normalsVec.push_back(m_normals[m_indices[i]].y);
-        normalsVec.push_back(m_normals[m_indices[i]].z);
-    }
-    return normalsVec;
+    return deindex<glm::vec3>(m_indices, m_normals);
 }
 
 std::vector<float> Torus::getSTangentsArray()
 {
-    std::vector<float> tangentsVec;
-    tangentsVec.reserve(m_numIndices * 3);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        tangentsVec.push_back(m_sTangents[m_indices[i]].x);
-        tangentsVec.push_back(m_sTangents[m_indices[i]].y);
-        tangentsVec.push_back(m_sTangents[m_indices[i]].z);
-    }
-    return tangentsVec;
+    return deindex<glm::vec3>(m_indices, m_sTangents);
 }
 
 std::vector<float> Torus::getTTangentsArray()
 {
-    std::vector<float> tangentsVec;
-    tangentsVec.reserve(m_numIndices * 3);
-    for (int i = 0; i < m_numIndices; ++i)
-    {
-        tangentsVec.push_back(m_tTangents[m_indices[i]].x);
-        tangentsVec.push_back(m_tTangents[m_indices[i]].y);
-        tangentsVec.push_back(m_tTangents[m_indices[i]].z);
-    }
-    return tangentsVec;
+    return deindex<glm::vec3>(m_indices, m_tTangents);
 }
 
 bool Torus::supplyIndices()
@@ -197,4 +158,34 @@ std::vector<glm::vec3> Torus::getTTangents()
     return m_tTangents;
 }
 
+std::span<const int> Torus::getIndicesView()
+{
+    return m_indices;
+}
+
+std::span<const glm::vec3> Torus::getVerticesView()
+{
+    return m_vertices;
+}
+
+std::span<const glm::vec2> Torus::getTexCoordsView()
+{
+    return m_texCoords;
+}
+
+std::span<const glm::vec3> Torus::getNormalsView()
+{
+    return m_normals;
+}
+
+std::span<const glm::vec3> Torus::getSTangentsView()
+{
+    return m_sTangents;
+}
+
+std::span<const glm::vec3> Torus::getTTangentsView()
+{
+    return m_tTangents;
+}
+
 } // namespace Utils
\ No newline at end of file
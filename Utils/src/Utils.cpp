@@ -3,6 +3,7 @@
 #include <fstream>
 #include <string>
 #include <format>
+#include <vector>
 #include <soil2/SOIL2.h>
 #include <Logger.h>
 
@@ -160,45 +161,137 @@ GLuint createShaderProgramFromSource(const std::string& vertexShader, const std:
                                      const std::string& fragmentShader, const std::string& geometryShader,
                                      const std::source_location& loc)
 {
-    // vertex and fragment shader
-    GLuint vShader = createAndCompileShader(vertexShader, GL_VERTEX_SHADER, "Vertex", loc);
-    GLuint fShader = createAndCompileShader(fragmentShader, GL_FRAGMENT_SHADER, "Fragment", loc);
-    
-    // create program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vShader);
-    glAttachShader(shaderProgram, fShader);
+    std::vector<ProgramStage> stages = { { GL_VERTEX_SHADER, vertexShader }, { GL_FRAGMENT_SHADER, fragmentShader } };
+    for (const auto& stage : { ProgramStage{ GL_TESS_CONTROL_SHADER, tessellationCtrlShader }, ProgramStage{ GL_TESS_EVALUATION_SHADER, tessellationEvalShader },
+                               ProgramStage{ GL_GEOMETRY_SHADER, geometryShader } })
+    {
+        if (!stage.source.empty())
+        {
+            stages.push_back(stage);
+        }
+    }
+    PendingProgram pending = submitShaderProgram(stages, loc);
+    return finishShaderProgram(pending, loc);
+}
 
-    // tessellation control shader
-    if (!tessellationCtrlShader.empty())
+// create compute shader program from source
+GLuint createComputeProgramFromSource(const std::string& computeShader, const std::source_location& loc)
+{
+    const ProgramStage stages[] = { { GL_COMPUTE_SHADER, computeShader } };
+    PendingProgram pending = submitShaderProgram(stages, loc);
+    return finishShaderProgram(pending, loc);
+}
+
+static std::string shaderStageName(GLenum type)
+{
+    switch (type)
     {
-        GLuint tCShader = createAndCompileShader(tessellationCtrlShader, GL_TESS_CONTROL_SHADER, "Tessellation control", loc);
-        glAttachShader(shaderProgram, tCShader);
+    case GL_VERTEX_SHADER:
+        return "Vertex"s;
+    case GL_TESS_CONTROL_SHADER:
+        return "Tessellation control"s;
+    case GL_TESS_EVALUATION_SHADER:
+        return "Tessellation evaluation"s;
+    case GL_GEOMETRY_SHADER:
+        return "Geometry"s;
+    case GL_FRAGMENT_SHADER:
+        return "Fragment"s;
+    case GL_COMPUTE_SHADER:
+        return "Compute"s;
+    default:
+        return std::to_string(type);
     }
-    // tessellation evaluation shader
-    if (!tessellationEvalShader.empty())
+}
+
+void setShaderCompilerThreads(GLuint count)
+{
+    if (GLAD_GL_KHR_parallel_shader_compile)
     {
-        GLuint tEShader = createAndCompileShader(tessellationEvalShader, GL_TESS_EVALUATION_SHADER, "Tessellation evaluation", loc);
-        glAttachShader(shaderProgram, tEShader);
+        glMaxShaderCompilerThreadsKHR(count);
     }
-    // geometry shader
-    if (!geometryShader.empty())
+}
+
+PendingProgram submitShaderProgram(std::span<const ProgramStage> stages, const std::source_location& loc)
+{
+    // a cached binary of the same sources skips compiling and linking
+    PendingProgram pending;
+    ProgramBinaryCache& cache = ProgramBinaryCache::globalCache();
+    pending.program = cache.load(stages);
+    if (pending.program != 0)
+    {
+        return pending;
+    }
+    // no status query here, it would wait for the driver
+    pending.program = glCreateProgram();
+    for (const auto& stage : stages)
     {
-        GLuint gShader = createAndCompileShader(geometryShader, GL_GEOMETRY_SHADER, "Geometry", loc);
-        glAttachShader(shaderProgram, gShader);
+        GLuint shader = glCreateShader(stage.type);
+        const char* source = stage.source.data();
+        GLint length = GLint(stage.source.size());
+        glShaderSource(shader, 1, &source, &length);
+        glCompileShader(shader);
+        glAttachShader(pending.program, shader);
+        pending.stages.push_back(PendingProgram::Stage{ stage.type, shader, std::string(stage.source) });
     }
+    if (cache.isEnabled())
+    {
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(pending.program);
+    checkOpenGLError(loc);
+    return pending;
+}
 
-    // link shader program
-    glLinkProgram(shaderProgram);
-    checkOpenGLError();
+bool isProgramComplete(const PendingProgram& pending)
+{
+    if (pending.stages.empty() || !GLAD_GL_KHR_parallel_shader_compile)
+    {
+        return true;
+    }
+    GLint complete = GL_FALSE;
+    glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+GLuint finishShaderProgram(PendingProgram& pending, const std::source_location& loc)
+{
+    if (pending.stages.empty()) // loaded from the cache or finished already
+    {
+        return pending.program;
+    }
     GLint linkStatus = GL_FALSE;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linkStatus);
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &linkStatus);
     if (linkStatus != GL_TRUE)
     {
+        // a stage that does not compile fails the link, the compile status is only asked for then
+        for (const auto& stage : pending.stages)
+        {
+            GLint compiled = GL_FALSE;
+            glGetShaderiv(stage.shader, GL_COMPILE_STATUS, &compiled);
+            if (compiled != GL_TRUE)
+            {
+                Logger::globalLogger().warning(std::format("{} shader compilation failed!", shaderStageName(stage.type)), loc);
+                printShaderLog(stage.shader, loc);
+            }
+        }
         Logger::globalLogger().warning("Shader program linking failed!", loc);
-        printProgramLog(shaderProgram, loc);
+        printProgramLog(pending.program, loc);
+    }
+    // the linked program does not need its shader objects any more
+    std::vector<ProgramStage> stages;
+    for (const auto& stage : pending.stages)
+    {
+        glDetachShader(pending.program, stage.shader);
+        glDeleteShader(stage.shader);
+        stages.push_back(ProgramStage{ stage.type, stage.source });
+    }
+    if (linkStatus == GL_TRUE)
+    {
+        ProgramBinaryCache::globalCache().store(pending.program, stages);
     }
-    return shaderProgram;
+    pending.stages.clear();
+    checkOpenGLError(loc);
+    return pending.program;
 }
 
 // load texture to OpenGL texture object
@@ -0,0 +1,44 @@
+#include <VertexLayout.h>
+
+namespace Utils
+{
+
+VertexLayout::VertexLayout(VertexPacking packing)
+    : m_Packing(packing)
+{
+}
+
+void VertexLayout::addAttribute(GLuint location, GLint components, GLenum type, GLboolean normalized, GLsizei size)
+{
+    VertexAttribute attribute{ location, components, type, normalized, size, 0 };
+    if (m_Packing == InterleavedBuffer)
+    {
+        attribute.offset = std::size_t(m_Stride);
+        m_Stride = (m_Stride + size + alignment - 1) / alignment * alignment;
+    }
+    m_Attributes.push_back(attribute);
+}
+
+VertexPacking VertexLayout::getPacking() const
+{
+    return m_Packing;
+}
+
+const std::vector<VertexAttribute>& VertexLayout::getAttributes() const
+{
+    return m_Attributes;
+}
+
+GLsizei VertexLayout::getStride() const
+{
+    return m_Stride;
+}
+
+void VertexLayout::setAttributePointer(const VertexAttribute& attribute, std::size_t bufferOffset) const
+{
+    glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, m_Stride,
+                          reinterpret_cast<const void*>(bufferOffset + attribute.offset));
+    glEnableVertexAttribArray(attribute.location);
+}
+
+} // namespace Utils
\ No newline at end of file
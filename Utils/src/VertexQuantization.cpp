@@ -0,0 +1,146 @@
+#include <VertexQuantization.h>
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+namespace Utils
+{
+
+std::uint16_t floatToHalf(float value)
+{
+    std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+    std::uint16_t sign = std::uint16_t((bits >> 16) & 0x8000u);
+    std::uint32_t absBits = bits & 0x7fffffffu;
+    // infinity and nan, nan stays a quiet nan
+    if (absBits >= 0x7f800000u)
+    {
+        return sign | 0x7c00u | (absBits > 0x7f800000u ? 0x0200u : 0u);
+    }
+    // 65520 and above round to infinity
+    if (absBits >= 0x477ff000u)
+    {
+        return sign | 0x7c00u;
+    }
+    // below 2^-14: half subnormals in units of 2^-24, 2^-25 and below round to zero
+    if (absBits < 0x38800000u)
+    {
+        if (absBits <= 0x33000000u)
+        {
+            return sign;
+        }
+        std::uint32_t mantissa = (absBits & 0x007fffffu) | 0x00800000u;
+        std::uint32_t shift = 126u - (absBits >> 23);
+        std::uint32_t half = mantissa >> shift;
+        std::uint32_t rest = mantissa & ((1u << shift) - 1u);
+        std::uint32_t halfway = 1u << (shift - 1u);
+        if (rest > halfway || (rest == halfway && (half & 1u)))
+        {
+            half++;
+        }
+        return sign | std::uint16_t(half);
+    }
+    // normals: rebias the exponent from 127 to 15, round the mantissa from 23 to 10 bits, a carry goes to the exponent
+    std::uint32_t half = (absBits - 0x38000000u) >> 13;
+    std::uint32_t rest = absBits & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+    {
+        half++;
+    }
+    return sign | std::uint16_t(half);
+}
+
+float halfToFloat(std::uint16_t value)
+{
+    std::uint32_t sign = std::uint32_t(value & 0x8000u) << 16;
+    std::uint32_t exponent = (value >> 10) & 0x1fu;
+    std::uint32_t mantissa = value & 0x03ffu;
+    if (exponent == 0x1fu)
+    {
+        return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+    }
+    if (exponent == 0)
+    {
+        float magnitude = std::ldexp(float(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+namespace
+{
+
+std::int16_t toSnorm16(float value)
+{
+    return std::int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float fromSnorm16(std::int16_t value)
+{
+    // the conversion of normalized signed integers of OpenGL 4.2 and later
+    return std::max(float(value) / 32767.0f, -1.0f);
+}
+
+float signNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+} // anonymous namespace
+
+// project to the octahedron |x| + |y| + |z| = 1, unfold the lower half (z < 0) onto the corners of the square
+std::array<std::int16_t, 2> octEncode(glm::vec3 direction)
+{
+    float l1 = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (l1 == 0.0f)
+    {
+        return { 0, 0 };
+    }
+    float x = direction.x / l1, y = direction.y / l1;
+    if (direction.z < 0.0f)
+    {
+        float foldedX = (1.0f - std::abs(y)) * signNotZero(x);
+        float foldedY = (1.0f - std::abs(x)) * signNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    return { toSnorm16(x), toSnorm16(y) };
+}
+
+glm::vec3 octDecode(std::array<std::int16_t, 2> encoded)
+{
+    glm::vec3 n(fromSnorm16(encoded[0]), fromSnorm16(encoded[1]), 0.0f);
+    n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+std::vector<std::uint16_t> quantizeHalfFloats(std::span<const float> values)
+{
+    std::vector<std::uint16_t> res(values.size());
+    std::transform(values.begin(), values.end(), res.begin(), floatToHalf);
+    return res;
+}
+
+std::vector<std::int16_t> quantizeDirections(std::span<const float> directions)
+{
+    std::size_t count = directions.size() / 3;
+    std::vector<std::int16_t> res(count * 2);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto encoded = octEncode(glm::vec3(directions[i * 3], directions[i * 3 + 1], directions[i * 3 + 2]));
+        res[i * 2] = encoded[0];
+        res[i * 2 + 1] = encoded[1];
+    }
+    return res;
+}
+
+std::vector<std::uint16_t> narrowIndices(std::span<const int> indices)
+{
+    std::vector<std::uint16_t> res(indices.size());
+    std::transform(indices.begin(), indices.end(), res.begin(), [](int index) { return std::uint16_t(index); });
+    return res;
+}
+
+} // namespace Utils
\ No newline at end of file